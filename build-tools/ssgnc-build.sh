@@ -10,6 +10,11 @@ ShowUsage()
 	echo "CHECKER: time, valgrind"
 	echo "  time: time -f 'real %E, user %U, sys %S'"
 	echo "  valgrind: valgrind --leak-check=full"
+	echo
+	echo "MAX_FILE_SIZE (environment): writes an index of the wide format"
+	echo "  0: one file per order"
+	echo "  N: switches files at list boundaries after N bytes"
+	echo "INDEX_FORMAT (environment): plain (default), elias-fano"
 }
 
 CheckCommands()
@@ -128,7 +133,7 @@ BuildIndex()
 	$checker ssgnc-db-merge \
 		$num_tokens "$INDEX_DIR/vocab.dic" "$TEMP_DIR" | \
 		$checker ssgnc-db-split \
-		$num_tokens "$INDEX_DIR/vocab.dic" "$INDEX_DIR" \
+		$num_tokens "$INDEX_DIR/vocab.dic" "$INDEX_DIR" $MAX_FILE_SIZE \
 		> "$TEMP_DIR/$num_tokens""gms.idx"
 	if [ $? -ne 0 ]
 	then
@@ -159,7 +164,8 @@ BuildIndices()
 	echo
 	echo "ssgnc-idx-merge"
 	$checker ssgnc-idx-merge \
-		"$INDEX_DIR/vocab.dic" "$TEMP_DIR" > "$INDEX_DIR/ngms.idx"
+		"$INDEX_DIR/vocab.dic" "$TEMP_DIR" $INDEX_FORMAT \
+		> "$INDEX_DIR/ngms.idx"
 	if [ $? -ne 0 ]
 	then
 		exit 500
@@ -223,6 +229,8 @@ echo "DATA_DIR: $DATA_DIR"
 echo "INDEX_DIR: $INDEX_DIR"
 echo "TEMP_DIR: $TEMP_DIR"
 echo "CHECKER: $CHECKER"
+echo "MAX_FILE_SIZE: $MAX_FILE_SIZE"
+echo "INDEX_FORMAT: $INDEX_FORMAT"
 
 if [ ! -d "$DATA_DIR" ]
 then
@@ -5,6 +5,11 @@ namespace {
 ssgnc::Int32 num_tokens;
 ssgnc::VocabDic vocab_dic;
 
+// In the wide format, a file is switched only at the beginning of a list,
+// and 0 means that all the lists are written into one file.
+bool is_wide = false;
+ssgnc::UInt64 max_file_size = ssgnc::NgramIndex::MAX_OFFSET;
+
 bool readNgram(ssgnc::ByteReader *byte_reader, ssgnc::Int16 *freq,
 	ssgnc::StringBuilder *ngram_buf)
 {
@@ -61,9 +66,10 @@ bool openNextFile(ssgnc::FilePath *file_path, std::ofstream *file)
 	return true;
 }
 
-bool writeNgramOffset(ssgnc::Int32 file_id, ssgnc::UInt32 offset)
+template <typename T>
+bool writeNgramOffset(ssgnc::Int32 file_id, ssgnc::UInt64 offset)
 {
-	ssgnc::NgramIndex::FileEntry entries;
+	T entries;
 
 	if (!entries.set_file_id(file_id))
 	{
@@ -87,10 +93,23 @@ bool writeNgramOffset(ssgnc::Int32 file_id, ssgnc::UInt32 offset)
 	return true;
 }
 
-bool splitDatabase(ssgnc::FilePath *file_path)
+bool writeNgramOffset(ssgnc::Int32 file_id, ssgnc::UInt64 offset)
 {
-	static const ssgnc::UInt32 MAX_FILE_SIZE = 0x7FFFFFFFU;
+	return is_wide
+		? writeNgramOffset<ssgnc::NgramIndex::WideFileEntry>(file_id, offset)
+		: writeNgramOffset<ssgnc::NgramIndex::FileEntry>(file_id, offset);
+}
 
+bool needsNextFile(ssgnc::UInt64 file_size, bool is_list_head,
+	const ssgnc::StringBuilder &ngram_buf)
+{
+	if (!is_wide)
+		return file_size + ngram_buf.length() > max_file_size;
+	return is_list_head && max_file_size != 0 && file_size >= max_file_size;
+}
+
+bool splitDatabase(ssgnc::FilePath *file_path)
+{
 	std::ofstream file;
 
 	ssgnc::ByteReader byte_reader;
@@ -101,8 +120,9 @@ bool splitDatabase(ssgnc::FilePath *file_path)
 	}
 
 	ssgnc::UInt64 num_ngrams = 0;
-	ssgnc::UInt32 file_size = MAX_FILE_SIZE + 1;
+	ssgnc::UInt64 file_size = 0;
 	ssgnc::UInt64 total_size = 0;
+	bool is_list_head = true;
 
 	if (!writeNgramOffset(0, 0))
 	{
@@ -114,7 +134,7 @@ bool splitDatabase(ssgnc::FilePath *file_path)
 	ssgnc::StringBuilder ngram_buf;
 	while (readNgram(&byte_reader, &freq, &ngram_buf))
 	{
-		if (file_size + ngram_buf.length() > MAX_FILE_SIZE)
+		if (!file.is_open() || needsNextFile(file_size, is_list_head, ngram_buf))
 		{
 			if (file_path->tell() != 0)
 			{
@@ -134,6 +154,7 @@ bool splitDatabase(ssgnc::FilePath *file_path)
 		{
 			file.put('\0');
 			++file_size;
+			is_list_head = true;
 
 			if (!writeNgramOffset(file_path->tell() - 1, file_size))
 			{
@@ -151,6 +172,7 @@ bool splitDatabase(ssgnc::FilePath *file_path)
 
 		file_size += ngram_buf.length();
 		total_size += ngram_buf.length();
+		is_list_head = false;
 
 		++num_ngrams;
 	}
@@ -192,16 +214,30 @@ int main(int argc, char *argv[])
 {
 	ssgnc::tools::initIO();
 
-	if (argc != 4)
+	if (argc != 4 && argc != 5)
 	{
 		std::cerr << "Usage: " << argv[0]
-			<< " NUM_TOKENS VOCAB_DIC INDEX_DIR" << std::endl;
+			<< " NUM_TOKENS VOCAB_DIC INDEX_DIR [MAX_FILE_SIZE]" << std::endl;
+		std::cerr << "MAX_FILE_SIZE: writes wide entries (0: one file)"
+			<< std::endl;
 		return 1;
 	}
 
 	if (!ssgnc::tools::parseNumTokens(argv[1], &num_tokens))
 		return 2;
 
+	if (argc == 5)
+	{
+		ssgnc::Int64 value;
+		if (!ssgnc::tools::parseInt64(argv[4], &value) || value < 0)
+		{
+			SSGNC_ERROR << "Invalid max file size: " << argv[4] << std::endl;
+			return 1;
+		}
+		is_wide = true;
+		max_file_size = static_cast<ssgnc::UInt64>(value);
+	}
+
 	if (!vocab_dic.open(argv[2]))
 		return 3;
 
@@ -78,8 +78,61 @@ bool openIndexFiles(const ssgnc::String &index_dir,
 	return true;
 }
 
-bool writeHeader(std::size_t num_files)
+bool checkFormat(std::vector<std::ifstream *> *files, bool *is_wide)
 {
+	ssgnc::UInt64 num_entries = vocab_dic.num_keys() + 1ULL;
+	for (std::size_t i = 0; i < files->size(); ++i)
+	{
+		std::ifstream *file = (*files)[i];
+		if (!file->seekg(0, std::ios::end))
+		{
+			SSGNC_ERROR << "std::ifstream::seekg() failed" << std::endl;
+			return false;
+		}
+		ssgnc::UInt64 file_size = static_cast<ssgnc::UInt64>(file->tellg());
+		if (!file->seekg(0, std::ios::beg))
+		{
+			SSGNC_ERROR << "std::ifstream::seekg() failed" << std::endl;
+			return false;
+		}
+
+		bool is_wide_file;
+		if (file_size == num_entries
+			* sizeof(ssgnc::NgramIndex::FileEntry))
+			is_wide_file = false;
+		else if (file_size == num_entries
+			* sizeof(ssgnc::NgramIndex::WideFileEntry))
+			is_wide_file = true;
+		else
+		{
+			SSGNC_ERROR << "Wrong file size: " << file_size << std::endl;
+			return false;
+		}
+
+		if (i == 0)
+			*is_wide = is_wide_file;
+		else if (is_wide_file != *is_wide)
+		{
+			SSGNC_ERROR << "Mixed formats" << std::endl;
+			return false;
+		}
+	}
+	return true;
+}
+
+bool writeHeader(std::size_t num_files, ssgnc::Int32 format)
+{
+	if (format != 0)
+	{
+		ssgnc::Int32 marker = ssgnc::NgramIndex::FORMAT_MARKER;
+		if (!ssgnc::Writer(&std::cout).write(marker) ||
+			!ssgnc::Writer(&std::cout).write(format))
+		{
+			SSGNC_ERROR << "ssgnc::Writer::write() failed" << std::endl;
+			return false;
+		}
+	}
+
 	ssgnc::Int32 max_num_tokens = static_cast<ssgnc::UInt32>(num_files);
 	ssgnc::Int32 max_token_id = vocab_dic.num_keys() - 1;
 
@@ -92,11 +145,12 @@ bool writeHeader(std::size_t num_files)
 	return true;
 }
 
-bool mergeIndices(std::vector<std::ifstream *> *files)
+template <typename T>
+bool mergeIndices(std::vector<std::ifstream *> *files, ssgnc::Int32 format)
 {
 	enum { FILE_BUF_SIZE = 1 << 20 };
 
-	if (!writeHeader(files->size()))
+	if (!writeHeader(files->size(), format))
 	{
 		SSGNC_ERROR << "writeHeader() failed" << std::endl;
 		return false;
@@ -130,7 +184,7 @@ bool mergeIndices(std::vector<std::ifstream *> *files)
 		(*files)[i]->rdbuf()->pubsetbuf(&file_bufs[i][0], file_bufs[i].size());
 	}
 
-	ssgnc::NgramIndex::FileEntry entries;
+	T entries;
 	for (ssgnc::UInt32 i = 0; i <= vocab_dic.num_keys(); ++i)
 	{
 		for (std::size_t j = 0; j < files->size(); ++j)
@@ -167,19 +221,100 @@ bool mergeIndices(std::vector<std::ifstream *> *files)
 	return true;
 }
 
+// Each file has the keys of one order, which are compressed into an
+// ssgnc::EliasFano sequence.
+template <typename T>
+bool compressIndices(std::vector<std::ifstream *> *files, ssgnc::Int32 format)
+{
+	if (!writeHeader(files->size(), format))
+	{
+		SSGNC_ERROR << "writeHeader() failed" << std::endl;
+		return false;
+	}
+
+	std::vector<ssgnc::UInt64> keys;
+	try
+	{
+		keys.reserve(vocab_dic.num_keys() + 1);
+	}
+	catch (...)
+	{
+		SSGNC_ERROR << "std::vector<ssgnc::UInt64>::reserve() failed: "
+			<< sizeof(ssgnc::UInt64) << " * "
+			<< (vocab_dic.num_keys() + 1) << std::endl;
+		return false;
+	}
+
+	ssgnc::Writer writer(&std::cout);
+	T entries;
+	for (std::size_t i = 0; i < files->size(); ++i)
+	{
+		ssgnc::Reader reader((*files)[i]);
+
+		keys.clear();
+		for (ssgnc::UInt32 j = 0; j <= vocab_dic.num_keys(); ++j)
+		{
+			if (!reader.read(&entries))
+			{
+				SSGNC_ERROR << "ssgnc::Reader::read() failed" << std::endl;
+				return false;
+			}
+			keys.push_back(entries.key());
+		}
+
+		if ((*files)[i]->get() != EOF)
+		{
+			SSGNC_ERROR << "Extra bytes" << std::endl;
+			return false;
+		}
+
+		if (!ssgnc::EliasFano::build(keys, &writer))
+		{
+			SSGNC_ERROR << "ssgnc::EliasFano::build() failed: "
+				<< (i + 1) << std::endl;
+			return false;
+		}
+
+		std::cerr << "No. tokens: " << (i + 1)
+			<< ", Total size: " << writer.tell() << std::endl;
+	}
+
+	if (!std::cout.flush())
+	{
+		SSGNC_ERROR << "std::ofstream::flush() failed" << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
 }  // namespace
 
 int main(int argc, char *argv[])
 {
 	ssgnc::tools::initIO();
 
-	if (argc != 3)
+	if (argc != 3 && argc != 4)
 	{
 		std::cerr << "Usage: " << argv[0]
-			<< " VOCAB_DIC TEMP_DIR" << std::endl;
+			<< " VOCAB_DIC TEMP_DIR [FORMAT]" << std::endl;
+		std::cerr << "FORMAT: plain (default), elias-fano" << std::endl;
 		return 1;
 	}
 
+	bool is_elias_fano = false;
+	if (argc == 4)
+	{
+		ssgnc::String format_name(argv[3]);
+		if (format_name == "elias-fano")
+			is_elias_fano = true;
+		else if (format_name != "plain")
+		{
+			SSGNC_ERROR << "Unknown format: " << format_name << std::endl;
+			return 1;
+		}
+	}
+
 	if (!vocab_dic.open(argv[1]))
 		return 2;
 
@@ -188,8 +323,37 @@ int main(int argc, char *argv[])
 		return 3;
 
 	int ret = 0;
-	if (!mergeIndices(&files))
+	bool is_wide = false;
+	if (!checkFormat(&files, &is_wide))
 		ret = 4;
+	else
+	{
+		ssgnc::Int32 format = 0;
+		if (is_wide)
+			format |= ssgnc::NgramIndex::WIDE_FORMAT;
+		if (is_elias_fano)
+			format |= ssgnc::NgramIndex::ELIAS_FANO_FORMAT;
+
+		bool is_ok;
+		if (is_elias_fano)
+		{
+			is_ok = is_wide
+				? compressIndices<ssgnc::NgramIndex::WideFileEntry>(
+				&files, format)
+				: compressIndices<ssgnc::NgramIndex::FileEntry>(
+				&files, format);
+		}
+		else
+		{
+			is_ok = is_wide
+				? mergeIndices<ssgnc::NgramIndex::WideFileEntry>(
+				&files, format)
+				: mergeIndices<ssgnc::NgramIndex::FileEntry>(
+				&files, format);
+		}
+		if (!is_ok)
+			ret = 5;
+	}
 
 	ssgnc::tools::closeFiles(&files);
 
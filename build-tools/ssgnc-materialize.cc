@@ -0,0 +1,197 @@
+#include "tools-common.h"
+
+#include <cstdio>
+
+namespace {
+
+enum { MAX_DEPTH = 1 << 20 };
+
+ssgnc::Database database;
+ssgnc::MaterializedResults::Builder builder;
+
+// Each query is searched for one more result than the depth, so that an
+// entry which has all the results of its query is marked as complete.
+bool materializeQuery(const ssgnc::Query &query, ssgnc::Int64 depth)
+{
+	ssgnc::ResultCache::Key key;
+	if (!database.makeKey(query, &key))
+	{
+		SSGNC_ERROR << "ssgnc::Database::makeKey() failed" << std::endl;
+		return false;
+	}
+
+	// The same query may be given more than once.
+	if (builder.contains(key))
+		return true;
+
+	ssgnc::Agent agent;
+	if (!database.search(query, &agent))
+	{
+		SSGNC_ERROR << "ssgnc::Database::search() failed" << std::endl;
+		return false;
+	}
+
+	ssgnc::ResultCache::Results results;
+	ssgnc::Int16 encoded_freq;
+	std::vector<ssgnc::Int32> tokens;
+	bool is_complete = true;
+	while (agent.read(&encoded_freq, &tokens))
+	{
+		if (static_cast<ssgnc::Int64>(results.size()) >= depth)
+		{
+			is_complete = false;
+			break;
+		}
+		else if (!results.append(encoded_freq, tokens))
+		{
+			SSGNC_ERROR << "ssgnc::ResultCache::Results::append() failed"
+				<< std::endl;
+			return false;
+		}
+	}
+
+	if (agent.bad())
+	{
+		SSGNC_ERROR << "ssgnc::Agent::read() failed" << std::endl;
+		return false;
+	}
+
+	if (!builder.append(key, results, is_complete, agent.tell(),
+		agent.num_scanned()))
+	{
+		SSGNC_ERROR << "ssgnc::MaterializedResults::Builder::append() failed"
+			<< std::endl;
+		return false;
+	}
+	return true;
+}
+
+bool materializeQueries(std::istream *in, ssgnc::Int64 depth,
+	ssgnc::Query *query)
+{
+	std::string line;
+	while (ssgnc::tools::readLine(in, &line))
+	{
+		ssgnc::String query_str(line.c_str(), line.length());
+		if (query_str.empty())
+			continue;
+
+		if (!database.parseQuery(query_str, query))
+		{
+			SSGNC_ERROR << "ssgnc::Database::parseQuery() failed: "
+				<< query_str << std::endl;
+			return false;
+		}
+
+		if (!materializeQuery(*query, depth))
+			return false;
+	}
+
+	if (in->bad())
+	{
+		SSGNC_ERROR << "ssgnc::tools::readLine() failed" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+bool writeResults(const ssgnc::String &index_dir)
+{
+	ssgnc::StringBuilder path, temp_path;
+	if (!ssgnc::FilePath::join(index_dir, "ngms.mat", &path) ||
+		!temp_path.append(path.str()) || !temp_path.append(".tmp") ||
+		!temp_path.append())
+	{
+		SSGNC_ERROR << "ssgnc::FilePath::join() failed" << std::endl;
+		return false;
+	}
+
+	std::ofstream file(temp_path.ptr(), std::ios::binary);
+	if (!file)
+	{
+		SSGNC_ERROR << "std::ofstream::open() failed: "
+			<< temp_path << std::endl;
+		return false;
+	}
+
+	if (!builder.write(&file) || !file.flush())
+	{
+		SSGNC_ERROR << "ssgnc::MaterializedResults::Builder::write() failed"
+			<< std::endl;
+		return false;
+	}
+	file.close();
+
+	// The file is replaced at once, because servers may be reading it.
+	if (std::rename(temp_path.ptr(), path.ptr()) != 0)
+	{
+		SSGNC_ERROR << "std::rename() failed: " << temp_path
+			<< ", " << path << std::endl;
+		return false;
+	}
+
+	std::cerr << "No. entries: " << builder.num_entries()
+		<< ", File: " << path << std::endl;
+	return true;
+}
+
+}  // namespace
+
+int main(int argc, char *argv[])
+{
+	ssgnc::tools::initIO();
+
+	// Options such as --ssgnc-order are applied to all the queries. The
+	// limits are replaced with the depth.
+	ssgnc::Query query;
+	if (!query.parseOptions(&argc, argv))
+		return 1;
+
+	if (argc < 3)
+	{
+		std::cerr << "Usage: " << argv[0]
+			<< " [OPTION]... INDEX_DIR DEPTH [QUERY_FILE]...\n\n"
+			<< "DEPTH: the maximum number of results per query [1-"
+			<< MAX_DEPTH << "]\n"
+			<< "QUERY_FILE: a query per line (default: stdin)\n"
+			<< "The results are written into INDEX_DIR/ngms.mat.\n\n";
+		ssgnc::Query::showOptions(&std::cerr);
+		return 1;
+	}
+
+	ssgnc::Int64 depth;
+	if (!ssgnc::tools::parseInt64(argv[2], &depth) ||
+		depth < 1 || depth > MAX_DEPTH)
+	{
+		SSGNC_ERROR << "Invalid depth: " << argv[2] << std::endl;
+		return 1;
+	}
+
+	if (!query.set_max_num_results(depth + 1) || !query.set_io_limit(0) ||
+		!query.set_time_limit(0) || !query.set_scan_limit(0))
+		return 1;
+
+	if (!database.open(argv[1]))
+		return 2;
+
+	if (argc == 3 && !materializeQueries(&std::cin, depth, &query))
+		return 3;
+	for (int i = 3; i < argc; ++i)
+	{
+		std::ifstream file(argv[i], std::ios::binary);
+		if (!file)
+		{
+			SSGNC_ERROR << "std::ifstream::open() failed: "
+				<< argv[i] << std::endl;
+			return 3;
+		}
+
+		if (!materializeQueries(&file, depth, &query))
+			return 3;
+	}
+
+	if (!writeResults(argv[1]))
+		return 4;
+
+	return 0;
+}
@@ -0,0 +1,742 @@
+#include "tools-common.h"
+
+#include <algorithm>
+#include <map>
+
+#include <unistd.h>
+
+namespace {
+
+typedef ssgnc::NgramIndex::WideFileEntry WideFileEntry;
+
+// A list is identified by its number of tokens and its token ID.
+typedef std::pair<ssgnc::Int32, ssgnc::Int32> ListId;
+typedef std::map<ListId, ssgnc::UInt64> CountMap;
+
+struct HotList
+{
+	HotList() : id(), count(0), size(0) {}
+
+	ListId id;
+	ssgnc::UInt64 count;
+	ssgnc::Int64 size;
+};
+
+enum { BYTE_READER_BUF_SIZE = 1 << 20 };
+
+// Files are switched only at the beginning of a list.
+const ssgnc::UInt64 MAX_FILE_SIZE = ssgnc::NgramIndex::MAX_OFFSET;
+
+ssgnc::StringBuilder index_dir;
+ssgnc::ShardMap shard_map;
+ssgnc::VocabDic vocab_dic;
+ssgnc::NgramIndex ngram_index;
+
+std::vector<WideFileEntry> entries;
+std::vector<ssgnc::UInt32> sizes;
+
+// This class reads lists from an index of any format, which may be sharded.
+// A list of the original format may continue to the following files.
+class ListReader
+{
+public:
+	ListReader() : num_tokens_(0), file_path_(), file_(), byte_reader_() {}
+	~ListReader() { if (file_path_.is_open()) close(); }
+
+	bool open(ssgnc::Int32 num_tokens, const ssgnc::NgramIndex::Entry &entry)
+	{
+		ssgnc::StringBuilder basename;
+		if (!basename.appendf("%dgm-%%04d.db", num_tokens))
+		{
+			SSGNC_ERROR << "ssgnc::StringBuilder::appendf() failed"
+				<< std::endl;
+			return false;
+		}
+
+		if (!file_path_.open(index_dir.str(), basename.str()) ||
+			!file_path_.seek(entry.file_id()))
+		{
+			SSGNC_ERROR << "ssgnc::FilePath::open() failed: "
+				<< index_dir << ", " << basename << std::endl;
+			return false;
+		}
+
+		num_tokens_ = num_tokens;
+		if (!openNextFile(entry.offset()))
+		{
+			SSGNC_ERROR << "ListReader::openNextFile() failed" << std::endl;
+			close();
+			return false;
+		}
+		return true;
+	}
+
+	bool close()
+	{
+		num_tokens_ = 0;
+		if (byte_reader_.is_open())
+			byte_reader_.close();
+		if (file_.is_open())
+			file_.close();
+		return file_path_.close();
+	}
+
+	// This function copies a list to `file' and returns its size. If `file'
+	// is NULL, the list is skipped.
+	bool copyList(std::ofstream *file, ssgnc::UInt64 *list_size)
+	{
+		*list_size = 0;
+
+		ssgnc::Int16 freq;
+		ssgnc::StringBuilder ngram_buf;
+		do
+		{
+			if (!readNgram(&freq, &ngram_buf))
+			{
+				SSGNC_ERROR << "ListReader::readNgram() failed" << std::endl;
+				return false;
+			}
+
+			if (file != NULL)
+			{
+				if (freq == 0)
+					file->put('\0');
+				else
+					*file << ngram_buf;
+				if (!*file)
+				{
+					SSGNC_ERROR << "std::ofstream::operator<<() failed"
+						<< std::endl;
+					return false;
+				}
+			}
+			*list_size += (freq == 0) ? 1 : ngram_buf.length();
+		} while (freq != 0);
+
+		return true;
+	}
+
+private:
+	ssgnc::Int32 num_tokens_;
+	ssgnc::FilePath file_path_;
+	std::ifstream file_;
+	ssgnc::ByteReader byte_reader_;
+
+	bool openNextFile(ssgnc::UInt64 offset = 0)
+	{
+		ssgnc::StringBuilder path;
+		if (!file_path_.read(shard_map.dirname(
+			shard_map.find(num_tokens_, file_path_.tell())), &path))
+		{
+			SSGNC_ERROR << "ssgnc::FilePath::read() failed" << std::endl;
+			return false;
+		}
+
+		if (byte_reader_.is_open())
+			byte_reader_.close();
+		if (file_.is_open())
+			file_.close();
+		file_.clear();
+
+		file_.open(path.ptr(), std::ios::binary);
+		if (!file_)
+		{
+			SSGNC_ERROR << "std::ifstream::open() failed: " << path
+				<< std::endl;
+			return false;
+		}
+		else if (offset != 0 && !file_.seekg(offset))
+		{
+			SSGNC_ERROR << "std::ifstream::seekg() failed: " << offset
+				<< std::endl;
+			return false;
+		}
+
+		if (!byte_reader_.open(&file_, BYTE_READER_BUF_SIZE))
+		{
+			SSGNC_ERROR << "ssgnc::ByteReader::open() failed" << std::endl;
+			return false;
+		}
+		return true;
+	}
+
+	// A list which starts a new file has the end of the previous file as
+	// its start position.
+	bool readNgram(ssgnc::Int16 *freq, ssgnc::StringBuilder *ngram_buf)
+	{
+		while (!ssgnc::tools::readFreq(&byte_reader_, ngram_buf, freq))
+		{
+			if (byte_reader_.bad() || !openNextFile())
+			{
+				SSGNC_ERROR << "ssgnc::tools::readFreq() failed" << std::endl;
+				return false;
+			}
+		}
+
+		if (*freq == 0)
+			return true;
+
+		if (!ssgnc::tools::readTokens(num_tokens_, vocab_dic,
+			&byte_reader_, ngram_buf, NULL))
+		{
+			SSGNC_ERROR << "ssgnc::tools::readTokens() failed" << std::endl;
+			return false;
+		}
+		return true;
+	}
+
+	// Disallows copies.
+	ListReader(const ListReader &);
+	ListReader &operator=(const ListReader &);
+};
+
+bool getRealPath(const ssgnc::String &dirname,
+	ssgnc::StringBuilder *real_path)
+{
+	std::string path(dirname.ptr(), dirname.length());
+	char *real_path_ptr = ::realpath(path.c_str(), NULL);
+	if (real_path_ptr == NULL)
+	{
+		SSGNC_ERROR << "::realpath() failed: " << dirname << std::endl;
+		return false;
+	}
+
+	bool is_ok = real_path->append(real_path_ptr) && real_path->append();
+	std::free(real_path_ptr);
+	if (!is_ok)
+	{
+		SSGNC_ERROR << "ssgnc::StringBuilder::append() failed"
+			<< std::endl;
+		return false;
+	}
+	return true;
+}
+
+// This class writes lists into the files of a tier. Each file is linked
+// from the output directory unless the tier is the output directory.
+class ListWriter
+{
+public:
+	ListWriter() : tier_path_(), link_path_(), needs_link_(false), file_(),
+		file_path_(), file_size_(0) {}
+	~ListWriter() { if (tier_path_.is_open()) close(); }
+
+	bool open(const ssgnc::String &tier_dir, const ssgnc::String &output_dir,
+		ssgnc::Int32 num_tokens, ssgnc::Int32 file_id)
+	{
+		ssgnc::StringBuilder tier_real_dir, output_real_dir;
+		if (!getRealPath(tier_dir, &tier_real_dir) ||
+			!getRealPath(output_dir, &output_real_dir))
+		{
+			SSGNC_ERROR << "getRealPath() failed" << std::endl;
+			return false;
+		}
+
+		needs_link_ = (tier_real_dir.str() != output_real_dir.str());
+
+		if (!ssgnc::tools::initFilePath(tier_real_dir.str(), "db",
+			num_tokens, &tier_path_) ||
+			!ssgnc::tools::initFilePath(output_dir, "db",
+			num_tokens, &link_path_))
+		{
+			SSGNC_ERROR << "ssgnc::tools::initFilePath() failed" << std::endl;
+			return false;
+		}
+		else if (!tier_path_.seek(file_id) || !link_path_.seek(file_id))
+		{
+			SSGNC_ERROR << "ssgnc::FilePath::seek() failed: " << file_id
+				<< std::endl;
+			return false;
+		}
+		return true;
+	}
+
+	// This function returns the ID of the next file.
+	ssgnc::Int32 close()
+	{
+		if (file_.is_open())
+		{
+			if (!file_.flush())
+				SSGNC_ERROR << "std::ofstream::flush() failed" << std::endl;
+			file_.close();
+			std::cerr << "File: " << file_path_ << ", File size: "
+				<< file_size_ << std::endl;
+		}
+
+		ssgnc::Int32 file_id = tier_path_.tell();
+		tier_path_.close();
+		link_path_.close();
+		file_path_.clear();
+		file_size_ = 0;
+		return file_id;
+	}
+
+	// This function returns the position of the next list.
+	bool beginList(WideFileEntry *entry)
+	{
+		if (!file_.is_open() || file_size_ >= MAX_FILE_SIZE)
+		{
+			if (!openNextFile())
+			{
+				SSGNC_ERROR << "ListWriter::openNextFile() failed"
+					<< std::endl;
+				return false;
+			}
+		}
+
+		if (!entry->set_file_id(tier_path_.tell() - 1) ||
+			!entry->set_offset(file_size_))
+		{
+			SSGNC_ERROR << "ssgnc::NgramIndex::WideFileEntry::set_offset() "
+				"failed: " << file_size_ << std::endl;
+			return false;
+		}
+		return true;
+	}
+
+	void endList(ssgnc::UInt64 list_size) { file_size_ += list_size; }
+
+	std::ofstream *file() { return &file_; }
+
+private:
+	ssgnc::FilePath tier_path_;
+	ssgnc::FilePath link_path_;
+	bool needs_link_;
+	std::ofstream file_;
+	ssgnc::StringBuilder file_path_;
+	ssgnc::UInt64 file_size_;
+
+	bool openNextFile()
+	{
+		if (file_.is_open())
+		{
+			if (!file_.flush())
+			{
+				SSGNC_ERROR << "std::ofstream::flush() failed" << std::endl;
+				return false;
+			}
+			file_.close();
+			std::cerr << "File: " << file_path_ << ", File size: "
+				<< file_size_ << std::endl;
+		}
+
+		ssgnc::StringBuilder link_path;
+		if (!tier_path_.read(&file_path_) || !link_path_.read(&link_path))
+		{
+			SSGNC_ERROR << "ssgnc::FilePath::read() failed" << std::endl;
+			return false;
+		}
+
+		file_.open(file_path_.ptr(), std::ios::binary);
+		if (!file_)
+		{
+			SSGNC_ERROR << "std::ofstream::open() failed: " << file_path_
+				<< std::endl;
+			return false;
+		}
+		file_size_ = 0;
+
+		if (needs_link_)
+		{
+			::unlink(link_path.ptr());
+			if (::symlink(file_path_.ptr(), link_path.ptr()) != 0)
+			{
+				SSGNC_ERROR << "::symlink() failed: " << file_path_ << ", "
+					<< link_path << std::endl;
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// Disallows copies.
+	ListWriter(const ListWriter &);
+	ListWriter &operator=(const ListWriter &);
+};
+
+bool readAccessLog(std::istream *in, CountMap *counts)
+{
+	std::string line;
+	while (ssgnc::tools::readLine(in, &line))
+	{
+		if (line.empty())
+			continue;
+
+		ssgnc::AccessLog::Record record;
+		if (!ssgnc::AccessLog::parse(ssgnc::String(line.c_str(),
+			static_cast<ssgnc::UInt32>(line.length())), &record))
+		{
+			SSGNC_ERROR << "ssgnc::AccessLog::parse() failed" << std::endl;
+			continue;
+		}
+
+		// Records of lists which are not identified by a token are ignored.
+		if (record.num_tokens() > ngram_index.max_num_tokens() ||
+			record.token_id() < 0 ||
+			record.token_id() > ngram_index.max_token_id())
+			continue;
+
+		++(*counts)[ListId(record.num_tokens(), record.token_id())];
+	}
+
+	if (in->bad())
+	{
+		SSGNC_ERROR << "ssgnc::tools::readLine() failed" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+// Frequently accessed lists come first. Short lists are preferred among
+// lists with the same count because they cost less of the hot tier.
+bool compareHotLists(const HotList &lhs, const HotList &rhs)
+{
+	if (lhs.count != rhs.count)
+		return lhs.count > rhs.count;
+	return lhs.size < rhs.size;
+}
+
+// The sizes of the source index are used to fill the hot tier. They are
+// approximate if a list of the original format spans files.
+bool chooseHotLists(const CountMap &counts, ssgnc::UInt64 hot_size,
+	std::vector<std::vector<ssgnc::Int32> > *hot_lists)
+{
+	std::vector<HotList> candidates;
+	for (CountMap::const_iterator it = counts.begin();
+		it != counts.end(); ++it)
+	{
+		ssgnc::NgramIndex::Entry entry;
+		if (!ngram_index.get(it->first.first, it->first.second, &entry))
+		{
+			SSGNC_ERROR << "ssgnc::NgramIndex::get() failed" << std::endl;
+			return false;
+		}
+
+		HotList hot_list;
+		hot_list.id = it->first;
+		hot_list.count = it->second;
+		hot_list.size = entry.approx_size();
+		candidates.push_back(hot_list);
+	}
+	std::sort(candidates.begin(), candidates.end(), compareHotLists);
+
+	hot_lists->resize(ngram_index.max_num_tokens() + 1);
+
+	ssgnc::UInt64 num_hot_lists = 0;
+	ssgnc::UInt64 total_size = 0;
+	for (std::size_t i = 0; i < candidates.size(); ++i)
+	{
+		ssgnc::UInt64 size = static_cast<ssgnc::UInt64>(candidates[i].size);
+		if (size > hot_size - total_size)
+			continue;
+
+		(*hot_lists)[candidates[i].id.first].push_back(
+			candidates[i].id.second);
+		total_size += size;
+		++num_hot_lists;
+	}
+
+	std::cerr << "No. hot lists: " << num_hot_lists
+		<< ", Hot size: " << total_size << std::endl;
+
+	return true;
+}
+
+bool relayoutList(ListReader *reader, ListWriter *writer,
+	ssgnc::Int32 num_tokens, ssgnc::Int32 token_id)
+{
+	WideFileEntry *entry = &entries[(static_cast<std::size_t>(
+		ngram_index.max_num_tokens()) * token_id) + num_tokens - 1];
+	ssgnc::UInt32 *list_size = &sizes[(static_cast<std::size_t>(
+		ngram_index.max_num_tokens()) * token_id) + num_tokens - 1];
+
+	if (!writer->beginList(entry))
+	{
+		SSGNC_ERROR << "ListWriter::beginList() failed" << std::endl;
+		return false;
+	}
+
+	ssgnc::UInt64 size;
+	if (!reader->copyList(writer->file(), &size))
+	{
+		SSGNC_ERROR << "ListReader::copyList() failed: "
+			<< num_tokens << ", " << token_id << std::endl;
+		return false;
+	}
+	writer->endList(size);
+
+	*list_size = (size > ssgnc::NgramIndex::MAX_LIST_SIZE)
+		? ssgnc::NgramIndex::MAX_LIST_SIZE : static_cast<ssgnc::UInt32>(size);
+	return true;
+}
+
+// Hot lists are packed at the front of the hot tier in order of their
+// counts. The other lists follow in the cold tier in order of token IDs.
+bool relayoutOrder(ssgnc::Int32 num_tokens,
+	const std::vector<ssgnc::Int32> &hot_lists, const ssgnc::String &output_dir,
+	const ssgnc::String &hot_dir, const ssgnc::String &cold_dir)
+{
+	std::vector<bool> is_hot(ngram_index.max_token_id() + 1, false);
+
+	ListWriter writer;
+	if (!writer.open(hot_dir, output_dir, num_tokens, 0))
+	{
+		SSGNC_ERROR << "ListWriter::open() failed: " << hot_dir << std::endl;
+		return false;
+	}
+
+	for (std::size_t i = 0; i < hot_lists.size(); ++i)
+	{
+		ssgnc::NgramIndex::Entry entry;
+		if (!ngram_index.get(num_tokens, hot_lists[i], &entry))
+		{
+			SSGNC_ERROR << "ssgnc::NgramIndex::get() failed" << std::endl;
+			return false;
+		}
+
+		ListReader reader;
+		if (!reader.open(num_tokens, entry) ||
+			!relayoutList(&reader, &writer, num_tokens, hot_lists[i]))
+		{
+			SSGNC_ERROR << "relayoutList() failed" << std::endl;
+			return false;
+		}
+		is_hot[hot_lists[i]] = true;
+	}
+
+	ssgnc::Int32 file_id = writer.close();
+	if (!writer.open(cold_dir, output_dir, num_tokens, file_id))
+	{
+		SSGNC_ERROR << "ListWriter::open() failed: " << cold_dir << std::endl;
+		return false;
+	}
+
+	ssgnc::NgramIndex::Entry entry;
+	ListReader reader;
+	if (!ngram_index.get(num_tokens, 0, &entry) ||
+		!reader.open(num_tokens, entry))
+	{
+		SSGNC_ERROR << "ListReader::open() failed" << std::endl;
+		return false;
+	}
+
+	for (ssgnc::Int32 token_id = 0; token_id <= ngram_index.max_token_id();
+		++token_id)
+	{
+		if (is_hot[token_id])
+		{
+			ssgnc::UInt64 size;
+			if (!reader.copyList(NULL, &size))
+			{
+				SSGNC_ERROR << "ListReader::copyList() failed" << std::endl;
+				return false;
+			}
+		}
+		else if (!relayoutList(&reader, &writer, num_tokens, token_id))
+		{
+			SSGNC_ERROR << "relayoutList() failed" << std::endl;
+			return false;
+		}
+	}
+
+	writer.close();
+	return true;
+}
+
+bool writeIndex(const ssgnc::String &output_dir)
+{
+	ssgnc::StringBuilder path;
+	if (!ssgnc::FilePath::join(output_dir, "ngms.idx", &path))
+	{
+		SSGNC_ERROR << "ssgnc::FilePath::join() failed" << std::endl;
+		return false;
+	}
+
+	std::ofstream file(path.ptr(), std::ios::binary);
+	if (!file)
+	{
+		SSGNC_ERROR << "std::ofstream::open() failed: " << path << std::endl;
+		return false;
+	}
+
+	ssgnc::Writer writer;
+	if (!writer.open(&file))
+	{
+		SSGNC_ERROR << "ssgnc::Writer::open() failed" << std::endl;
+		return false;
+	}
+
+	if (!writer.write(static_cast<ssgnc::Int32>(
+		ssgnc::NgramIndex::FORMAT_MARKER)) ||
+		!writer.write(static_cast<ssgnc::Int32>(
+		ssgnc::NgramIndex::WIDE_FORMAT | ssgnc::NgramIndex::SIZED_FORMAT)) ||
+		!writer.write(ngram_index.max_num_tokens()) ||
+		!writer.write(ngram_index.max_token_id()))
+	{
+		SSGNC_ERROR << "ssgnc::Writer::write() failed: header" << std::endl;
+		return false;
+	}
+	else if (!writer.write(&entries[0], entries.size()) ||
+		!writer.write(&sizes[0], sizes.size()))
+	{
+		SSGNC_ERROR << "ssgnc::Writer::write() failed: entries" << std::endl;
+		return false;
+	}
+
+	if (!file.flush())
+	{
+		SSGNC_ERROR << "std::ofstream::flush() failed" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+bool copyVocabDic(const ssgnc::String &output_dir)
+{
+	ssgnc::StringBuilder src_path, dest_path;
+	if (!ssgnc::FilePath::join(index_dir.str(), "vocab.dic", &src_path) ||
+		!ssgnc::FilePath::join(output_dir, "vocab.dic", &dest_path))
+	{
+		SSGNC_ERROR << "ssgnc::FilePath::join() failed" << std::endl;
+		return false;
+	}
+
+	std::ifstream src_file(src_path.ptr(), std::ios::binary);
+	std::ofstream dest_file(dest_path.ptr(), std::ios::binary);
+	if (!src_file || !dest_file)
+	{
+		SSGNC_ERROR << "std::fstream::open() failed: "
+			<< src_path << ", " << dest_path << std::endl;
+		return false;
+	}
+
+	if (!(dest_file << src_file.rdbuf()) || !dest_file.flush())
+	{
+		SSGNC_ERROR << "std::ofstream::operator<<() failed" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+bool relayout(const ssgnc::String &output_dir, const ssgnc::String &hot_dir,
+	const ssgnc::String &cold_dir, ssgnc::UInt64 hot_size,
+	const CountMap &counts)
+{
+	// The source files must not be overwritten while they are read.
+	ssgnc::StringBuilder index_real_dir;
+	if (!getRealPath(index_dir.str(), &index_real_dir))
+		return false;
+
+	const ssgnc::String dirs[] = { output_dir, hot_dir, cold_dir };
+	for (std::size_t i = 0; i < sizeof(dirs) / sizeof(dirs[0]); ++i)
+	{
+		ssgnc::StringBuilder real_dir;
+		if (!getRealPath(dirs[i], &real_dir))
+			return false;
+		else if (real_dir.str() == index_real_dir.str())
+		{
+			SSGNC_ERROR << "Same as INDEX_DIR: " << dirs[i] << std::endl;
+			return false;
+		}
+	}
+
+	std::vector<std::vector<ssgnc::Int32> > hot_lists;
+	if (!chooseHotLists(counts, hot_size, &hot_lists))
+	{
+		SSGNC_ERROR << "chooseHotLists() failed" << std::endl;
+		return false;
+	}
+
+	std::size_t num_entries = static_cast<std::size_t>(
+		ngram_index.max_num_tokens()) * (ngram_index.max_token_id() + 1);
+	try
+	{
+		entries.resize(num_entries);
+		sizes.resize(num_entries);
+	}
+	catch (...)
+	{
+		SSGNC_ERROR << "std::vector<ssgnc::NgramIndex::WideFileEntry>::"
+			"resize() failed: " << num_entries << std::endl;
+		return false;
+	}
+
+	for (ssgnc::Int32 num_tokens = 1;
+		num_tokens <= ngram_index.max_num_tokens(); ++num_tokens)
+	{
+		if (!relayoutOrder(num_tokens, hot_lists[num_tokens],
+			output_dir, hot_dir, cold_dir))
+		{
+			SSGNC_ERROR << "relayoutOrder() failed: " << num_tokens
+				<< std::endl;
+			return false;
+		}
+	}
+
+	if (!writeIndex(output_dir) || !copyVocabDic(output_dir))
+		return false;
+
+	return true;
+}
+
+}  // namespace
+
+int main(int argc, char *argv[])
+{
+	ssgnc::tools::initIO();
+
+	if (argc < 6)
+	{
+		std::cerr << "Usage: " << argv[0]
+			<< " INDEX_DIR OUTPUT_DIR HOT_DIR COLD_DIR HOT_SIZE [ACCESS_LOG]..."
+			<< std::endl;
+		std::cerr << "OUTPUT_DIR: OUTPUT_DIR/vocab.dic, ngms.idx, "
+			"Ngm-KKKK.db (links)" << std::endl;
+		std::cerr << "HOT_SIZE: the maximum number of bytes in HOT_DIR"
+			<< std::endl;
+		std::cerr << "ACCESS_LOG: written by SSGNC_ACCESS_LOG=FILE ssgnc-search"
+			<< std::endl;
+		return 1;
+	}
+
+	ssgnc::Int64 hot_size;
+	if (!ssgnc::tools::parseInt64(argv[5], &hot_size) || hot_size < 0)
+	{
+		SSGNC_ERROR << "Invalid hot size: " << argv[5] << std::endl;
+		return 1;
+	}
+
+	if (!index_dir.append(argv[1]) || !index_dir.append() ||
+		!shard_map.open(index_dir.str()))
+		return 2;
+
+	ssgnc::StringBuilder path;
+	if (!ssgnc::FilePath::join(index_dir.str(), "vocab.dic", &path) ||
+		!vocab_dic.open(path.ptr()))
+		return 2;
+	else if (!ssgnc::FilePath::join(index_dir.str(), "ngms.idx", &path) ||
+		!ngram_index.open(path.ptr()))
+		return 2;
+
+	CountMap counts;
+	if (argc == 6 && !readAccessLog(&std::cin, &counts))
+		return 3;
+	for (int i = 6; i < argc; ++i)
+	{
+		std::ifstream file(argv[i], std::ios::binary);
+		if (!file)
+		{
+			SSGNC_ERROR << "std::ifstream::open() failed: "
+				<< argv[i] << std::endl;
+			return 3;
+		}
+		else if (!readAccessLog(&file, &counts))
+			return 3;
+	}
+
+	if (!relayout(argv[2], argv[3], argv[4],
+		static_cast<ssgnc::UInt64>(hot_size), counts))
+		return 4;
+
+	return 0;
+}
@@ -0,0 +1,216 @@
+#include "tools-common.h"
+
+#include <cstdio>
+
+#include <sys/time.h>
+
+namespace {
+
+enum { BATCH_SIZE = 1 << 10 };
+
+ssgnc::Database database;
+ssgnc::NgramStats::Builder builder;
+ssgnc::UInt64 total_ngrams = 0;
+
+// The n-grams of a list are counted for each bucket of frequencies and added
+// to the sketch of the list. An n-gram is counted for its order and added to
+// the pair filter only by the list of its smallest token.
+bool collectList(ssgnc::Int32 num_tokens, ssgnc::Int32 token_id,
+	const ssgnc::Query &query, ssgnc::Agent *agent,
+	ssgnc::ResultBatch *batch)
+{
+	ssgnc::NgramIndex::Entry entry;
+	if (!database.ngram_index().get(num_tokens, token_id, &entry))
+	{
+		SSGNC_ERROR << "ssgnc::NgramIndex::get() failed" << std::endl;
+		return false;
+	}
+
+	ssgnc::UInt64 freq_counts[ssgnc::NgramStats::NUM_FREQ_BUCKETS] = { 0 };
+	ssgnc::UInt64 num_first_ngrams = 0;
+	ssgnc::NgramStats::Sketch sketch;
+	sketch.clear();
+	if (entry.approx_size() > 1)
+	{
+		std::vector<ssgnc::Agent::Source> sources(1,
+			ssgnc::Agent::Source(num_tokens, token_id, entry));
+		if (!agent->open(database.shard_map(), query, sources))
+		{
+			SSGNC_ERROR << "ssgnc::Agent::open() failed" << std::endl;
+			return false;
+		}
+
+		while (agent->readBatch(batch, BATCH_SIZE))
+		{
+			for (ssgnc::UInt32 i = 0; i < batch->size(); ++i)
+			{
+				++freq_counts[ssgnc::NgramStats::freqBucket(
+					batch->encoded_freq(i))];
+
+				const ssgnc::Int32 *tokens = batch->tokens(i);
+				sketch.add(tokens, batch->num_tokens(i));
+
+				ssgnc::Int32 min_token = tokens[0];
+				for (ssgnc::Int32 j = 1; j < batch->num_tokens(i); ++j)
+				{
+					if (tokens[j] < min_token)
+						min_token = tokens[j];
+				}
+				if (min_token == token_id)
+				{
+					if (!builder.appendPairs(tokens, batch->num_tokens(i)))
+					{
+						SSGNC_ERROR << "ssgnc::NgramStats::Builder::"
+							"appendPairs() failed" << std::endl;
+						return false;
+					}
+					++num_first_ngrams;
+				}
+			}
+			total_ngrams += batch->size();
+		}
+
+		if (agent->bad())
+		{
+			SSGNC_ERROR << "ssgnc::Agent::readBatch() failed" << std::endl;
+			return false;
+		}
+		else if (!agent->close())
+		{
+			SSGNC_ERROR << "ssgnc::Agent::close() failed" << std::endl;
+			return false;
+		}
+	}
+
+	if (!builder.appendList(num_tokens, token_id, freq_counts, sketch,
+		num_first_ngrams))
+	{
+		SSGNC_ERROR << "ssgnc::NgramStats::Builder::appendList() failed"
+			<< std::endl;
+		return false;
+	}
+	return true;
+}
+
+double getTime()
+{
+	struct timeval tv;
+	::gettimeofday(&tv, NULL);
+	return tv.tv_sec + (tv.tv_usec * 0.000001);
+}
+
+// A query of a meta token matches all the n-grams of a list. The time to
+// read the lists is measured as the scan cost of searches.
+bool collectLists()
+{
+	ssgnc::Query query;
+	if (!query.appendToken(ssgnc::Query::META_TOKEN) ||
+		!query.set_max_num_results(0) || !query.set_io_limit(0) ||
+		!query.set_time_limit(0) || !query.set_scan_limit(0))
+	{
+		SSGNC_ERROR << "ssgnc::Query::appendToken() failed" << std::endl;
+		return false;
+	}
+
+	ssgnc::Agent agent;
+	ssgnc::ResultBatch batch;
+	double start_time = getTime();
+	for (ssgnc::Int32 i = 1; i <= database.max_num_tokens(); ++i)
+	{
+		for (ssgnc::Int32 j = 0; j <= database.max_token_id(); ++j)
+		{
+			if (!collectList(i, j, query, &agent, &batch))
+				return false;
+		}
+
+		std::cerr << "No. " << i << "-grams: " << builder.num_ngrams(i)
+			<< ", No. histograms: " << builder.num_histograms()
+			<< std::endl;
+	}
+
+	double elapsed_time = getTime() - start_time;
+	double scan_cost = (total_ngrams != 0) ?
+		(elapsed_time * 1000000000000.0 / total_ngrams) : 0.0;
+	if (scan_cost < 1.0)
+		scan_cost = 1.0;
+	else if (scan_cost > 0xFFFFFFFFU)
+		scan_cost = 0xFFFFFFFFU;
+	builder.set_scan_cost(static_cast<ssgnc::UInt32>(scan_cost));
+
+	std::cerr << "Scan cost: " << builder.scan_cost()
+		<< " ns / 1,000 n-grams" << std::endl;
+	return true;
+}
+
+bool writeStats(const ssgnc::String &index_dir)
+{
+	ssgnc::StringBuilder path, temp_path;
+	if (!ssgnc::FilePath::join(index_dir, "ngms.stat", &path) ||
+		!temp_path.append(path.str()) || !temp_path.append(".tmp") ||
+		!temp_path.append())
+	{
+		SSGNC_ERROR << "ssgnc::FilePath::join() failed" << std::endl;
+		return false;
+	}
+
+	std::ofstream file(temp_path.ptr(), std::ios::binary);
+	if (!file)
+	{
+		SSGNC_ERROR << "std::ofstream::open() failed: "
+			<< temp_path << std::endl;
+		return false;
+	}
+
+	if (!builder.write(&file) || !file.flush())
+	{
+		SSGNC_ERROR << "ssgnc::NgramStats::Builder::write() failed"
+			<< std::endl;
+		return false;
+	}
+	file.close();
+
+	std::cerr << "No. pairs: " << builder.num_pairs() << std::endl;
+
+	// The file is replaced at once, because servers may be reading it.
+	if (std::rename(temp_path.ptr(), path.ptr()) != 0)
+	{
+		SSGNC_ERROR << "std::rename() failed: " << temp_path
+			<< ", " << path << std::endl;
+		return false;
+	}
+
+	std::cerr << "File: " << path << std::endl;
+	return true;
+}
+
+}  // namespace
+
+int main(int argc, char *argv[])
+{
+	ssgnc::tools::initIO();
+
+	if (argc != 2)
+	{
+		std::cerr << "Usage: " << argv[0] << " INDEX_DIR\n\n"
+			<< "The statistics of the lists are written into "
+			"INDEX_DIR/ngms.stat.\n";
+		return 1;
+	}
+
+	// The statistics are rebuilt even if they are stale.
+	if (!database.open(argv[1], ssgnc::FileMap::DEFAULT_MODE, false))
+		return 2;
+
+	if (!builder.init(database.max_num_tokens(), database.max_token_id()))
+		return 3;
+	builder.set_index(database.ngram_index().size(),
+		database.ngram_index().fingerprint());
+
+	if (!collectLists())
+		return 3;
+
+	if (!writeStats(argv[1]))
+		return 4;
+
+	return 0;
+}
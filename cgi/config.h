@@ -26,6 +26,9 @@ public:
 	static Int64 MAX_MAX_NUM_RESULTS() { return 0LL; }
 	static Int64 MAX_IO_LIMIT() { return 1LL << 20; }
 
+	// The number of threads of a FastCGI responder.
+	static Int32 NUM_THREADS() { return 4; }
+
 private:
 	Config();
 };
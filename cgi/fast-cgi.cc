@@ -0,0 +1,394 @@
+#include "fast-cgi.h"
+
+#include <cerrno>
+
+#include <sys/socket.h>
+
+namespace ssgnc {
+namespace cgi {
+
+namespace {
+
+enum { OUT_BUF_SIZE = 1 << 13 };
+
+UInt32 readLength(const char **ptr, const char *end)
+{
+	if (*ptr >= end)
+		return 0xFFFFFFFFU;
+
+	UInt32 length = static_cast<UInt8>(**ptr);
+	if ((length & 0x80) == 0)
+	{
+		++*ptr;
+		return length;
+	}
+	else if (end - *ptr < 4)
+		return 0xFFFFFFFFU;
+
+	length = ((length & 0x7F) << 24)
+		| (static_cast<UInt32>(static_cast<UInt8>((*ptr)[1])) << 16)
+		| (static_cast<UInt32>(static_cast<UInt8>((*ptr)[2])) << 8)
+		| static_cast<UInt32>(static_cast<UInt8>((*ptr)[3]));
+	*ptr += 4;
+	return length;
+}
+
+}  // namespace
+
+FastCgiRequest::FastCgiRequest() : std::streambuf(), conn_buf_(),
+	conn_(&conn_buf_), request_id_(0), keep_conn_(false), params_buf_(),
+	params_(), content_(), out_buf_(OUT_BUF_SIZE)
+{
+	setp(&out_buf_[0], &out_buf_[0] + out_buf_.size());
+}
+
+FastCgiRequest::~FastCgiRequest()
+{
+	if (is_open())
+		close();
+}
+
+bool FastCgiRequest::open(int fd)
+{
+	if (is_open())
+	{
+		SSGNC_ERROR << "Already opened" << std::endl;
+		return false;
+	}
+
+	if (!conn_buf_.open(fd))
+	{
+		SSGNC_ERROR << "ssgnc::FdStreambuf::open() failed" << std::endl;
+		return false;
+	}
+
+	conn_.clear();
+	request_id_ = 0;
+	keep_conn_ = false;
+	setp(&out_buf_[0], &out_buf_[0] + out_buf_.size());
+	return true;
+}
+
+bool FastCgiRequest::close()
+{
+	if (!is_open())
+	{
+		SSGNC_ERROR << "Not opened" << std::endl;
+		return false;
+	}
+
+	conn_buf_.close();
+	request_id_ = 0;
+	keep_conn_ = false;
+	params_buf_.clear();
+	params_.clear();
+	setp(&out_buf_[0], &out_buf_[0] + out_buf_.size());
+	return true;
+}
+
+bool FastCgiRequest::accept()
+{
+	if (!is_open())
+	{
+		SSGNC_ERROR << "Not opened" << std::endl;
+		return false;
+	}
+
+	request_id_ = 0;
+	keep_conn_ = false;
+	params_buf_.clear();
+	params_.clear();
+
+	bool has_params = false;
+	bool has_stdin = false;
+	while (!has_params || !has_stdin)
+	{
+		Header header;
+		if (!readRecord(&header))
+			return false;
+
+		// Management records have a request ID of 0.
+		if (header.request_id == 0)
+		{
+			if (header.type == GET_VALUES)
+			{
+				if (!writeValues())
+					return false;
+			}
+			else
+			{
+				char content[8] = { static_cast<char>(header.type) };
+				if (!writeRecord(UNKNOWN_TYPE, 0, content, sizeof(content)))
+					return false;
+			}
+
+			if (!conn_.flush())
+				return false;
+			continue;
+		}
+
+		switch (header.type)
+		{
+		case BEGIN_REQUEST:
+			if (header.content_length < 8)
+			{
+				SSGNC_ERROR << "Too short FCGI_BEGIN_REQUEST" << std::endl;
+				return false;
+			}
+			else if (request_id_ != 0)
+			{
+				if (!writeEndRequest(header.request_id, CANT_MPX_CONN) ||
+					!conn_.flush())
+					return false;
+			}
+			else if (((static_cast<UInt8>(content_[0]) << 8)
+				| static_cast<UInt8>(content_[1])) != RESPONDER)
+			{
+				if (!writeEndRequest(header.request_id, UNKNOWN_ROLE) ||
+					!conn_.flush())
+					return false;
+			}
+			else
+			{
+				request_id_ = header.request_id;
+				keep_conn_ = (content_[2] & KEEP_CONN) != 0;
+			}
+			break;
+		case ABORT_REQUEST:
+			if (header.request_id == request_id_)
+			{
+				bool keep_conn = keep_conn_;
+				if (!writeEndRequest(request_id_, REQUEST_COMPLETE) ||
+					!conn_.flush())
+					return false;
+				else if (!keep_conn)
+					return false;
+
+				request_id_ = 0;
+				params_buf_.clear();
+				has_params = has_stdin = false;
+			}
+			break;
+		case PARAMS:
+			if (header.request_id != request_id_)
+				break;
+			else if (header.content_length == 0)
+				has_params = true;
+			else
+			{
+				try
+				{
+					params_buf_.insert(params_buf_.end(), content_.begin(),
+						content_.begin() + header.content_length);
+				}
+				catch (...)
+				{
+					SSGNC_ERROR << "std::vector<char>::insert() failed: "
+						<< params_buf_.size() << std::endl;
+					return false;
+				}
+			}
+			break;
+		case STDIN:
+			// The body of a request is ignored because parameters are given
+			// as a query string.
+			if (header.request_id == request_id_ &&
+				header.content_length == 0)
+				has_stdin = true;
+			break;
+		default:
+			break;
+		}
+	}
+
+	if (!parseParams())
+	{
+		SSGNC_ERROR << "ssgnc::cgi::FastCgiRequest::parseParams() failed"
+			<< std::endl;
+		return false;
+	}
+	return true;
+}
+
+bool FastCgiRequest::finish()
+{
+	if (!is_open() || request_id_ == 0)
+	{
+		SSGNC_ERROR << "No request" << std::endl;
+		return false;
+	}
+
+	if (!flushOut() || !writeRecord(STDOUT, request_id_, NULL, 0) ||
+		!writeEndRequest(request_id_, REQUEST_COMPLETE) || !conn_.flush())
+	{
+		SSGNC_ERROR << "Failed to end a request: " << request_id_ << std::endl;
+		return false;
+	}
+
+	request_id_ = 0;
+	return true;
+}
+
+String FastCgiRequest::param(const String &name) const
+{
+	std::map<std::string, std::string>::const_iterator it =
+		params_.find(std::string(name.ptr(), name.length()));
+	if (it == params_.end())
+		return String();
+	return String(it->second.c_str(),
+		static_cast<UInt32>(it->second.length()));
+}
+
+bool FastCgiRequest::isListenSocket(int fd)
+{
+	struct sockaddr_storage address;
+	socklen_t address_length = sizeof(address);
+	return ::getpeername(fd, reinterpret_cast<struct sockaddr *>(&address),
+		&address_length) == -1 && errno == ENOTCONN;
+}
+
+FastCgiRequest::int_type FastCgiRequest::overflow(int_type c)
+{
+	if (!flushOut())
+		return traits_type::eof();
+
+	if (!traits_type::eq_int_type(c, traits_type::eof()))
+	{
+		*pptr() = traits_type::to_char_type(c);
+		pbump(1);
+	}
+	return traits_type::not_eof(c);
+}
+
+int FastCgiRequest::sync()
+{
+	return (flushOut() && conn_.flush()) ? 0 : -1;
+}
+
+bool FastCgiRequest::readRecord(Header *header)
+{
+	unsigned char bytes[HEADER_SIZE];
+	if (!conn_.read(reinterpret_cast<char *>(bytes), sizeof(bytes)))
+	{
+		// The web server may close a connection between records.
+		if (conn_.gcount() != 0)
+			SSGNC_ERROR << "std::iostream::read() failed: header" << std::endl;
+		return false;
+	}
+	else if (bytes[0] != PROTOCOL_VERSION)
+	{
+		SSGNC_ERROR << "Unsupported version: "
+			<< static_cast<int>(bytes[0]) << std::endl;
+		return false;
+	}
+
+	header->type = bytes[1];
+	header->request_id = (bytes[2] << 8) | bytes[3];
+	header->content_length = (bytes[4] << 8) | bytes[5];
+	header->padding_length = bytes[6];
+
+	try
+	{
+		content_.resize(header->content_length + header->padding_length);
+	}
+	catch (...)
+	{
+		SSGNC_ERROR << "std::vector<char>::resize() failed: "
+			<< header->content_length << std::endl;
+		return false;
+	}
+
+	if (!content_.empty() && !conn_.read(&content_[0], content_.size()))
+	{
+		SSGNC_ERROR << "std::iostream::read() failed: content" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+bool FastCgiRequest::writeRecord(Int32 type, Int32 request_id,
+	const char *content, Int32 content_length)
+{
+	static const char PADDING[8] = { 0 };
+
+	Int32 padding_length = (8 - (content_length & 7)) & 7;
+	char bytes[HEADER_SIZE] = {
+		static_cast<char>(PROTOCOL_VERSION), static_cast<char>(type),
+		static_cast<char>(request_id >> 8), static_cast<char>(request_id),
+		static_cast<char>(content_length >> 8),
+		static_cast<char>(content_length),
+		static_cast<char>(padding_length), 0
+	};
+
+	if (!conn_.write(bytes, sizeof(bytes)) ||
+		(content_length > 0 && !conn_.write(content, content_length)) ||
+		!conn_.write(PADDING, padding_length))
+	{
+		SSGNC_ERROR << "std::iostream::write() failed" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+bool FastCgiRequest::writeEndRequest(Int32 request_id, ProtocolStatus status)
+{
+	char content[8] = { 0, 0, 0, 0, static_cast<char>(status) };
+	return writeRecord(END_REQUEST, request_id, content, sizeof(content));
+}
+
+// Only FCGI_MPXS_CONNS is answered because the other values are optional.
+bool FastCgiRequest::writeValues()
+{
+	static const char CONTENT[] = "\x0F\x01" "FCGI_MPXS_CONNS" "0";
+	return writeRecord(GET_VALUES_RESULT, 0, CONTENT, sizeof(CONTENT) - 1);
+}
+
+bool FastCgiRequest::parseParams()
+{
+	const char *ptr = params_buf_.empty() ? NULL : &params_buf_[0];
+	const char *end = ptr + params_buf_.size();
+	while (ptr < end)
+	{
+		UInt32 name_length = readLength(&ptr, end);
+		UInt32 value_length = readLength(&ptr, end);
+		if (name_length > static_cast<UInt32>(end - ptr) ||
+			value_length > static_cast<UInt32>(end - ptr - name_length))
+		{
+			SSGNC_ERROR << "Broken name-value pair" << std::endl;
+			return false;
+		}
+
+		try
+		{
+			params_[std::string(ptr, name_length)].assign(
+				ptr + name_length, value_length);
+		}
+		catch (...)
+		{
+			SSGNC_ERROR << "std::map::operator[]() failed" << std::endl;
+			return false;
+		}
+		ptr += name_length + value_length;
+	}
+	return true;
+}
+
+bool FastCgiRequest::flushOut()
+{
+	if (pptr() == pbase())
+		return true;
+
+	if (request_id_ == 0)
+	{
+		SSGNC_ERROR << "No request" << std::endl;
+		setp(&out_buf_[0], &out_buf_[0] + out_buf_.size());
+		return false;
+	}
+
+	Int32 length = static_cast<Int32>(pptr() - pbase());
+	setp(&out_buf_[0], &out_buf_[0] + out_buf_.size());
+	return writeRecord(STDOUT, request_id_, &out_buf_[0], length);
+}
+
+}  // namespace cgi
+}  // namespace ssgnc
@@ -0,0 +1,93 @@
+#ifndef SSGNC_CGI_FAST_CGI_H
+#define SSGNC_CGI_FAST_CGI_H
+
+#include <ssgnc.h>
+
+#include <map>
+#include <string>
+
+namespace ssgnc {
+namespace cgi {
+
+// A FastCGI request of the responder role. The requests on a connection are
+// served one at a time, so multiplexed requests are rejected. The response
+// is written to this stream buffer and sent as FCGI_STDOUT records.
+class FastCgiRequest : public std::streambuf
+{
+public:
+	FastCgiRequest();
+	~FastCgiRequest();
+
+	// The connection is closed when the request is closed.
+	bool open(int fd) SSGNC_WARN_UNUSED_RESULT;
+	bool close();
+
+	// Reads the parameters of the next request. This function returns false
+	// if the connection is closed by the web server.
+	bool accept() SSGNC_WARN_UNUSED_RESULT;
+	// Ends the current request. The connection should be closed after that
+	// if keep_conn() returns false.
+	bool finish() SSGNC_WARN_UNUSED_RESULT;
+
+	bool is_open() const { return conn_buf_.is_open(); }
+	bool keep_conn() const { return keep_conn_; }
+
+	// An empty string is returned if there is no such parameter.
+	String param(const String &name) const;
+
+	// A file descriptor, which is passed as the standard input by a web
+	// server, is a listening socket.
+	static bool isListenSocket(int fd);
+
+	enum RecordType
+	{
+		BEGIN_REQUEST = 1, ABORT_REQUEST, END_REQUEST, PARAMS, STDIN,
+		STDOUT, STDERR, DATA, GET_VALUES, GET_VALUES_RESULT, UNKNOWN_TYPE
+	};
+	enum ProtocolStatus
+	{
+		REQUEST_COMPLETE, CANT_MPX_CONN, OVERLOADED, UNKNOWN_ROLE
+	};
+	enum { PROTOCOL_VERSION = 1, RESPONDER = 1, KEEP_CONN = 1 };
+	enum { HEADER_SIZE = 8, MAX_CONTENT_LENGTH = 0xFFFF };
+
+protected:
+	int_type overflow(int_type c);
+	int sync();
+
+private:
+	struct Header
+	{
+		Int32 type;
+		Int32 request_id;
+		Int32 content_length;
+		Int32 padding_length;
+	};
+
+	FdStreambuf conn_buf_;
+	std::iostream conn_;
+	Int32 request_id_;
+	bool keep_conn_;
+	std::vector<char> params_buf_;
+	std::map<std::string, std::string> params_;
+	std::vector<char> content_;
+	std::vector<char> out_buf_;
+
+	bool readRecord(Header *header) SSGNC_WARN_UNUSED_RESULT;
+	bool writeRecord(Int32 type, Int32 request_id, const char *content,
+		Int32 content_length) SSGNC_WARN_UNUSED_RESULT;
+	bool writeEndRequest(Int32 request_id, ProtocolStatus status)
+		SSGNC_WARN_UNUSED_RESULT;
+	bool writeValues() SSGNC_WARN_UNUSED_RESULT;
+	bool parseParams() SSGNC_WARN_UNUSED_RESULT;
+	bool flushOut() SSGNC_WARN_UNUSED_RESULT;
+
+	// Disallows copies.
+	FastCgiRequest(const FastCgiRequest &);
+	FastCgiRequest &operator=(const FastCgiRequest &);
+};
+
+}  // namespace cgi
+}  // namespace ssgnc
+
+#endif  // SSGNC_CGI_FAST_CGI_H
@@ -1,10 +1,14 @@
 #include "config.h"
+#include "fast-cgi.h"
 
+#include <csignal>
 #include <cstdlib>
 #include <iostream>
 #include <map>
 #include <vector>
 
+#include <pthread.h>
+
 namespace {
 
 using namespace ssgnc;
@@ -12,125 +16,196 @@ using namespace ssgnc;
 typedef std::pair<String, String> KeyValuePair;
 typedef std::map<String, String> KeyValueMap;
 
-MemPool mem_pool;
-KeyValueMap key_value_map;
-
-Query query;
-String query_str;
-StringBuilder char_tokens_buf;
+enum { MAX_NUM_THREADS = 256 };
 
+// The database is opened once and shared by handlers.
 Database database;
-Agent agent;
-
-Int16 encoded_freq;
-std::vector<Int32> tokens;
-
-Int64 freq;
-std::vector<String> token_strs;
-StringBuilder ngram_buf;
-StringBuilder token_buf;
 
-// A query string is read by std::getenv(). This means that this function
-// parses only parameters of GET requests.
-void setupQuery()
+// A handler keeps the objects used to serve a request. They are reset
+// before each request, so a handler serves requests one after another.
+class Handler
+{
+public:
+	Handler() : mem_pool_(), key_value_map_(), query_(), query_str_(),
+		char_tokens_buf_(), agent_(), cursor_(), cursor_buf_(),
+		encoded_freq_(0), tokens_(), freq_(0), token_strs_(), ngram_buf_(),
+		token_buf_(), out_(&std::cout) {}
+
+	void handle(const String &query_string, std::ostream *out);
+
+private:
+	MemPool mem_pool_;
+	KeyValueMap key_value_map_;
+
+	Query query_;
+	String query_str_;
+	StringBuilder char_tokens_buf_;
+
+	Agent agent_;
+	Cursor cursor_;
+	StringBuilder cursor_buf_;
+
+	Int16 encoded_freq_;
+	std::vector<Int32> tokens_;
+
+	Int64 freq_;
+	std::vector<String> token_strs_;
+	StringBuilder ngram_buf_;
+	StringBuilder token_buf_;
+
+	std::ostream *out_;
+
+	void reset();
+	void setupQuery(const String &query_string);
+	void splitCharTokens();
+	void search();
+	void printToken(const String &token);
+	void printHtmlHeader();
+	void printHtmlForm();
+	void printXmlQuery();
+	void printXmlCursor();
+	void handleHtmlRequest();
+	void handleTextRequest();
+	void handleXmlRequest();
+
+	// Disallows copies.
+	Handler(const Handler &);
+	Handler &operator=(const Handler &);
+};
+
+// A query string is given by the environment variable or the parameter
+// QUERY_STRING. This means that this function parses only parameters of GET
+// requests.
+void Handler::setupQuery(const String &query_string)
 {
 	// If the CGI program is used through browsers, the number of results
 	// should be limited. Also, the IO limit is useful to shorten the
 	// worst case response time.
 
 	// These default settings are defined in config.h.
-	query.set_max_num_results(cgi::Config::DEFAULT_MAX_NUM_RESULTS());
-	query.set_io_limit(cgi::Config::DEFAULT_IO_LIMIT());
+	query_.set_max_num_results(cgi::Config::DEFAULT_MAX_NUM_RESULTS());
+	query_.set_io_limit(cgi::Config::DEFAULT_IO_LIMIT());
 
 	// Parses the query string of the GET request.
 	std::vector<KeyValuePair> key_value_pairs;
-	query.parseQueryString(std::getenv("QUERY_STRING"),
-		&mem_pool, &key_value_pairs);
-	key_value_map.insert(key_value_pairs.begin(), key_value_pairs.end());
+	query_.parseQueryString(query_string, &mem_pool_, &key_value_pairs);
+	key_value_map_.insert(key_value_pairs.begin(), key_value_pairs.end());
 
 	// These limitations are defined in config.h.
 	if (cgi::Config::MAX_MAX_NUM_RESULTS() != 0 &&
-		(query.max_num_results() == 0 || query.max_num_results()
+		(query_.max_num_results() == 0 || query_.max_num_results()
 		> static_cast<UInt64>(cgi::Config::MAX_MAX_NUM_RESULTS())))
-		query.set_max_num_results(cgi::Config::MAX_MAX_NUM_RESULTS());
+		query_.set_max_num_results(cgi::Config::MAX_MAX_NUM_RESULTS());
 
 	if (cgi::Config::MAX_IO_LIMIT() != 0 &&
-		(query.io_limit() == 0 || query.io_limit()
+		(query_.io_limit() == 0 || query_.io_limit()
 		> static_cast<UInt64>(cgi::Config::MAX_IO_LIMIT())))
-		query.set_io_limit(cgi::Config::MAX_IO_LIMIT());
+		query_.set_io_limit(cgi::Config::MAX_IO_LIMIT());
 }
 
 // If the token type is CHAR_TOKEN, the CGI program splits the given query
 // parameter into character tokens.
-void splitCharTokens()
+void Handler::splitCharTokens()
 {
 	// These special tokens are not divided into characters.
 	static const String START_TAG = "<S>";
 	static const String END_TAG = "</S>";
 
-	while (!query_str.empty())
+	while (!query_str_.empty())
 	{
 		String token;
-		if (query_str.startsWith(START_TAG))
-			token = query_str.substr(0, START_TAG.length());
-		else if (query_str.startsWith(END_TAG))
-			token = query_str.substr(0, END_TAG.length());
+		if (query_str_.startsWith(START_TAG))
+			token = query_str_.substr(0, START_TAG.length());
+		else if (query_str_.startsWith(END_TAG))
+			token = query_str_.substr(0, END_TAG.length());
 		else
 		{
 			// A UTF-8 string can be easily divided into code points because
 			// the 1st byte & 0xC0 must be 0x00, 0x40 or 0xC0.
 			UInt32 token_length = 1;
-			while (token_length < query_str.length())
+			while (token_length < query_str_.length())
 			{
-				if ((static_cast<UInt8>(query_str[token_length]) & 0xC0)
+				if ((static_cast<UInt8>(query_str_[token_length]) & 0xC0)
 					!= 0x80)
 					break;
 				++token_length;
 			}
-			token = query_str.substr(0, token_length);
+			token = query_str_.substr(0, token_length);
 		}
 
 		// A white-space is inserted before each token.
-		if (!char_tokens_buf.append(' ') || !char_tokens_buf.append(token))
+		if (!char_tokens_buf_.append(' ') || !char_tokens_buf_.append(token))
 			SSGNC_ERROR << "ssgnc::StringBuilder::append() failed" << std::endl;
-		query_str = query_str.substr(token.length());
+		query_str_ = query_str_.substr(token.length());
+	}
+	query_str_ = char_tokens_buf_.str();
+}
+
+// If a cursor is given by the parameter "p", the search is resumed from the
+// end of the previous page. The limits of the query are applied to the page,
+// so they are added to the counters of the previous pages. A CGI process
+// accepts the cursors of other processes only if the index has ngms.key.
+void Handler::search()
+{
+	String cursor_str = key_value_map_["p"];
+	if (cursor_str.empty())
+	{
+		database.search(query_, &agent_);
+		return;
 	}
-	query_str = char_tokens_buf.str();
+
+	const Cursor::Key *cursor_key;
+	if (!database.cursor_key(&cursor_key) ||
+		!cursor_.decode(*cursor_key, cursor_str))
+		return;
+
+	UInt64 max_num_results = query_.max_num_results();
+	UInt64 io_limit = query_.io_limit();
+	if (max_num_results != 0)
+		query_.set_max_num_results(static_cast<Int64>(
+			max_num_results + cursor_.num_results()));
+	if (io_limit != 0)
+		query_.set_io_limit(static_cast<Int64>(io_limit + cursor_.total()));
+
+	database.search(query_, cursor_, &agent_);
+
+	query_.set_max_num_results(static_cast<Int64>(max_num_results));
+	query_.set_io_limit(static_cast<Int64>(io_limit));
 }
 
 // The special characters '<', '>' and '&' must be encoded.
 // The others are printed as is.
-void printToken(const String &token)
+void Handler::printToken(const String &token)
 {
-	token_buf.clear();
+	token_buf_.clear();
 	for (std::size_t i = 0; i < token.length(); ++i)
 	{
 		switch (token[i])
 		{
 		case '<':
-			if (!token_buf.append("&lt;"))
+			if (!token_buf_.append("&lt;"))
 				return;
 			break;
 		case '>':
-			if (!token_buf.append("&gt;"))
+			if (!token_buf_.append("&gt;"))
 				return;
 			break;
 		case '&':
-			if (!token_buf.append("&amp;"))
+			if (!token_buf_.append("&amp;"))
 				return;
 			break;
 		default:
-			if (!token_buf.append(token[i]))
+			if (!token_buf_.append(token[i]))
 				return;
 			break;
 		}
 	}
-	std::cout << token_buf;
+	*out_ << token_buf_;
 }
 
-void printHtmlHeader()
+void Handler::printHtmlHeader()
 {
-	std::cout << "<head>\n"
+	*out_ << "<head>\n"
 		"<meta http-equiv=\"Content-Type\""
 		" content=\"text/html; charset=utf-8\">\n"
 		"<title>SSGNC</title>\n"
@@ -149,207 +224,238 @@ void printHtmlHeader()
 }
 
 // The form is filled with the parameters of the query.
-void printHtmlForm()
+void Handler::printHtmlForm()
 {
-	std::cout << "<form method=\"get\" action=\"\">\n"
+	*out_ << "<form method=\"get\" action=\"\">\n"
 		"<table>\n"
 		"<caption><a href=\"?\">SSGNC Search Form</a></caption>\n";
 
-	std::cout << "<tr><td>Query</td>\n"
+	*out_ << "<tr><td>Query</td>\n"
 		"<td><input type=\"text\" name=\"q\" /></td>\n"
 		"<td><input type=\"submit\" value=\"Submit\" /></td></tr>\n";
 
-	std::cout << "<tr><td>Token Order</td><td colspan=\"2\">\n"
+	*out_ << "<tr><td>Token Order</td><td colspan=\"2\">\n"
 		"<input type=\"radio\" name=\"o\" value=\"unordered\" "
-		<< ((query.order() == Query::UNORDERED) ? " checked=\"checked\"" : "")
+		<< ((query_.order() == Query::UNORDERED) ? " checked=\"checked\"" : "")
 		<< " /> Unordered\n"
 		"<input type=\"radio\" name=\"o\" value=\"ordered\""
-		<< ((query.order() == Query::ORDERED) ? " checked=\"checked\"" : "")
+		<< ((query_.order() == Query::ORDERED) ? " checked=\"checked\"" : "")
 		<< " /> Ordered\n"
 		"<input type=\"radio\" name=\"o\" value=\"phrase\""
-		<< ((query.order() == Query::PHRASE) ? " checked=\"checked\"" : "")
+		<< ((query_.order() == Query::PHRASE) ? " checked=\"checked\"" : "")
 		<< " /> Phrase\n"
 		"<input type=\"radio\" name=\"o\" value=\"fixed\""
-		<< ((query.order() == Query::FIXED) ? " checked=\"checked\"" : "")
+		<< ((query_.order() == Query::FIXED) ? " checked=\"checked\"" : "")
 		<< " /> Fixed</td></tr>\n";
 
-	std::cout << "<tr><td>Min. Frequency</td><td>\n"
+	*out_ << "<tr><td>Min. Frequency</td><td>\n"
 		"<input type=\"text\" name=\"f\" value=\""
-		<< query.min_freq() << "\" /></td></tr>\n";
+		<< query_.min_freq() << "\" /></td></tr>\n";
 
-	std::cout << "<tr><td>No. Tokens</td>\n"
+	*out_ << "<tr><td>No. Tokens</td>\n"
 		"<td><input type=\"text\" name=\"t\" value=\""
-		<< query.min_num_tokens() << '-'
-		<< query.max_num_tokens() << "\" /></td></tr>\n";
+		<< query_.min_num_tokens() << '-'
+		<< query_.max_num_tokens() << "\" /></td></tr>\n";
 
-	std::cout << "<tr><td>Max. Results</td>\n"
+	*out_ << "<tr><td>Max. Results</td>\n"
 		"<td><input type=\"text\" name=\"r\" value=\""
-		<< query.max_num_results() << "\" /></td></tr>\n";
+		<< query_.max_num_results() << "\" /></td></tr>\n";
 
-	std::cout << "<tr><td>IO Limit</td>\n"
+	*out_ << "<tr><td>IO Limit</td>\n"
 		"<td><input type=\"text\" name=\"i\" value=\""
-		<< query.io_limit() << "\" /></td></tr>\n";
+		<< query_.io_limit() << "\" /></td></tr>\n";
 
-	std::cout << "<tr><td class=\"last\">Format</td>\n"
+	*out_ << "<tr><td class=\"last\">Format</td>\n"
 		"<td colspan=\"2\" class=\"last\">\n"
 		"<input type=\"radio\" name=\"c\" value=\"html\""
 		" checked=\"checked\" /> Html\n"
 		"<input type=\"radio\" name=\"c\" value=\"text\" /> Text\n"
 		"<input type=\"radio\" name=\"c\" value=\"xml\" /> Xml</td></tr>\n";
 
-	std::cout << "<tr><td colspan=\"3\" class=\"link\">\n"
+	*out_ << "<tr><td colspan=\"3\" class=\"link\">\n"
 		"<a href=\"http://code.google.com/p/ssgnc/\">SSGNC Project Site\n"
 		" - http://code.google.com/p/ssgnc/</a>\n"
 		"</td></tr>\n";
 
-	std::cout << "</table>\n"
+	*out_ << "</table>\n"
 		"</form>\n";
 }
 
-void printXmlQuery()
+void Handler::printXmlQuery()
 {
-	std::cout << "<query>\n"
+	*out_ << "<query>\n"
 		"<str>";
-	printToken(query_str);
-	std::cout << "</str>\n"
-		"<min_freq>" << query.min_freq() << "</min_freq>\n"
-		"<min_num_tokens>" << query.min_num_tokens() << "</min_num_tokens>\n"
-		"<max_num_tokens>" << query.max_num_tokens() << "</max_num_tokens>\n"
-		"<max_num_results>" << query.max_num_results()
+	printToken(query_str_);
+	*out_ << "</str>\n"
+		"<min_freq>" << query_.min_freq() << "</min_freq>\n"
+		"<min_num_tokens>" << query_.min_num_tokens() << "</min_num_tokens>\n"
+		"<max_num_tokens>" << query_.max_num_tokens() << "</max_num_tokens>\n"
+		"<max_num_results>" << query_.max_num_results()
 		<< "</max_num_results>\n"
-		"<io_limit>" << query.io_limit() << "</io_limit>\n";
+		"<io_limit>" << query_.io_limit() << "</io_limit>\n";
 
-	std::cout << "<order>";
-	switch (query.order())
+	*out_ << "<order>";
+	switch (query_.order())
 	{
 	case Query::UNORDERED:
-		std::cout << "unordered";
+		*out_ << "unordered";
 		break;
 	case Query::ORDERED:
-		std::cout << "ordered";
+		*out_ << "ordered";
 		break;
 	case Query::PHRASE:
-		std::cout << "phrase";
+		*out_ << "phrase";
 		break;
 	case Query::FIXED:
-		std::cout << "fixed";
+		*out_ << "fixed";
 		break;
 	}
-	std::cout << "</order>\n"
+	*out_ << "</order>\n"
 		"</query>\n";
 }
 
-void handleHtmlRequest()
+// A cursor is printed if the search has not finished. It is given as the
+// parameter "p" to get the next page.
+void Handler::printXmlCursor()
 {
-	std::cout << "Content-Type: text/html; charset=utf-8\n\n";
+	const Cursor::Key *cursor_key;
+	if (!agent_.is_open() || !agent_.save(&cursor_) ||
+		cursor_.num_lists() == 0 || !database.cursor_key(&cursor_key) ||
+		!cursor_.encode(*cursor_key, &cursor_buf_))
+		return;
 
-	std::cout << "<!DOCTYPE HTML PUBLIC \"-//W3C//DTD HTML 4.01//EN\"\n"
+	*out_ << "<cursor>" << cursor_buf_ << "</cursor>\n";
+}
+
+void Handler::handleHtmlRequest()
+{
+	*out_ << "Content-Type: text/html; charset=utf-8\n\n";
+
+	*out_ << "<!DOCTYPE HTML PUBLIC \"-//W3C//DTD HTML 4.01//EN\"\n"
 		" \"http://www.w3.org/TR/html4/strict.dtd\">\n"
 		"<html>\n";
 	printHtmlHeader();
-	std::cout << "<body>\n";
+	*out_ << "<body>\n";
 
 	// If the agent has not been opened correctly, an HTML form is printed.
-	if (!agent.is_open())
+	if (!agent_.is_open())
 		printHtmlForm();
 
 	// The n-grams read by the agent are printed with tags, <div> and <span>.
-	while (agent.read(&encoded_freq, &tokens))
+	while (agent_.read(&encoded_freq_, &tokens_))
 	{
-		if (!database.decode(encoded_freq, tokens, &freq, &token_strs))
+		if (!database.decode(encoded_freq_, tokens_, &freq_, &token_strs_))
 			continue;
 
-		std::cout << "<div class=\"result\">";
-		for (std::size_t i = 0; i < token_strs.size(); ++i)
+		*out_ << "<div class=\"result\">";
+		for (std::size_t i = 0; i < token_strs_.size(); ++i)
 		{
-			std::cout << "<span class=\"token\">";
-			printToken(token_strs[i]);
-			std::cout << "</span> ";
+			*out_ << "<span class=\"token\">";
+			printToken(token_strs_[i]);
+			*out_ << "</span> ";
 		}
-		std::cout << "<span class=\"freq\">" << freq << "</span>";
-		std::cout << "</div>\n";
+		*out_ << "<span class=\"freq\">" << freq_ << "</span>";
+		*out_ << "</div>\n";
 	}
 
-	std::cout << "</body>\n"
+	*out_ << "</body>\n"
 		"</html>\n";
 }
 
-void handleTextRequest()
+void Handler::handleTextRequest()
 {
-	std::cout << "Content-Type: text/plain; charset=utf-8\n\n";
+	*out_ << "Content-Type: text/plain; charset=utf-8\n\n";
 
 	// The n-grams read by the agent are printed without any tags.
-	while (agent.read(&encoded_freq, &tokens))
+	while (agent_.read(&encoded_freq_, &tokens_))
 	{
-		if (database.decode(encoded_freq, tokens, &ngram_buf))
-			std::cout << ngram_buf << '\n';
+		if (database.decode(encoded_freq_, tokens_, &ngram_buf_))
+			*out_ << ngram_buf_ << '\n';
 	}
 }
 
-void handleXmlRequest()
+void Handler::handleXmlRequest()
 {
-	std::cout << "Content-Type: application/xml\n\n";
+	*out_ << "Content-Type: application/xml\n\n";
 
-	std::cout << "<?xml version=\"1.0\" encoding=\"utf-8\""
+	*out_ << "<?xml version=\"1.0\" encoding=\"utf-8\""
 		" standalone=\"yes\"?>\n"
 		"<search>\n";
 	printXmlQuery();
 
 	// The n-grams read by the agent are printed with tags ---
 	// <results>, <result>, <token> and <freq>.
-	std::cout << "<results>\n";
-	while (agent.read(&encoded_freq, &tokens))
+	*out_ << "<results>\n";
+	while (agent_.read(&encoded_freq_, &tokens_))
 	{
-		if (!database.decode(encoded_freq, tokens, &freq, &token_strs))
+		if (!database.decode(encoded_freq_, tokens_, &freq_, &token_strs_))
 			continue;
 
-		std::cout << "<result>";
-		for (std::size_t i = 0; i < token_strs.size(); ++i)
+		*out_ << "<result>";
+		for (std::size_t i = 0; i < token_strs_.size(); ++i)
 		{
-			std::cout << "<token>";
-			printToken(token_strs[i]);
-			std::cout << "</token>";
+			*out_ << "<token>";
+			printToken(token_strs_[i]);
+			*out_ << "</token>";
 		}
-		std::cout << "<freq>" << freq << "</freq>";
-		std::cout << "</result>\n";
+		*out_ << "<freq>" << freq_ << "</freq>";
+		*out_ << "</result>\n";
 	}
-	std::cout << "</results>\n"
-		"</search>\n";
+	*out_ << "</results>\n";
+	printXmlCursor();
+	*out_ << "</search>\n";
 }
 
-}  // namespace
+void Handler::reset()
+{
+	if (agent_.is_open())
+		agent_.close();
+
+	mem_pool_.clear();
+	key_value_map_.clear();
+	query_.clear();
+	query_str_ = String();
+	char_tokens_buf_.clear();
+	cursor_.clear();
+	cursor_buf_.clear();
+}
 
-int main()
+void Handler::handle(const String &query_string, std::ostream *out)
 {
+	// The objects used by the previous request are reset.
+	reset();
+	out_ = out;
+
 	// The query is initialized with the default settings.
 	// Then, the settings are overwritten by the parameters of the GET request.
 	// Finally, the limitatons are used.
-	setupQuery();
+	setupQuery(query_string);
 
-	// If a query is not given, the agent defined as a global variable is not
-	// opened. And, the search result will be empty.
-	query_str = key_value_map["q"];
-	if (!query_str.empty())
+	// If a query is not given, the agent is not opened. And, the search
+	// result will be empty.
+	query_str_ = key_value_map_["q"];
+	if (!query_str_.empty())
 	{
 		if (cgi::Config::TOKEN_TYPE() == cgi::Config::CHAR_TOKEN)
 			splitCharTokens();
 
-		// A dictionary file and an index file are opend.
+		// A dictionary file and an index file are opend unless they have
+		// been opened for a FastCGI responder.
 		// Then, the query is parsed by using the dictionary file.
 		// After that, the agent is opened by using the index file.
-		if (database.open(cgi::Config::INDEX_DIR()))
+		if (database.is_open() || database.open(cgi::Config::INDEX_DIR()))
 		{
-			if (database.parseQuery(query_str, &query))
+			if (database.parseQuery(query_str_, &query_))
 			{
-				if (query.num_tokens() > 0)
-					database.search(query, &agent);
+				if (query_.num_tokens() > 0)
+					search();
 			}
 		}
 	}
 
 	// The default content type is "html". Prefixes of the valid content types,
 	// such as "h", "t" and "x", also work well.
-	String content_type = key_value_map["c"];
+	String content_type = key_value_map_["c"];
 	if (!content_type.empty())
 	{
 		if (String("html").startsWith(content_type))
@@ -361,6 +467,86 @@ int main()
 	}
 	else
 		handleHtmlRequest();
+}
+
+// Threads accept connections from the same socket. Each thread has its own
+// handler and serves the requests on a connection one after another.
+void *serveConnections(void *arg)
+{
+	int listen_fd = *static_cast<int *>(arg);
+
+	Handler handler;
+	cgi::FastCgiRequest request;
+	std::ostream out(&request);
+	for ( ; ; )
+	{
+		int fd;
+		if (!Socket::accept(listen_fd, &fd))
+			break;
+		else if (!request.open(fd))
+			continue;
+
+		while (request.accept())
+		{
+			out.clear();
+			handler.handle(request.param("QUERY_STRING"), &out);
+			if (!request.finish() || !request.keep_conn())
+				break;
+		}
+		request.close();
+	}
+	return NULL;
+}
+
+}  // namespace
+
+int main(int argc, char *argv[])
+{
+	// A web server starts a FastCGI responder with a listening socket as its
+	// standard input. Otherwise, the responder listens on the given address.
+	// If neither is available, the program serves one CGI request.
+	int listen_fd = 0;
+	if (argc > 1)
+	{
+		if (!Socket::listen(argv[1], &listen_fd))
+			return 1;
+	}
+	else if (!cgi::FastCgiRequest::isListenSocket(0))
+	{
+		Handler handler;
+		handler.handle(std::getenv("QUERY_STRING"), &std::cout);
+		return 0;
+	}
+
+	// The database is opened before the threads start, so that the threads
+	// only read it.
+	if (!database.open(cgi::Config::INDEX_DIR()))
+		return 2;
+
+	std::signal(SIGPIPE, SIG_IGN);
+
+	std::size_t num_threads = cgi::Config::NUM_THREADS();
+	if (num_threads < 1 || num_threads > MAX_NUM_THREADS)
+	{
+		SSGNC_ERROR << "Out of range #threads: " << num_threads << std::endl;
+		return 3;
+	}
+
+	std::vector<pthread_t> threads(num_threads);
+	std::size_t num_started = 0;
+	for ( ; num_started < num_threads; ++num_started)
+	{
+		if (::pthread_create(&threads[num_started], NULL,
+			serveConnections, &listen_fd) != 0)
+		{
+			SSGNC_ERROR << "::pthread_create() failed" << std::endl;
+			break;
+		}
+	}
+
+	// Threads return only if accept() fails.
+	for (std::size_t i = 0; i < num_started; ++i)
+		::pthread_join(threads[i], NULL);
 
-	return 0;
+	return 4;
 }
@@ -1,10 +1,16 @@
 #ifndef SSGNC_H
 #define SSGNC_H
 
+#include "ssgnc/agent-pool.h"
+#include "ssgnc/coalescer.h"
+#include "ssgnc/coordinator.h"
+#include "ssgnc/database-handle.h"
 #include "ssgnc/database.h"
 #include "ssgnc/mapper.h"
 #include "ssgnc/mem-pool.h"
 #include "ssgnc/reader.h"
+#include "ssgnc/result-cache.h"
+#include "ssgnc/socket.h"
 #include "ssgnc/writer.h"
 
 #endif  // SSGNC_H
@@ -0,0 +1,75 @@
+#ifndef SSGNC_ACCESS_LOG_H
+#define SSGNC_ACCESS_LOG_H
+
+#include "string.h"
+
+#include <pthread.h>
+
+namespace ssgnc {
+
+// An access log records the byte ranges of .db files read by searches.
+// Each record is written as a line "NUM_TOKENS TOKEN_ID FILE_ID OFFSET
+// LENGTH", where the range starts at OFFSET of the FILE_ID-th file of
+// NUM_TOKENS-grams and may continue to the following files. Records are
+// written under a lock, so a log may be shared by the agents of threads.
+class AccessLog
+{
+public:
+	class Record
+	{
+	public:
+		Record() : num_tokens_(0), token_id_(0), file_id_(0),
+			offset_(0), length_(0) {}
+
+		void set_num_tokens(Int32 num_tokens) { num_tokens_ = num_tokens; }
+		void set_token_id(Int32 token_id) { token_id_ = token_id; }
+		void set_file_id(Int32 file_id) { file_id_ = file_id; }
+		void set_offset(UInt64 offset) { offset_ = offset; }
+		void set_length(UInt64 length) { length_ = length; }
+
+		Int32 num_tokens() const { return num_tokens_; }
+		Int32 token_id() const { return token_id_; }
+		Int32 file_id() const { return file_id_; }
+		UInt64 offset() const { return offset_; }
+		UInt64 length() const { return length_; }
+
+	private:
+		Int32 num_tokens_;
+		Int32 token_id_;
+		Int32 file_id_;
+		UInt64 offset_;
+		UInt64 length_;
+	};
+
+	AccessLog();
+	~AccessLog();
+
+	bool open(std::ostream *stream) SSGNC_WARN_UNUSED_RESULT;
+	bool close();
+
+	bool write(const Record &record) SSGNC_WARN_UNUSED_RESULT;
+
+	bool is_open() const { return stream_ != NULL; }
+
+	// The number of records is changed by other threads, so it is read under
+	// the lock.
+	UInt64 num_records() const;
+
+	static bool parse(const String &line, Record *record)
+		SSGNC_WARN_UNUSED_RESULT;
+
+private:
+	std::ostream *stream_;
+	UInt64 num_records_;
+	mutable pthread_mutex_t mutex_;
+
+	static bool parseValue(String *avail, Int64 *value);
+
+	// Disallows copies.
+	AccessLog(const AccessLog &);
+	AccessLog &operator=(const AccessLog &);
+};
+
+}  // namespace ssgnc
+
+#endif  // SSGNC_ACCESS_LOG_H
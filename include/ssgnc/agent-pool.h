@@ -0,0 +1,53 @@
+#ifndef SSGNC_AGENT_POOL_H
+#define SSGNC_AGENT_POOL_H
+
+#include "agent.h"
+
+#include <pthread.h>
+
+namespace ssgnc {
+
+// An agent pool keeps closed agents for reuse, so that threads which share a
+// database do not create an agent and its buffers for every search. An agent
+// is taken by acquire() and returned by release(), which closes the agent and
+// keeps it in a free list unless the list is full.
+class AgentPool
+{
+public:
+	enum { DEFAULT_MAX_NUM_AGENTS = 64 };
+
+	AgentPool();
+	~AgentPool();
+
+	bool open(UInt32 max_num_agents = DEFAULT_MAX_NUM_AGENTS)
+		SSGNC_WARN_UNUSED_RESULT;
+	// All the acquired agents must be released before the pool is closed.
+	bool close();
+
+	// Returns NULL if an agent cannot be created.
+	Agent *acquire();
+	void release(Agent *agent);
+
+	bool is_open() const { return is_open_; }
+
+	UInt32 max_num_agents() const { return max_num_agents_; }
+	UInt32 num_free_agents() const;
+	UInt32 num_acquired_agents() const;
+	UInt64 num_created_agents() const;
+
+private:
+	bool is_open_;
+	UInt32 max_num_agents_;
+	std::vector<Agent *> free_agents_;
+	UInt32 num_acquired_agents_;
+	UInt64 num_created_agents_;
+	mutable pthread_mutex_t mutex_;
+
+	// Disallows copies.
+	AgentPool(const AgentPool &);
+	AgentPool &operator=(const AgentPool &);
+};
+
+}  // namespace ssgnc
+
+#endif  // SSGNC_AGENT_POOL_H
@@ -1,9 +1,15 @@
 #ifndef SSGNC_AGENT_H
 #define SSGNC_AGENT_H
 
+#include "access-log.h"
+#include "cursor.h"
 #include "heap-queue.h"
-#include "ngram-reader.h"
+#include "ngram-block.h"
 #include "query.h"
+#include "result-batch.h"
+#include "result-cache.h"
+
+#include <pthread.h>
 
 namespace ssgnc {
 
@@ -20,57 +26,210 @@ public:
 	class Source
 	{
 	public:
-		Source() : num_tokens_(0), entry_() {}
+		Source() : num_tokens_(0), token_id_(-1), entry_() {}
 		Source(Int32 num_tokens, const NgramIndex::Entry &entry)
-			: num_tokens_(num_tokens), entry_(entry) {}
+			: num_tokens_(num_tokens), token_id_(-1), entry_(entry) {}
+		Source(Int32 num_tokens, Int32 token_id,
+			const NgramIndex::Entry &entry)
+			: num_tokens_(num_tokens), token_id_(token_id), entry_(entry) {}
 
 		void set_num_tokens(Int32 num_tokens) { num_tokens_ = num_tokens; }
+		void set_token_id(Int32 token_id) { token_id_ = token_id; }
 		void set_entry(const NgramIndex::Entry &entry) { entry_ = entry; }
 
 		Int32 num_tokens() const { return num_tokens_; }
+		Int32 token_id() const { return token_id_; }
 		const NgramIndex::Entry entry() const { return entry_; }
 
 	private:
 		Int32 num_tokens_;
+		Int32 token_id_;
 		NgramIndex::Entry entry_;
 	};
 
+	// The reason why eof() returns true. The budgets of a query are tested
+	// in this order.
+	enum StopReason
+	{
+		NOT_STOPPED, CANCELED, TIME_LIMIT, MAX_NUM_RESULTS, END_OF_LISTS,
+		IO_LIMIT, SCAN_LIMIT
+	};
+
 public:
 	Agent();
 	~Agent();
 
 	bool open(const String &index_dir, const Query &query,
 		const std::vector<Source> &sources) SSGNC_WARN_UNUSED_RESULT;
+	// If the shard map has shards other than the index directory, the lists
+	// are opened in parallel by a thread per shard. The threads are started
+	// by the first search and kept until the agent is destroyed. The shard
+	// map must be kept open until the agent is closed.
+	bool open(const ShardMap &shard_map, const Query &query,
+		const std::vector<Source> &sources) SSGNC_WARN_UNUSED_RESULT;
+	// Resumes a search from a cursor saved by save(). The counters are
+	// restored from the cursor, so the limits of the query count the
+	// results and the bytes of the previous pages too.
+	bool open(const ShardMap &shard_map, const Query &query,
+		const Cursor &cursor) SSGNC_WARN_UNUSED_RESULT;
+	// The readers and the buffers are kept after close(), so that an agent
+	// which is reused for the next search does not allocate memory in the
+	// steady state, except for the result cache.
 	bool close();
 
+	// Saves the position of the search into a cursor. A search which is
+	// returning cached results cannot be saved until they are all read.
+	bool save(Cursor *cursor) const SSGNC_WARN_UNUSED_RESULT;
+
 	bool read(Int16 *encoded_freq, std::vector<Int32> *tokens);
+	// Reads up to max_num_results results into a batch, which is cleared
+	// first. The tokens are read into the batch directly. This function
+	// returns false if no result is read, and bad() tells an error.
+	bool readBatch(ResultBatch *batch, UInt32 max_num_results);
+
+	// Non-blocking variants for event-driven servers. If the next n-gram
+	// needs disk I/O, these functions stop with would_block() and
+	// pending_read() gives the range to be read. The caller starts the read
+	// by PendingRead::prefetch() or load(), and then tries again. Opening
+	// an agent and moving to the next file of a list may still block.
+	bool tryRead(Int16 *encoded_freq, std::vector<Int32> *tokens);
+	bool tryReadBatch(ResultBatch *batch, UInt32 max_num_results);
+
+	bool would_block() const { return would_block_; }
+	const NgramReader::PendingRead &pending_read() const
+	{ return pending_read_; }
+
+	// Requests the search to stop. This function may be called from another
+	// thread while the agent is open. The request is tested with the time
+	// limit at intervals of CHECK_INTERVAL n-grams, and is cleared when the
+	// agent is closed.
+	void cancel();
 
 	bool is_open() const { return is_open_; }
 
 	bool bad() const { return bad_; }
-	bool eof() const;
+	bool eof() const { return stop_reason() != NOT_STOPPED; }
 	bool good() const { return !fail(); }
 	bool fail() const { return bad() || eof(); }
 
 	UInt64 num_results() const { return num_results_; }
 	UInt64 tell() const { return total_; }
+	// The number of n-grams read from lists by this agent, which is not
+	// restored from a cursor. Results from the cache count the n-grams which
+	// the cached search has read.
+	UInt64 num_scanned() const { return num_scanned_; }
+
+	StopReason stop_reason() const;
+	static const char *stopReasonName(StopReason stop_reason);
 
 	const Query &query() const { return query_; }
 
+	// If an access log is set, the byte ranges read from .db files are
+	// recorded when the agent is closed.
+	void set_access_log(AccessLog *access_log) { access_log_ = access_log; }
+	AccessLog *access_log() const { return access_log_; }
+
+	// If a result cache is set, the results of the next search are stored
+	// into the cache under the key when the agent is closed.
+	bool set_result_cache(ResultCache *result_cache,
+		const ResultCache::Key &key) SSGNC_WARN_UNUSED_RESULT;
+	ResultCache *result_cache() const { return result_cache_; }
+
 private:
+	friend class Database;
+	friend class MaterializedResults;
+	friend class ResultCache;
+
 	bool is_open_;
 	bool bad_;
 	Query query_;
+	std::vector<Source> sources_;
 	std::vector<NgramReader *> ngram_readers_;
 	HeapQueue<NgramReader *, FreqComparer> heap_queue_;
 	UInt64 num_results_;
 	UInt64 total_;
+	AccessLog *access_log_;
+	ResultCache *result_cache_;
+	ResultCache::Key cache_key_;
+	ResultCache::Results results_;
+	bool is_recording_;
+	std::vector<NgramReader *> free_readers_;
+	NgramBlock block_;
+	UInt64 num_scanned_;
+	UInt64 deadline_;
+	UInt64 next_check_;
+	bool is_canceled_;
+	bool is_expired_;
+	bool is_cancel_requested_;
+	pthread_mutex_t cancel_mutex_;
+	bool would_block_;
+	NgramReader::PendingRead pending_read_;
+
+	enum { CHECK_INTERVAL = NgramBlock::MAX_SIZE };
 
-	bool filter(const std::vector<Int32> &tokens) const;
-	bool filterUnordered(const std::vector<Int32> &tokens) const;
-	bool filterOrdered(const std::vector<Int32> &tokens) const;
-	bool filterPhrase(const std::vector<Int32> &tokens) const;
-	bool filterFixed(const std::vector<Int32> &tokens) const;
+	// Scratch buffers of Database::search(), which are kept across searches
+	// like the other buffers.
+	ResultCache::Key search_key_;
+	std::vector<Source> search_sources_;
+
+	// The lists of a shard are opened by its worker, except for the first
+	// shard, whose lists are opened by the calling thread. A worker waits
+	// for the next generation of tasks.
+	struct OpenTask
+	{
+		Agent *agent;
+		Int32 shard_id;
+		UInt64 generation;
+		bool has_lists;
+		bool is_ok;
+	};
+
+	std::vector<OpenTask> open_tasks_;
+	std::vector<pthread_t> open_workers_;
+	const ShardMap *open_shard_map_;
+	const std::vector<Source> *open_sources_;
+	UInt64 open_generation_;
+	std::size_t num_pending_opens_;
+	bool is_stopping_workers_;
+	pthread_mutex_t open_mutex_;
+	pthread_cond_t open_cond_;
+
+	bool open(const String &index_dir, const ShardMap *shard_map,
+		const Query &query, const std::vector<Source> &sources)
+		SSGNC_WARN_UNUSED_RESULT;
+	bool openShards(const ShardMap &shard_map,
+		const std::vector<Source> &sources) SSGNC_WARN_UNUSED_RESULT;
+	void openShard(OpenTask *task);
+	bool startWorkers(Int32 num_shards) SSGNC_WARN_UNUSED_RESULT;
+	void stopWorkers();
+	static void *runWorker(void *arg);
+
+	bool openCached(ResultCache *result_cache, const ResultCache::Key &key,
+		const Query &query, ResultCache::Results *results, UInt64 total,
+		UInt64 num_scanned, Agent *suspended) SSGNC_WARN_UNUSED_RESULT;
+	void takeReaders(Agent *agent);
+	bool newReader(NgramReader **ngram_reader) SSGNC_WARN_UNUSED_RESULT;
+	bool recordResult(Int16 encoded_freq, const Int32 *tokens,
+		Int32 num_tokens);
+	void cacheResults();
+
+	void writeAccessLog();
+
+	// The n-grams of the top list are read into the block while the list
+	// stays on the top of the heap queue, and the block is filtered at
+	// once. readNext() consumes the block and returns the index of the
+	// next n-gram which passes the filter.
+	bool read(Int16 *encoded_freq, std::vector<Int32> *tokens,
+		bool is_nonblocking);
+	bool readBatch(ResultBatch *batch, UInt32 max_num_results,
+		bool is_nonblocking);
+	bool readNext(UInt32 *index, bool is_nonblocking);
+	bool fillBlock(bool is_nonblocking) SSGNC_WARN_UNUSED_RESULT;
+
+	// The time limit is converted into a deadline when the agent is opened,
+	// and the clock and the cancel request are tested by checkBudgets().
+	void startClock();
+	void checkBudgets();
 
 	// Disallows copies.
 	Agent(const Agent &);
@@ -85,19 +244,30 @@ inline bool Agent::FreqComparer::operator()(const NgramReader *lhs,
 	return lhs->num_tokens() < rhs->num_tokens();
 }
 
-inline bool Agent::eof() const
+inline Agent::StopReason Agent::stop_reason() const
 {
-	if (heap_queue_.empty())
-		return true;
+	if (is_canceled_)
+		return CANCELED;
+	else if (is_expired_)
+		return TIME_LIMIT;
 
 	if (query_.max_num_results() != 0 &&
 		num_results_ >= query_.max_num_results())
-		return true;
+		return MAX_NUM_RESULTS;
+
+	// Cached results are returned without reading lists.
+	if (num_results_ < results_.size())
+		return NOT_STOPPED;
+
+	if (heap_queue_.empty())
+		return END_OF_LISTS;
 
 	if (query_.io_limit() != 0 && total_ >= query_.io_limit())
-		return true;
+		return IO_LIMIT;
+	else if (query_.scan_limit() != 0 && num_scanned_ >= query_.scan_limit())
+		return SCAN_LIMIT;
 
-	return false;
+	return NOT_STOPPED;
 }
 
 }  // namespace ssgnc
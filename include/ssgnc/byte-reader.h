@@ -36,6 +36,9 @@ public:
 	{ return bad() || (pos_ >= buf_.size() && stream_->fail()); }
 
 	UInt64 tell() const { return total_; }
+	// The number of bytes which can be read without reading the stream.
+	UInt32 avail() const
+	{ return static_cast<UInt32>(buf_.size()) - pos_; }
 
 	enum { DEFAULT_BUF_SIZE = 1 << 12 };
 	enum { MAX_FREQ_LENGTH = 2, MAX_TOKEN_LENGTH = 5 };
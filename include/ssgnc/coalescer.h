@@ -0,0 +1,152 @@
+#ifndef SSGNC_COALESCER_H
+#define SSGNC_COALESCER_H
+
+#include "database.h"
+
+#include <map>
+
+#include <pthread.h>
+
+namespace ssgnc {
+
+// A coalescer lets concurrent searches for the same query share an agent.
+// The first search of a query opens an agent, and the searches which arrive
+// while it is in flight attach to it. Results are appended to a buffer shared
+// by the searches, and each search reads the buffer at its own pace and stops
+// at its own limit. A search which needs a result not in the buffer yet reads
+// it from the agent while the others wait for the result.
+//
+// A flight is kept until its last search is closed, so a search which
+// arrives after the agent has finished is answered from the buffer. Once a
+// flight has buffered more than max_flight_bytes or is older than
+// max_flight_age, new searches start another flight instead of attaching to
+// it, so that a flight of a popular query ends and frees its buffer.
+class Coalescer
+{
+private:
+	struct Flight;
+
+public:
+	typedef ResultCache::Key Key;
+
+	// A waiter reads the results of a coalesced search like an agent.
+	class Waiter
+	{
+	public:
+		Waiter() : coalescer_(NULL), flight_(NULL), max_num_results_(0),
+			num_results_(0), bad_(false), eof_(false) {}
+		~Waiter();
+
+		bool close();
+
+		bool read(Int16 *encoded_freq, std::vector<Int32> *tokens);
+
+		bool is_open() const { return flight_ != NULL; }
+
+		bool bad() const { return bad_; }
+		bool eof() const;
+		bool good() const { return !fail(); }
+		bool fail() const { return bad() || eof(); }
+
+		UInt64 num_results() const { return num_results_; }
+
+	private:
+		friend class Coalescer;
+
+		Coalescer *coalescer_;
+		Flight *flight_;
+		UInt64 max_num_results_;
+		UInt64 num_results_;
+		bool bad_;
+		bool eof_;
+
+		// Disallows copies.
+		Waiter(const Waiter &);
+		Waiter &operator=(const Waiter &);
+	};
+
+public:
+	Coalescer();
+	~Coalescer();
+
+	// The database must be kept open until the coalescer is closed. The age
+	// of a flight is given in microseconds.
+	bool open(const Database &database,
+		UInt64 max_flight_bytes = DEFAULT_MAX_FLIGHT_BYTES,
+		UInt64 max_flight_age = DEFAULT_MAX_FLIGHT_AGE)
+		SSGNC_WARN_UNUSED_RESULT;
+	// All the waiters must be closed before the coalescer.
+	bool close();
+
+	bool search(const Query &query, Waiter *waiter) SSGNC_WARN_UNUSED_RESULT;
+
+	bool is_open() const { return database_ != NULL; }
+
+	// The counters are changed by other threads, so they are read under the
+	// lock.
+	UInt64 num_flights() const;
+	UInt64 num_joins() const;
+
+	// A key consists of the settings which affect the order and the contents
+	// of results. The range of the number of tokens is normalized by the
+	// database, and the limits are included because they cut results.
+	bool makeKey(const Query &query, Key *key) const
+		SSGNC_WARN_UNUSED_RESULT;
+
+	enum { DEFAULT_MAX_FLIGHT_BYTES = 4 << 20 };
+	enum { DEFAULT_MAX_FLIGHT_AGE = 10 * 1000000 };
+
+private:
+	struct Flight
+	{
+		Flight() : key(), agent(), results(), num_waiters(0),
+			start_time(0), is_opening(false), is_reading(false),
+			is_finished(false), bad(false) {}
+
+		Key key;
+		Agent agent;
+		ResultCache::Results results;
+		UInt32 num_waiters;
+		UInt64 start_time;
+		bool is_opening;
+		bool is_reading;
+		bool is_finished;
+		bool bad;
+
+	private:
+		// Disallows copies.
+		Flight(const Flight &);
+		Flight &operator=(const Flight &);
+	};
+
+	typedef std::map<Key, Flight *> FlightMap;
+
+	const Database *database_;
+	UInt64 max_flight_bytes_;
+	UInt64 max_flight_age_;
+	FlightMap flights_;
+	UInt64 num_flights_;
+	UInt64 num_joins_;
+	mutable pthread_mutex_t mutex_;
+	pthread_cond_t cond_;
+
+	bool isJoinable(const Flight &flight) const;
+	bool read(Waiter *waiter, Int16 *encoded_freq,
+		std::vector<Int32> *tokens) SSGNC_WARN_UNUSED_RESULT;
+	void leave(Waiter *waiter);
+
+	// Disallows copies.
+	Coalescer(const Coalescer &);
+	Coalescer &operator=(const Coalescer &);
+};
+
+inline bool Coalescer::Waiter::eof() const
+{
+	if (max_num_results_ != 0 && num_results_ >= max_num_results_)
+		return true;
+	return eof_;
+}
+
+}  // namespace ssgnc
+
+#endif  // SSGNC_COALESCER_H
@@ -22,12 +22,20 @@
 #define SSGNC_LINE_TO_STR(line) SSGNC_INT_TO_STR(line)
 #define SSGNC_LINE_STR SSGNC_LINE_TO_STR(__LINE__)
 
-// The format of error log is as follows:
-// formatted time string: __FILE__:__LINE__: error:
-//   In __FUNCTION__(): error message
-#define SSGNC_ERROR (*ssgnc::error_stream() \
-	<< (__FILE__ ":" SSGNC_LINE_STR ": error:\n  In ") \
-	<< __FUNCTION__ << "(): ")
+// The format of a log message is as follows:
+// formatted time string: __FILE__:__LINE__: level:
+//   In __FUNCTION__(): message
+// A message is formatted only if its level is enabled, so a disabled message
+// costs a function call and a comparison.
+#define SSGNC_LOG(level, label) \
+	!ssgnc::is_logging_enabled(level) ? (void)0 : ssgnc::LogVoidify() & \
+	*ssgnc::error_stream() \
+	<< (__FILE__ ":" SSGNC_LINE_STR ": " label ":\n  In ") \
+	<< __FUNCTION__ << "(): "
+
+#define SSGNC_ERROR SSGNC_LOG(ssgnc::LOG_ERROR, "error")
+#define SSGNC_WARNING SSGNC_LOG(ssgnc::LOG_WARNING, "warning")
+#define SSGNC_INFO SSGNC_LOG(ssgnc::LOG_INFO, "info")
 
 namespace ssgnc {
 
@@ -41,16 +49,38 @@ typedef unsigned short UInt16;
 typedef unsigned int UInt32;
 typedef unsigned long long UInt64;
 
-// Use SSGNC_ERROR for error logging.
-// This function should not be called directly.
+// Messages of a level are written if the level is not greater than the
+// current log level, which is LOG_ERROR in default.
+enum LogLevel { LOG_ERROR, LOG_WARNING, LOG_INFO };
+
+void set_log_level(LogLevel level);
+LogLevel log_level();
+
+// Use SSGNC_ERROR, SSGNC_WARNING and SSGNC_INFO for logging.
+// These functions should not be called directly. error_stream() returns a
+// stream of the calling thread, which passes a message to the output stream
+// when the message is flushed by std::endl or std::flush.
+bool is_logging_enabled(LogLevel level);
 std::ostream *error_stream();
 
-// Replaces an output stream for error logging. If a NULL pointer is given,
-// error logging is disabled.
+// This class makes the type of a logging expression void.
+class LogVoidify
+{
+public:
+	void operator&(std::ostream &) {}
+};
+
+// Replaces an output stream for logging. If a NULL pointer is given, logging
+// is disabled. The output stream is written only under a lock, so it may be
+// shared by threads. The messages passed before the replacement are written
+// to the previous stream.
 void set_error_stream(std::ostream *stream);
 
 inline void disable_error_logging() { set_error_stream(NULL); }
 
+// Writes the messages which have been passed by threads but not written yet.
+void flush_error_stream();
+
 }  // namespace ssgnc
 
 #endif  // SSGNC_COMMON_H
@@ -0,0 +1,123 @@
+#ifndef SSGNC_COORDINATOR_H
+#define SSGNC_COORDINATOR_H
+
+#include "fd-streambuf.h"
+#include "heap-queue.h"
+#include "protocol.h"
+#include "socket.h"
+
+namespace ssgnc {
+
+// A coordinator sends a query to workers, each of which serves a partition
+// of an index, and merges their results in the same order as ssgnc::Agent.
+// The limits of the query are applied to the merged results.
+class Coordinator
+{
+public:
+	// A connection to a worker. See ssgnc::Socket for addresses.
+	class Worker
+	{
+	public:
+		Worker() : streambuf_(), stream_(&streambuf_), reader_(), writer_(),
+			encoded_freq_(Protocol::END_OF_RESULTS), tokens_(), total_(0) {}
+		~Worker();
+
+		bool open(const String &address) SSGNC_WARN_UNUSED_RESULT;
+		bool close();
+
+		bool send(const Query &query) SSGNC_WARN_UNUSED_RESULT;
+		bool next() SSGNC_WARN_UNUSED_RESULT;
+
+		bool is_open() const { return streambuf_.is_open(); }
+
+		bool bad() const
+		{ return encoded_freq_ == Protocol::ERROR_OF_RESULTS; }
+		bool good() const
+		{ return encoded_freq_ > Protocol::END_OF_RESULTS; }
+
+		Int16 encoded_freq() const { return encoded_freq_; }
+		const std::vector<Int32> &tokens() const { return tokens_; }
+		Int32 num_tokens() const { return static_cast<Int32>(tokens_.size()); }
+		UInt64 tell() const { return total_; }
+
+	private:
+		FdStreambuf streambuf_;
+		std::iostream stream_;
+		Reader reader_;
+		Writer writer_;
+		Int16 encoded_freq_;
+		std::vector<Int32> tokens_;
+		UInt64 total_;
+
+		// Disallows copies.
+		Worker(const Worker &);
+		Worker &operator=(const Worker &);
+	};
+
+	class FreqComparer
+	{
+	public:
+		bool operator()(const Worker *lhs, const Worker *rhs) const;
+	};
+
+public:
+	Coordinator();
+	~Coordinator();
+
+	bool open(const std::vector<String> &addresses, const Query &query)
+		SSGNC_WARN_UNUSED_RESULT;
+	bool close();
+
+	bool read(Int16 *encoded_freq, std::vector<Int32> *tokens);
+
+	bool is_open() const { return is_open_; }
+
+	bool bad() const { return bad_; }
+	bool eof() const;
+	bool good() const { return !fail(); }
+	bool fail() const { return bad() || eof(); }
+
+	UInt64 num_results() const { return num_results_; }
+	UInt64 tell() const;
+
+	const Query &query() const { return query_; }
+
+private:
+	bool is_open_;
+	bool bad_;
+	Query query_;
+	std::vector<Worker *> workers_;
+	HeapQueue<Worker *, FreqComparer> heap_queue_;
+	UInt64 num_results_;
+
+	// Disallows copies.
+	Coordinator(const Coordinator &);
+	Coordinator &operator=(const Coordinator &);
+};
+
+inline bool Coordinator::FreqComparer::operator()(const Worker *lhs,
+	const Worker *rhs) const
+{
+	if (lhs->encoded_freq() != rhs->encoded_freq())
+		return lhs->encoded_freq() > rhs->encoded_freq();
+	return lhs->num_tokens() < rhs->num_tokens();
+}
+
+inline bool Coordinator::eof() const
+{
+	if (heap_queue_.empty())
+		return true;
+
+	if (query_.max_num_results() != 0 &&
+		num_results_ >= query_.max_num_results())
+		return true;
+
+	if (query_.io_limit() != 0 && tell() >= query_.io_limit())
+		return true;
+
+	return false;
+}
+
+}  // namespace ssgnc
+
+#endif  // SSGNC_COORDINATOR_H
@@ -0,0 +1,114 @@
+#ifndef SSGNC_CURSOR_H
+#define SSGNC_CURSOR_H
+
+#include "query.h"
+
+namespace ssgnc {
+
+// A cursor keeps the position of a search, so that the next page of results
+// is read without reading the previous pages again. It consists of the
+// states of the unfinished lists and the counters of the agent. A cursor is
+// encoded into a URL-safe string, which is opaque to clients. The string is
+// signed with a secret key of the server, because its positions are used to
+// open .db files as they are.
+class Cursor
+{
+public:
+	// The state of a list is the position of the next n-gram in a .db file
+	// and the encoded frequency of the n-gram, which has already been read.
+	class List
+	{
+	public:
+		List() : num_tokens_(0), file_id_(0), offset_(0), encoded_freq_(0) {}
+
+		void set_num_tokens(Int32 num_tokens) { num_tokens_ = num_tokens; }
+		void set_file_id(Int32 file_id) { file_id_ = file_id; }
+		void set_offset(UInt64 offset) { offset_ = offset; }
+		void set_encoded_freq(Int16 encoded_freq)
+		{ encoded_freq_ = encoded_freq; }
+
+		Int32 num_tokens() const { return num_tokens_; }
+		Int32 file_id() const { return file_id_; }
+		UInt64 offset() const { return offset_; }
+		Int16 encoded_freq() const { return encoded_freq_; }
+
+	private:
+		Int32 num_tokens_;
+		Int32 file_id_;
+		UInt64 offset_;
+		Int16 encoded_freq_;
+	};
+
+	// A key of SipHash-2-4, which is used as a MAC of encoded cursors.
+	class Key
+	{
+	public:
+		Key() : k0_(0), k1_(0) {}
+
+		// A secret must have at least MIN_SECRET_LENGTH bytes. It is hashed
+		// into a key.
+		bool set(const String &secret) SSGNC_WARN_UNUSED_RESULT;
+		// Reads a random key from /dev/urandom.
+		bool generate() SSGNC_WARN_UNUSED_RESULT;
+
+		UInt64 k0() const { return k0_; }
+		UInt64 k1() const { return k1_; }
+
+		enum { MIN_SECRET_LENGTH = 16 };
+
+	private:
+		UInt64 k0_;
+		UInt64 k1_;
+	};
+
+	enum { FORMAT_VERSION = 2, MAX_NUM_LISTS = Query::MAX_NUM_TOKENS };
+	enum { MAC_SIZE = 8 };
+
+public:
+	Cursor() : checksum_(0), num_results_(0), total_(0), lists_() {}
+	~Cursor() {}
+
+	void clear();
+
+	bool appendList(const List &list) SSGNC_WARN_UNUSED_RESULT;
+
+	// A cursor is decoded only if its MAC matches the key.
+	bool encode(const Key &key, StringBuilder *str) const
+		SSGNC_WARN_UNUSED_RESULT;
+	bool decode(const Key &key, const String &str) SSGNC_WARN_UNUSED_RESULT;
+
+	void set_checksum(UInt32 checksum) { checksum_ = checksum; }
+	void set_num_results(UInt64 num_results) { num_results_ = num_results; }
+	void set_total(UInt64 total) { total_ = total; }
+
+	UInt32 checksum() const { return checksum_; }
+	UInt64 num_results() const { return num_results_; }
+	UInt64 total() const { return total_; }
+
+	UInt32 num_lists() const { return static_cast<UInt32>(lists_.size()); }
+	const List &list(UInt32 index) const { return lists_[index]; }
+
+	// A cursor is used only for queries which have the same checksum. The
+	// limits of a query are not a part of the checksum, so a query for the
+	// next page has larger limits than the previous one.
+	static UInt32 checksum(const Query &query);
+
+private:
+	UInt32 checksum_;
+	UInt64 num_results_;
+	UInt64 total_;
+	std::vector<List> lists_;
+
+	static UInt64 mac(const Key &key, const String &bytes);
+
+	static bool encodeValue(UInt64 value, StringBuilder *buf);
+	static bool decodeValue(String *avail, UInt64 *value);
+
+	// Disallows copies.
+	Cursor(const Cursor &);
+	Cursor &operator=(const Cursor &);
+};
+
+}  // namespace ssgnc
+
+#endif  // SSGNC_CURSOR_H
@@ -0,0 +1,124 @@
+#ifndef SSGNC_DATABASE_HANDLE_H
+#define SSGNC_DATABASE_HANDLE_H
+
+#include "coalescer.h"
+
+#include <pthread.h>
+
+namespace ssgnc {
+
+// A database handle lets a long-running process switch to a new index
+// without stopping. An index is opened as a snapshot, which consists of a
+// database and the objects tied to it, a result cache and a coalescer.
+// reload() opens a new snapshot, validates and warms it by searching queries,
+// and then replaces the current snapshot at once.
+//
+// A search takes a reference to the current snapshot. The references keep
+// the old snapshot while its agents are in use, and the old snapshot is
+// closed when its last reference is released. So, the handle must be kept
+// until all the references are released.
+class DatabaseHandle
+{
+public:
+	class Snapshot
+	{
+	public:
+		const Database &database() const { return database_; }
+		Coalescer *coalescer() { return &coalescer_; }
+		ResultCache *result_cache()
+		{ return result_cache_.is_open() ? &result_cache_ : NULL; }
+
+		UInt64 generation() const { return generation_; }
+
+	private:
+		friend class DatabaseHandle;
+
+		Database database_;
+		ResultCache result_cache_;
+		Coalescer coalescer_;
+		UInt64 generation_;
+		UInt32 num_refs_;
+
+		Snapshot() : database_(), result_cache_(), coalescer_(),
+			generation_(0), num_refs_(0) {}
+		~Snapshot();
+
+		// Disallows copies.
+		Snapshot(const Snapshot &);
+		Snapshot &operator=(const Snapshot &);
+	};
+
+	// A reference keeps a snapshot until it is released.
+	class Ref
+	{
+	public:
+		Ref() : handle_(NULL), snapshot_(NULL) {}
+		~Ref();
+
+		bool acquire(DatabaseHandle *handle) SSGNC_WARN_UNUSED_RESULT;
+		bool release();
+
+		bool is_open() const { return snapshot_ != NULL; }
+
+		Snapshot *snapshot() const { return snapshot_; }
+		Snapshot *operator->() const { return snapshot_; }
+
+	private:
+		DatabaseHandle *handle_;
+		Snapshot *snapshot_;
+
+		// Disallows copies.
+		Ref(const Ref &);
+		Ref &operator=(const Ref &);
+	};
+
+public:
+	DatabaseHandle();
+	~DatabaseHandle();
+
+	// A snapshot has a result cache if the cache size is not 0.
+	bool open(const String &index_dir,
+		FileMap::Mode mode = FileMap::DEFAULT_MODE, UInt64 cache_size = 0)
+		SSGNC_WARN_UNUSED_RESULT;
+	bool close();
+
+	// Opens a new snapshot and searches the queries, if given, to warm it.
+	// If the new snapshot fails, the current snapshot is kept.
+	bool reload(const String &index_dir,
+		const std::vector<std::string> *queries = NULL)
+		SSGNC_WARN_UNUSED_RESULT;
+
+	bool is_open() const;
+
+	UInt64 generation() const;
+	UInt64 num_reloads() const;
+	// The number of snapshots which are not deleted yet, including the
+	// current one and the old ones kept by references.
+	UInt32 num_snapshots() const;
+
+private:
+	Snapshot *current_;
+	FileMap::Mode mode_;
+	UInt64 cache_size_;
+	UInt64 num_reloads_;
+	UInt32 num_snapshots_;
+	mutable pthread_mutex_t mutex_;
+
+	bool openSnapshot(const String &index_dir, UInt64 generation,
+		const std::vector<std::string> *queries, Snapshot **snapshot) const
+		SSGNC_WARN_UNUSED_RESULT;
+	static bool warmSnapshot(Snapshot *snapshot,
+		const std::vector<std::string> &queries) SSGNC_WARN_UNUSED_RESULT;
+
+	void replace(Snapshot *snapshot);
+	Snapshot *acquire();
+	void release(Snapshot *snapshot);
+
+	// Disallows copies.
+	DatabaseHandle(const DatabaseHandle &);
+	DatabaseHandle &operator=(const DatabaseHandle &);
+};
+
+}  // namespace ssgnc
+
+#endif  // SSGNC_DATABASE_HANDLE_H
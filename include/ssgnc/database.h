@@ -2,24 +2,59 @@
 #define SSGNC_DATABASE_H
 
 #include "agent.h"
+#include "materialized-results.h"
+#include "planner.h"
 #include "vocab-dic.h"
 
+#include <pthread.h>
+
 namespace ssgnc {
 
+// After open(), the const member functions of a database may be called by
+// threads at the same time. The dictionary and the index are read-only maps,
+// and the access log and the result cache lock themselves. An agent must be
+// used by one thread at a time, so each thread should have its own agents,
+// e.g. from an agent pool.
 class Database
 {
 public:
 	Database();
 	~Database();
 
+	// ngms.stat is not read if reads_stats is false, e.g. to rebuild stale
+	// statistics.
 	bool open(const String &index_dir,
-		FileMap::Mode mode = FileMap::DEFAULT_MODE) SSGNC_WARN_UNUSED_RESULT;
+		FileMap::Mode mode = FileMap::DEFAULT_MODE, bool reads_stats = true)
+		SSGNC_WARN_UNUSED_RESULT;
 	bool close();
 
 	bool parseQuery(const String &str, Query *query,
 		const String &meta_token = "*") const SSGNC_WARN_UNUSED_RESULT;
 
 	bool search(const Query &query, Agent *agent) const;
+	// Resumes a search from a cursor saved by Agent::save(). The query must
+	// be the same as the previous one except for its limits.
+	bool search(const Query &query, const Cursor &cursor, Agent *agent) const;
+	// Chooses a list of each order for a query by the planner. A query which
+	// contains an unknown token has no source.
+	bool plan(const Query &query, std::vector<Agent::Source> *sources) const
+		SSGNC_WARN_UNUSED_RESULT;
+	// Explains how search() answers a query: the access path, the chosen
+	// lists and the estimated cost. The result cache is not looked up,
+	// because a lookup changes its state.
+	bool explain(const Query &query, Planner::Explanation *explanation) const
+		SSGNC_WARN_UNUSED_RESULT;
+	// Estimates the number of results of a query and the time to read its
+	// lists in microseconds from the index and the statistics, without
+	// reading .db files. The number of results ignores the limits of the
+	// query except for the minimum frequency, but the time is limited by
+	// them. This function fails if the index has no statistics.
+	bool estimate(const Query &query, double *num_results,
+		double *search_time) const SSGNC_WARN_UNUSED_RESULT;
+	// A key identifies the results of a query in the result cache and the
+	// materialized results.
+	bool makeKey(const Query &query, ResultCache::Key *key) const
+		SSGNC_WARN_UNUSED_RESULT;
 
 	bool decode(Int16 encoded_freq, const std::vector<Int32> &tokens,
 		StringBuilder *ngram) const SSGNC_WARN_UNUSED_RESULT;
@@ -27,6 +62,11 @@ public:
 		Int64 *freq, std::vector<String> *token_strs) const 
 		SSGNC_WARN_UNUSED_RESULT;
 
+	// Writes the results of a batch in the format of decode(), one per line.
+	// The output is cleared first.
+	bool decode(const ResultBatch &batch, StringBuilder *output) const
+		SSGNC_WARN_UNUSED_RESULT;
+
 	bool decodeFreq(Int16 encoded_freq, Int64 *freq) const
 		SSGNC_WARN_UNUSED_RESULT;
 
@@ -40,16 +80,53 @@ public:
 	String index_dir() const { return index_dir_.str(); }
 	const VocabDic &vocab_dic() const { return vocab_dic_; }
 	const NgramIndex &ngram_index() const { return ngram_index_; }
+	const ShardMap &shard_map() const { return shard_map_; }
+	const NgramStats &ngram_stats() const { return ngram_stats_; }
+	const MaterializedResults &materialized_results() const
+	{ return materialized_results_; }
+
+	// Cursors are signed with the key, which is read from INDEX_DIR/ngms.key
+	// if it exists. Otherwise, a random key is generated when it is first
+	// required, so the cursors are valid only for the process, and a
+	// database which does not use cursors never reads /dev/urandom.
+	bool cursor_key(const Cursor::Key **key) const SSGNC_WARN_UNUSED_RESULT;
 
 	UInt32 num_keys() const { return vocab_dic_.num_keys(); }
 	Int32 max_num_tokens() const { return ngram_index_.max_num_tokens(); }
 	Int32 max_token_id() const { return ngram_index_.max_token_id(); }
 
+	// The access log is given to agents in search(). It is not owned by the
+	// database.
+	void set_access_log(AccessLog *access_log) { access_log_ = access_log; }
+	AccessLog *access_log() const { return access_log_; }
+
+	// The result cache is used in search(). It is not owned by the database
+	// and must be closed before the database.
+	void set_result_cache(ResultCache *result_cache)
+	{ result_cache_ = result_cache; }
+	ResultCache *result_cache() const { return result_cache_; }
+
 private:
 	StringBuilder index_dir_;
 	VocabDic vocab_dic_;
 	NgramIndex ngram_index_;
+	ShardMap shard_map_;
+	MaterializedResults materialized_results_;
+	NgramStats ngram_stats_;
+	Planner planner_;
+	mutable Cursor::Key cursor_key_;
+	mutable bool has_cursor_key_;
+	mutable pthread_mutex_t cursor_key_mutex_;
 	FreqHandler freq_handler_;
+	AccessLog *access_log_;
+	ResultCache *result_cache_;
+
+	void getNumTokensRange(const Query &query, Int32 *min_num_tokens,
+		Int32 *max_num_tokens) const;
+	bool explainLists(const Query &query,
+		Planner::Explanation *explanation) const SSGNC_WARN_UNUSED_RESULT;
+
+	bool openCursorKey(const String &index_dir) SSGNC_WARN_UNUSED_RESULT;
 
 	static String findDelim(const String &str);
 
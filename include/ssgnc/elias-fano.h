@@ -0,0 +1,131 @@
+#ifndef SSGNC_ELIAS_FANO_H
+#define SSGNC_ELIAS_FANO_H
+
+#include "mapper.h"
+#include "writer.h"
+
+namespace ssgnc {
+
+// A compressed monotone sequence of 64-bit values. Each value is split into
+// low bits, which are stored as they are, and high bits, which are stored as
+// unary-coded gaps in a bit vector. The position of every SAMPLE_INTERVAL-th
+// one in the bit vector is sampled for constant time access.
+class EliasFano
+{
+public:
+	EliasFano() : num_values_(0), num_low_bits_(0), low_mask_(0),
+		lower_(NULL), upper_(NULL), samples_(NULL) {}
+	~EliasFano() {}
+
+	bool map(Mapper *mapper) SSGNC_WARN_UNUSED_RESULT;
+	void clear();
+
+	bool get(UInt64 index, UInt64 *value) const SSGNC_WARN_UNUSED_RESULT;
+
+	// Returns the value of index without range checks.
+	UInt64 operator[](UInt64 index) const;
+
+	bool is_mapped() const { return upper_ != NULL; }
+
+	UInt64 num_values() const { return num_values_; }
+	UInt32 num_low_bits() const { return num_low_bits_; }
+
+	static bool build(const std::vector<UInt64> &values, Writer *writer)
+		SSGNC_WARN_UNUSED_RESULT;
+
+	enum { SAMPLE_INTERVAL = 256 };
+
+private:
+	UInt64 num_values_;
+	UInt32 num_low_bits_;
+	UInt64 low_mask_;
+	const UInt64 *lower_;
+	const UInt64 *upper_;
+	const UInt64 *samples_;
+
+	UInt64 low(UInt64 index) const;
+	UInt64 high(UInt64 index) const;
+
+	static bool checkUpper(const UInt64 *upper, UInt64 num_upper_words,
+		const UInt64 *samples, UInt64 num_values);
+
+	static UInt32 popCount(UInt64 word);
+	static UInt32 selectInWord(UInt64 word, UInt32 rank);
+
+	// Disallows copies.
+	EliasFano(const EliasFano &);
+	EliasFano &operator=(const EliasFano &);
+};
+
+inline UInt64 EliasFano::operator[](UInt64 index) const
+{
+	return (high(index) << num_low_bits_) | low(index);
+}
+
+inline UInt64 EliasFano::low(UInt64 index) const
+{
+	if (num_low_bits_ == 0)
+		return 0;
+
+	UInt64 bit_pos = index * num_low_bits_;
+	UInt64 word_id = bit_pos / 64;
+	UInt32 shift = static_cast<UInt32>(bit_pos % 64);
+
+	UInt64 value = lower_[word_id] >> shift;
+	if (shift + num_low_bits_ > 64)
+		value |= lower_[word_id + 1] << (64 - shift);
+	return value & low_mask_;
+}
+
+inline UInt64 EliasFano::high(UInt64 index) const
+{
+	UInt64 bit_pos = samples_[index / SAMPLE_INTERVAL];
+	UInt32 rank = static_cast<UInt32>(index % SAMPLE_INTERVAL);
+
+	UInt64 word_id = bit_pos / 64;
+	UInt64 word = upper_[word_id] & (~0ULL << (bit_pos % 64));
+	for (UInt32 count = popCount(word); rank >= count;
+		count = popCount(word))
+	{
+		rank -= count;
+		word = upper_[++word_id];
+	}
+
+	bit_pos = (word_id * 64) + selectInWord(word, rank);
+	return bit_pos - index;
+}
+
+inline UInt32 EliasFano::popCount(UInt64 word)
+{
+#ifdef __GNUC__
+	return static_cast<UInt32>(__builtin_popcountll(word));
+#else  // __GNUC__
+	word = word - ((word >> 1) & 0x5555555555555555ULL);
+	word = (word & 0x3333333333333333ULL)
+		+ ((word >> 2) & 0x3333333333333333ULL);
+	word = (word + (word >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+	return static_cast<UInt32>((word * 0x0101010101010101ULL) >> 56);
+#endif  // __GNUC__
+}
+
+inline UInt32 EliasFano::selectInWord(UInt64 word, UInt32 rank)
+{
+	for (UInt32 i = 0; i < rank; ++i)
+		word &= word - 1;
+
+#ifdef __GNUC__
+	return static_cast<UInt32>(__builtin_ctzll(word));
+#else  // __GNUC__
+	UInt32 pos = 0;
+	while ((word & 1) == 0)
+	{
+		word >>= 1;
+		++pos;
+	}
+	return pos;
+#endif  // __GNUC__
+}
+
+}  // namespace ssgnc
+
+#endif  // SSGNC_ELIAS_FANO_H
@@ -0,0 +1,61 @@
+#ifndef SSGNC_FD_STREAMBUF_H
+#define SSGNC_FD_STREAMBUF_H
+
+#include "common.h"
+
+#include <streambuf>
+
+#include <sys/types.h>
+
+namespace ssgnc {
+
+// A stream buffer which reads and writes a file descriptor, such as a
+// socket, a pipe or a file. The descriptor is closed when the buffer is
+// closed, but the buffers are kept for the next descriptor, so that a reused
+// stream buffer does not allocate memory.
+class FdStreambuf : public std::streambuf
+{
+public:
+	FdStreambuf() : std::streambuf(), fd_(-1), in_buf_(), out_buf_() {}
+	~FdStreambuf();
+
+	bool open(int fd, UInt32 buf_size = DEFAULT_BUF_SIZE)
+		SSGNC_WARN_UNUSED_RESULT;
+	bool close();
+
+	bool is_open() const { return fd_ != -1; }
+
+	int fd() const { return fd_; }
+
+	enum { DEFAULT_BUF_SIZE = 1 << 12 };
+
+protected:
+	int_type underflow();
+	int_type overflow(int_type c);
+	int sync();
+
+	// A large read bypasses the input buffer.
+	std::streamsize xsgetn(char *s, std::streamsize n);
+
+	// Only input positions of seekable descriptors are supported.
+	pos_type seekoff(off_type off, std::ios_base::seekdir dir,
+		std::ios_base::openmode which = std::ios_base::in);
+	pos_type seekpos(pos_type pos,
+		std::ios_base::openmode which = std::ios_base::in);
+
+private:
+	int fd_;
+	std::vector<char> in_buf_;
+	std::vector<char> out_buf_;
+
+	bool flushBuf();
+	ssize_t readFd(char *buf, std::size_t size);
+
+	// Disallows copies.
+	FdStreambuf(const FdStreambuf &);
+	FdStreambuf &operator=(const FdStreambuf &);
+};
+
+}  // namespace ssgnc
+
+#endif  // SSGNC_FD_STREAMBUF_H
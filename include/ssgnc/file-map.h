@@ -8,7 +8,29 @@ namespace ssgnc {
 class FileMap
 {
 public:
-	enum Mode { MMAP_FILE, READ_FILE, DEFAULT_MODE = MMAP_FILE };
+	// The lower bits select how a file is loaded and the upper bits are
+	// optional flags which are combined by operator|(), for example,
+	// MMAP_FILE | POPULATE_PAGES | RANDOM_ACCESS.
+	enum Mode
+	{
+		MMAP_FILE = 0x00,
+		READ_FILE = 0x01,
+
+		// Prefaults the entire mapping in open() (MAP_POPULATE).
+		POPULATE_PAGES = 0x10,
+		// Pins the pages in memory (mlock). Also available for READ_FILE.
+		LOCK_PAGES = 0x20,
+		// Asks for transparent huge pages (MADV_HUGEPAGE).
+		HUGE_PAGES = 0x40,
+		// Disables readahead for random lookups (MADV_RANDOM).
+		RANDOM_ACCESS = 0x80,
+		// Starts reading the entire file in background (MADV_WILLNEED).
+		WILL_NEED = 0x100,
+
+		DEFAULT_MODE = MMAP_FILE
+	};
+
+	enum { LOAD_MODE_MASK = 0x0F, FLAGS_MASK = 0x1F0 };
 
 	FileMap() : impl_(NULL), ptr_(NULL), size_(0) {}
 	~FileMap();
@@ -18,18 +40,18 @@ public:
 	bool close();
 
 	const void *ptr() const { return ptr_; }
-	UInt32 size() const { return size_; }
+	UInt64 size() const { return size_; }
 
 	bool is_open() const { return impl_ != NULL; }
 
-	enum { MAX_FILE_SIZE = 0x7FFFFFFFU };
+	static const UInt64 MAX_FILE_SIZE = 0xFFFFFFFFFFFFULL;
 
 private:
 	class Impl;
 
 	Impl *impl_;
 	const void *ptr_;
-	UInt32 size_;
+	UInt64 size_;
 
 	// Disallows copies.
 	FileMap(const FileMap &);
@@ -38,4 +60,11 @@ private:
 
 }  // namespace ssgnc
 
+inline ssgnc::FileMap::Mode operator|(ssgnc::FileMap::Mode lhs,
+	ssgnc::FileMap::Mode rhs)
+{
+	return static_cast<ssgnc::FileMap::Mode>(
+		static_cast<int>(lhs) | static_cast<int>(rhs));
+}
+
 #endif  // SSGNC_FILE_MAP_H
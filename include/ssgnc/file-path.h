@@ -8,7 +8,7 @@ namespace ssgnc {
 class FilePath
 {
 public:
-	FilePath() : dirname_(), basename_(), file_id_(0) {}
+	FilePath() : dirname_(), basename_(), file_id_(0), filename_() {}
 	~FilePath();
 
 	bool open(const String &dirname, const String &basename)
@@ -16,6 +16,10 @@ public:
 	bool close();
 
 	bool read(StringBuilder *path) SSGNC_WARN_UNUSED_RESULT;
+	// This function joins the next basename with `dirname' instead of the
+	// directory given to open().
+	bool read(const String &dirname, StringBuilder *path)
+		SSGNC_WARN_UNUSED_RESULT;
 
 	bool is_open() const { return !basename_.empty(); }
 
@@ -34,6 +38,9 @@ private:
 	StringBuilder dirname_;
 	StringBuilder basename_;
 	Int32 file_id_;
+	// A buffer for read(), which is kept so that read() does not allocate
+	// memory after the first call.
+	StringBuilder filename_;
 
 	// Disallows copies.
 	FilePath(const FilePath &);
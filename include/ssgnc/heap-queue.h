@@ -13,6 +13,7 @@ public:
 	~HeapQueue() { clear(); }
 
 	void clear() { buf_.clear(); }
+	void swap(HeapQueue *target) { buf_.swap(target->buf_); }
 
 	bool push(const T &value) SSGNC_WARN_UNUSED_RESULT;
 	bool pop();
@@ -20,6 +21,9 @@ public:
 	bool popPush(const T &value);
 
 	bool top(T *value) const;
+	// Gets the child of the top value which popPush() compares with a new
+	// value first. This function returns false if there is no child.
+	bool second(T *value) const;
 
 	bool empty() const { return buf_.empty(); }
 	UInt32 size() const { return buf_.size(); }
@@ -132,6 +136,21 @@ bool HeapQueue<T, LessThan>::top(T *value) const
 	return true;
 }
 
+template <typename T, typename LessThan>
+bool HeapQueue<T, LessThan>::second(T *value) const
+{
+	UInt32 child_index = getChildIndex(getRootIndex());
+	if (child_index >= buf_.size())
+		return false;
+
+	if (child_index + 1 < buf_.size() &&
+		less_than_(buf_[child_index + 1], buf_[child_index]))
+		++child_index;
+
+	*value = buf_[child_index];
+	return true;
+}
+
 }  // namespace ssgnc
 
 #endif  // SSGNC_HEAP_QUEUE_H
@@ -9,17 +9,17 @@ class Mapper
 {
 public:
 	Mapper() : ptr_(NULL), size_(0), total_(0) {}
-	Mapper(const void *ptr, UInt32 size)
+	Mapper(const void *ptr, UInt64 size)
 		: ptr_(ptr), size_(size), total_(0) {}
 	~Mapper();
 
-	bool open(const void *ptr, UInt32 size) SSGNC_WARN_UNUSED_RESULT;
+	bool open(const void *ptr, UInt64 size) SSGNC_WARN_UNUSED_RESULT;
 	bool close();
 
 	template <typename T>
 	bool map(const T **ptr) SSGNC_WARN_UNUSED_RESULT;
 	template <typename T>
-	bool map(const T **ptr, UInt32 num_objs) SSGNC_WARN_UNUSED_RESULT;
+	bool map(const T **ptr, UInt64 num_objs) SSGNC_WARN_UNUSED_RESULT;
 
 	bool is_open() const { return ptr_ != NULL; }
 
@@ -28,14 +28,14 @@ public:
 	bool good() const { return total_ < size_; }
 	bool fail() const { return ptr_ == NULL || total_ == size_; }
 
-	UInt32 tell() const { return total_; }
+	UInt64 tell() const { return total_; }
 
-	enum { MAX_SIZE = 0x7FFFFFFF };
+	static const UInt64 MAX_SIZE = 0xFFFFFFFFFFFFULL;
 
 private:
 	const void *ptr_;
-	UInt32 size_;
-	UInt32 total_;
+	UInt64 size_;
+	UInt64 total_;
 
 	// Disallows copies.
 	Mapper(const Mapper &);
@@ -67,12 +67,12 @@ bool Mapper::map(const T **ptr)
 	*ptr = static_cast<const T *>(ptr_);
 
 	ptr_ = static_cast<const T *>(ptr_) + 1;
-	total_ += static_cast<UInt32>(sizeof(T));
+	total_ += sizeof(T);
 	return true;
 }
 
 template <typename T>
-bool Mapper::map(const T **ptr, UInt32 num_objs)
+bool Mapper::map(const T **ptr, UInt64 num_objs)
 {
 	if (!is_open())
 	{
@@ -86,7 +86,7 @@ bool Mapper::map(const T **ptr, UInt32 num_objs)
 	}
 
 	UInt64 num_bytes = static_cast<UInt64>(sizeof(T)) * num_objs;
-	if (total_ + num_bytes > size_)
+	if (num_bytes > size_ || total_ + num_bytes > size_)
 	{
 		SSGNC_ERROR << "No more input: " << total_
 			<< " + " << sizeof(T) << " * " << num_objs << std::endl;
@@ -97,7 +97,7 @@ bool Mapper::map(const T **ptr, UInt32 num_objs)
 	*ptr = static_cast<const T *>(ptr_);
 
 	ptr_ = static_cast<const T *>(ptr_) + num_objs;
-	total_ += static_cast<UInt32>(num_bytes);
+	total_ += num_bytes;
 	return true;
 }
 
@@ -0,0 +1,116 @@
+#ifndef SSGNC_MATERIALIZED_RESULTS_H
+#define SSGNC_MATERIALIZED_RESULTS_H
+
+#include "file-map.h"
+#include "result-cache.h"
+
+namespace ssgnc {
+
+// Materialized results are the first results of heavy-hitter queries, which
+// are searched offline by ssgnc-materialize and stored in INDEX_DIR/ngms.mat.
+// A query of a stored key is answered from the file without reading .db
+// files if the stored results are enough for its limit.
+//
+// The file consists of FORMAT_MARKER, FORMAT_VERSION, the number of entries,
+// the entries sorted by their keys and a pool of Int32 values. An entry
+// refers to its key and its results in the pool, where each result is stored
+// as its encoded frequency, its number of tokens and the token IDs. So, the
+// results of a query are read from a small sequential region. An entry also
+// keeps the bytes and the n-grams which the search has read, so that a query
+// with smaller limits is not answered from the file.
+class MaterializedResults
+{
+public:
+	typedef ResultCache::Key Key;
+
+	struct Entry
+	{
+		UInt32 key_offset;
+		UInt32 key_length;
+		UInt32 results_offset;
+		UInt32 num_results;
+		UInt32 is_complete;
+		UInt32 total;
+		UInt32 num_scanned;
+	};
+
+	// The marker is not a valid number of entries in the old format, which
+	// has no version.
+	static const UInt32 FORMAT_MARKER = 0xFFFFFFFFU;
+	enum { FORMAT_VERSION = 2 };
+
+	// The counters of an entry are saturated at MAX_COUNT, which is regarded
+	// as larger than any limit.
+	static const UInt32 MAX_COUNT = 0xFFFFFFFFU;
+
+	// A builder collects the results of queries and writes them in the
+	// format of ngms.mat.
+	class Builder
+	{
+	public:
+		Builder() : entries_(), keys_(), pool_() {}
+		~Builder() {}
+
+		void clear();
+
+		// An incomplete entry answers only the queries whose limits are not
+		// greater than the number of its results. The total bytes and the
+		// number of scanned n-grams are those of the search.
+		bool append(const Key &key, const ResultCache::Results &results,
+			bool is_complete, UInt64 total, UInt64 num_scanned)
+			SSGNC_WARN_UNUSED_RESULT;
+
+		bool write(std::ostream *stream) const SSGNC_WARN_UNUSED_RESULT;
+
+		bool contains(const Key &key) const;
+
+		UInt32 num_entries() const
+		{ return static_cast<UInt32>(entries_.size()); }
+
+	private:
+		std::vector<Entry> entries_;
+		std::vector<Key> keys_;
+		std::vector<Int32> pool_;
+
+		// Disallows copies.
+		Builder(const Builder &);
+		Builder &operator=(const Builder &);
+	};
+
+public:
+	MaterializedResults();
+	~MaterializedResults();
+
+	bool open(const Int8 *path, FileMap::Mode mode = FileMap::DEFAULT_MODE)
+		SSGNC_WARN_UNUSED_RESULT;
+	bool close();
+
+	// Opens an agent with the stored results of a key. If the key is not
+	// found, there are not enough results or the IO and scan limits of the
+	// query would have stopped the search earlier, `is_found' is set to
+	// false and the agent is not opened. This function returns false only
+	// on errors, such as a broken pool.
+	bool find(const Key &key, const Query &query, Agent *agent,
+		bool *is_found) const SSGNC_WARN_UNUSED_RESULT;
+
+	bool is_open() const { return file_map_.is_open(); }
+
+	UInt32 num_entries() const { return num_entries_; }
+
+private:
+	UInt32 num_entries_;
+	const Entry *entries_;
+	const Int32 *pool_;
+	UInt64 pool_size_;
+	FileMap file_map_;
+
+	bool compareKey(const Entry &entry, const Key &key) const;
+
+	// Disallows copies.
+	MaterializedResults(const MaterializedResults &);
+	MaterializedResults &operator=(const MaterializedResults &);
+};
+
+}  // namespace ssgnc
+
+#endif  // SSGNC_MATERIALIZED_RESULTS_H
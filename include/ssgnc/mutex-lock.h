@@ -0,0 +1,29 @@
+#ifndef SSGNC_MUTEX_LOCK_H
+#define SSGNC_MUTEX_LOCK_H
+
+#include "common.h"
+
+#include <pthread.h>
+
+namespace ssgnc {
+
+// A mutex is locked during the lifetime of a lock. This header is used by
+// the library internally and is not included by ssgnc.h.
+class MutexLock
+{
+public:
+	explicit MutexLock(pthread_mutex_t *mutex) : mutex_(mutex)
+	{ ::pthread_mutex_lock(mutex_); }
+	~MutexLock() { ::pthread_mutex_unlock(mutex_); }
+
+private:
+	pthread_mutex_t *mutex_;
+
+	// Disallows copies.
+	MutexLock(const MutexLock &);
+	MutexLock &operator=(const MutexLock &);
+};
+
+}  // namespace ssgnc
+
+#endif  // SSGNC_MUTEX_LOCK_H
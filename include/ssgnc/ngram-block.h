@@ -0,0 +1,94 @@
+#ifndef SSGNC_NGRAM_BLOCK_H
+#define SSGNC_NGRAM_BLOCK_H
+
+#include "ngram-reader.h"
+#include "query.h"
+
+namespace ssgnc {
+
+// An n-gram block holds consecutive n-grams of a list in columns, so that
+// filter() tests a token position of all the n-grams in a tight loop which
+// the compiler can vectorize. The position of each n-gram is recorded, and
+// the n-grams which have not been consumed can be saved into a cursor.
+class NgramBlock
+{
+public:
+	enum { MAX_SIZE = 1 << 8 };
+
+	NgramBlock() : ngram_reader_(NULL), num_tokens_(0), size_(0), pos_(0),
+		tokens_(), encoded_freqs_(), file_ids_(), offsets_(), tells_(),
+		matches_(), states_(), hits_() {}
+	~NgramBlock() {}
+
+	// Starts a block of n-grams read from a reader. The columns keep their
+	// memory for the next block.
+	bool reset(NgramReader *ngram_reader) SSGNC_WARN_UNUSED_RESULT;
+	void clear();
+
+	void swap(NgramBlock *target);
+
+	// Reads the next n-gram of the reader into the block.
+	bool read() SSGNC_WARN_UNUSED_RESULT;
+
+	// Tests the n-grams in the block with the tokens of a query.
+	bool filter(const Query &query) SSGNC_WARN_UNUSED_RESULT;
+
+	NgramReader *ngram_reader() const { return ngram_reader_; }
+	Int32 num_tokens() const { return num_tokens_; }
+	UInt32 size() const { return size_; }
+	bool full() const { return size_ >= MAX_SIZE; }
+
+	// The n-grams are consumed in order by skip().
+	UInt32 pos() const { return pos_; }
+	bool is_pending() const { return pos_ < size_; }
+	void skip() { ++pos_; }
+
+	// The number of bytes read into the block.
+	UInt64 bytes() const { return ngram_reader_->tell() - tells_[0]; }
+
+	Int16 encoded_freq(UInt32 index) const { return encoded_freqs_[index]; }
+	Int32 file_id(UInt32 index) const { return file_ids_[index]; }
+	UInt64 offset(UInt32 index) const { return offsets_[index]; }
+	UInt64 length(UInt32 index) const
+	{ return tells_[index + 1] - tells_[index]; }
+	bool match(UInt32 index) const { return matches_[index] != 0; }
+
+	const Int32 *column(Int32 token_pos) const
+	{ return &tokens_[0] + (token_pos * MAX_SIZE); }
+	void copyTokens(UInt32 index, Int32 *tokens) const;
+
+	UInt64 bytes_used() const;
+
+private:
+	NgramReader *ngram_reader_;
+	Int32 num_tokens_;
+	UInt32 size_;
+	UInt32 pos_;
+
+	// The token of the j-th position of the i-th n-gram is stored into
+	// tokens_[(j * MAX_SIZE) + i].
+	std::vector<Int32> tokens_;
+	std::vector<Int16> encoded_freqs_;
+	std::vector<Int32> file_ids_;
+	std::vector<UInt64> offsets_;
+	std::vector<UInt64> tells_;
+
+	// The flags and the states of filters are 32-bit integers, so that the
+	// loops over the columns do not mix the widths of their operands.
+	std::vector<UInt32> matches_;
+	std::vector<UInt32> states_;
+	std::vector<UInt32> hits_;
+
+	void filterUnordered(const Query &query);
+	void filterOrdered(const Query &query);
+	void filterPhrase(const Query &query);
+	void filterFixed(const Query &query);
+
+	// Disallows copies.
+	NgramBlock(const NgramBlock &);
+	NgramBlock &operator=(const NgramBlock &);
+};
+
+}  // namespace ssgnc
+
+#endif  // SSGNC_NGRAM_BLOCK_H
@@ -1,6 +1,7 @@
 #ifndef SSGNC_NGRAM_INDEX_H
 #define SSGNC_NGRAM_INDEX_H
 
+#include "elias-fano.h"
 #include "file-map.h"
 
 namespace ssgnc {
@@ -20,36 +21,83 @@ public:
 		UInt32 offset() const
 		{ return (static_cast<UInt32>(offset_hi_) << 16) + offset_lo_; }
 
+		// A key is a monotone combination of a file ID and an offset.
+		bool set_key(UInt64 key) SSGNC_WARN_UNUSED_RESULT;
+		UInt64 key() const
+		{ return (static_cast<UInt64>(file_id_) << OFFSET_BITS) + offset(); }
+
+		enum { OFFSET_BITS = 31 };
+
 	private:
 		Int16 file_id_;
 		UInt16 offset_lo_;
 		UInt16 offset_hi_;
 	};
 
+	// An entry of the wide format, which has a 48-bit offset. In this
+	// format, a list never spans files.
+	class WideFileEntry
+	{
+	public:
+		WideFileEntry() : file_id_(0), offset_lo_(0), offset_hi_(0) {}
+
+		bool set_file_id(Int32 file_id) SSGNC_WARN_UNUSED_RESULT;
+		bool set_offset(UInt64 offset) SSGNC_WARN_UNUSED_RESULT;
+
+		Int32 file_id() const { return file_id_; }
+		UInt64 offset() const
+		{ return (static_cast<UInt64>(offset_hi_) << 16) + offset_lo_; }
+
+		bool set_key(UInt64 key) SSGNC_WARN_UNUSED_RESULT;
+		UInt64 key() const
+		{ return (static_cast<UInt64>(file_id_) << OFFSET_BITS) + offset(); }
+
+		enum { OFFSET_BITS = 48 };
+
+	private:
+		UInt16 file_id_;
+		UInt16 offset_lo_;
+		UInt32 offset_hi_;
+	};
+
 	class Entry
 	{
 	public:
 		Entry() : file_id_(0), offset_(0), approx_size_(0) {}
 
 		bool set_file_id(Int32 file_id) SSGNC_WARN_UNUSED_RESULT;
-		bool set_offset(UInt32 offset) SSGNC_WARN_UNUSED_RESULT;
+		bool set_offset(UInt64 offset) SSGNC_WARN_UNUSED_RESULT;
 		bool set_approx_size(Int64 approx_size) SSGNC_WARN_UNUSED_RESULT;
 
 		Int32 file_id() const { return file_id_; }
-		UInt32 offset() const { return offset_; }
+		UInt64 offset() const { return offset_; }
 		Int64 approx_size() const { return approx_size_; }
 
 	private:
 		Int32 file_id_;
-		UInt32 offset_;
+		UInt64 offset_;
 		Int64 approx_size_;
 	};
 
 	enum { MAX_FILE_ID = 9999 };
 	enum { MAX_OFFSET = 0x7FFFFFFF };
 
+	static const UInt64 MAX_WIDE_OFFSET = 0xFFFFFFFFFFFFULL;
 	static const Int64 MAX_APPROX_SIZE = 1LL << 40;
 
+	// An index of a new format starts with FORMAT_MARKER in place of the
+	// maximum number of tokens. The marker is followed by format flags and
+	// then the original header. In the Elias-Fano format, the keys of each
+	// order are stored as an ssgnc::EliasFano sequence instead of entries.
+	// The sized format is used with the wide format. Its lists may be laid
+	// out in any order, so the entries are followed by the list sizes, which
+	// are saturated at MAX_LIST_SIZE, instead of the end of the last lists.
+	enum { FORMAT_MARKER = 0 };
+	enum { WIDE_FORMAT = 0x01, ELIAS_FANO_FORMAT = 0x02, SIZED_FORMAT = 0x04 };
+	enum { FORMAT_MASK = WIDE_FORMAT | ELIAS_FANO_FORMAT | SIZED_FORMAT };
+
+	static const UInt32 MAX_LIST_SIZE = 0xFFFFFFFFU;
+
 public:
 	NgramIndex();
 	~NgramIndex();
@@ -63,16 +111,49 @@ public:
 
 	bool is_open() const { return file_map_.is_open(); }
 
+	// The size and the fingerprint of ngms.idx identify a build of the
+	// index, because a rebuild moves the offsets of lists. The fingerprint
+	// is a hash of up to FINGERPRINT_BLOCKS blocks which are spread over the
+	// file, so it is cheap for large indexes.
+	UInt64 size() const { return file_map_.size(); }
+	UInt64 fingerprint() const;
+
+	enum { FINGERPRINT_BLOCKS = 256, FINGERPRINT_BLOCK_SIZE = 64 << 10 };
+
 	Int32 max_num_tokens() const { return max_num_tokens_; }
 	Int32 max_token_id() const { return max_token_id_; }
 
+	Int32 format() const { return format_; }
+	bool is_wide() const { return (format_ & WIDE_FORMAT) != 0; }
+	bool is_elias_fano() const { return (format_ & ELIAS_FANO_FORMAT) != 0; }
+	bool is_sized() const { return (format_ & SIZED_FORMAT) != 0; }
+
 private:
 	Int32 max_num_tokens_;
 	Int32 max_token_id_;
+	Int32 format_;
 	const FileEntry *entries_;
+	const WideFileEntry *wide_entries_;
+	const UInt32 *sizes_;
+	EliasFano *sequences_;
 	FileMap file_map_;
 
-	bool mapData(const void *ptr, UInt32 size) SSGNC_WARN_UNUSED_RESULT;
+	template <typename T>
+	bool getEntry(const T *entries, UInt64 index, Entry *entry) const
+		SSGNC_WARN_UNUSED_RESULT;
+	template <typename T>
+	bool getEntry(const EliasFano &sequence, Int32 token_id,
+		Entry *entry) const SSGNC_WARN_UNUSED_RESULT;
+	template <typename T>
+	bool getEntry(const T &begin, const T &end, Entry *entry) const
+		SSGNC_WARN_UNUSED_RESULT;
+	template <typename T>
+	bool setEntry(const T &begin, Int64 approx_size, Entry *entry) const
+		SSGNC_WARN_UNUSED_RESULT;
+
+	bool mapData(const void *ptr, UInt64 size) SSGNC_WARN_UNUSED_RESULT;
+	static bool mapSequences(Mapper *mapper, Int32 max_num_tokens,
+		Int32 max_token_id, EliasFano **sequences) SSGNC_WARN_UNUSED_RESULT;
 
 	// Disallows copies.
 	NgramIndex(const NgramIndex &);
@@ -88,4 +169,15 @@ inline ssgnc::Int64 operator-(const ssgnc::NgramIndex::FileEntry &lhs,
 		- ((static_cast<ssgnc::Int64>(rhs.file_id()) << 31) + rhs.offset());
 }
 
+// In the wide format, a list which starts a new file has the end of the
+// previous file as its start position, so its size is the offset of its end.
+inline ssgnc::Int64 operator-(const ssgnc::NgramIndex::WideFileEntry &lhs,
+	const ssgnc::NgramIndex::WideFileEntry &rhs)
+{
+	if (lhs.file_id() != rhs.file_id())
+		return static_cast<ssgnc::Int64>(lhs.offset());
+	return static_cast<ssgnc::Int64>(lhs.offset())
+		- static_cast<ssgnc::Int64>(rhs.offset());
+}
+
 #endif  // SSGNC_NGRAM_INDEX_H
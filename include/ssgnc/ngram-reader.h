@@ -2,25 +2,84 @@
 #define SSGNC_NGRAM_READER_H
 
 #include "byte-reader.h"
+#include "fd-streambuf.h"
 #include "file-path.h"
 #include "ngram-index.h"
+#include "shard-map.h"
 
 namespace ssgnc {
 
 class NgramReader
 {
 public:
-	NgramReader() : num_tokens_(0), file_path_(), file_(), byte_reader_(),
-		min_encoded_freq_(1), encoded_freq_(-1), total_(0) {}
+	// A range of a file which must be read from disk before the next n-gram
+	// is read. The descriptor is valid until the reader moves to the next
+	// file or is closed.
+	class PendingRead
+	{
+	public:
+		PendingRead() : fd_(-1), offset_(0), length_(0) {}
+
+		void clear() { set(-1, 0, 0); }
+		void set(int fd, UInt64 offset, UInt32 length)
+		{
+			fd_ = fd;
+			offset_ = offset;
+			length_ = length;
+		}
+
+		bool empty() const { return fd_ == -1; }
+
+		int fd() const { return fd_; }
+		UInt64 offset() const { return offset_; }
+		UInt32 length() const { return length_; }
+
+		// Starts reading the range into the page cache without blocking.
+		bool prefetch() const SSGNC_WARN_UNUSED_RESULT;
+		// Reads the range into the page cache and returns when it is
+		// resident, so that this function is called in a worker thread.
+		bool load() const SSGNC_WARN_UNUSED_RESULT;
+
+	private:
+		int fd_;
+		UInt64 offset_;
+		UInt32 length_;
+	};
+
+	NgramReader() : num_tokens_(0), shard_map_(NULL), file_path_(),
+		file_buf_(), file_(&file_buf_), byte_reader_(), file_offset_(0),
+		min_encoded_freq_(1), encoded_freq_(-1), total_(0), basename_(),
+		path_() {}
 	~NgramReader();
 
 	bool open(const String &index_dir, Int32 num_tokens,
 		const NgramIndex::Entry &entry, Int16 min_encoded_freq = 1)
 		SSGNC_WARN_UNUSED_RESULT;
+	// The shard map must be kept open until the reader is closed.
+	bool open(const ShardMap &shard_map, Int32 num_tokens,
+		const NgramIndex::Entry &entry, Int16 min_encoded_freq = 1)
+		SSGNC_WARN_UNUSED_RESULT;
+	// Resumes reading at a position given by file_id() and offset(), where
+	// the encoded frequency of the next n-gram has already been read.
+	bool resume(const ShardMap &shard_map, Int32 num_tokens, Int32 file_id,
+		UInt64 offset, Int16 encoded_freq, Int16 min_encoded_freq = 1)
+		SSGNC_WARN_UNUSED_RESULT;
 	bool close();
 
 	bool read(Int16 *encoded_freq, std::vector<Int32> *tokens)
 		SSGNC_WARN_UNUSED_RESULT;
+	// Reads the tokens into an array which has room for num_tokens() tokens.
+	// If a stride is given, the tokens are stored into every stride-th
+	// element of the array.
+	bool read(Int16 *encoded_freq, Int32 *tokens, Int32 stride = 1)
+		SSGNC_WARN_UNUSED_RESULT;
+
+	// Tests whether the next n-gram can be read without waiting for disk
+	// I/O. If not, the range to be read is set to `pending_read'. The test
+	// uses preadv2() with RWF_NOWAIT, and the reader is always ready if the
+	// system does not support it. Moving to the next file of a list is not
+	// tested.
+	bool isReady(PendingRead *pending_read);
 
 	bool is_open() const { return file_path_.is_open(); }
 
@@ -31,25 +90,48 @@ public:
 
 	UInt64 tell() const { return total_ + byte_reader_.tell(); }
 
+	// The position of the next n-gram except its encoded frequency.
+	Int32 file_id() const { return file_path_.tell() - 1; }
+	UInt64 offset() const { return file_offset_ + byte_reader_.tell(); }
+
 	Int32 num_tokens() const { return num_tokens_; }
 	Int16 min_encoded_freq() const { return min_encoded_freq_; }
 	Int16 encoded_freq() const { return encoded_freq_; }
 
 private:
 	Int32 num_tokens_;
+	const ShardMap *shard_map_;
 	FilePath file_path_;
-	std::ifstream file_;
+	FdStreambuf file_buf_;
+	std::istream file_;
 	ByteReader byte_reader_;
+	UInt64 file_offset_;
 	Int16 min_encoded_freq_;
 	Int16 encoded_freq_;
 	UInt64 total_;
 
+	// The buffers and the paths are kept after close(), so that a reused
+	// reader does not allocate memory.
+	StringBuilder basename_;
+	StringBuilder path_;
+
 	enum { BYTE_READER_BUF_SIZE = 16 << 10 };
+	enum { PROBE_INTERVAL = 4 << 10 };
+	enum { FILE_BUF_SIZE = 4 << 10 };
+
+	bool open(const String &index_dir, const ShardMap *shard_map,
+		Int32 num_tokens, const NgramIndex::Entry &entry,
+		Int16 min_encoded_freq) SSGNC_WARN_UNUSED_RESULT;
+	bool openFile(const String &index_dir, const ShardMap *shard_map,
+		Int32 num_tokens, Int32 file_id, UInt64 offset)
+		SSGNC_WARN_UNUSED_RESULT;
 
 	bool openNextFile();
 
 	bool readEncodedFreq();
-	bool readTokens(std::vector<Int32> *tokens);
+	bool readTokens(Int32 *tokens, Int32 stride);
+
+	bool probe(PendingRead *pending_read);
 
 	// Disallows copies.
 	NgramReader(const NgramReader &);
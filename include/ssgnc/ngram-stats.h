@@ -0,0 +1,257 @@
+#ifndef SSGNC_NGRAM_STATS_H
+#define SSGNC_NGRAM_STATS_H
+
+#include "file-map.h"
+
+namespace ssgnc {
+
+// N-gram statistics are the exact sizes of the lists and the frequency
+// histograms and the co-occurrence sketches of large lists, which are
+// gathered offline by ssgnc-stat and stored in INDEX_DIR/ngms.stat. The query
+// planner uses them to choose lists and to estimate the cost of searches
+// without reading .db files.
+//
+// The file consists of a header, the number of n-grams of each order, the
+// number of n-grams of each list, ordered like the entries of the index, the
+// histograms sorted by their orders and tokens, and the sketches in order of
+// the histograms and the pair filter. A histogram counts the n-grams of each
+// bucket of encoded frequencies, where a bucket corresponds to the decimal
+// exponent of FreqHandler, i.e. 0 - 999, 1000 - 9990, ... A sketch is a
+// count-min sketch of the pairs of tokens and positions in the n-grams of a
+// list. The pair filter is a Bloom filter of the pairs of distinct tokens
+// which co-occur in the n-grams of each order.
+class NgramStats
+{
+public:
+	enum { NUM_FREQ_BUCKETS = 16, FREQ_BUCKET_SHIFT = 10 };
+
+	// Lists with fewer n-grams have neither histograms nor sketches.
+	enum { MIN_HISTOGRAM_SIZE = 1 << 10 };
+
+	static const UInt32 MAX_LIST_SIZE = 0xFFFFFFFFU;
+
+	enum { SKETCH_DEPTH = 2, SKETCH_WIDTH_BITS = 6 };
+	enum { SKETCH_WIDTH = 1 << SKETCH_WIDTH_BITS };
+
+	// The pair filter has PAIR_FILTER_BITS_PER_PAIR bits for each distinct
+	// pair, rounded up to a power of 2, which gives about 2% false positives.
+	// A filter which is limited to the maximum size may be saturated, and a
+	// saturated filter, whose bits are set more than half, is not used.
+	enum { PAIR_FILTER_NUM_HASHES = 3, PAIR_FILTER_BITS_PER_PAIR = 10 };
+	enum { MIN_PAIR_FILTER_SIZE_BITS = 6, MAX_PAIR_FILTER_SIZE_BITS = 36 };
+
+	// The scan cost is the time to read 1,000 n-grams in nanoseconds, which
+	// is measured by ssgnc-stat. The pair filter has 2^pair_filter_size_bits
+	// bits, or is missing if pair_filter_size_bits is 0. The size and the
+	// fingerprint of ngms.idx tell the build of the index, so that stale
+	// statistics are not used with a rebuilt index. The number of the set
+	// bits gives the fill ratio of the pair filter.
+	struct Header
+	{
+		Int32 max_num_tokens;
+		Int32 max_token_id;
+		Int32 num_freq_buckets;
+		UInt32 num_histograms;
+		Int32 sketch_depth;
+		Int32 sketch_width;
+		UInt32 scan_cost;
+		UInt32 pair_filter_size_bits;
+		UInt64 index_size;
+		UInt64 index_fingerprint;
+		UInt64 num_pairs;
+		UInt64 pair_filter_num_set_bits;
+	};
+
+	struct Histogram
+	{
+		Int32 num_tokens;
+		Int32 token_id;
+		UInt32 freq_counts[NUM_FREQ_BUCKETS];
+	};
+
+	// count() never underestimates the number of n-grams which have a token
+	// at a position, and overestimates it by collisions of the pairs.
+	struct Sketch
+	{
+		UInt32 counts[SKETCH_DEPTH][SKETCH_WIDTH];
+
+		void clear();
+		void add(const Int32 *tokens, Int32 num_tokens);
+		UInt32 count(Int32 token_id, Int32 position) const;
+
+		static UInt32 hash(Int32 row, Int32 token_id, Int32 position);
+	};
+
+	// The bits of a pair are given by double hashing, so that a filter is
+	// folded by taking the lower bits of the positions.
+	struct PairFilter
+	{
+		static UInt64 hash(Int32 num_tokens, Int32 token_id, Int32 token_id2);
+		static UInt64 position(UInt64 hash, Int32 index)
+		{ return (hash >> 32) + (index * (hash | 1)); }
+	};
+
+	class Entry
+	{
+	public:
+		Entry() : num_ngrams_(0), freq_counts_(NULL), sketch_(NULL) {}
+
+		void set_num_ngrams(UInt64 num_ngrams) { num_ngrams_ = num_ngrams; }
+		void set_freq_counts(const UInt32 *freq_counts)
+		{ freq_counts_ = freq_counts; }
+		void set_sketch(const Sketch *sketch) { sketch_ = sketch; }
+
+		UInt64 num_ngrams() const { return num_ngrams_; }
+		bool has_histogram() const { return freq_counts_ != NULL; }
+		const UInt32 *freq_counts() const { return freq_counts_; }
+		bool has_sketch() const { return sketch_ != NULL; }
+		const Sketch *sketch() const { return sketch_; }
+
+	private:
+		UInt64 num_ngrams_;
+		const UInt32 *freq_counts_;
+		const Sketch *sketch_;
+	};
+
+	// A builder collects the statistics of lists and writes them in the
+	// format of ngms.stat.
+	class Builder
+	{
+	public:
+		Builder() : max_num_tokens_(0), max_token_id_(0), scan_cost_(0),
+			index_size_(0), index_fingerprint_(0), num_ngrams_(),
+			list_sizes_(), histograms_(), sketches_(), pair_hashes_(),
+			num_sorted_pair_hashes_(0) {}
+		~Builder() {}
+
+		bool init(Int32 max_num_tokens, Int32 max_token_id)
+			SSGNC_WARN_UNUSED_RESULT;
+		void clear();
+
+		// Appends the histogram and the sketch of a list. The lists must be
+		// appended in order of their orders and tokens. An n-gram is counted
+		// once for its order by the list of its smallest token ID, so that
+		// the number of n-grams of an order does not depend on their
+		// lengths.
+		bool appendList(Int32 num_tokens, Int32 token_id,
+			const UInt64 *freq_counts, const Sketch &sketch,
+			UInt64 num_first_ngrams) SSGNC_WARN_UNUSED_RESULT;
+
+		// Adds the pairs of distinct tokens in an n-gram to the pair filter.
+		// An n-gram should be appended once, e.g. from the list of its
+		// smallest token ID. The hashes of the pairs are kept until write()
+		// to count the distinct pairs, which takes 8 bytes per pair.
+		bool appendPairs(const Int32 *tokens, Int32 num_tokens)
+			SSGNC_WARN_UNUSED_RESULT;
+
+		void set_scan_cost(UInt32 scan_cost) { scan_cost_ = scan_cost; }
+		UInt32 scan_cost() const { return scan_cost_; }
+
+		void set_index(UInt64 index_size, UInt64 index_fingerprint)
+		{
+			index_size_ = index_size;
+			index_fingerprint_ = index_fingerprint;
+		}
+
+		// The pair filter is sized by the number of distinct pairs.
+		bool write(std::ostream *stream) SSGNC_WARN_UNUSED_RESULT;
+
+		UInt64 num_ngrams(Int32 num_tokens) const
+		{ return num_ngrams_[num_tokens - 1]; }
+		UInt32 num_histograms() const
+		{ return static_cast<UInt32>(histograms_.size()); }
+		// The number of distinct pairs is counted by write().
+		UInt64 num_pairs() const { return num_sorted_pair_hashes_; }
+
+	private:
+		Int32 max_num_tokens_;
+		Int32 max_token_id_;
+		UInt32 scan_cost_;
+		UInt64 index_size_;
+		UInt64 index_fingerprint_;
+		std::vector<UInt64> num_ngrams_;
+		std::vector<UInt32> list_sizes_;
+		std::vector<Histogram> histograms_;
+		std::vector<Sketch> sketches_;
+		std::vector<UInt64> pair_hashes_;
+		std::size_t num_sorted_pair_hashes_;
+
+		// The hashes are sorted and deduplicated when their number has
+		// doubled, so that duplicate pairs take a bounded space.
+		void sortPairHashes();
+
+		static UInt32 pairFilterSizeBits(UInt64 num_pairs);
+
+		// Disallows copies.
+		Builder(const Builder &);
+		Builder &operator=(const Builder &);
+	};
+
+public:
+	NgramStats();
+	~NgramStats();
+
+	bool open(const Int8 *path, FileMap::Mode mode = FileMap::DEFAULT_MODE)
+		SSGNC_WARN_UNUSED_RESULT;
+	bool close();
+
+	bool get(Int32 num_tokens, Int32 token_id, Entry *entry) const
+		SSGNC_WARN_UNUSED_RESULT;
+
+	// Returns false if no n-gram of the order has both the tokens. A false
+	// positive is possible, and true is returned without the pair filter.
+	bool mayHavePair(Int32 num_tokens, Int32 token_id, Int32 token_id2) const;
+
+	bool is_open() const { return file_map_.is_open(); }
+	bool has_pair_filter() const { return pair_filter_ != NULL; }
+	// The planner ignores a saturated pair filter, which would let almost
+	// all the pairs pass.
+	bool is_pair_filter_saturated() const
+	{ return pair_filter_num_set_bits_ * 2 > pair_filter_mask_ + 1; }
+	double pair_filter_fill_ratio() const
+	{
+		return (pair_filter_ == NULL) ? 0.0 :
+			static_cast<double>(pair_filter_num_set_bits_)
+			/ (static_cast<double>(pair_filter_mask_) + 1.0);
+	}
+
+	Int32 max_num_tokens() const { return max_num_tokens_; }
+	Int32 max_token_id() const { return max_token_id_; }
+	UInt32 scan_cost() const { return scan_cost_; }
+	UInt64 index_size() const { return index_size_; }
+	UInt64 index_fingerprint() const { return index_fingerprint_; }
+	// The number of distinct pairs of tokens in the n-grams of all orders.
+	UInt64 num_pairs() const { return num_pairs_; }
+
+	// The number of distinct n-grams of an order.
+	UInt64 num_ngrams(Int32 num_tokens) const
+	{ return num_ngrams_[num_tokens - 1]; }
+
+	static Int32 freqBucket(Int16 encoded_freq)
+	{ return encoded_freq >> FREQ_BUCKET_SHIFT; }
+
+private:
+	Int32 max_num_tokens_;
+	Int32 max_token_id_;
+	UInt32 scan_cost_;
+	UInt64 index_size_;
+	UInt64 index_fingerprint_;
+	UInt64 num_pairs_;
+	UInt32 num_histograms_;
+	const UInt64 *num_ngrams_;
+	const UInt32 *list_sizes_;
+	const Histogram *histograms_;
+	const Sketch *sketches_;
+	UInt64 pair_filter_mask_;
+	UInt64 pair_filter_num_set_bits_;
+	const UInt64 *pair_filter_;
+	FileMap file_map_;
+
+	// Disallows copies.
+	NgramStats(const NgramStats &);
+	NgramStats &operator=(const NgramStats &);
+};
+
+}  // namespace ssgnc
+
+#endif  // SSGNC_NGRAM_STATS_H
@@ -0,0 +1,128 @@
+#ifndef SSGNC_PLANNER_H
+#define SSGNC_PLANNER_H
+
+#include "agent.h"
+#include "ngram-index.h"
+#include "ngram-stats.h"
+
+namespace ssgnc {
+
+// A planner chooses a list of each order for a query. If the statistics of
+// the index are available, the list with the fewest n-grams is chosen and
+// the cost of the search is estimated from the histograms and the sketches of
+// the chosen lists. Otherwise, the list with the fewest bytes is chosen. An
+// order is not read if the pair filter shows that two tokens of the query
+// never co-occur in its n-grams, unless the filter is saturated.
+class Planner
+{
+public:
+	// An estimate of the list which is read for an order. The density is the
+	// expected ratio of the n-grams which pass the filter. It is estimated
+	// from the sketch of the list if available. Otherwise, the tokens of a
+	// query are assumed to appear independently of each other and of their
+	// positions. Without the statistics, only the bytes of lists are known.
+	// The total matches ignore the limits of a query except for the minimum
+	// frequency.
+	struct Estimate
+	{
+		Int32 num_tokens;
+		Int32 token_id;
+		Int64 approx_size;
+		UInt64 num_ngrams;
+		const UInt32 *freq_counts;
+		const NgramStats::Sketch *sketch;
+		double density;
+
+		double num_scans;
+		double num_bytes;
+		double num_matches;
+		double num_total_matches;
+	};
+
+	class Explanation
+	{
+	public:
+		enum Access { NO_SOURCES, MATERIALIZED_RESULTS, LISTS };
+
+		Explanation() : access_(NO_SOURCES), has_stats_(false), scan_cost_(0),
+			estimates_() {}
+		~Explanation() {}
+
+		void clear();
+
+		void set_access(Access access) { access_ = access; }
+		void set_has_stats(bool has_stats) { has_stats_ = has_stats; }
+		void set_scan_cost(UInt32 scan_cost) { scan_cost_ = scan_cost; }
+
+		Access access() const { return access_; }
+		bool has_stats() const { return has_stats_; }
+		UInt32 scan_cost() const { return scan_cost_; }
+
+		const std::vector<Estimate> &estimates() const { return estimates_; }
+		std::vector<Estimate> *mutable_estimates() { return &estimates_; }
+
+		double num_scans() const;
+		double num_bytes() const;
+		double num_matches() const;
+		double num_total_matches() const;
+
+		// The estimated time to read the lists in microseconds, which is
+		// based on the scan cost of NgramStats.
+		double search_time() const
+		{ return num_scans() * scan_cost_ / 1000000.0; }
+
+		// Writes the access path and the estimates of the lists, one per
+		// line. Unknown numbers are written as '?'.
+		bool write(std::ostream *stream) const SSGNC_WARN_UNUSED_RESULT;
+
+		static const char *accessName(Access access);
+
+	private:
+		Access access_;
+		bool has_stats_;
+		UInt32 scan_cost_;
+		std::vector<Estimate> estimates_;
+
+		// Disallows copies.
+		Explanation(const Explanation &);
+		Explanation &operator=(const Explanation &);
+	};
+
+public:
+	Planner(const NgramIndex *ngram_index, const NgramStats *ngram_stats)
+		: ngram_index_(ngram_index), ngram_stats_(ngram_stats) {}
+	~Planner() {}
+
+	// Chooses the lists of orders from `min_num_tokens' to `max_num_tokens'.
+	// If `estimates' is given, the estimates of the chosen lists are stored
+	// into it. The sources are built without allocation for a reused vector.
+	bool plan(const Query &query, Int32 min_num_tokens, Int32 max_num_tokens,
+		std::vector<Agent::Source> *sources,
+		std::vector<Estimate> *estimates = NULL) const
+		SSGNC_WARN_UNUSED_RESULT;
+
+	// Estimates the numbers of n-grams and bytes read from lists and the
+	// number of results. The lists are merged in descending order of
+	// frequency, so a search with a limit is expected to stop in the
+	// frequency bucket where the expected results reach the limit.
+	static void estimate(const Query &query, std::vector<Estimate> *estimates);
+
+private:
+	const NgramIndex *ngram_index_;
+	const NgramStats *ngram_stats_;
+
+	bool has_stats() const
+	{ return ngram_stats_ != NULL && ngram_stats_->is_open(); }
+
+	bool hasPairs(const Query &query, Int32 num_tokens) const;
+	bool estimateDensity(const Query &query, Estimate *estimate) const
+		SSGNC_WARN_UNUSED_RESULT;
+
+	// Disallows copies.
+	Planner(const Planner &);
+	Planner &operator=(const Planner &);
+};
+
+}  // namespace ssgnc
+
+#endif  // SSGNC_PLANNER_H
@@ -0,0 +1,81 @@
+#ifndef SSGNC_PROTOCOL_H
+#define SSGNC_PROTOCOL_H
+
+#include "query.h"
+#include "reader.h"
+#include "writer.h"
+
+namespace ssgnc {
+
+// The protocol between a coordinator and workers. A request is a query and
+// its response is a sequence of results in descending order of frequency.
+// Each result carries the number of bytes read by the worker so far. The
+// response ends with an encoded frequency of END_OF_RESULTS on success or
+// ERROR_OF_RESULTS on failure.
+//
+// The protocol between clients and ssgnc-server. A request is the options
+// of a query and a query string, and its response is a sequence of decoded
+// n-grams, each of which is preceded by its length. The response ends with
+// a length of END_OF_NGRAMS on success or ERROR_OF_NGRAMS on failure.
+// Requests may be pipelined and the responses are returned in order.
+class Protocol
+{
+public:
+	static bool writeQuery(Writer *writer, const Query &query)
+		SSGNC_WARN_UNUSED_RESULT;
+	static bool readQuery(Reader *reader, Query *query)
+		SSGNC_WARN_UNUSED_RESULT;
+
+	static bool writeResult(Writer *writer, Int16 encoded_freq,
+		const std::vector<Int32> &tokens, UInt64 total)
+		SSGNC_WARN_UNUSED_RESULT;
+	static bool writeEnd(Writer *writer, bool is_ok, UInt64 total)
+		SSGNC_WARN_UNUSED_RESULT;
+
+	// An encoded frequency of END_OF_RESULTS or ERROR_OF_RESULTS is
+	// returned at the end of a response.
+	static bool readResult(Reader *reader, Int16 *encoded_freq,
+		std::vector<Int32> *tokens, UInt64 *total) SSGNC_WARN_UNUSED_RESULT;
+
+	// The tokens of `options' are ignored.
+	static bool writeRequest(Writer *writer, const Query &options,
+		const String &query_str) SSGNC_WARN_UNUSED_RESULT;
+	static bool readRequest(Reader *reader, Query *options,
+		StringBuilder *query_str) SSGNC_WARN_UNUSED_RESULT;
+
+	static bool writeNgram(Writer *writer, const String &ngram)
+		SSGNC_WARN_UNUSED_RESULT;
+	static bool writeEndOfNgrams(Writer *writer, bool is_ok)
+		SSGNC_WARN_UNUSED_RESULT;
+
+	// A length of END_OF_NGRAMS or ERROR_OF_NGRAMS is returned at the end
+	// of a response.
+	static bool readNgram(Reader *reader, Int32 *length,
+		StringBuilder *ngram) SSGNC_WARN_UNUSED_RESULT;
+
+	enum { QUERY_MARKER = 0x51474E53, REQUEST_MARKER = 0x52474E53 };
+	enum { END_OF_RESULTS = 0, ERROR_OF_RESULTS = -1 };
+	enum { END_OF_NGRAMS = -1, ERROR_OF_NGRAMS = -2 };
+	enum { MAX_STRING_LENGTH = 1 << 20 };
+
+private:
+	static bool writeOptions(Writer *writer, const Query &query)
+		SSGNC_WARN_UNUSED_RESULT;
+	static bool readOptions(Reader *reader, Query *query)
+		SSGNC_WARN_UNUSED_RESULT;
+
+	static bool writeString(Writer *writer, const String &str)
+		SSGNC_WARN_UNUSED_RESULT;
+	static bool readString(Reader *reader, Int32 *length,
+		StringBuilder *str) SSGNC_WARN_UNUSED_RESULT;
+
+
+	// Disallows instantiation.
+	Protocol();
+	Protocol(const Protocol &);
+	Protocol &operator=(const Protocol &);
+};
+
+}  // namespace ssgnc
+
+#endif  // SSGNC_PROTOCOL_H
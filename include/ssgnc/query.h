@@ -34,6 +34,8 @@ public:
 	bool set_max_num_tokens(Int64 value);
 	bool set_max_num_results(Int64 value);
 	bool set_io_limit(Int64 value);
+	bool set_time_limit(Int64 value);
+	bool set_scan_limit(Int64 value);
 	bool set_order(TokenOrder value);
 
 	Int32 token(Int32 index) const;
@@ -47,6 +49,11 @@ public:
 	Int32 max_num_tokens() const { return max_num_tokens_; }
 	UInt64 max_num_results() const { return max_num_results_; }
 	UInt64 io_limit() const { return io_limit_; }
+	// The time limit is given in microseconds, and the scan limit is the
+	// maximum number of n-grams read from lists, which includes the n-grams
+	// rejected by the filter.
+	UInt64 time_limit() const { return time_limit_; }
+	UInt64 scan_limit() const { return scan_limit_; }
 	TokenOrder order() const { return order_; }
 
 	bool parseOptions(Int32 *argc, Int8 *argv[]);
@@ -60,6 +67,8 @@ public:
 	bool parseMaxNumTokens(const String &str);
 	bool parseMaxNumResults(const String &str);
 	bool parseIOLimit(const String &str);
+	bool parseTimeLimit(const String &str);
+	bool parseScanLimit(const String &str);
 	bool parseOrder(const String &str);
 
 	static bool showOptions(std::ostream *out);
@@ -70,6 +79,8 @@ public:
 	static const Int64 MIN_NUM_TOKENS = 0;
 	static const Int64 MIN_NUM_RESULTS = 0;
 	static const Int64 MIN_IO_LIMIT = 0;
+	static const Int64 MIN_TIME_LIMIT = 0;
+	static const Int64 MIN_SCAN_LIMIT = 0;
 
 	static const Int64 MAX_TOKEN = 0x7FFFFFFF;
 	static const Int64 MAX_FREQ = FreqHandler::MAX_FREQ;
@@ -77,6 +88,8 @@ public:
 	static const Int64 MAX_NUM_TOKENS = 30;
 	static const Int64 MAX_NUM_RESULTS = 0xFFFFFFFFFFLL;
 	static const Int64 MAX_IO_LIMIT = 0xFFFFFFFFFFLL;
+	static const Int64 MAX_TIME_LIMIT = 0xFFFFFFFFFFLL;
+	static const Int64 MAX_SCAN_LIMIT = 0xFFFFFFFFFFLL;
 
 private:
 	std::vector<Int32> tokens_;
@@ -86,6 +99,8 @@ private:
 	Int32 max_num_tokens_;
 	UInt64 max_num_results_;
 	UInt64 io_limit_;
+	UInt64 time_limit_;
+	UInt64 scan_limit_;
 	TokenOrder order_;
 	FreqHandler freq_handler_;
 
@@ -0,0 +1,62 @@
+#ifndef SSGNC_RESULT_BATCH_H
+#define SSGNC_RESULT_BATCH_H
+
+#include "common.h"
+
+namespace ssgnc {
+
+class Agent;
+
+// A result batch holds results in columns: the encoded frequencies, the
+// numbers of tokens and the offsets of the results, and the tokens of all
+// the results in a flat array. Agent::readBatch() reads tokens into the
+// flat array directly, and Database::decode() writes a batch at once. The
+// columns keep their memory for the next batch.
+class ResultBatch
+{
+public:
+	ResultBatch() : encoded_freqs_(), num_tokens_(), offsets_(), tokens_() {}
+	~ResultBatch() {}
+
+	void clear();
+
+	bool append(Int16 encoded_freq, const Int32 *tokens, Int32 num_tokens)
+		SSGNC_WARN_UNUSED_RESULT;
+
+	UInt32 size() const { return static_cast<UInt32>(encoded_freqs_.size()); }
+	bool empty() const { return encoded_freqs_.empty(); }
+
+	Int16 encoded_freq(UInt32 index) const { return encoded_freqs_[index]; }
+	Int32 num_tokens(UInt32 index) const { return num_tokens_[index]; }
+	const Int32 *tokens(UInt32 index) const
+	{ return &tokens_[0] + offsets_[index]; }
+
+	const std::vector<Int16> &encoded_freqs() const { return encoded_freqs_; }
+	const std::vector<Int32> &num_tokens() const { return num_tokens_; }
+	const std::vector<UInt32> &offsets() const { return offsets_; }
+	const std::vector<Int32> &tokens() const { return tokens_; }
+
+private:
+	friend class Agent;
+
+	std::vector<Int16> encoded_freqs_;
+	std::vector<Int32> num_tokens_;
+	std::vector<UInt32> offsets_;
+	std::vector<Int32> tokens_;
+
+	// A result is read in two steps. reserve() returns the space for its
+	// tokens, and commit() appends the other columns. If the result is
+	// filtered out, the space is released by rollback().
+	bool reserve(Int32 num_tokens, Int32 **tokens) SSGNC_WARN_UNUSED_RESULT;
+	bool commit(Int16 encoded_freq, Int32 num_tokens)
+		SSGNC_WARN_UNUSED_RESULT;
+	void rollback(Int32 num_tokens);
+
+	// Disallows copies.
+	ResultBatch(const ResultBatch &);
+	ResultBatch &operator=(const ResultBatch &);
+};
+
+}  // namespace ssgnc
+
+#endif  // SSGNC_RESULT_BATCH_H
@@ -0,0 +1,156 @@
+#ifndef SSGNC_RESULT_CACHE_H
+#define SSGNC_RESULT_CACHE_H
+
+#include "query.h"
+
+#include <list>
+#include <map>
+
+#include <pthread.h>
+
+namespace ssgnc {
+
+class Agent;
+
+// A result cache keeps the first results of queries, so that repeated
+// queries are answered without reading .db files. An entry of an unfinished
+// search also keeps the agent which has produced the results, and a repeat
+// with a larger limit continues from the end of the cached results. Entries
+// are evicted in LRU order when their total size exceeds the limit.
+//
+// A cache is shared by the agents of a database. It must be closed before
+// the database because the suspended agents refer to its shard map.
+class ResultCache
+{
+public:
+	typedef std::vector<Int32> Key;
+
+	class Results
+	{
+	public:
+		Results() : encoded_freqs_(), tokens_(), ends_() {}
+		~Results() {}
+
+		void clear();
+		void swap(Results *target);
+
+		bool assign(const Results &results) SSGNC_WARN_UNUSED_RESULT;
+		bool append(Int16 encoded_freq, const std::vector<Int32> &tokens)
+			SSGNC_WARN_UNUSED_RESULT;
+		bool append(Int16 encoded_freq, const Int32 *tokens,
+			Int32 num_tokens) SSGNC_WARN_UNUSED_RESULT;
+		bool get(UInt64 index, Int16 *encoded_freq,
+			std::vector<Int32> *tokens) const SSGNC_WARN_UNUSED_RESULT;
+		// The tokens are returned as a pointer into the results, which is
+		// valid until the results are modified.
+		bool get(UInt64 index, Int16 *encoded_freq, const Int32 **tokens,
+			Int32 *num_tokens) const SSGNC_WARN_UNUSED_RESULT;
+
+		UInt64 size() const { return encoded_freqs_.size(); }
+		UInt64 bytes() const;
+
+	private:
+		std::vector<Int16> encoded_freqs_;
+		std::vector<Int32> tokens_;
+		std::vector<UInt32> ends_;
+
+		// Disallows copies.
+		Results(const Results &);
+		Results &operator=(const Results &);
+	};
+
+public:
+	ResultCache();
+	~ResultCache();
+
+	bool open(UInt64 max_bytes,
+		UInt32 max_num_agents = DEFAULT_MAX_NUM_AGENTS)
+		SSGNC_WARN_UNUSED_RESULT;
+	bool close();
+
+	// A key consists of the settings which affect the order and the contents
+	// of results. Limits on results, IO and scans are not included.
+	// Instead, find() uses an entry only if the IO and scan limits of a
+	// query would not have stopped the cached search before its results.
+	static bool makeKey(const Query &query, Int32 min_num_tokens,
+		Int32 max_num_tokens, Key *key) SSGNC_WARN_UNUSED_RESULT;
+
+	// Opens an agent with cached results. If there are not enough results,
+	// the agent continues the search of the cached agent if available.
+	// Otherwise, this function returns false.
+	bool find(const Key &key, const Query &query, Agent *agent)
+		SSGNC_WARN_UNUSED_RESULT;
+	// Takes the results and the suspended agent, which may be NULL. The
+	// total bytes and the number of scanned n-grams are those of the search
+	// which has produced the results. An entry is not replaced with fewer
+	// incomplete results, e.g. those of a search with a smaller limit.
+	void insert(const Key &key, Results *results, bool is_complete,
+		UInt64 total, UInt64 num_scanned, Agent *agent);
+
+	bool is_open() const { return is_open_; }
+
+	UInt64 max_bytes() const { return max_bytes_; }
+	// A larger result set is not cached.
+	UInt64 max_entry_bytes() const { return max_bytes_ / 4; }
+
+	// The counters are changed by other threads, so all of them are read
+	// under the lock.
+	UInt64 num_bytes() const;
+	UInt64 num_entries() const;
+	UInt64 num_hits() const;
+	UInt64 num_resumes() const;
+	UInt64 num_misses() const;
+	double hit_rate() const;
+
+	enum { DEFAULT_MAX_NUM_AGENTS = 64 };
+
+	// An agent keeps a file and buffers for each list.
+	enum { READER_BYTES = 24 << 10 };
+
+private:
+	struct Entry
+	{
+		Entry() : key(), results(), is_complete(false), total(0),
+			num_scanned(0), agent(NULL), bytes(0) {}
+
+		Key key;
+		Results results;
+		bool is_complete;
+		UInt64 total;
+		UInt64 num_scanned;
+		Agent *agent;
+		UInt64 bytes;
+
+	private:
+		// Disallows copies.
+		Entry(const Entry &);
+		Entry &operator=(const Entry &);
+	};
+
+	typedef std::list<Entry *> EntryList;
+	typedef std::map<Key, EntryList::iterator> EntryMap;
+
+	bool is_open_;
+	UInt64 max_bytes_;
+	UInt32 max_num_agents_;
+	UInt64 num_bytes_;
+	UInt32 num_agents_;
+	EntryList entries_;
+	EntryMap map_;
+	UInt64 num_hits_;
+	UInt64 num_resumes_;
+	UInt64 num_misses_;
+	mutable pthread_mutex_t mutex_;
+
+	void remove(EntryMap::iterator it);
+	void deleteEntry(Entry *entry);
+	void clearEntries();
+
+	// Disallows copies.
+	ResultCache(const ResultCache &);
+	ResultCache &operator=(const ResultCache &);
+};
+
+}  // namespace ssgnc
+
+#endif  // SSGNC_RESULT_CACHE_H
@@ -0,0 +1,65 @@
+#ifndef SSGNC_SHARD_MAP_H
+#define SSGNC_SHARD_MAP_H
+
+#include "string-builder.h"
+
+#include <string>
+
+namespace ssgnc {
+
+// A shard map tells which directory has each .db file. It is read from
+// INDEX_DIR/ngms.shards, which consists of lines "NUM_TOKENS FIRST_FILE_ID
+// DIRNAME". The files of NUM_TOKENS-grams from FIRST_FILE_ID to the next
+// line of the same order are in DIRNAME, which may be relative to INDEX_DIR.
+// Lists are laid out in order of token IDs, so a range of file IDs is also
+// a range of token IDs. The other files and all the files of an index
+// without ngms.shards are in INDEX_DIR, which is the shard of ID 0.
+class ShardMap
+{
+public:
+	ShardMap() : index_dir_(), ranges_(), dirnames_() {}
+	~ShardMap();
+
+	bool open(const String &index_dir) SSGNC_WARN_UNUSED_RESULT;
+	bool close();
+
+	Int32 find(Int32 num_tokens, Int32 file_id) const;
+	String dirname(Int32 shard_id) const;
+
+	bool is_open() const { return !index_dir_.empty(); }
+
+	String index_dir() const { return index_dir_.str(); }
+	Int32 num_shards() const
+	{ return static_cast<Int32>(dirnames_.size()) + 1; }
+
+private:
+	struct Range
+	{
+		Int32 num_tokens;
+		Int32 first_file_id;
+		Int32 shard_id;
+
+		bool operator<(const Range &rhs) const
+		{
+			if (num_tokens != rhs.num_tokens)
+				return num_tokens < rhs.num_tokens;
+			return first_file_id < rhs.first_file_id;
+		}
+	};
+
+	StringBuilder index_dir_;
+	std::vector<Range> ranges_;
+	std::vector<std::string> dirnames_;
+
+	bool readShards(std::istream *stream) SSGNC_WARN_UNUSED_RESULT;
+	bool addRange(Int32 num_tokens, Int32 first_file_id,
+		const std::string &dirname) SSGNC_WARN_UNUSED_RESULT;
+
+	// Disallows copies.
+	ShardMap(const ShardMap &);
+	ShardMap &operator=(const ShardMap &);
+};
+
+}  // namespace ssgnc
+
+#endif  // SSGNC_SHARD_MAP_H
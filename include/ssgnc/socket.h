@@ -0,0 +1,40 @@
+#ifndef SSGNC_SOCKET_H
+#define SSGNC_SOCKET_H
+
+#include "string.h"
+
+namespace ssgnc {
+
+// An address is "[HOST]:PORT" for TCP or a path for a Unix domain socket.
+// An address which contains '/' or does not contain ':' is a path. An empty
+// host means any address for listen() and the local host for connect().
+class Socket
+{
+public:
+	static bool listen(const String &address, int *listen_fd)
+		SSGNC_WARN_UNUSED_RESULT;
+	static bool accept(int listen_fd, int *fd) SSGNC_WARN_UNUSED_RESULT;
+	static bool connect(const String &address, int *fd)
+		SSGNC_WARN_UNUSED_RESULT;
+
+	static bool isTcp(const String &address);
+
+private:
+	static bool listenUnix(const String &path, int *listen_fd)
+		SSGNC_WARN_UNUSED_RESULT;
+	static bool listenTcp(const String &address, int *listen_fd)
+		SSGNC_WARN_UNUSED_RESULT;
+	static bool connectUnix(const String &path, int *fd)
+		SSGNC_WARN_UNUSED_RESULT;
+	static bool connectTcp(const String &address, int *fd)
+		SSGNC_WARN_UNUSED_RESULT;
+
+	// Disallows instantiation.
+	Socket();
+	Socket(const Socket &);
+	Socket &operator=(const Socket &);
+};
+
+}  // namespace ssgnc
+
+#endif  // SSGNC_SOCKET_H
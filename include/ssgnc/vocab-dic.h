@@ -3,6 +3,7 @@
 
 #include "string-hash.h"
 #include "file-map.h"
+#include "mapper.h"
 
 namespace ssgnc {
 
@@ -24,25 +25,39 @@ public:
 
 	UInt32 num_keys() const { return num_keys_; }
 	UInt32 table_size() const { return table_size_; }
-	UInt32 total_size() const { return total_size_; }
+	UInt64 total_size() const { return total_size_; }
 
-	static bool build(const Int8 *path, const std::vector<String> &keys)
-		SSGNC_WARN_UNUSED_RESULT;
+	bool is_large() const { return large_offsets_ != NULL; }
+
+	// The large format is used if the dictionary does not fit in the
+	// original format or if force_large is true.
+	static bool build(const Int8 *path, const std::vector<String> &keys,
+		bool force_large = false) SSGNC_WARN_UNUSED_RESULT;
 
 	enum { INVALID_KEY_ID = -1 };
 
+	// A dictionary which does not fit in the original format, in which the
+	// sizes and the offsets are 32-bit, starts with LARGE_FORMAT_MARKER in
+	// place of the number of keys. The marker is followed by format flags.
+	// The table of the large format is padded to a multiple of 8 bytes, so
+	// that the 64-bit offsets are aligned.
+	enum { LARGE_FORMAT_MARKER = 0, LARGE_FORMAT = 1 };
+
 private:
 	UInt32 num_keys_;
 	UInt32 table_size_;
-	UInt32 total_size_;
+	UInt64 total_size_;
 	const Int32 *table_;
 	const UInt32 *offsets_;
+	const UInt64 *large_offsets_;
 	const Int8 *keys_;
 	FileMap file_map_;
 
+	UInt64 offset(Int32 key_id) const;
 	String restoreKey(Int32 key_id) const;
 
-	bool mapData(const void *ptr, UInt32 size) SSGNC_WARN_UNUSED_RESULT;
+	bool mapData(const void *ptr, UInt64 size) SSGNC_WARN_UNUSED_RESULT;
+	bool mapLargeData(Mapper *mapper) SSGNC_WARN_UNUSED_RESULT;
 
 	// Disallows copies.
 	VocabDic(const VocabDic &);
@@ -66,10 +81,17 @@ inline bool VocabDic::find(Int32 key_id, String *key) const
 	return true;
 }
 
+inline UInt64 VocabDic::offset(Int32 key_id) const
+{
+	return (large_offsets_ != NULL)
+		? large_offsets_[key_id] : offsets_[key_id];
+}
+
 inline String VocabDic::restoreKey(Int32 key_id) const
 {
-	return String(keys_ + offsets_[key_id],
-		offsets_[key_id + 1] - offsets_[key_id]);
+	UInt64 begin = offset(key_id);
+	return String(keys_ + begin,
+		static_cast<UInt32>(offset(key_id + 1) - begin));
 }
 
 }  // namespace ssgnc
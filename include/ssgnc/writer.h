@@ -18,7 +18,7 @@ public:
 	template <typename T>
 	bool write(const T &obj) SSGNC_WARN_UNUSED_RESULT;
 	template <typename T>
-	bool write(const T *objs, UInt32 num_objs) SSGNC_WARN_UNUSED_RESULT;
+	bool write(const T *objs, UInt64 num_objs) SSGNC_WARN_UNUSED_RESULT;
 
 	bool is_open() const { return stream_ != NULL; }
 
@@ -27,13 +27,13 @@ public:
 	bool good() const { return stream_ != NULL && stream_->good(); }
 	bool fail() const { return stream_ == NULL || stream_->fail(); }
 
-	UInt32 tell() const { return total_; }
+	UInt64 tell() const { return total_; }
 
-	enum { MAX_TOTAL = 0x7FFFFFFF };
+	static const UInt64 MAX_TOTAL = 0xFFFFFFFFFFFFULL;
 
 private:
 	std::ostream *stream_;
-	UInt32 total_;
+	UInt64 total_;
 
 	// Disallows copies.
 	Writer(const Writer &);
@@ -63,12 +63,12 @@ bool Writer::write(const T &obj)
 		return false;
 	}
 
-	total_ += static_cast<UInt32>(sizeof(T));
+	total_ += sizeof(T);
 	return true;
 }
 
 template <typename T>
-bool Writer::write(const T *objs, UInt32 num_objs)
+bool Writer::write(const T *objs, UInt64 num_objs)
 {
 	if (!is_open())
 	{
@@ -82,7 +82,7 @@ bool Writer::write(const T *objs, UInt32 num_objs)
 	}
 
 	UInt64 num_bytes = static_cast<UInt64>(sizeof(T)) * num_objs;
-	if (total_ + num_bytes > MAX_TOTAL)
+	if (num_bytes > MAX_TOTAL || total_ + num_bytes > MAX_TOTAL)
 	{
 		SSGNC_ERROR << "Total overflow: " << total_
 			<< " + " << sizeof(T) << " * " << num_objs << std::endl;
@@ -90,14 +90,14 @@ bool Writer::write(const T *objs, UInt32 num_objs)
 	}
 
 	if (!stream_->write(reinterpret_cast<const Int8 *>(objs),
-		sizeof(T) * num_objs))
+		static_cast<std::streamsize>(num_bytes)))
 	{
 		SSGNC_ERROR << "std::iostream::write() failed: " << total_
 			<< " + " << sizeof(T) << " * " << num_objs << std::endl;
 		return false;
 	}
 
-	total_ += static_cast<UInt32>(num_bytes);
+	total_ += num_bytes;
 	return true;
 }
 
@@ -0,0 +1,156 @@
+#include "ssgnc/access-log.h"
+#include "ssgnc/mutex-lock.h"
+
+#include <cctype>
+
+namespace ssgnc {
+
+AccessLog::AccessLog() : stream_(NULL), num_records_(0), mutex_()
+{
+	::pthread_mutex_init(&mutex_, NULL);
+}
+
+AccessLog::~AccessLog()
+{
+	if (is_open())
+		close();
+
+	::pthread_mutex_destroy(&mutex_);
+}
+
+bool AccessLog::open(std::ostream *stream)
+{
+	if (is_open())
+	{
+		SSGNC_ERROR << "Already opened" << std::endl;
+		return false;
+	}
+	else if (stream == NULL)
+	{
+		SSGNC_ERROR << "Null pointer" << std::endl;
+		return false;
+	}
+
+	stream_ = stream;
+	return true;
+}
+
+bool AccessLog::close()
+{
+	if (!is_open())
+	{
+		SSGNC_ERROR << "Not opened" << std::endl;
+		return false;
+	}
+
+	bool is_ok = true;
+	if (!stream_->flush())
+	{
+		SSGNC_ERROR << "std::ostream::flush() failed" << std::endl;
+		is_ok = false;
+	}
+
+	stream_ = NULL;
+	num_records_ = 0;
+	return is_ok;
+}
+
+UInt64 AccessLog::num_records() const
+{
+	MutexLock lock(&mutex_);
+	return num_records_;
+}
+
+bool AccessLog::write(const Record &record)
+{
+	if (!is_open())
+	{
+		SSGNC_ERROR << "Not opened" << std::endl;
+		return false;
+	}
+
+	bool is_ok;
+	{
+		MutexLock lock(&mutex_);
+		*stream_ << record.num_tokens() << ' ' << record.token_id() << ' '
+			<< record.file_id() << ' ' << record.offset() << ' '
+			<< record.length() << '\n';
+		is_ok = !stream_->fail();
+		if (is_ok)
+			++num_records_;
+	}
+
+	if (!is_ok)
+	{
+		SSGNC_ERROR << "std::ostream::operator<<() failed" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+bool AccessLog::parse(const String &line, Record *record)
+{
+	if (record == NULL)
+	{
+		SSGNC_ERROR << "Null pointer" << std::endl;
+		return false;
+	}
+
+	String avail = line;
+	Int64 values[5];
+	for (std::size_t i = 0; i < sizeof(values) / sizeof(values[0]); ++i)
+	{
+		if (!parseValue(&avail, &values[i]))
+		{
+			SSGNC_ERROR << "Invalid record: " << line << std::endl;
+			return false;
+		}
+	}
+
+	while (!avail.empty() && std::isspace(static_cast<UInt8>(avail[0])))
+		avail = avail.substr(1);
+	if (!avail.empty() || values[0] <= 0 || values[2] < 0 ||
+		values[3] < 0 || values[4] < 0)
+	{
+		SSGNC_ERROR << "Invalid record: " << line << std::endl;
+		return false;
+	}
+
+	record->set_num_tokens(static_cast<Int32>(values[0]));
+	record->set_token_id(static_cast<Int32>(values[1]));
+	record->set_file_id(static_cast<Int32>(values[2]));
+	record->set_offset(static_cast<UInt64>(values[3]));
+	record->set_length(static_cast<UInt64>(values[4]));
+	return true;
+}
+
+bool AccessLog::parseValue(String *avail, Int64 *value)
+{
+	while (!avail->empty() && std::isspace(static_cast<UInt8>((*avail)[0])))
+		*avail = avail->substr(1);
+
+	bool is_negative = false;
+	if (!avail->empty() && (*avail)[0] == '-')
+	{
+		is_negative = true;
+		*avail = avail->substr(1);
+	}
+
+	if (avail->empty() || !std::isdigit(static_cast<UInt8>((*avail)[0])))
+		return false;
+
+	*value = 0;
+	while (!avail->empty() && std::isdigit(static_cast<UInt8>((*avail)[0])))
+	{
+		if (*value > (0x7FFFFFFFFFFFFFFFLL - 9) / 10)
+			return false;
+		*value = (*value * 10) + ((*avail)[0] - '0');
+		*avail = avail->substr(1);
+	}
+
+	if (is_negative)
+		*value = -*value;
+	return true;
+}
+
+}  // namespace ssgnc
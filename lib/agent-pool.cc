@@ -0,0 +1,150 @@
+#include "ssgnc/agent-pool.h"
+#include "ssgnc/mutex-lock.h"
+
+namespace ssgnc {
+
+AgentPool::AgentPool() : is_open_(false), max_num_agents_(0),
+	free_agents_(), num_acquired_agents_(0), num_created_agents_(0),
+	mutex_()
+{
+	::pthread_mutex_init(&mutex_, NULL);
+}
+
+AgentPool::~AgentPool()
+{
+	if (is_open())
+		close();
+
+	::pthread_mutex_destroy(&mutex_);
+}
+
+// The free list is reserved here, so that release() never allocates.
+bool AgentPool::open(UInt32 max_num_agents)
+{
+	if (is_open())
+	{
+		SSGNC_ERROR << "Already opened" << std::endl;
+		return false;
+	}
+
+	try
+	{
+		free_agents_.reserve(max_num_agents);
+	}
+	catch (...)
+	{
+		SSGNC_ERROR << "std::vector<ssgnc::Agent *>::reserve() failed: "
+			<< max_num_agents << std::endl;
+		return false;
+	}
+
+	is_open_ = true;
+	max_num_agents_ = max_num_agents;
+	return true;
+}
+
+bool AgentPool::close()
+{
+	if (!is_open())
+	{
+		SSGNC_ERROR << "Not opened" << std::endl;
+		return false;
+	}
+
+	MutexLock lock(&mutex_);
+	if (num_acquired_agents_ != 0)
+	{
+		SSGNC_ERROR << "Acquired agents: " << num_acquired_agents_
+			<< std::endl;
+		return false;
+	}
+
+	for (std::size_t i = 0; i < free_agents_.size(); ++i)
+		delete free_agents_[i];
+	std::vector<Agent *>().swap(free_agents_);
+
+	is_open_ = false;
+	max_num_agents_ = 0;
+	num_created_agents_ = 0;
+	return true;
+}
+
+Agent *AgentPool::acquire()
+{
+	if (!is_open())
+	{
+		SSGNC_ERROR << "Not opened" << std::endl;
+		return NULL;
+	}
+
+	{
+		MutexLock lock(&mutex_);
+		++num_acquired_agents_;
+		if (!free_agents_.empty())
+		{
+			Agent *agent = free_agents_.back();
+			free_agents_.pop_back();
+			return agent;
+		}
+		++num_created_agents_;
+	}
+
+	// An agent is created without the lock.
+	Agent *agent;
+	try
+	{
+		agent = new Agent;
+	}
+	catch (...)
+	{
+		SSGNC_ERROR << "new ssgnc::Agent failed" << std::endl;
+		MutexLock lock(&mutex_);
+		--num_acquired_agents_;
+		--num_created_agents_;
+		return NULL;
+	}
+	return agent;
+}
+
+// An agent is closed and its settings are cleared before reuse. If the free
+// list is full, the agent is deleted.
+void AgentPool::release(Agent *agent)
+{
+	if (agent == NULL)
+		return;
+
+	if (agent->is_open())
+		agent->close();
+	agent->set_access_log(NULL);
+
+	{
+		MutexLock lock(&mutex_);
+		--num_acquired_agents_;
+		if (free_agents_.size() < max_num_agents_)
+		{
+			free_agents_.push_back(agent);
+			return;
+		}
+	}
+	delete agent;
+}
+
+UInt32 AgentPool::num_free_agents() const
+{
+	MutexLock lock(&mutex_);
+	return static_cast<UInt32>(free_agents_.size());
+}
+
+UInt32 AgentPool::num_acquired_agents() const
+{
+	MutexLock lock(&mutex_);
+	return num_acquired_agents_;
+}
+
+UInt64 AgentPool::num_created_agents() const
+{
+	MutexLock lock(&mutex_);
+	return num_created_agents_;
+}
+
+}  // namespace ssgnc
@@ -1,18 +1,71 @@
 #include "ssgnc/agent.h"
+#include "ssgnc/mutex-lock.h"
+
+#include <pthread.h>
+#include <sys/time.h>
 
 namespace ssgnc {
+namespace {
+
+// Returns the current time in microseconds.
+UInt64 getTime()
+{
+	struct timeval tv;
+	::gettimeofday(&tv, NULL);
+	return (static_cast<UInt64>(tv.tv_sec) * 1000000) + tv.tv_usec;
+}
+
+}  // namespace
 
-Agent::Agent() : is_open_(false), bad_(false), query_(),
-	ngram_readers_(), heap_queue_(), num_results_(0), total_(0) {}
+Agent::Agent() : is_open_(false), bad_(false), query_(), sources_(),
+	ngram_readers_(), heap_queue_(), num_results_(0), total_(0),
+	access_log_(NULL), result_cache_(NULL), cache_key_(), results_(),
+	is_recording_(false), free_readers_(), block_(), num_scanned_(0),
+	deadline_(0), next_check_(0), is_canceled_(false), is_expired_(false),
+	is_cancel_requested_(false), cancel_mutex_(), would_block_(false),
+	pending_read_(), search_key_(), search_sources_(), open_tasks_(),
+	open_workers_(), open_shard_map_(NULL), open_sources_(NULL),
+	open_generation_(0), num_pending_opens_(0), is_stopping_workers_(false),
+	open_mutex_(), open_cond_()
+{
+	::pthread_mutex_init(&cancel_mutex_, NULL);
+	::pthread_mutex_init(&open_mutex_, NULL);
+	::pthread_cond_init(&open_cond_, NULL);
+}
 
 Agent::~Agent()
 {
 	if (is_open())
 		close();
+
+	for (std::size_t i = 0; i < free_readers_.size(); ++i)
+		delete free_readers_[i];
+
+	stopWorkers();
+	::pthread_cond_destroy(&open_cond_);
+	::pthread_mutex_destroy(&open_mutex_);
+	::pthread_mutex_destroy(&cancel_mutex_);
 }
 
 bool Agent::open(const String &index_dir, const Query &query,
 	const std::vector<Source> &sources)
+{
+	return open(index_dir, NULL, query, sources);
+}
+
+bool Agent::open(const ShardMap &shard_map, const Query &query,
+	const std::vector<Source> &sources)
+{
+	if (!shard_map.is_open())
+	{
+		SSGNC_ERROR << "Not opened shard map" << std::endl;
+		return false;
+	}
+	return open(shard_map.index_dir(), &shard_map, query, sources);
+}
+
+bool Agent::open(const String &index_dir, const ShardMap *shard_map,
+	const Query &query, const std::vector<Source> &sources)
 {
 	if (is_open())
 	{
@@ -28,29 +81,60 @@ bool Agent::open(const String &index_dir, const Query &query,
 		close();
 		return false;
 	}
+	startClock();
 
-	ngram_readers_.resize(sources.size(), NULL);
-	for (std::size_t i = 0; i < sources.size(); ++i)
+	if (access_log_ != NULL)
 	{
 		try
 		{
-			ngram_readers_[i] = new NgramReader;
+			sources_ = sources;
 		}
 		catch (...)
 		{
-			SSGNC_ERROR << "new ssgnc::NgramReader failed" << std::endl;
+			SSGNC_ERROR << "std::vector<ssgnc::Agent::Source>::operator=() "
+				"failed: " << sources.size() << std::endl;
 			close();
 			return false;
 		}
+	}
 
-		if (!ngram_readers_[i]->open(index_dir, sources[i].num_tokens(),
-			sources[i].entry(), query.min_encoded_freq()))
+	ngram_readers_.resize(sources.size(), NULL);
+	for (std::size_t i = 0; i < sources.size(); ++i)
+	{
+		if (!newReader(&ngram_readers_[i]))
 		{
-			SSGNC_ERROR << "ssgnc::NgramReader::open() failed" << std::endl;
+			SSGNC_ERROR << "ssgnc::Agent::newReader() failed" << std::endl;
 			close();
 			return false;
 		}
+	}
 
+	if (shard_map != NULL && shard_map->num_shards() > 1)
+	{
+		if (!openShards(*shard_map, sources))
+		{
+			SSGNC_ERROR << "ssgnc::Agent::openShards() failed" << std::endl;
+			close();
+			return false;
+		}
+	}
+	else
+	{
+		for (std::size_t i = 0; i < sources.size(); ++i)
+		{
+			if (!ngram_readers_[i]->open(index_dir, sources[i].num_tokens(),
+				sources[i].entry(), query.min_encoded_freq()))
+			{
+				SSGNC_ERROR << "ssgnc::NgramReader::open() failed"
+					<< std::endl;
+				close();
+				return false;
+			}
+		}
+	}
+
+	for (std::size_t i = 0; i < sources.size(); ++i)
+	{
 		if (ngram_readers_[i]->good() && !heap_queue_.push(ngram_readers_[i]))
 		{
 			SSGNC_ERROR << "ssgnc::HeapQueue::push() failed" << std::endl;
@@ -59,9 +143,312 @@ bool Agent::open(const String &index_dir, const Query &query,
 		}
 	}
 
+	is_recording_ = (result_cache_ != NULL);
 	return true;
 }
 
+bool Agent::open(const ShardMap &shard_map, const Query &query,
+	const Cursor &cursor)
+{
+	if (is_open())
+	{
+		SSGNC_ERROR << "Already opened" << std::endl;
+		return false;
+	}
+	else if (cursor.checksum() != Cursor::checksum(query))
+	{
+		SSGNC_ERROR << "Wrong cursor: " << cursor.checksum() << std::endl;
+		return false;
+	}
+
+	is_open_ = true;
+
+	if (!query.clone(&query_))
+	{
+		SSGNC_ERROR << "ssgnc::Query::clone() failed" << std::endl;
+		close();
+		return false;
+	}
+	startClock();
+
+	ngram_readers_.resize(cursor.num_lists(), NULL);
+	for (UInt32 i = 0; i < cursor.num_lists(); ++i)
+	{
+		if (!newReader(&ngram_readers_[i]))
+		{
+			SSGNC_ERROR << "ssgnc::Agent::newReader() failed" << std::endl;
+			close();
+			return false;
+		}
+
+		const Cursor::List &list = cursor.list(i);
+		if (!ngram_readers_[i]->resume(shard_map, list.num_tokens(),
+			list.file_id(), list.offset(), list.encoded_freq(),
+			query.min_encoded_freq()))
+		{
+			SSGNC_ERROR << "ssgnc::NgramReader::resume() failed" << std::endl;
+			close();
+			return false;
+		}
+		else if (ngram_readers_[i]->good() &&
+			!heap_queue_.push(ngram_readers_[i]))
+		{
+			SSGNC_ERROR << "ssgnc::HeapQueue::push() failed" << std::endl;
+			close();
+			return false;
+		}
+	}
+
+	num_results_ = cursor.num_results();
+	total_ = cursor.total();
+	return true;
+}
+
+bool Agent::save(Cursor *cursor) const
+{
+	if (!is_open())
+	{
+		SSGNC_ERROR << "Not opened" << std::endl;
+		return false;
+	}
+	else if (cursor == NULL)
+	{
+		SSGNC_ERROR << "Null pointer" << std::endl;
+		return false;
+	}
+	else if (bad())
+	{
+		SSGNC_ERROR << "Bad agent" << std::endl;
+		return false;
+	}
+	else if (num_results_ < results_.size())
+	{
+		SSGNC_ERROR << "Unfinished cached results: " << num_results_
+			<< " / " << results_.size() << std::endl;
+		return false;
+	}
+
+	cursor->clear();
+	cursor->set_checksum(Cursor::checksum(query_));
+	cursor->set_num_results(num_results_);
+	cursor->set_total(total_);
+
+	// The finished lists have been removed from the heap queue or have a
+	// frequency less than the minimum.
+	for (std::size_t i = 0; i < ngram_readers_.size(); ++i)
+	{
+		const NgramReader *ngram_reader = ngram_readers_[i];
+		if (ngram_reader == NULL || (!ngram_reader->good() &&
+			(ngram_reader != block_.ngram_reader() || !block_.is_pending())))
+			continue;
+
+		Cursor::List list;
+		list.set_num_tokens(ngram_reader->num_tokens());
+		list.set_file_id(ngram_reader->file_id());
+		list.set_offset(ngram_reader->offset());
+		list.set_encoded_freq(ngram_reader->encoded_freq());
+		if (ngram_reader == block_.ngram_reader() && block_.is_pending())
+		{
+			// The list has n-grams which are read but not consumed.
+			list.set_file_id(block_.file_id(block_.pos()));
+			list.set_offset(block_.offset(block_.pos()));
+			list.set_encoded_freq(block_.encoded_freq(block_.pos()));
+		}
+		if (!cursor->appendList(list))
+		{
+			SSGNC_ERROR << "ssgnc::Cursor::appendList() failed" << std::endl;
+			cursor->clear();
+			return false;
+		}
+	}
+	return true;
+}
+
+bool Agent::set_result_cache(ResultCache *result_cache,
+	const ResultCache::Key &key)
+{
+	if (is_open())
+	{
+		SSGNC_ERROR << "Already opened" << std::endl;
+		return false;
+	}
+
+	try
+	{
+		cache_key_ = key;
+	}
+	catch (...)
+	{
+		SSGNC_ERROR << "std::vector<ssgnc::Int32>::operator=() failed: "
+			<< key.size() << std::endl;
+		return false;
+	}
+	result_cache_ = result_cache;
+	return true;
+}
+
+// The tasks and the workers are kept across searches, so that a search of a
+// sharded index neither creates threads nor allocates memory. Shards which
+// have no worker, because a thread could not be started, are opened by the
+// calling thread.
+bool Agent::openShards(const ShardMap &shard_map,
+	const std::vector<Source> &sources)
+{
+	std::size_t num_shards = static_cast<std::size_t>(shard_map.num_shards());
+	if (open_tasks_.size() != num_shards)
+	{
+		stopWorkers();
+		if (!startWorkers(shard_map.num_shards()))
+		{
+			SSGNC_ERROR << "ssgnc::Agent::startWorkers() failed: "
+				<< num_shards << std::endl;
+			return false;
+		}
+	}
+
+	for (std::size_t i = 0; i < num_shards; ++i)
+	{
+		open_tasks_[i].has_lists = false;
+		open_tasks_[i].is_ok = true;
+	}
+	for (std::size_t i = 0; i < sources.size(); ++i)
+	{
+		open_tasks_[shard_map.find(sources[i].num_tokens(),
+			sources[i].entry().file_id())].has_lists = true;
+	}
+
+	{
+		MutexLock lock(&open_mutex_);
+		open_shard_map_ = &shard_map;
+		open_sources_ = &sources;
+		++open_generation_;
+		num_pending_opens_ = open_workers_.size();
+		::pthread_cond_broadcast(&open_cond_);
+	}
+
+	openShard(&open_tasks_[0]);
+	for (std::size_t i = open_workers_.size() + 1; i < num_shards; ++i)
+		openShard(&open_tasks_[i]);
+
+	{
+		MutexLock lock(&open_mutex_);
+		while (num_pending_opens_ != 0)
+			::pthread_cond_wait(&open_cond_, &open_mutex_);
+		open_shard_map_ = NULL;
+		open_sources_ = NULL;
+	}
+
+	bool is_ok = true;
+	for (std::size_t i = 0; i < num_shards; ++i)
+	{
+		if (!open_tasks_[i].is_ok)
+			is_ok = false;
+	}
+	return is_ok;
+}
+
+void Agent::openShard(OpenTask *task)
+{
+	if (!task->has_lists)
+		return;
+
+	for (std::size_t i = 0; i < open_sources_->size(); ++i)
+	{
+		const Source &source = (*open_sources_)[i];
+		if (open_shard_map_->find(source.num_tokens(),
+			source.entry().file_id()) != task->shard_id)
+			continue;
+
+		if (!ngram_readers_[i]->open(*open_shard_map_, source.num_tokens(),
+			source.entry(), query_.min_encoded_freq()))
+		{
+			SSGNC_ERROR << "ssgnc::NgramReader::open() failed" << std::endl;
+			task->is_ok = false;
+			break;
+		}
+	}
+}
+
+bool Agent::startWorkers(Int32 num_shards)
+{
+	try
+	{
+		open_tasks_.resize(num_shards);
+		open_workers_.reserve(num_shards - 1);
+	}
+	catch (...)
+	{
+		SSGNC_ERROR << "std::vector<ssgnc::Agent::OpenTask>::resize() failed: "
+			<< num_shards << std::endl;
+		open_tasks_.clear();
+		return false;
+	}
+
+	for (Int32 i = 0; i < num_shards; ++i)
+	{
+		open_tasks_[i].agent = this;
+		open_tasks_[i].shard_id = i;
+		open_tasks_[i].generation = open_generation_;
+		open_tasks_[i].has_lists = false;
+		open_tasks_[i].is_ok = true;
+	}
+
+	for (Int32 i = 1; i < num_shards; ++i)
+	{
+		pthread_t worker;
+		if (::pthread_create(&worker, NULL, runWorker, &open_tasks_[i]) != 0)
+		{
+			SSGNC_ERROR << "::pthread_create() failed: " << i << std::endl;
+			break;
+		}
+		open_workers_.push_back(worker);
+	}
+	return true;
+}
+
+void Agent::stopWorkers()
+{
+	if (!open_workers_.empty())
+	{
+		{
+			MutexLock lock(&open_mutex_);
+			is_stopping_workers_ = true;
+			::pthread_cond_broadcast(&open_cond_);
+		}
+
+		for (std::size_t i = 0; i < open_workers_.size(); ++i)
+			::pthread_join(open_workers_[i], NULL);
+		open_workers_.clear();
+		is_stopping_workers_ = false;
+	}
+	open_tasks_.clear();
+}
+
+void *Agent::runWorker(void *arg)
+{
+	OpenTask *task = static_cast<OpenTask *>(arg);
+	Agent *agent = task->agent;
+
+	MutexLock lock(&agent->open_mutex_);
+	for ( ; ; )
+	{
+		while (task->generation == agent->open_generation_ &&
+			!agent->is_stopping_workers_)
+			::pthread_cond_wait(&agent->open_cond_, &agent->open_mutex_);
+		if (agent->is_stopping_workers_)
+			break;
+		task->generation = agent->open_generation_;
+
+		::pthread_mutex_unlock(&agent->open_mutex_);
+		agent->openShard(task);
+		::pthread_mutex_lock(&agent->open_mutex_);
+
+		if (--agent->num_pending_opens_ == 0)
+			::pthread_cond_broadcast(&agent->open_cond_);
+	}
+	return NULL;
+}
+
 bool Agent::close()
 {
 	if (!is_open())
@@ -70,155 +457,481 @@ bool Agent::close()
 		return false;
 	}
 
+	if (access_log_ != NULL)
+		writeAccessLog();
+
+	// The lists which are not finished are moved to a suspended agent,
+	// which is kept in the cache.
+	if (is_recording_ && !bad_)
+		cacheResults();
+
+	// The readers are closed and kept for the next search.
 	for (std::size_t i = 0; i < ngram_readers_.size(); ++i)
-		delete ngram_readers_[i];
+	{
+		NgramReader *ngram_reader = ngram_readers_[i];
+		if (ngram_reader == NULL)
+			continue;
+		else if (ngram_reader->is_open())
+			ngram_reader->close();
+
+		try
+		{
+			free_readers_.push_back(ngram_reader);
+		}
+		catch (...)
+		{
+			delete ngram_reader;
+		}
+	}
 
 	is_open_ = false;
 	bad_ = false;
 	query_.clear();
+	sources_.clear();
 	ngram_readers_.clear();
 	heap_queue_.clear();
+	block_.clear();
 	num_results_ = 0;
 	total_ = 0;
+	result_cache_ = NULL;
+	cache_key_.clear();
+	results_.clear();
+	is_recording_ = false;
+	num_scanned_ = 0;
+	deadline_ = 0;
+	next_check_ = 0;
+	is_canceled_ = false;
+	is_expired_ = false;
+	would_block_ = false;
+	pending_read_.clear();
 
+	MutexLock lock(&cancel_mutex_);
+	is_cancel_requested_ = false;
 	return true;
 }
 
+void Agent::cancel()
+{
+	MutexLock lock(&cancel_mutex_);
+	is_cancel_requested_ = true;
+}
+
+const char *Agent::stopReasonName(StopReason stop_reason)
+{
+	switch (stop_reason)
+	{
+	case NOT_STOPPED:
+		return "not-stopped";
+	case CANCELED:
+		return "canceled";
+	case TIME_LIMIT:
+		return "time-limit";
+	case MAX_NUM_RESULTS:
+		return "max-num-results";
+	case END_OF_LISTS:
+		return "end-of-lists";
+	case IO_LIMIT:
+		return "io-limit";
+	case SCAN_LIMIT:
+		return "scan-limit";
+	default:
+		return "unknown";
+	}
+}
+
 bool Agent::read(Int16 *encoded_freq, std::vector<Int32> *tokens)
 {
-	while (good())
+	return read(encoded_freq, tokens, false);
+}
+
+bool Agent::readBatch(ResultBatch *batch, UInt32 max_num_results)
+{
+	return readBatch(batch, max_num_results, false);
+}
+
+bool Agent::tryRead(Int16 *encoded_freq, std::vector<Int32> *tokens)
+{
+	return read(encoded_freq, tokens, true);
+}
+
+bool Agent::tryReadBatch(ResultBatch *batch, UInt32 max_num_results)
+{
+	return readBatch(batch, max_num_results, true);
+}
+
+bool Agent::read(Int16 *encoded_freq, std::vector<Int32> *tokens,
+	bool is_nonblocking)
+{
+	would_block_ = false;
+	if (good() && num_results_ < results_.size())
 	{
-		NgramReader *ngram_reader;
-		if (!heap_queue_.top(&ngram_reader))
+		if (!results_.get(num_results_, encoded_freq, tokens))
 		{
-			SSGNC_ERROR << "ssgnc::HeapQueue<ssgnc::NgramReader *>::top() "
-				"failed" << std::endl;
+			SSGNC_ERROR << "ssgnc::ResultCache::Results::get() failed"
+				<< std::endl;
+			bad_ = true;
 			return false;
 		}
+		++num_results_;
+		return true;
+	}
 
-		total_ -= ngram_reader->tell();
-		bool is_ok = ngram_reader->read(encoded_freq, tokens);
-		total_ += ngram_reader->tell();
+	UInt32 index;
+	if (!readNext(&index, is_nonblocking))
+		return false;
 
-		if (is_ok)
+	Int32 num_tokens = block_.num_tokens();
+	try
+	{
+		tokens->resize(num_tokens);
+	}
+	catch (...)
+	{
+		SSGNC_ERROR << "std::vector<ssgnc::Int32>::resize() failed: "
+			<< num_tokens << std::endl;
+		bad_ = true;
+		return false;
+	}
+
+	*encoded_freq = block_.encoded_freq(index);
+	block_.copyTokens(index, &(*tokens)[0]);
+	if (is_recording_ &&
+		!recordResult(*encoded_freq, &(*tokens)[0], num_tokens))
+		is_recording_ = false;
+	++num_results_;
+	return true;
+}
+
+bool Agent::readBatch(ResultBatch *batch, UInt32 max_num_results,
+	bool is_nonblocking)
+{
+	if (batch == NULL)
+	{
+		SSGNC_ERROR << "Null pointer" << std::endl;
+		return false;
+	}
+
+	would_block_ = false;
+	batch->clear();
+	while (batch->size() < max_num_results && good())
+	{
+		Int16 encoded_freq;
+		if (num_results_ < results_.size())
 		{
-			heap_queue_.popPush(ngram_reader);
-			if (filter(*tokens))
+			const Int32 *cached_tokens;
+			Int32 num_tokens;
+			if (!results_.get(num_results_, &encoded_freq, &cached_tokens,
+				&num_tokens) ||
+				!batch->append(encoded_freq, cached_tokens, num_tokens))
 			{
-				++num_results_;
-				return true;
+				SSGNC_ERROR << "ssgnc::ResultBatch::append() failed"
+					<< std::endl;
+				bad_ = true;
+				return false;
 			}
+			++num_results_;
+			continue;
+		}
+
+		UInt32 index;
+		if (!readNext(&index, is_nonblocking))
+			break;
+
+		Int32 num_tokens = block_.num_tokens();
+		Int32 *tokens;
+		if (!batch->reserve(num_tokens, &tokens))
+		{
+			SSGNC_ERROR << "ssgnc::ResultBatch::reserve() failed" << std::endl;
+			bad_ = true;
+			return false;
 		}
-		else if (ngram_reader->bad())
+
+		encoded_freq = block_.encoded_freq(index);
+		block_.copyTokens(index, tokens);
+		if (!batch->commit(encoded_freq, num_tokens))
 		{
-			SSGNC_ERROR << "ssgnc::NgramReader::read() failed" << std::endl;
+			batch->rollback(num_tokens);
+			SSGNC_ERROR << "ssgnc::ResultBatch::commit() failed" << std::endl;
 			bad_ = true;
 			return false;
 		}
-		else
-			heap_queue_.pop();
+		if (is_recording_ && !recordResult(encoded_freq, tokens, num_tokens))
+			is_recording_ = false;
+		++num_results_;
 	}
 
-	return false;
+	return !batch->empty();
 }
 
-bool Agent::filter(const std::vector<Int32> &tokens) const
+bool Agent::readNext(UInt32 *index, bool is_nonblocking)
 {
-	switch (query_.order())
+	while (good())
 	{
-	case Query::UNORDERED:
-		return filterUnordered(tokens);
-	case Query::ORDERED:
-		return filterOrdered(tokens);
-	case Query::PHRASE:
-		return filterPhrase(tokens);
-	case Query::FIXED:
-		return filterFixed(tokens);
-	default:
-		SSGNC_ERROR << "Undefined token order: " << std::endl;
-		return false;
+		if (block_.is_pending())
+		{
+			// The limit of I/O is tested for each n-gram as if the n-grams
+			// were read one by one.
+			UInt32 pos = block_.pos();
+			block_.skip();
+			total_ += block_.length(pos);
+			++num_scanned_;
+			if (block_.match(pos))
+			{
+				*index = pos;
+				return true;
+			}
+			continue;
+		}
+
+		NgramReader *ngram_reader = block_.ngram_reader();
+		if (ngram_reader != NULL)
+		{
+			// The list of a consumed block goes back to the heap queue.
+			block_.clear();
+			if (ngram_reader->good())
+				heap_queue_.popPush(ngram_reader);
+			else if (ngram_reader->bad())
+			{
+				SSGNC_ERROR << "ssgnc::NgramReader::read() failed"
+					<< std::endl;
+				bad_ = true;
+				return false;
+			}
+			else
+				heap_queue_.pop();
+			continue;
+		}
+
+		if (!fillBlock(is_nonblocking))
+		{
+			SSGNC_ERROR << "ssgnc::Agent::fillBlock() failed" << std::endl;
+			bad_ = true;
+			return false;
+		}
+		else if (would_block_)
+			return false;
 	}
+	return false;
 }
 
-bool Agent::filterUnordered(const std::vector<Int32> &tokens) const
+bool Agent::fillBlock(bool is_nonblocking)
 {
-	UInt32 mask = 0;
-	for (Int32 i = 0; i < query_.num_tokens(); ++i)
+	if (num_scanned_ >= next_check_)
 	{
-		Int32 token = query_.token(i);
-		if (token == Query::META_TOKEN)
-			continue;
+		checkBudgets();
+		if (is_canceled_ || is_expired_)
+			return true;
+	}
 
-		std::size_t j;
-		for (j = 0; j < tokens.size(); ++j)
-		{
-			if ((mask & (1U << j)) != 0)
-				continue;
+	NgramReader *ngram_reader = NULL;
+	if (!heap_queue_.top(&ngram_reader))
+	{
+		SSGNC_ERROR << "ssgnc::HeapQueue<ssgnc::NgramReader *>::top() "
+			"failed" << std::endl;
+		return false;
+	}
+	else if (!block_.reset(ngram_reader))
+	{
+		SSGNC_ERROR << "ssgnc::NgramBlock::reset() failed" << std::endl;
+		return false;
+	}
 
-			if (token == tokens[j])
+	// The top list gives n-grams until popPush() would move another list to
+	// the top, so the order of results is the same as reading n-grams one
+	// by one.
+	NgramReader *second_reader = NULL;
+	bool has_second = heap_queue_.second(&second_reader);
+	FreqComparer comparer;
+	while (!block_.full() && ngram_reader->good())
+	{
+		if (has_second && comparer(second_reader, ngram_reader))
+			break;
+		else if (query_.io_limit() != 0 &&
+			total_ + block_.bytes() >= query_.io_limit())
+			break;
+		else if (query_.scan_limit() != 0 &&
+			num_scanned_ + block_.size() >= query_.scan_limit())
+			break;
+		else if (is_nonblocking && !ngram_reader->isReady(&pending_read_))
+		{
+			// A block which has n-grams is returned first.
+			if (block_.size() == 0)
 			{
-				mask |= 1U << j;
-				break;
+				block_.clear();
+				would_block_ = true;
+				return true;
 			}
+			break;
 		}
-		if (j >= tokens.size())
+
+		if (!block_.read())
+		{
+			SSGNC_ERROR << "ssgnc::NgramBlock::read() failed" << std::endl;
 			return false;
+		}
+	}
+
+	if (!block_.filter(query_))
+	{
+		SSGNC_ERROR << "ssgnc::NgramBlock::filter() failed" << std::endl;
+		return false;
 	}
 	return true;
 }
 
-bool Agent::filterOrdered(const std::vector<Int32> &tokens) const
+void Agent::startClock()
+{
+	deadline_ = (query_.time_limit() != 0) ?
+		(getTime() + query_.time_limit()) : 0;
+	next_check_ = 0;
+}
+
+void Agent::checkBudgets()
 {
-	for (Int32 i = 0, j = 0; i < query_.num_tokens(); ++i, ++j)
 	{
-		Int32 token = query_.token(i);
-		while (j < static_cast<Int32>(tokens.size()))
-		{
-			if (token == Query::META_TOKEN || token == tokens[j])
-				break;
-			++j;
-		}
-		if (j >= static_cast<Int32>(tokens.size()))
-			return false;
+		MutexLock lock(&cancel_mutex_);
+		is_canceled_ = is_cancel_requested_;
+	}
+
+	if (deadline_ != 0 && getTime() >= deadline_)
+		is_expired_ = true;
+
+	next_check_ = num_scanned_ + CHECK_INTERVAL;
+}
+
+bool Agent::openCached(ResultCache *result_cache,
+	const ResultCache::Key &key, const Query &query,
+	ResultCache::Results *results, UInt64 total, UInt64 num_scanned,
+	Agent *suspended)
+{
+	if (is_open())
+	{
+		SSGNC_ERROR << "Already opened" << std::endl;
+		delete suspended;
+		return false;
+	}
+
+	// A resumed search is cached again when the agent is closed.
+	if (suspended != NULL && !set_result_cache(result_cache, key))
+	{
+		SSGNC_ERROR << "ssgnc::Agent::set_result_cache() failed" << std::endl;
+		delete suspended;
+		return false;
+	}
+
+	is_open_ = true;
+
+	if (!query.clone(&query_))
+	{
+		SSGNC_ERROR << "ssgnc::Query::clone() failed" << std::endl;
+		delete suspended;
+		close();
+		return false;
+	}
+	startClock();
+
+	results_.swap(results);
+	total_ = total;
+	num_scanned_ = num_scanned;
+
+	if (suspended != NULL)
+	{
+		takeReaders(suspended);
+		delete suspended;
+		is_recording_ = true;
 	}
 	return true;
 }
 
-bool Agent::filterPhrase(const std::vector<Int32> &tokens) const
+void Agent::takeReaders(Agent *agent)
+{
+	sources_.swap(agent->sources_);
+	ngram_readers_.swap(agent->ngram_readers_);
+	heap_queue_.swap(&agent->heap_queue_);
+	block_.swap(&agent->block_);
+	total_ = agent->total_;
+	num_scanned_ = agent->num_scanned_;
+	is_open_ = true;
+}
+
+bool Agent::newReader(NgramReader **ngram_reader)
 {
-	Int32 max_i = static_cast<Int32>(tokens.size()) - query_.num_tokens();
-	for (Int32 i = 0; i <= max_i; ++i)
+	if (!free_readers_.empty())
 	{
-		Int32 j;
-		for (j = 0; j < query_.num_tokens(); ++j)
-		{
-			Int32 token = query_.token(j);
-			if (token == Query::META_TOKEN)
-				continue;
+		*ngram_reader = free_readers_.back();
+		free_readers_.pop_back();
+		return true;
+	}
 
-			if (token != tokens[i + j])
-				break;
-		}
-		if (j == query_.num_tokens())
-			return true;
+	try
+	{
+		*ngram_reader = new NgramReader;
 	}
-	return false;
+	catch (...)
+	{
+		SSGNC_ERROR << "new ssgnc::NgramReader failed" << std::endl;
+		return false;
+	}
+	return true;
 }
 
-bool Agent::filterFixed(const std::vector<Int32> &tokens) const
+bool Agent::recordResult(Int16 encoded_freq, const Int32 *tokens,
+	Int32 num_tokens)
 {
-	if (static_cast<Int32>(tokens.size()) != query_.num_tokens())
+	if (results_.size() != num_results_ ||
+		!results_.append(encoded_freq, tokens, num_tokens) ||
+		results_.bytes() > result_cache_->max_entry_bytes())
+	{
+		results_.clear();
 		return false;
-	for (Int32 i = 0; i < query_.num_tokens(); ++i)
+	}
+	return true;
+}
+
+void Agent::cacheResults()
+{
+	bool is_complete = heap_queue_.empty();
+
+	Agent *suspended = NULL;
+	if (!is_complete)
 	{
-		Int32 token = query_.token(i);
-		if (token == Query::META_TOKEN)
+		try
+		{
+			suspended = new Agent;
+			suspended->takeReaders(this);
+		}
+		catch (...)
+		{
+			SSGNC_ERROR << "new ssgnc::Agent failed" << std::endl;
+			suspended = NULL;
+		}
+	}
+
+	result_cache_->insert(cache_key_, &results_, is_complete, total_,
+		num_scanned_, suspended);
+}
+
+void Agent::writeAccessLog()
+{
+	for (std::size_t i = 0; i < ngram_readers_.size(); ++i)
+	{
+		if (i >= sources_.size() || ngram_readers_[i] == NULL ||
+			!ngram_readers_[i]->is_open() || ngram_readers_[i]->tell() == 0)
 			continue;
 
-		if (token != tokens[i])
-			return false;
+		const Source &source = sources_[i];
+		AccessLog::Record record;
+		record.set_num_tokens(source.num_tokens());
+		record.set_token_id(source.token_id());
+		record.set_file_id(source.entry().file_id());
+		record.set_offset(source.entry().offset());
+		record.set_length(ngram_readers_[i]->tell());
+		if (!access_log_->write(record))
+		{
+			SSGNC_ERROR << "ssgnc::AccessLog::write() failed" << std::endl;
+			return;
+		}
 	}
-	return true;
 }
 
 }  // namespace ssgnc
@@ -48,8 +48,9 @@ bool ByteReader::close()
 		return false;
 	}
 
+	// The buffer is kept for the next stream.
 	stream_ = NULL;
-	std::vector<Int8>().swap(buf_);
+	buf_.clear();
 	buf_size_ = 0;
 	pos_ = 0;
 	total_ = 0;
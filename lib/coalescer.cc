@@ -0,0 +1,375 @@
+#include "ssgnc/coalescer.h"
+#include "ssgnc/mutex-lock.h"
+
+#include <sys/time.h>
+
+namespace ssgnc {
+namespace {
+
+// Returns the current time in microseconds.
+UInt64 getTime()
+{
+	struct timeval tv;
+	::gettimeofday(&tv, NULL);
+	return (static_cast<UInt64>(tv.tv_sec) * 1000000) + tv.tv_usec;
+}
+
+}  // namespace
+
+Coalescer::Waiter::~Waiter()
+{
+	if (is_open())
+		close();
+}
+
+bool Coalescer::Waiter::close()
+{
+	if (!is_open())
+	{
+		SSGNC_ERROR << "Not opened" << std::endl;
+		return false;
+	}
+
+	coalescer_->leave(this);
+
+	coalescer_ = NULL;
+	flight_ = NULL;
+	max_num_results_ = 0;
+	num_results_ = 0;
+	bad_ = false;
+	eof_ = false;
+	return true;
+}
+
+bool Coalescer::Waiter::read(Int16 *encoded_freq, std::vector<Int32> *tokens)
+{
+	if (!is_open() || fail())
+		return false;
+
+	if (!coalescer_->read(this, encoded_freq, tokens))
+		return false;
+
+	++num_results_;
+	return true;
+}
+
+Coalescer::Coalescer() : database_(NULL), max_flight_bytes_(0),
+	max_flight_age_(0), flights_(), num_flights_(0), num_joins_(0),
+	mutex_(), cond_()
+{
+	::pthread_mutex_init(&mutex_, NULL);
+	::pthread_cond_init(&cond_, NULL);
+}
+
+Coalescer::~Coalescer()
+{
+	if (is_open())
+		close();
+
+	::pthread_cond_destroy(&cond_);
+	::pthread_mutex_destroy(&mutex_);
+}
+
+bool Coalescer::open(const Database &database, UInt64 max_flight_bytes,
+	UInt64 max_flight_age)
+{
+	if (is_open())
+	{
+		SSGNC_ERROR << "Already opened" << std::endl;
+		return false;
+	}
+	else if (!database.is_open())
+	{
+		SSGNC_ERROR << "Not opened database" << std::endl;
+		return false;
+	}
+
+	database_ = &database;
+	max_flight_bytes_ = max_flight_bytes;
+	max_flight_age_ = max_flight_age;
+	return true;
+}
+
+bool Coalescer::close()
+{
+	if (!is_open())
+	{
+		SSGNC_ERROR << "Not opened" << std::endl;
+		return false;
+	}
+
+	MutexLock lock(&mutex_);
+	if (!flights_.empty())
+	{
+		SSGNC_ERROR << "Flights in progress: "
+			<< flights_.size() << std::endl;
+		return false;
+	}
+
+	database_ = NULL;
+	max_flight_bytes_ = 0;
+	max_flight_age_ = 0;
+	num_flights_ = 0;
+	num_joins_ = 0;
+	return true;
+}
+
+bool Coalescer::search(const Query &query, Waiter *waiter)
+{
+	if (!is_open())
+	{
+		SSGNC_ERROR << "Not opened" << std::endl;
+		return false;
+	}
+	else if (waiter == NULL)
+	{
+		SSGNC_ERROR << "Null pointer" << std::endl;
+		return false;
+	}
+	else if (waiter->is_open())
+	{
+		SSGNC_ERROR << "Already opened waiter" << std::endl;
+		return false;
+	}
+
+	Key key;
+	if (!makeKey(query, &key))
+	{
+		SSGNC_ERROR << "ssgnc::Coalescer::makeKey() failed" << std::endl;
+		return false;
+	}
+
+	MutexLock lock(&mutex_);
+
+	// A flight which has buffered too much or for too long is detached from
+	// the map. Its waiters keep reading it, and the last of them deletes it.
+	FlightMap::iterator it = flights_.find(key);
+	if (it != flights_.end() && !isJoinable(*it->second))
+	{
+		flights_.erase(it);
+		it = flights_.end();
+	}
+
+	if (it != flights_.end())
+	{
+		Flight *flight = it->second;
+		++flight->num_waiters;
+		++num_joins_;
+
+		while (flight->is_opening)
+			::pthread_cond_wait(&cond_, &mutex_);
+
+		if (!flight->agent.is_open())
+		{
+			SSGNC_ERROR << "ssgnc::Database::search() failed" << std::endl;
+			if (--flight->num_waiters == 0)
+				delete flight;
+			return false;
+		}
+
+		waiter->coalescer_ = this;
+		waiter->flight_ = flight;
+		waiter->max_num_results_ = query.max_num_results();
+		return true;
+	}
+
+	// The agent of a flight is not limited by the number of results, because
+	// each waiter has its own limit. The agent reads only the results which
+	// are required by the waiters.
+	Query flight_query;
+	if (!query.clone(&flight_query) || !flight_query.set_max_num_results(0))
+	{
+		SSGNC_ERROR << "ssgnc::Query::clone() failed" << std::endl;
+		return false;
+	}
+
+	Flight *flight;
+	try
+	{
+		flight = new Flight;
+	}
+	catch (...)
+	{
+		SSGNC_ERROR << "new ssgnc::Coalescer::Flight failed" << std::endl;
+		return false;
+	}
+
+	try
+	{
+		flight->key.swap(key);
+		flights_.insert(std::make_pair(flight->key, flight));
+	}
+	catch (...)
+	{
+		SSGNC_ERROR << "std::map<ssgnc::Coalescer::Key, "
+			"ssgnc::Coalescer::Flight *>::insert() failed: "
+			<< flights_.size() << std::endl;
+		delete flight;
+		return false;
+	}
+	flight->num_waiters = 1;
+	flight->start_time = getTime();
+	flight->is_opening = true;
+	++num_flights_;
+
+	// Lists are opened without the lock. The searches of the same query wait
+	// for the lists instead of opening them again.
+	::pthread_mutex_unlock(&mutex_);
+	bool is_ok = database_->search(flight_query, &flight->agent);
+	::pthread_mutex_lock(&mutex_);
+	flight->is_opening = false;
+	::pthread_cond_broadcast(&cond_);
+
+	if (!is_ok)
+	{
+		SSGNC_ERROR << "ssgnc::Database::search() failed" << std::endl;
+
+		// The flight may have been detached while it was opening, and then
+		// the key may belong to a newer flight.
+		it = flights_.find(flight->key);
+		if (it != flights_.end() && it->second == flight)
+			flights_.erase(it);
+		if (--flight->num_waiters == 0)
+			delete flight;
+		return false;
+	}
+
+	waiter->coalescer_ = this;
+	waiter->flight_ = flight;
+	waiter->max_num_results_ = query.max_num_results();
+	return true;
+}
+
+UInt64 Coalescer::num_flights() const
+{
+	MutexLock lock(&mutex_);
+	return num_flights_;
+}
+
+UInt64 Coalescer::num_joins() const
+{
+	MutexLock lock(&mutex_);
+	return num_joins_;
+}
+
+bool Coalescer::makeKey(const Query &query, Key *key) const
+{
+	if (!is_open())
+	{
+		SSGNC_ERROR << "Not opened" << std::endl;
+		return false;
+	}
+	else if (!database_->makeKey(query, key))
+	{
+		SSGNC_ERROR << "ssgnc::Database::makeKey() failed" << std::endl;
+		return false;
+	}
+
+	try
+	{
+		key->push_back(static_cast<Int32>(query.io_limit() >> 32));
+		key->push_back(static_cast<Int32>(query.io_limit()));
+		key->push_back(static_cast<Int32>(query.time_limit() >> 32));
+		key->push_back(static_cast<Int32>(query.time_limit()));
+		key->push_back(static_cast<Int32>(query.scan_limit() >> 32));
+		key->push_back(static_cast<Int32>(query.scan_limit()));
+	}
+	catch (...)
+	{
+		SSGNC_ERROR << "std::vector<ssgnc::Int32>::push_back() failed: "
+			<< key->size() << std::endl;
+		return false;
+	}
+	return true;
+}
+
+bool Coalescer::isJoinable(const Flight &flight) const
+{
+	if (max_flight_bytes_ != 0 && flight.results.bytes() > max_flight_bytes_)
+		return false;
+	else if (max_flight_age_ != 0 &&
+		getTime() - flight.start_time > max_flight_age_)
+		return false;
+	return true;
+}
+
+// A waiter reads the next result from the buffer. If the result is not in
+// the buffer yet, the waiter reads it from the agent without the lock, or
+// waits for the waiter which is reading the agent.
+bool Coalescer::read(Waiter *waiter, Int16 *encoded_freq,
+	std::vector<Int32> *tokens)
+{
+	Flight *flight = waiter->flight_;
+	UInt64 index = waiter->num_results_;
+
+	MutexLock lock(&mutex_);
+	for ( ; ; )
+	{
+		if (index < flight->results.size())
+		{
+			if (!flight->results.get(index, encoded_freq, tokens))
+			{
+				SSGNC_ERROR << "ssgnc::ResultCache::Results::get() failed"
+					<< std::endl;
+				waiter->bad_ = true;
+				return false;
+			}
+			return true;
+		}
+		else if (flight->is_finished)
+		{
+			waiter->bad_ = flight->bad;
+			waiter->eof_ = true;
+			return false;
+		}
+		else if (!flight->is_reading)
+			break;
+
+		::pthread_cond_wait(&cond_, &mutex_);
+	}
+
+	flight->is_reading = true;
+	::pthread_mutex_unlock(&mutex_);
+	bool is_ok = flight->agent.read(encoded_freq, tokens);
+	::pthread_mutex_lock(&mutex_);
+	flight->is_reading = false;
+	::pthread_cond_broadcast(&cond_);
+
+	if (!is_ok)
+	{
+		flight->is_finished = true;
+		flight->bad = flight->agent.bad();
+		waiter->bad_ = flight->bad;
+		waiter->eof_ = true;
+		return false;
+	}
+	else if (!flight->results.append(*encoded_freq, *tokens))
+	{
+		SSGNC_ERROR << "ssgnc::ResultCache::Results::append() failed"
+			<< std::endl;
+		flight->is_finished = true;
+		flight->bad = true;
+		waiter->bad_ = true;
+		return false;
+	}
+	return true;
+}
+
+void Coalescer::leave(Waiter *waiter)
+{
+	Flight *flight = waiter->flight_;
+	{
+		MutexLock lock(&mutex_);
+		if (--flight->num_waiters > 0)
+			return;
+
+		FlightMap::iterator it = flights_.find(flight->key);
+		if (it != flights_.end() && it->second == flight)
+			flights_.erase(it);
+	}
+
+	// The agent is closed without the lock.
+	delete flight;
+}
+
+}  // namespace ssgnc
@@ -1,12 +1,16 @@
 #include "ssgnc/common.h"
 
 #include <ctime>
+#include <string>
+
+#include <pthread.h>
 
 namespace ssgnc {
 namespace {
 
 // This streambuf works like /dev/null.
-// Error logging can be disabled by using this streambuf.
+// It discards messages of a thread which has no stream while logging is
+// disabled.
 class NullStreambuf : public std::streambuf
 {
 public:
@@ -23,14 +27,93 @@ private:
 
 // In default, messages are written to the standard error through std::clog
 // which is a buffered output stream. This means that the stream should be
-// flushed by std::endl or std::flush.
-std::ostream *error_stream_ = &std::clog;
+// flushed by std::endl or std::flush. A NULL pointer disables logging.
+std::ostream * volatile error_stream_ = &std::clog;
+pthread_mutex_t error_stream_mutex_ = PTHREAD_MUTEX_INITIALIZER;
 
-}  // namespace
+volatile int log_level_ = LOG_ERROR;
 
-std::ostream *error_stream()
+class Message
+{
+public:
+	Message() : text_(), next_(NULL) {}
+	~Message() {}
+
+	std::string *text() { return &text_; }
+	Message *next() const { return next_; }
+	void set_next(Message *next) { next_ = next; }
+
+private:
+	std::string text_;
+	Message *next_;
+
+	// Disallows copies.
+	Message(const Message &);
+	Message &operator=(const Message &);
+};
+
+// Flushed messages are pushed onto a lock-free stack. A thread which gets
+// the lock of the error stream writes all the pending messages, so the other
+// threads go back to work without waiting for the lock.
+Message * volatile pending_messages_ = NULL;
+
+void pushMessage(Message *message)
+{
+	Message *head;
+	do
+	{
+		head = pending_messages_;
+		message->set_next(head);
+	} while (!__sync_bool_compare_and_swap(&pending_messages_, head, message));
+}
+
+// This function must be called under the lock of the error stream.
+void writePendingMessages()
+{
+	Message *head = __sync_lock_test_and_set(&pending_messages_,
+		static_cast<Message *>(NULL));
+
+	// The stack is reversed to write the messages in order.
+	Message *messages = NULL;
+	while (head != NULL)
+	{
+		Message *next = head->next();
+		head->set_next(messages);
+		messages = head;
+		head = next;
+	}
+
+	std::ostream *stream = error_stream_;
+	while (messages != NULL)
+	{
+		if (stream != NULL)
+		{
+			stream->write(messages->text()->data(),
+				static_cast<std::streamsize>(messages->text()->length()));
+		}
+		Message *next = messages->next();
+		delete messages;
+		messages = next;
+	}
+	if (stream != NULL)
+		stream->flush();
+}
+
+// A thread which fails to get the lock leaves its message to the thread
+// holding the lock, which checks the stack again after the unlock.
+void writeMessages()
+{
+	while (pending_messages_ != NULL &&
+		::pthread_mutex_trylock(&error_stream_mutex_) == 0)
+	{
+		writePendingMessages();
+		::pthread_mutex_unlock(&error_stream_mutex_);
+		__sync_synchronize();
+	}
+}
+
+void formatTime(std::time_t epoch_time, Int8 *time_buf, std::size_t size)
 {
-	std::time_t epoch_time = std::time(NULL);
 	struct tm current_time;
 
 // The thread-safe versions are used instead of ::localtime().
@@ -40,22 +123,197 @@ std::ostream *error_stream()
 	::localtime_r(&epoch_time, &current_time);
 #endif  // _MSC_VER
 
-	Int8 time_buf[32];
-	std::strftime(time_buf, sizeof(time_buf),
-		"%Y-%m-%d %H-%M-%S: ", &current_time);
-	*error_stream_ << time_buf;
-	return error_stream_;
+	std::strftime(time_buf, size, "%Y-%m-%d %H-%M-%S: ", &current_time);
 }
 
-void set_error_stream(std::ostream *stream)
+// A message is built in a buffer of its thread and passed to the error
+// stream at once when it is flushed, so that messages of threads are not
+// mixed up.
+class MessageStreambuf : public std::streambuf
 {
+public:
+	MessageStreambuf() : std::streambuf(), message_() {}
+	~MessageStreambuf() {}
+
+	int_type overflow(int_type c)
+	{
+		if (!traits_type::eq_int_type(c, traits_type::eof()))
+			message_ += traits_type::to_char_type(c);
+		return traits_type::not_eof(c);
+	}
+
+	std::streamsize xsputn(const char *s, std::streamsize n)
+	{
+		message_.append(s, static_cast<std::size_t>(n));
+		return n;
+	}
+
+	int sync()
+	{
+		if (message_.empty())
+			return 0;
+
+		Message *message = NULL;
+		try
+		{
+			message = new Message;
+		}
+		catch (...)
+		{
+		}
+
+		// If a message cannot be pushed, it is written under the lock.
+		if (message == NULL)
+		{
+			::pthread_mutex_lock(&error_stream_mutex_);
+			writePendingMessages();
+			std::ostream *stream = error_stream_;
+			if (stream != NULL)
+			{
+				stream->write(message_.data(),
+					static_cast<std::streamsize>(message_.length()));
+				stream->flush();
+			}
+			::pthread_mutex_unlock(&error_stream_mutex_);
+			message_.clear();
+			return 0;
+		}
+
+		message->text()->swap(message_);
+		pushMessage(message);
+		writeMessages();
+		return 0;
+	}
+
+private:
+	std::string message_;
+
+	// Disallows copies.
+	MessageStreambuf(const MessageStreambuf &);
+	MessageStreambuf &operator=(const MessageStreambuf &);
+};
+
+// The time string of a thread is formatted again only when the time has
+// changed.
+class MessageStream : public std::ostream
+{
+public:
+	MessageStream() : std::ostream(NULL), streambuf_(), epoch_time_(-1)
+	{
+		rdbuf(&streambuf_);
+		time_buf_[0] = '\0';
+	}
+	~MessageStream() { streambuf_.pubsync(); }
+
+	const Int8 *time_string()
+	{
+		std::time_t epoch_time = std::time(NULL);
+		if (epoch_time != epoch_time_)
+		{
+			formatTime(epoch_time, time_buf_, sizeof(time_buf_));
+			epoch_time_ = epoch_time;
+		}
+		return time_buf_;
+	}
+
+private:
+	MessageStreambuf streambuf_;
+	std::time_t epoch_time_;
+	Int8 time_buf_[32];
+
+	// Disallows copies.
+	MessageStream(const MessageStream &);
+	MessageStream &operator=(const MessageStream &);
+};
+
+pthread_key_t message_stream_key_;
+pthread_once_t message_stream_once_ = PTHREAD_ONCE_INIT;
+
+void deleteMessageStream(void *stream)
+{
+	delete static_cast<MessageStream *>(stream);
+}
+
+void createMessageStreamKey()
+{
+	::pthread_key_create(&message_stream_key_, deleteMessageStream);
+}
+
+// If a stream cannot be created for a thread, NULL is returned.
+MessageStream *message_stream()
+{
+	::pthread_once(&message_stream_once_, createMessageStreamKey);
+
+	MessageStream *stream = static_cast<MessageStream *>(
+		::pthread_getspecific(message_stream_key_));
 	if (stream == NULL)
 	{
-		static NullStreambuf null_streambuf;
-		static std::ostream null_stream(&null_streambuf);
-		stream = &null_stream;
+		try
+		{
+			stream = new MessageStream;
+		}
+		catch (...)
+		{
+			return NULL;
+		}
+		::pthread_setspecific(message_stream_key_, stream);
+	}
+	return stream;
+}
+
+}  // namespace
+
+void set_log_level(LogLevel level)
+{
+	log_level_ = level;
+}
+
+LogLevel log_level()
+{
+	return static_cast<LogLevel>(log_level_);
+}
+
+bool is_logging_enabled(LogLevel level)
+{
+	return error_stream_ != NULL && level <= log_level_;
+}
+
+// If a stream cannot be created for a thread, its messages are written to
+// the error stream directly.
+std::ostream *error_stream()
+{
+	MessageStream *stream = message_stream();
+	if (stream != NULL)
+	{
+		*stream << stream->time_string();
+		return stream;
 	}
+
+	static NullStreambuf null_streambuf;
+	static std::ostream null_stream(&null_streambuf);
+	std::ostream *direct_stream = error_stream_;
+	if (direct_stream == NULL)
+		return &null_stream;
+
+	Int8 time_buf[32];
+	formatTime(std::time(NULL), time_buf, sizeof(time_buf));
+	*direct_stream << time_buf;
+	return direct_stream;
+}
+
+void set_error_stream(std::ostream *stream)
+{
+	::pthread_mutex_lock(&error_stream_mutex_);
+	writePendingMessages();
 	error_stream_ = stream;
+	::pthread_mutex_unlock(&error_stream_mutex_);
+}
+
+void flush_error_stream()
+{
+	::pthread_mutex_lock(&error_stream_mutex_);
+	writePendingMessages();
+	::pthread_mutex_unlock(&error_stream_mutex_);
 }
 
 }  // namespace ssgnc
@@ -0,0 +1,260 @@
+#include "ssgnc/coordinator.h"
+
+#include <unistd.h>
+
+namespace ssgnc {
+
+Coordinator::Worker::~Worker()
+{
+	if (is_open())
+		close();
+}
+
+bool Coordinator::Worker::open(const String &address)
+{
+	if (is_open())
+	{
+		SSGNC_ERROR << "Already opened" << std::endl;
+		return false;
+	}
+
+	int fd;
+	if (!Socket::connect(address, &fd))
+	{
+		SSGNC_ERROR << "ssgnc::Socket::connect() failed" << std::endl;
+		return false;
+	}
+
+	if (!streambuf_.open(fd))
+	{
+		SSGNC_ERROR << "ssgnc::FdStreambuf::open() failed" << std::endl;
+		::close(fd);
+		return false;
+	}
+
+	stream_.clear();
+	if (!reader_.open(&stream_) || !writer_.open(&stream_))
+	{
+		SSGNC_ERROR << "ssgnc::Reader::open() failed" << std::endl;
+		close();
+		return false;
+	}
+
+	return true;
+}
+
+bool Coordinator::Worker::close()
+{
+	if (!is_open())
+	{
+		SSGNC_ERROR << "Not opened" << std::endl;
+		return false;
+	}
+
+	if (reader_.is_open())
+		reader_.close();
+	if (writer_.is_open())
+		writer_.close();
+
+	// Results which are not read yet are discarded. The worker stops when it
+	// fails to write the rest.
+	streambuf_.close();
+
+	encoded_freq_ = Protocol::END_OF_RESULTS;
+	tokens_.clear();
+	total_ = 0;
+	return true;
+}
+
+bool Coordinator::Worker::send(const Query &query)
+{
+	if (!is_open())
+	{
+		SSGNC_ERROR << "Not opened" << std::endl;
+		return false;
+	}
+
+	if (!Protocol::writeQuery(&writer_, query))
+	{
+		SSGNC_ERROR << "ssgnc::Protocol::writeQuery() failed" << std::endl;
+		return false;
+	}
+	else if (!stream_.flush())
+	{
+		SSGNC_ERROR << "std::iostream::flush() failed" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+bool Coordinator::Worker::next()
+{
+	if (!is_open())
+	{
+		SSGNC_ERROR << "Not opened" << std::endl;
+		return false;
+	}
+
+	if (!Protocol::readResult(&reader_, &encoded_freq_, &tokens_, &total_))
+	{
+		encoded_freq_ = Protocol::ERROR_OF_RESULTS;
+		SSGNC_ERROR << "ssgnc::Protocol::readResult() failed" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+Coordinator::Coordinator() : is_open_(false), bad_(false), query_(),
+	workers_(), heap_queue_(), num_results_(0) {}
+
+Coordinator::~Coordinator()
+{
+	if (is_open())
+		close();
+}
+
+bool Coordinator::open(const std::vector<String> &addresses,
+	const Query &query)
+{
+	if (is_open())
+	{
+		SSGNC_ERROR << "Already opened" << std::endl;
+		return false;
+	}
+
+	is_open_ = true;
+
+	if (!query.clone(&query_))
+	{
+		SSGNC_ERROR << "ssgnc::Query::clone() failed" << std::endl;
+		close();
+		return false;
+	}
+
+	// The query is sent to all the workers before any result is read, so
+	// that the workers search their partitions in parallel.
+	workers_.resize(addresses.size(), NULL);
+	for (std::size_t i = 0; i < addresses.size(); ++i)
+	{
+		try
+		{
+			workers_[i] = new Worker;
+		}
+		catch (...)
+		{
+			SSGNC_ERROR << "new ssgnc::Coordinator::Worker failed"
+				<< std::endl;
+			close();
+			return false;
+		}
+
+		if (!workers_[i]->open(addresses[i]) ||
+			!workers_[i]->send(query_))
+		{
+			SSGNC_ERROR << "ssgnc::Coordinator::Worker::open() failed: "
+				<< addresses[i] << std::endl;
+			close();
+			return false;
+		}
+	}
+
+	for (std::size_t i = 0; i < workers_.size(); ++i)
+	{
+		if (!workers_[i]->next() || workers_[i]->bad())
+		{
+			SSGNC_ERROR << "ssgnc::Coordinator::Worker::next() failed: "
+				<< addresses[i] << std::endl;
+			close();
+			return false;
+		}
+
+		if (workers_[i]->good() && !heap_queue_.push(workers_[i]))
+		{
+			SSGNC_ERROR << "ssgnc::HeapQueue::push() failed" << std::endl;
+			close();
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool Coordinator::close()
+{
+	if (!is_open())
+	{
+		SSGNC_ERROR << "Not opened" << std::endl;
+		return false;
+	}
+
+	for (std::size_t i = 0; i < workers_.size(); ++i)
+		delete workers_[i];
+
+	is_open_ = false;
+	bad_ = false;
+	query_.clear();
+	workers_.clear();
+	heap_queue_.clear();
+	num_results_ = 0;
+
+	return true;
+}
+
+bool Coordinator::read(Int16 *encoded_freq, std::vector<Int32> *tokens)
+{
+	if (encoded_freq == NULL || tokens == NULL)
+	{
+		SSGNC_ERROR << "Null pointer" << std::endl;
+		return false;
+	}
+
+	if (!good())
+		return false;
+
+	Worker *worker;
+	if (!heap_queue_.top(&worker))
+	{
+		SSGNC_ERROR << "ssgnc::HeapQueue<ssgnc::Coordinator::Worker *>::"
+			"top() failed" << std::endl;
+		return false;
+	}
+
+	try
+	{
+		*tokens = worker->tokens();
+	}
+	catch (...)
+	{
+		SSGNC_ERROR << "std::vector<ssgnc::Int32>::operator=() failed: "
+			<< worker->num_tokens() << std::endl;
+		bad_ = true;
+		return false;
+	}
+	*encoded_freq = worker->encoded_freq();
+
+	if (!worker->next() || worker->bad())
+	{
+		SSGNC_ERROR << "ssgnc::Coordinator::Worker::next() failed"
+			<< std::endl;
+		bad_ = true;
+		return false;
+	}
+
+	if (worker->good())
+		heap_queue_.popPush(worker);
+	else
+		heap_queue_.pop();
+
+	++num_results_;
+	return true;
+}
+
+UInt64 Coordinator::tell() const
+{
+	UInt64 total = 0;
+	for (std::size_t i = 0; i < workers_.size(); ++i)
+		total += workers_[i]->tell();
+	return total;
+}
+
+}  // namespace ssgnc
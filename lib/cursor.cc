@@ -0,0 +1,377 @@
+#include "ssgnc/cursor.h"
+#include "ssgnc/file-path.h"
+
+namespace ssgnc {
+namespace {
+
+// Bytes are encoded with the URL-safe alphabet of base64 without padding.
+const char BASE64_CHARS[] =
+	"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+
+Int32 decodeBase64Char(Int8 c)
+{
+	if (c >= 'A' && c <= 'Z')
+		return c - 'A';
+	else if (c >= 'a' && c <= 'z')
+		return c - 'a' + 26;
+	else if (c >= '0' && c <= '9')
+		return c - '0' + 52;
+	else if (c == '-')
+		return 62;
+	else if (c == '_')
+		return 63;
+	return -1;
+}
+
+UInt32 hashValue(UInt32 hash, Int32 value)
+{
+	for (Int32 i = 0; i < 4; ++i)
+	{
+		hash ^= (static_cast<UInt32>(value) >> (i * 8)) & 0xFF;
+		hash *= 16777619U;
+	}
+	return hash;
+}
+
+UInt64 rotate(UInt64 value, Int32 bits)
+{
+	return (value << bits) | (value >> (64 - bits));
+}
+
+void sipRound(UInt64 *v0, UInt64 *v1, UInt64 *v2, UInt64 *v3)
+{
+	*v0 += *v1;
+	*v1 = rotate(*v1, 13);
+	*v1 ^= *v0;
+	*v0 = rotate(*v0, 32);
+	*v2 += *v3;
+	*v3 = rotate(*v3, 16);
+	*v3 ^= *v2;
+	*v0 += *v3;
+	*v3 = rotate(*v3, 21);
+	*v3 ^= *v0;
+	*v2 += *v1;
+	*v1 = rotate(*v1, 17);
+	*v1 ^= *v2;
+	*v2 = rotate(*v2, 32);
+}
+
+// SipHash-2-4 of bytes.
+UInt64 sipHash(UInt64 k0, UInt64 k1, const String &bytes)
+{
+	UInt64 v0 = k0 ^ 0x736F6D6570736575ULL;
+	UInt64 v1 = k1 ^ 0x646F72616E646F6DULL;
+	UInt64 v2 = k0 ^ 0x6C7967656E657261ULL;
+	UInt64 v3 = k1 ^ 0x7465646279746573ULL;
+
+	UInt32 length = bytes.length();
+	UInt32 end = length - (length % 8);
+	for (UInt32 i = 0; i < end; i += 8)
+	{
+		UInt64 m = 0;
+		for (Int32 j = 0; j < 8; ++j)
+		{
+			m |= static_cast<UInt64>(static_cast<UInt8>(bytes[i + j]))
+				<< (j * 8);
+		}
+		v3 ^= m;
+		sipRound(&v0, &v1, &v2, &v3);
+		sipRound(&v0, &v1, &v2, &v3);
+		v0 ^= m;
+	}
+
+	UInt64 m = static_cast<UInt64>(length & 0xFF) << 56;
+	for (UInt32 i = end; i < length; ++i)
+	{
+		m |= static_cast<UInt64>(static_cast<UInt8>(bytes[i]))
+			<< ((i - end) * 8);
+	}
+	v3 ^= m;
+	sipRound(&v0, &v1, &v2, &v3);
+	sipRound(&v0, &v1, &v2, &v3);
+	v0 ^= m;
+
+	v2 ^= 0xFF;
+	for (Int32 i = 0; i < 4; ++i)
+		sipRound(&v0, &v1, &v2, &v3);
+	return v0 ^ v1 ^ v2 ^ v3;
+}
+
+}  // namespace
+
+// A secret is hashed with two fixed keys, so that a secret of any length is
+// turned into a key of 128 bits.
+bool Cursor::Key::set(const String &secret)
+{
+	if (secret.length() < MIN_SECRET_LENGTH)
+	{
+		SSGNC_ERROR << "Too short secret: " << secret.length() << std::endl;
+		return false;
+	}
+
+	k0_ = sipHash(0, 0, secret);
+	k1_ = sipHash(0, 1, secret);
+	return true;
+}
+
+bool Cursor::Key::generate()
+{
+	UInt64 values[2];
+	std::ifstream file("/dev/urandom", std::ios::binary);
+	if (!file || !file.read(reinterpret_cast<char *>(values), sizeof(values)))
+	{
+		SSGNC_ERROR << "std::ifstream::read() failed: /dev/urandom"
+			<< std::endl;
+		return false;
+	}
+
+	k0_ = values[0];
+	k1_ = values[1];
+	return true;
+}
+
+void Cursor::clear()
+{
+	checksum_ = 0;
+	num_results_ = 0;
+	total_ = 0;
+	lists_.clear();
+}
+
+bool Cursor::appendList(const List &list)
+{
+	if (lists_.size() >= MAX_NUM_LISTS)
+	{
+		SSGNC_ERROR << "Too many lists: " << lists_.size() << std::endl;
+		return false;
+	}
+
+	try
+	{
+		lists_.push_back(list);
+	}
+	catch (...)
+	{
+		SSGNC_ERROR << "std::vector<ssgnc::Cursor::List>::push_back() "
+			"failed: " << lists_.size() << std::endl;
+		return false;
+	}
+	return true;
+}
+
+bool Cursor::encode(const Key &key, StringBuilder *str) const
+{
+	if (str == NULL)
+	{
+		SSGNC_ERROR << "Null pointer" << std::endl;
+		return false;
+	}
+
+	StringBuilder buf;
+	bool is_ok = encodeValue(FORMAT_VERSION, &buf) &&
+		encodeValue(checksum_, &buf) && encodeValue(num_results_, &buf) &&
+		encodeValue(total_, &buf) && encodeValue(lists_.size(), &buf);
+	for (std::size_t i = 0; is_ok && i < lists_.size(); ++i)
+	{
+		const List &list = lists_[i];
+		is_ok = encodeValue(list.num_tokens(), &buf) &&
+			encodeValue(list.file_id(), &buf) &&
+			encodeValue(list.offset(), &buf) &&
+			encodeValue(list.encoded_freq(), &buf);
+	}
+	if (!is_ok)
+	{
+		SSGNC_ERROR << "ssgnc::Cursor::encodeValue() failed" << std::endl;
+		return false;
+	}
+
+	// The MAC is appended to the values in little endian.
+	UInt64 value_mac = mac(key, buf.str());
+	for (Int32 i = 0; i < MAC_SIZE; ++i)
+	{
+		if (!buf.append(static_cast<Int8>((value_mac >> (i * 8)) & 0xFF)))
+		{
+			SSGNC_ERROR << "ssgnc::StringBuilder::append() failed"
+				<< std::endl;
+			return false;
+		}
+	}
+
+	str->clear();
+
+	UInt32 bits = 0;
+	Int32 num_bits = 0;
+	for (UInt32 i = 0; i < buf.length(); ++i)
+	{
+		bits = (bits << 8) | static_cast<UInt8>(buf[i]);
+		num_bits += 8;
+		while (num_bits >= 6)
+		{
+			num_bits -= 6;
+			if (!str->append(BASE64_CHARS[(bits >> num_bits) & 0x3F]))
+			{
+				SSGNC_ERROR << "ssgnc::StringBuilder::append() failed"
+					<< std::endl;
+				return false;
+			}
+		}
+	}
+	if (num_bits > 0 &&
+		!str->append(BASE64_CHARS[(bits << (6 - num_bits)) & 0x3F]))
+	{
+		SSGNC_ERROR << "ssgnc::StringBuilder::append() failed" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+bool Cursor::decode(const Key &key, const String &str)
+{
+	clear();
+
+	StringBuilder buf;
+	UInt32 bits = 0;
+	Int32 num_bits = 0;
+	for (UInt32 i = 0; i < str.length(); ++i)
+	{
+		Int32 value = decodeBase64Char(str[i]);
+		if (value < 0)
+		{
+			SSGNC_ERROR << "Invalid character: " << str << std::endl;
+			return false;
+		}
+
+		bits = (bits << 6) | static_cast<UInt32>(value);
+		num_bits += 6;
+		if (num_bits >= 8)
+		{
+			num_bits -= 8;
+			if (!buf.append(static_cast<Int8>((bits >> num_bits) & 0xFF)))
+			{
+				SSGNC_ERROR << "ssgnc::StringBuilder::append() failed"
+					<< std::endl;
+				return false;
+			}
+		}
+	}
+
+	// The padding bits must be 0, so that an encoded cursor is unique. The
+	// MAC is compared without an early exit.
+	if ((bits & ((1U << num_bits) - 1)) != 0 || buf.length() < MAC_SIZE)
+	{
+		SSGNC_ERROR << "Invalid cursor: " << str << std::endl;
+		return false;
+	}
+	String avail = buf.str().substr(0, buf.length() - MAC_SIZE);
+	UInt64 value_mac = mac(key, avail);
+	UInt64 diff = 0;
+	for (Int32 i = 0; i < MAC_SIZE; ++i)
+	{
+		diff |= ((value_mac >> (i * 8)) & 0xFF)
+			^ static_cast<UInt8>(buf[avail.length() + i]);
+	}
+	if (diff != 0)
+	{
+		SSGNC_ERROR << "Wrong MAC: " << str << std::endl;
+		return false;
+	}
+
+	UInt64 version, checksum, num_lists;
+	if (!decodeValue(&avail, &version) || version != FORMAT_VERSION ||
+		!decodeValue(&avail, &checksum) || checksum > 0xFFFFFFFFULL ||
+		!decodeValue(&avail, &num_results_) ||
+		!decodeValue(&avail, &total_) ||
+		!decodeValue(&avail, &num_lists) || num_lists > MAX_NUM_LISTS)
+	{
+		SSGNC_ERROR << "Invalid cursor: " << str << std::endl;
+		clear();
+		return false;
+	}
+	checksum_ = static_cast<UInt32>(checksum);
+
+	for (UInt64 i = 0; i < num_lists; ++i)
+	{
+		UInt64 num_tokens, file_id, offset, encoded_freq;
+		if (!decodeValue(&avail, &num_tokens) ||
+			num_tokens < 1 || num_tokens > Query::MAX_NUM_TOKENS ||
+			!decodeValue(&avail, &file_id) ||
+			file_id > FilePath::MAX_FILE_ID ||
+			!decodeValue(&avail, &offset) ||
+			!decodeValue(&avail, &encoded_freq) ||
+			encoded_freq < static_cast<UInt64>(Query::MIN_ENCODED_FREQ) ||
+			encoded_freq > static_cast<UInt64>(Query::MAX_ENCODED_FREQ))
+		{
+			SSGNC_ERROR << "Invalid cursor: " << str << std::endl;
+			clear();
+			return false;
+		}
+
+		List list;
+		list.set_num_tokens(static_cast<Int32>(num_tokens));
+		list.set_file_id(static_cast<Int32>(file_id));
+		list.set_offset(offset);
+		list.set_encoded_freq(static_cast<Int16>(encoded_freq));
+		if (!appendList(list))
+		{
+			SSGNC_ERROR << "ssgnc::Cursor::appendList() failed" << std::endl;
+			clear();
+			return false;
+		}
+	}
+
+	if (!avail.empty())
+	{
+		SSGNC_ERROR << "Invalid cursor: " << str << std::endl;
+		clear();
+		return false;
+	}
+	return true;
+}
+
+// FNV-1a is applied to the parameters which affect the order of results.
+UInt32 Cursor::checksum(const Query &query)
+{
+	UInt32 hash = 2166136261U;
+	hash = hashValue(hash, query.order());
+	hash = hashValue(hash, query.min_encoded_freq());
+	hash = hashValue(hash, query.min_num_tokens());
+	hash = hashValue(hash, query.max_num_tokens());
+	for (Int32 i = 0; i < query.num_tokens(); ++i)
+		hash = hashValue(hash, query.token(i));
+	return hash;
+}
+
+UInt64 Cursor::mac(const Key &key, const String &bytes)
+{
+	return sipHash(key.k0(), key.k1(), bytes);
+}
+
+bool Cursor::encodeValue(UInt64 value, StringBuilder *buf)
+{
+	while (value >= 0x80)
+	{
+		if (!buf->append(static_cast<Int8>((value & 0x7F) | 0x80)))
+			return false;
+		value >>= 7;
+	}
+	return buf->append(static_cast<Int8>(value));
+}
+
+bool Cursor::decodeValue(String *avail, UInt64 *value)
+{
+	*value = 0;
+	for (Int32 shift = 0; shift < 64; shift += 7)
+	{
+		if (avail->empty())
+			return false;
+
+		UInt8 byte = static_cast<UInt8>((*avail)[0]);
+		*avail = avail->substr(1);
+		*value |= static_cast<UInt64>(byte & 0x7F) << shift;
+		if ((byte & 0x80) == 0)
+			return true;
+	}
+	return false;
+}
+
+}  // namespace ssgnc
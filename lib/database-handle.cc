@@ -0,0 +1,313 @@
+#include "ssgnc/database-handle.h"
+#include "ssgnc/mutex-lock.h"
+
+namespace ssgnc {
+
+// The objects are closed in reverse order of their dependencies.
+DatabaseHandle::Snapshot::~Snapshot()
+{
+	if (coalescer_.is_open())
+		coalescer_.close();
+	if (result_cache_.is_open())
+		result_cache_.close();
+	if (database_.is_open())
+		database_.close();
+}
+
+DatabaseHandle::Ref::~Ref()
+{
+	if (is_open())
+		release();
+}
+
+bool DatabaseHandle::Ref::acquire(DatabaseHandle *handle)
+{
+	if (is_open())
+	{
+		SSGNC_ERROR << "Already acquired" << std::endl;
+		return false;
+	}
+	else if (handle == NULL)
+	{
+		SSGNC_ERROR << "Null pointer" << std::endl;
+		return false;
+	}
+
+	Snapshot *snapshot = handle->acquire();
+	if (snapshot == NULL)
+	{
+		SSGNC_ERROR << "ssgnc::DatabaseHandle::acquire() failed" << std::endl;
+		return false;
+	}
+
+	handle_ = handle;
+	snapshot_ = snapshot;
+	return true;
+}
+
+bool DatabaseHandle::Ref::release()
+{
+	if (!is_open())
+	{
+		SSGNC_ERROR << "Not acquired" << std::endl;
+		return false;
+	}
+
+	handle_->release(snapshot_);
+
+	handle_ = NULL;
+	snapshot_ = NULL;
+	return true;
+}
+
+DatabaseHandle::DatabaseHandle() : current_(NULL),
+	mode_(FileMap::DEFAULT_MODE), cache_size_(0), num_reloads_(0),
+	num_snapshots_(0), mutex_()
+{
+	::pthread_mutex_init(&mutex_, NULL);
+}
+
+DatabaseHandle::~DatabaseHandle()
+{
+	if (is_open())
+		close();
+
+	::pthread_mutex_destroy(&mutex_);
+}
+
+bool DatabaseHandle::open(const String &index_dir, FileMap::Mode mode,
+	UInt64 cache_size)
+{
+	if (is_open())
+	{
+		SSGNC_ERROR << "Already opened" << std::endl;
+		return false;
+	}
+
+	mode_ = mode;
+	cache_size_ = cache_size;
+
+	Snapshot *snapshot;
+	if (!openSnapshot(index_dir, 1, NULL, &snapshot))
+	{
+		SSGNC_ERROR << "ssgnc::DatabaseHandle::openSnapshot() failed: "
+			<< index_dir << std::endl;
+		return false;
+	}
+
+	replace(snapshot);
+	return true;
+}
+
+// The current snapshot is kept until its references are released.
+bool DatabaseHandle::close()
+{
+	if (!is_open())
+	{
+		SSGNC_ERROR << "Not opened" << std::endl;
+		return false;
+	}
+
+	replace(NULL);
+
+	MutexLock lock(&mutex_);
+	mode_ = FileMap::DEFAULT_MODE;
+	cache_size_ = 0;
+	num_reloads_ = 0;
+	return true;
+}
+
+bool DatabaseHandle::reload(const String &index_dir,
+	const std::vector<std::string> *queries)
+{
+	if (!is_open())
+	{
+		SSGNC_ERROR << "Not opened" << std::endl;
+		return false;
+	}
+
+	Snapshot *snapshot;
+	if (!openSnapshot(index_dir, generation() + 1, queries, &snapshot))
+	{
+		SSGNC_ERROR << "ssgnc::DatabaseHandle::openSnapshot() failed: "
+			<< index_dir << std::endl;
+		return false;
+	}
+
+	replace(snapshot);
+
+	MutexLock lock(&mutex_);
+	++num_reloads_;
+	return true;
+}
+
+bool DatabaseHandle::is_open() const
+{
+	MutexLock lock(&mutex_);
+	return current_ != NULL;
+}
+
+UInt64 DatabaseHandle::generation() const
+{
+	MutexLock lock(&mutex_);
+	return (current_ != NULL) ? current_->generation_ : 0;
+}
+
+UInt64 DatabaseHandle::num_reloads() const
+{
+	MutexLock lock(&mutex_);
+	return num_reloads_;
+}
+
+UInt32 DatabaseHandle::num_snapshots() const
+{
+	MutexLock lock(&mutex_);
+	return num_snapshots_;
+}
+
+// A snapshot is opened without the lock, because it takes a while to open
+// and warm a database.
+bool DatabaseHandle::openSnapshot(const String &index_dir,
+	UInt64 generation, const std::vector<std::string> *queries,
+	Snapshot **snapshot) const
+{
+	Snapshot *new_snapshot;
+	try
+	{
+		new_snapshot = new Snapshot;
+	}
+	catch (...)
+	{
+		SSGNC_ERROR << "new ssgnc::DatabaseHandle::Snapshot failed"
+			<< std::endl;
+		return false;
+	}
+
+	if (!new_snapshot->database_.open(index_dir, mode_))
+	{
+		SSGNC_ERROR << "ssgnc::Database::open() failed: "
+			<< index_dir << std::endl;
+		delete new_snapshot;
+		return false;
+	}
+
+	if (cache_size_ != 0)
+	{
+		if (!new_snapshot->result_cache_.open(cache_size_))
+		{
+			SSGNC_ERROR << "ssgnc::ResultCache::open() failed: "
+				<< cache_size_ << std::endl;
+			delete new_snapshot;
+			return false;
+		}
+		new_snapshot->database_.set_result_cache(
+			&new_snapshot->result_cache_);
+	}
+
+	if (!new_snapshot->coalescer_.open(new_snapshot->database_))
+	{
+		SSGNC_ERROR << "ssgnc::Coalescer::open() failed" << std::endl;
+		delete new_snapshot;
+		return false;
+	}
+
+	if (queries != NULL && !warmSnapshot(new_snapshot, *queries))
+	{
+		SSGNC_ERROR << "ssgnc::DatabaseHandle::warmSnapshot() failed"
+			<< std::endl;
+		delete new_snapshot;
+		return false;
+	}
+
+	new_snapshot->generation_ = generation;
+	*snapshot = new_snapshot;
+	return true;
+}
+
+// Queries are searched to validate a new index and to load its pages and
+// its result cache before it is used.
+bool DatabaseHandle::warmSnapshot(Snapshot *snapshot,
+	const std::vector<std::string> &queries)
+{
+	Query query;
+	Agent agent;
+	Int16 encoded_freq;
+	std::vector<Int32> tokens;
+	for (std::size_t i = 0; i < queries.size(); ++i)
+	{
+		String query_str(queries[i].c_str(), queries[i].length());
+		if (!snapshot->database_.parseQuery(query_str, &query))
+		{
+			SSGNC_ERROR << "ssgnc::Database::parseQuery() failed: "
+				<< query_str << std::endl;
+			return false;
+		}
+		else if (!snapshot->database_.search(query, &agent))
+		{
+			SSGNC_ERROR << "ssgnc::Database::search() failed: "
+				<< query_str << std::endl;
+			return false;
+		}
+
+		while (agent.read(&encoded_freq, &tokens))
+			continue;
+
+		if (agent.bad())
+		{
+			SSGNC_ERROR << "ssgnc::Agent::read() failed: "
+				<< query_str << std::endl;
+			return false;
+		}
+		if (agent.is_open())
+			agent.close();
+	}
+	return true;
+}
+
+// The handle has a reference to its current snapshot. The old snapshot is
+// closed here if no one else refers to it.
+void DatabaseHandle::replace(Snapshot *snapshot)
+{
+	Snapshot *old_snapshot = NULL;
+	{
+		MutexLock lock(&mutex_);
+		if (snapshot != NULL)
+		{
+			++snapshot->num_refs_;
+			++num_snapshots_;
+		}
+		if (current_ != NULL && --current_->num_refs_ == 0)
+		{
+			old_snapshot = current_;
+			--num_snapshots_;
+		}
+		current_ = snapshot;
+	}
+	delete old_snapshot;
+}
+
+DatabaseHandle::Snapshot *DatabaseHandle::acquire()
+{
+	MutexLock lock(&mutex_);
+	if (current_ == NULL)
+	{
+		SSGNC_ERROR << "Not opened" << std::endl;
+		return NULL;
+	}
+
+	++current_->num_refs_;
+	return current_;
+}
+
+void DatabaseHandle::release(Snapshot *snapshot)
+{
+	{
+		MutexLock lock(&mutex_);
+		if (--snapshot->num_refs_ != 0)
+			return;
+		--num_snapshots_;
+	}
+	delete snapshot;
+}
+
+}  // namespace ssgnc
@@ -1,19 +1,29 @@
 #include "ssgnc/database.h"
+#include "ssgnc/mutex-lock.h"
 
 #include <cctype>
 
 namespace ssgnc {
 
 Database::Database() : index_dir_(), vocab_dic_(), ngram_index_(),
-	freq_handler_() {}
+	shard_map_(), materialized_results_(), ngram_stats_(),
+	planner_(&ngram_index_, &ngram_stats_), cursor_key_(),
+	has_cursor_key_(false), cursor_key_mutex_(), freq_handler_(),
+	access_log_(NULL), result_cache_(NULL)
+{
+	::pthread_mutex_init(&cursor_key_mutex_, NULL);
+}
 
 Database::~Database()
 {
 	if (is_open())
 		close();
+
+	::pthread_mutex_destroy(&cursor_key_mutex_);
 }
 
-bool Database::open(const String &index_dir, FileMap::Mode mode)
+bool Database::open(const String &index_dir, FileMap::Mode mode,
+	bool reads_stats)
 {
 	if (is_open())
 	{
@@ -58,6 +68,75 @@ bool Database::open(const String &index_dir, FileMap::Mode mode)
 		return false;
 	}
 
+	if (!shard_map_.open(index_dir))
+	{
+		SSGNC_ERROR << "ssgnc::ShardMap::open() failed: "
+			<< index_dir << std::endl;
+		close();
+		return false;
+	}
+
+	// An index without ngms.mat has no materialized results.
+	path.clear();
+	if (!FilePath::join(index_dir, "ngms.mat", &path))
+	{
+		SSGNC_ERROR << "ssgnc::FilePath::join() failed" << std::endl;
+		close();
+		return false;
+	}
+	else if (std::ifstream(path.ptr(), std::ios::binary) &&
+		!materialized_results_.open(path.ptr(), mode))
+	{
+		SSGNC_ERROR << "ssgnc::MaterializedResults::open() failed: "
+			<< path << std::endl;
+		close();
+		return false;
+	}
+
+	// An index without ngms.stat is planned without statistics.
+	path.clear();
+	if (!FilePath::join(index_dir, "ngms.stat", &path))
+	{
+		SSGNC_ERROR << "ssgnc::FilePath::join() failed" << std::endl;
+		close();
+		return false;
+	}
+	else if (reads_stats && std::ifstream(path.ptr(), std::ios::binary) &&
+		!ngram_stats_.open(path.ptr(), mode))
+	{
+		SSGNC_ERROR << "ssgnc::NgramStats::open() failed: "
+			<< path << std::endl;
+		close();
+		return false;
+	}
+	else if (ngram_stats_.is_open() &&
+		(ngram_stats_.max_num_tokens() != ngram_index_.max_num_tokens() ||
+		ngram_stats_.max_token_id() != ngram_index_.max_token_id()))
+	{
+		SSGNC_ERROR << "Wrong pair: " << ngram_stats_.max_num_tokens()
+			<< ", " << ngram_stats_.max_token_id() << std::endl;
+		close();
+		return false;
+	}
+	// Statistics of another build of the index would drop lists and orders
+	// which have n-grams, so they are refused.
+	else if (ngram_stats_.is_open() &&
+		(ngram_stats_.index_size() != ngram_index_.size() ||
+		ngram_stats_.index_fingerprint() != ngram_index_.fingerprint()))
+	{
+		SSGNC_ERROR << "Stale statistics, rebuild them by ssgnc-stat: "
+			<< path << std::endl;
+		close();
+		return false;
+	}
+
+	if (!openCursorKey(index_dir))
+	{
+		SSGNC_ERROR << "ssgnc::Database::openCursorKey() failed" << std::endl;
+		close();
+		return false;
+	}
+
 	if (!index_dir_.append(index_dir))
 	{
 		SSGNC_ERROR << "ssgnc::StringBuilder::append() failed" << std::endl;
@@ -80,6 +159,14 @@ bool Database::close()
 	vocab_dic_.close();
 	if (ngram_index_.is_open())
 		ngram_index_.close();
+	if (shard_map_.is_open())
+		shard_map_.close();
+	if (materialized_results_.is_open())
+		materialized_results_.close();
+	if (ngram_stats_.is_open())
+		ngram_stats_.close();
+	cursor_key_ = Cursor::Key();
+	has_cursor_key_ = false;
 	return true;
 }
 
@@ -139,76 +226,220 @@ bool Database::search(const Query &query, Agent *agent) const
 		return false;
 	}
 
-	Int32 min_num_tokens = 1;
-	Int32 max_num_tokens = ngram_index_.max_num_tokens();
+	// The access log is always replaced, so that a reused agent does not keep
+	// the log of another database.
+	agent->set_access_log(access_log_);
 
-	if (query.min_num_tokens() != 0 && query.min_num_tokens() > min_num_tokens)
-		min_num_tokens = query.min_num_tokens();
-	if (query.max_num_tokens() != 0 && query.max_num_tokens() < max_num_tokens)
-		max_num_tokens = query.max_num_tokens();
-
-	if (query.num_tokens() > min_num_tokens)
-		min_num_tokens = query.num_tokens();
-	if (query.order() == Query::FIXED && query.num_tokens() < max_num_tokens)
-		max_num_tokens = query.num_tokens();
-
-	std::vector<Agent::Source> sources;
+	// The key and the sources are built in the scratch buffers of the agent,
+	// so that a reused agent does not allocate them.
+	ResultCache::Key &key = agent->search_key_;
+	if ((materialized_results_.is_open() || result_cache_ != NULL) &&
+		!makeKey(query, &key))
+	{
+		SSGNC_ERROR << "ssgnc::Database::makeKey() failed" << std::endl;
+		return false;
+	}
 
-	for (Int32 i = 0; i < query.num_tokens(); ++i)
+	// A query of a heavy hitter is answered by the materialized results.
+	if (materialized_results_.is_open())
 	{
-		if (query.token(i) == Query::UNKNOWN_TOKEN)
+		bool is_found;
+		if (!materialized_results_.find(key, query, agent, &is_found))
 		{
-			if (!agent->open(index_dir_.str(), query, sources))
-			{
-				SSGNC_ERROR << "ssgnc::Agent::open() failed" << std::endl;
-				return false;
-			}
+			SSGNC_ERROR << "ssgnc::MaterializedResults::find() failed"
+				<< std::endl;
+			return false;
+		}
+		else if (is_found)
 			return true;
+	}
+
+	// A query is answered by the cache if possible. Otherwise, the results
+	// of the search are cached when the agent is closed.
+	if (result_cache_ != NULL)
+	{
+		if (result_cache_->find(key, query, agent))
+			return true;
+		else if (!agent->set_result_cache(result_cache_, key))
+		{
+			SSGNC_ERROR << "ssgnc::Agent::set_result_cache() failed"
+				<< std::endl;
+			return false;
 		}
 	}
 
-	for (Int32 i = min_num_tokens; i <= max_num_tokens; ++i)
+	std::vector<Agent::Source> &sources = agent->search_sources_;
+	if (!plan(query, &sources))
 	{
-		NgramIndex::Entry min_entry;
-		for (Int32 j = 0; j < query.num_tokens(); ++j)
+		SSGNC_ERROR << "ssgnc::Database::plan() failed" << std::endl;
+		return false;
+	}
+
+	if (!agent->open(shard_map_, query, sources))
+	{
+		SSGNC_ERROR << "ssgnc::Agent::open() failed" << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+bool Database::cursor_key(const Cursor::Key **key) const
+{
+	if (!is_open())
+	{
+		SSGNC_ERROR << "Not opened" << std::endl;
+		return false;
+	}
+	else if (key == NULL)
+	{
+		SSGNC_ERROR << "Null pointer" << std::endl;
+		return false;
+	}
+
+	MutexLock lock(&cursor_key_mutex_);
+	if (!has_cursor_key_)
+	{
+		if (!cursor_key_.generate())
 		{
-			Int32 token = query.token(j);
-			if (token == Query::META_TOKEN)
-				continue;
+			SSGNC_ERROR << "ssgnc::Cursor::Key::generate() failed"
+				<< std::endl;
+			return false;
+		}
+		has_cursor_key_ = true;
+	}
 
-			NgramIndex::Entry entry;
-			if (!ngram_index_.get(i, token, &entry))
-			{
-				SSGNC_ERROR << "ssgnc::NgramIndex::get() failed" << std::endl;
-				return false;
-			}
+	*key = &cursor_key_;
+	return true;
+}
 
-			if (min_entry.approx_size() == 0 ||
-				entry.approx_size() < min_entry.approx_size())
-				min_entry = entry;
+bool Database::search(const Query &query, const Cursor &cursor,
+	Agent *agent) const
+{
+	if (!is_open())
+	{
+		SSGNC_ERROR << "Not opened" << std::endl;
+		return false;
+	}
+	else if (agent == NULL)
+	{
+		SSGNC_ERROR << "Null pointer" << std::endl;
+		return false;
+	}
+
+	// The lists of a cursor are read without the result cache, because the
+	// cache keeps only the first results of queries.
+	if (!agent->open(shard_map_, query, cursor))
+	{
+		SSGNC_ERROR << "ssgnc::Agent::open() failed" << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+bool Database::plan(const Query &query,
+	std::vector<Agent::Source> *sources) const
+{
+	if (!is_open())
+	{
+		SSGNC_ERROR << "Not opened" << std::endl;
+		return false;
+	}
+	else if (sources == NULL)
+	{
+		SSGNC_ERROR << "Null pointer" << std::endl;
+		return false;
+	}
+
+	Int32 min_num_tokens, max_num_tokens;
+	getNumTokensRange(query, &min_num_tokens, &max_num_tokens);
+
+	if (!planner_.plan(query, min_num_tokens, max_num_tokens, sources))
+	{
+		SSGNC_ERROR << "ssgnc::Planner::plan() failed" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+bool Database::explain(const Query &query,
+	Planner::Explanation *explanation) const
+{
+	if (!is_open())
+	{
+		SSGNC_ERROR << "Not opened" << std::endl;
+		return false;
+	}
+	else if (explanation == NULL)
+	{
+		SSGNC_ERROR << "Null pointer" << std::endl;
+		return false;
+	}
+
+	explanation->clear();
+
+	if (materialized_results_.is_open())
+	{
+		ResultCache::Key key;
+		if (!makeKey(query, &key))
+		{
+			SSGNC_ERROR << "ssgnc::Database::makeKey() failed" << std::endl;
+			return false;
 		}
 
-		if (min_entry.approx_size() > 1)
+		Agent agent;
+		bool is_found;
+		if (!materialized_results_.find(key, query, &agent, &is_found))
 		{
-			try
-			{
-				sources.push_back(Agent::Source(i, min_entry));
-			}
-			catch (...)
-			{
-				SSGNC_ERROR << "std::vector<ssgnc::Agent::Source>::"
-					"push_back(): " << sources.size() << std::endl;
-				return false;
-			}
+			SSGNC_ERROR << "ssgnc::MaterializedResults::find() failed"
+				<< std::endl;
+			return false;
+		}
+		else if (is_found)
+		{
+			explanation->set_has_stats(ngram_stats_.is_open());
+			explanation->set_access(Planner::Explanation::MATERIALIZED_RESULTS);
+			return agent.close();
 		}
 	}
 
-	if (!agent->open(index_dir_.str(), query, sources))
+	if (!explainLists(query, explanation))
 	{
-		SSGNC_ERROR << "ssgnc::Agent::open() failed" << std::endl;
+		SSGNC_ERROR << "ssgnc::Database::explainLists() failed" << std::endl;
 		return false;
 	}
+	return true;
+}
 
+bool Database::estimate(const Query &query, double *num_results,
+	double *search_time) const
+{
+	if (!is_open())
+	{
+		SSGNC_ERROR << "Not opened" << std::endl;
+		return false;
+	}
+	else if (!ngram_stats_.is_open())
+	{
+		SSGNC_ERROR << "No statistics" << std::endl;
+		return false;
+	}
+	else if (num_results == NULL || search_time == NULL)
+	{
+		SSGNC_ERROR << "Null pointer" << std::endl;
+		return false;
+	}
+
+	Planner::Explanation explanation;
+	if (!explainLists(query, &explanation))
+	{
+		SSGNC_ERROR << "ssgnc::Database::explainLists() failed" << std::endl;
+		return false;
+	}
+
+	*num_results = explanation.num_total_matches();
+	*search_time = explanation.search_time();
 	return true;
 }
 
@@ -284,6 +515,64 @@ bool Database::decode(Int16 encoded_freq, const std::vector<Int32> &token_ids,
 	return true;
 }
 
+bool Database::decode(const ResultBatch &batch, StringBuilder *output) const
+{
+	if (!is_open())
+	{
+		SSGNC_ERROR << "Not opened" << std::endl;
+		return false;
+	}
+	else if (output == NULL)
+	{
+		SSGNC_ERROR << "Null pointer" << std::endl;
+		return false;
+	}
+
+	output->clear();
+	for (UInt32 i = 0; i < batch.size(); ++i)
+	{
+		const Int32 *tokens = batch.tokens(i);
+		for (Int32 j = 0; j < batch.num_tokens(i); ++j)
+		{
+			String token;
+			if (!vocab_dic_.find(tokens[j], &token))
+			{
+				SSGNC_ERROR << "ssgnc::VocabDic::find() failed: "
+					<< tokens[j] << std::endl;
+				return false;
+			}
+			else if ((j != 0 && !output->append(' ')) ||
+				!output->append(token))
+			{
+				SSGNC_ERROR << "ssgnc::StringBuilder::append() failed"
+					<< std::endl;
+				return false;
+			}
+		}
+
+		Int64 freq;
+		if (!decodeFreq(batch.encoded_freq(i), &freq))
+		{
+			SSGNC_ERROR << "ssgnc::Database::decodeFreq() failed: "
+				<< batch.encoded_freq(i) << std::endl;
+			return false;
+		}
+		else if (!output->appendf("\t%lld\n", freq))
+		{
+			SSGNC_ERROR << "ssgnc::StringBuilder::appendf() failed"
+				<< std::endl;
+			return false;
+		}
+	}
+
+	if (!output->append())
+	{
+		SSGNC_ERROR << "ssgnc::StringBuilder::append() failed" << std::endl;
+		return false;
+	}
+	return true;
+}
+
 bool Database::decodeFreq(Int16 encoded_freq, Int64 *freq) const
 {
 	if (freq == NULL)
@@ -393,6 +682,98 @@ bool Database::decodeTokens(const std::vector<Int32> &tokens,
 	return true;
 }
 
+bool Database::makeKey(const Query &query, ResultCache::Key *key) const
+{
+	Int32 min_num_tokens, max_num_tokens;
+	getNumTokensRange(query, &min_num_tokens, &max_num_tokens);
+
+	if (!ResultCache::makeKey(query, min_num_tokens, max_num_tokens, key))
+	{
+		SSGNC_ERROR << "ssgnc::ResultCache::makeKey() failed" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+bool Database::explainLists(const Query &query,
+	Planner::Explanation *explanation) const
+{
+	explanation->clear();
+	explanation->set_has_stats(ngram_stats_.is_open());
+	if (ngram_stats_.is_open())
+		explanation->set_scan_cost(ngram_stats_.scan_cost());
+
+	Int32 min_num_tokens, max_num_tokens;
+	getNumTokensRange(query, &min_num_tokens, &max_num_tokens);
+
+	std::vector<Agent::Source> sources;
+	if (!planner_.plan(query, min_num_tokens, max_num_tokens, &sources,
+		explanation->mutable_estimates()))
+	{
+		SSGNC_ERROR << "ssgnc::Planner::plan() failed" << std::endl;
+		return false;
+	}
+
+	explanation->set_access(sources.empty() ?
+		Planner::Explanation::NO_SOURCES : Planner::Explanation::LISTS);
+	return true;
+}
+
+bool Database::openCursorKey(const String &index_dir)
+{
+	StringBuilder path;
+	if (!FilePath::join(index_dir, "ngms.key", &path))
+	{
+		SSGNC_ERROR << "ssgnc::FilePath::join() failed" << std::endl;
+		return false;
+	}
+
+	// Without the file, the key is generated by cursor_key().
+	std::ifstream file(path.ptr(), std::ios::binary);
+	if (!file)
+		return true;
+
+	StringBuilder secret;
+	char c;
+	while (file.get(c))
+	{
+		if (!secret.append(static_cast<Int8>(c)))
+		{
+			SSGNC_ERROR << "ssgnc::StringBuilder::append() failed"
+				<< std::endl;
+			return false;
+		}
+	}
+
+	if (!cursor_key_.set(secret.str()))
+	{
+		SSGNC_ERROR << "ssgnc::Cursor::Key::set() failed: " << path
+			<< std::endl;
+		return false;
+	}
+	has_cursor_key_ = true;
+	return true;
+}
+
+void Database::getNumTokensRange(const Query &query, Int32 *min_num_tokens,
+	Int32 *max_num_tokens) const
+{
+	*min_num_tokens = 1;
+	*max_num_tokens = ngram_index_.max_num_tokens();
+
+	if (query.min_num_tokens() != 0 &&
+		query.min_num_tokens() > *min_num_tokens)
+		*min_num_tokens = query.min_num_tokens();
+	if (query.max_num_tokens() != 0 &&
+		query.max_num_tokens() < *max_num_tokens)
+		*max_num_tokens = query.max_num_tokens();
+
+	if (query.num_tokens() > *min_num_tokens)
+		*min_num_tokens = query.num_tokens();
+	if (query.order() == Query::FIXED && query.num_tokens() < *max_num_tokens)
+		*max_num_tokens = query.num_tokens();
+}
+
 String Database::findDelim(const String &str)
 {
 	for (std::size_t i = 0; i < str.length(); ++i)
@@ -0,0 +1,216 @@
+#include "ssgnc/elias-fano.h"
+
+namespace ssgnc {
+
+bool EliasFano::map(Mapper *mapper)
+{
+	if (is_mapped())
+	{
+		SSGNC_ERROR << "Already mapped" << std::endl;
+		return false;
+	}
+	else if (mapper == NULL)
+	{
+		SSGNC_ERROR << "Null pointer" << std::endl;
+		return false;
+	}
+
+	const UInt64 *num_values, *num_low_bits;
+	const UInt64 *num_lower_words, *num_upper_words, *num_samples;
+	if (!mapper->map(&num_values) || !mapper->map(&num_low_bits) ||
+		!mapper->map(&num_lower_words) || !mapper->map(&num_upper_words) ||
+		!mapper->map(&num_samples))
+	{
+		SSGNC_ERROR << "ssgnc::Mapper::map() failed: header" << std::endl;
+		return false;
+	}
+	// The sizes must be those written by build(), so that low() and high()
+	// never read past the words of a broken file.
+	else if (*num_values > Mapper::MAX_SIZE || *num_low_bits >= 64 ||
+		*num_lower_words != ((*num_values * *num_low_bits) + 63) / 64 ||
+		*num_upper_words > Mapper::MAX_SIZE ||
+		*num_upper_words * 64 < *num_values + 1 ||
+		*num_samples != (*num_values + SAMPLE_INTERVAL - 1) / SAMPLE_INTERVAL)
+	{
+		SSGNC_ERROR << "Wrong header" << std::endl;
+		return false;
+	}
+
+	const UInt64 *lower, *upper, *samples;
+	if (!mapper->map(&lower, *num_lower_words) ||
+		!mapper->map(&upper, *num_upper_words) ||
+		!mapper->map(&samples, *num_samples))
+	{
+		SSGNC_ERROR << "ssgnc::Mapper::map() failed: bits" << std::endl;
+		return false;
+	}
+	else if (!checkUpper(upper, *num_upper_words, samples, *num_values))
+	{
+		SSGNC_ERROR << "Wrong bits" << std::endl;
+		return false;
+	}
+
+	num_values_ = *num_values;
+	num_low_bits_ = static_cast<UInt32>(*num_low_bits);
+	low_mask_ = (1ULL << num_low_bits_) - 1;
+	lower_ = lower;
+	upper_ = upper;
+	samples_ = samples;
+
+	return true;
+}
+
+void EliasFano::clear()
+{
+	num_values_ = 0;
+	num_low_bits_ = 0;
+	low_mask_ = 0;
+	lower_ = NULL;
+	upper_ = NULL;
+	samples_ = NULL;
+}
+
+bool EliasFano::get(UInt64 index, UInt64 *value) const
+{
+	if (!is_mapped())
+	{
+		SSGNC_ERROR << "Not mapped" << std::endl;
+		return false;
+	}
+	else if (index >= num_values_)
+	{
+		SSGNC_ERROR << "Out of range index: " << index << std::endl;
+		return false;
+	}
+	else if (value == NULL)
+	{
+		SSGNC_ERROR << "Null pointer" << std::endl;
+		return false;
+	}
+
+	*value = (*this)[index];
+	return true;
+}
+
+// The bit vector must have a one for each value and the samples must point
+// to the ones, so that high() finds its one without leaving the vector. The
+// last one is at (max_value >> num_low_bits) + num_values - 1, so this also
+// ensures num_upper_words * 64 >= num_values + (max_value >> num_low_bits)
+// + 1.
+bool EliasFano::checkUpper(const UInt64 *upper, UInt64 num_upper_words,
+	const UInt64 *samples, UInt64 num_values)
+{
+	UInt64 num_ones = 0;
+	UInt64 sample_id = 0;
+	for (UInt64 i = 0; i < num_upper_words; ++i)
+	{
+		UInt64 word = upper[i];
+		UInt32 count = popCount(word);
+
+		UInt64 rank = sample_id * SAMPLE_INTERVAL;
+		while (rank < num_values && rank < num_ones + count)
+		{
+			UInt64 bit_pos = (i * 64) + selectInWord(word,
+				static_cast<UInt32>(rank - num_ones));
+			if (samples[sample_id] != bit_pos)
+				return false;
+			rank = ++sample_id * SAMPLE_INTERVAL;
+		}
+		num_ones += count;
+	}
+	return num_ones == num_values;
+}
+
+bool EliasFano::build(const std::vector<UInt64> &values, Writer *writer)
+{
+	if (writer == NULL)
+	{
+		SSGNC_ERROR << "Null pointer" << std::endl;
+		return false;
+	}
+
+	for (std::size_t i = 1; i < values.size(); ++i)
+	{
+		if (values[i] < values[i - 1])
+		{
+			SSGNC_ERROR << "Not monotone: " << values[i - 1]
+				<< ", " << values[i] << std::endl;
+			return false;
+		}
+	}
+
+	UInt64 num_values = values.size();
+	UInt64 max_value = values.empty() ? 0 : values.back();
+
+	// The number of low bits is chosen as floor(log2(max_value / num_values))
+	// so that the bit vector of high bits has about 2 bits per value.
+	UInt64 num_low_bits = 0;
+	if (num_values != 0)
+	{
+		for (UInt64 ratio = max_value / num_values; ratio > 1; ratio >>= 1)
+			++num_low_bits;
+	}
+
+	UInt64 num_lower_words = ((num_values * num_low_bits) + 63) / 64;
+	UInt64 num_upper_bits = num_values + (max_value >> num_low_bits) + 1;
+	UInt64 num_upper_words = (num_upper_bits + 63) / 64;
+	UInt64 num_samples = (num_values + SAMPLE_INTERVAL - 1) / SAMPLE_INTERVAL;
+
+	std::vector<UInt64> lower;
+	std::vector<UInt64> upper;
+	std::vector<UInt64> samples;
+	try
+	{
+		lower.resize(num_lower_words, 0);
+		upper.resize(num_upper_words, 0);
+		samples.resize(num_samples, 0);
+	}
+	catch (...)
+	{
+		SSGNC_ERROR << "std::vector<ssgnc::UInt64>::resize() failed: "
+			<< num_lower_words << ", " << num_upper_words << ", "
+			<< num_samples << std::endl;
+		return false;
+	}
+
+	UInt64 low_mask = (1ULL << num_low_bits) - 1;
+	for (UInt64 i = 0; i < num_values; ++i)
+	{
+		if (num_low_bits != 0)
+		{
+			UInt64 low = values[i] & low_mask;
+			UInt64 bit_pos = i * num_low_bits;
+			UInt64 word_id = bit_pos / 64;
+			UInt64 shift = bit_pos % 64;
+
+			lower[word_id] |= low << shift;
+			if (shift + num_low_bits > 64)
+				lower[word_id + 1] |= low >> (64 - shift);
+		}
+
+		UInt64 bit_pos = (values[i] >> num_low_bits) + i;
+		upper[bit_pos / 64] |= 1ULL << (bit_pos % 64);
+		if (i % SAMPLE_INTERVAL == 0)
+			samples[i / SAMPLE_INTERVAL] = bit_pos;
+	}
+
+	if (!writer->write(num_values) || !writer->write(num_low_bits) ||
+		!writer->write(num_lower_words) || !writer->write(num_upper_words) ||
+		!writer->write(num_samples))
+	{
+		SSGNC_ERROR << "ssgnc::Writer::write() failed: header" << std::endl;
+		return false;
+	}
+	else if ((num_lower_words != 0 &&
+		!writer->write(&lower[0], num_lower_words)) ||
+		!writer->write(&upper[0], num_upper_words) ||
+		(num_samples != 0 && !writer->write(&samples[0], num_samples)))
+	{
+		SSGNC_ERROR << "ssgnc::Writer::write() failed: bits" << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+}  // namespace ssgnc
@@ -0,0 +1,195 @@
+#include "ssgnc/fd-streambuf.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+
+#include <unistd.h>
+
+namespace ssgnc {
+
+FdStreambuf::~FdStreambuf()
+{
+	if (is_open())
+		close();
+}
+
+bool FdStreambuf::open(int fd, UInt32 buf_size)
+{
+	if (is_open())
+	{
+		SSGNC_ERROR << "Already opened" << std::endl;
+		return false;
+	}
+	else if (fd < 0)
+	{
+		SSGNC_ERROR << "Invalid file descriptor: " << fd << std::endl;
+		return false;
+	}
+	else if (buf_size == 0)
+	{
+		SSGNC_ERROR << "Zero buffer size" << std::endl;
+		return false;
+	}
+
+	try
+	{
+		in_buf_.resize(buf_size);
+		out_buf_.resize(buf_size);
+	}
+	catch (...)
+	{
+		SSGNC_ERROR << "std::vector<char>::resize() failed: "
+			<< buf_size << std::endl;
+		in_buf_.clear();
+		out_buf_.clear();
+		return false;
+	}
+
+	fd_ = fd;
+	setg(&in_buf_[0], &in_buf_[0], &in_buf_[0]);
+	setp(&out_buf_[0], &out_buf_[0] + out_buf_.size());
+	return true;
+}
+
+bool FdStreambuf::close()
+{
+	if (!is_open())
+	{
+		SSGNC_ERROR << "Not opened" << std::endl;
+		return false;
+	}
+
+	bool is_ok = flushBuf();
+	if (::close(fd_) != 0)
+	{
+		SSGNC_ERROR << "::close() failed: " << fd_ << std::endl;
+		is_ok = false;
+	}
+
+	fd_ = -1;
+	setg(NULL, NULL, NULL);
+	setp(NULL, NULL);
+	return is_ok;
+}
+
+FdStreambuf::int_type FdStreambuf::underflow()
+{
+	if (!is_open())
+		return traits_type::eof();
+	else if (gptr() < egptr())
+		return traits_type::to_int_type(*gptr());
+
+	ssize_t size = readFd(&in_buf_[0], in_buf_.size());
+	if (size <= 0)
+		return traits_type::eof();
+
+	setg(&in_buf_[0], &in_buf_[0], &in_buf_[0] + size);
+	return traits_type::to_int_type(*gptr());
+}
+
+FdStreambuf::int_type FdStreambuf::overflow(int_type c)
+{
+	if (!is_open() || !flushBuf())
+		return traits_type::eof();
+
+	if (!traits_type::eq_int_type(c, traits_type::eof()))
+	{
+		*pptr() = traits_type::to_char_type(c);
+		pbump(1);
+	}
+	return traits_type::not_eof(c);
+}
+
+std::streamsize FdStreambuf::xsgetn(char *s, std::streamsize n)
+{
+	std::streamsize total = 0;
+	while (total < n)
+	{
+		std::streamsize avail = egptr() - gptr();
+		if (avail > 0)
+		{
+			std::streamsize size = std::min(avail, n - total);
+			traits_type::copy(s + total, gptr(),
+				static_cast<std::size_t>(size));
+			gbump(static_cast<int>(size));
+			total += size;
+		}
+		else if (!is_open())
+			break;
+		else if (n - total >= static_cast<std::streamsize>(in_buf_.size()))
+		{
+			ssize_t size = readFd(s + total,
+				static_cast<std::size_t>(n - total));
+			if (size <= 0)
+				break;
+			total += size;
+		}
+		else if (traits_type::eq_int_type(underflow(), traits_type::eof()))
+			break;
+	}
+	return total;
+}
+
+// The input buffer is dropped, because the position of the descriptor is
+// ahead of the position of the stream by the buffered bytes.
+FdStreambuf::pos_type FdStreambuf::seekoff(off_type off,
+	std::ios_base::seekdir dir, std::ios_base::openmode which)
+{
+	if (!is_open() || (which & std::ios_base::out) || !flushBuf())
+		return pos_type(off_type(-1));
+
+	if (dir == std::ios_base::cur)
+		off -= egptr() - gptr();
+
+	int whence = (dir == std::ios_base::beg) ? SEEK_SET :
+		((dir == std::ios_base::cur) ? SEEK_CUR : SEEK_END);
+	off_t offset = ::lseek(fd_, static_cast<off_t>(off), whence);
+	if (offset < 0)
+		return pos_type(off_type(-1));
+
+	setg(&in_buf_[0], &in_buf_[0], &in_buf_[0]);
+	return pos_type(static_cast<off_type>(offset));
+}
+
+FdStreambuf::pos_type FdStreambuf::seekpos(pos_type pos,
+	std::ios_base::openmode which)
+{
+	return seekoff(off_type(pos), std::ios_base::beg, which);
+}
+
+int FdStreambuf::sync()
+{
+	return (is_open() && flushBuf()) ? 0 : -1;
+}
+
+bool FdStreambuf::flushBuf()
+{
+	const char *ptr = pbase();
+	while (ptr < pptr())
+	{
+		ssize_t size = ::write(fd_, ptr, pptr() - ptr);
+		if (size < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			setp(&out_buf_[0], &out_buf_[0] + out_buf_.size());
+			return false;
+		}
+		ptr += size;
+	}
+	setp(&out_buf_[0], &out_buf_[0] + out_buf_.size());
+	return true;
+}
+
+ssize_t FdStreambuf::readFd(char *buf, std::size_t size)
+{
+	ssize_t result;
+	do
+	{
+		result = ::read(fd_, buf, size);
+	} while (result < 0 && errno == EINTR);
+	return result;
+}
+
+}  // namespace ssgnc
@@ -48,9 +48,12 @@ private:
 
 	bool getFileSize(const Int8 *path, std::size_t *file_size);
 
-	bool mmap(const Int8 *path, std::size_t file_size);
+	bool mmap(const Int8 *path, std::size_t file_size, Mode mode);
 	bool read(const Int8 *path, std::size_t file_size);
 
+	bool lock();
+	void advise(Mode mode);
+
 	// Disallows copies.
 	Impl(const Impl &);
 	Impl &operator=(const Impl &);
@@ -98,7 +101,8 @@ bool FileMap::Impl::getFileSize(const Int8 *path, std::size_t *file_size)
 		SSGNC_ERROR << "::_stat64() failed: " << path << std::endl;
 		return false;
 	}
-	else if (st.st_size > MAX_FILE_SIZE)
+	else if (static_cast<UInt64>(st.st_size) > MAX_FILE_SIZE ||
+		static_cast<UInt64>(st.st_size) > static_cast<std::size_t>(-1))
 	{
 		SSGNC_ERROR << "Too large file: " << st.st_size << std::endl;
 		return false;
@@ -108,7 +112,7 @@ bool FileMap::Impl::getFileSize(const Int8 *path, std::size_t *file_size)
 	return true;
 }
 
-bool FileMap::Impl::mmap(const Int8 *path, std::size_t file_size)
+bool FileMap::Impl::mmap(const Int8 *path, std::size_t file_size, Mode)
 {
 	file_handle_ = ::CreateFile(path, GENERIC_READ, FILE_SHARE_READ,
 		NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
@@ -137,6 +141,19 @@ bool FileMap::Impl::mmap(const Int8 *path, std::size_t file_size)
 	return true;
 }
 
+bool FileMap::Impl::lock()
+{
+	if (!::VirtualLock(const_cast<void *>(ptr()), size_))
+	{
+		SSGNC_ERROR << "::VirtualLock() failed: " << size_ << std::endl;
+		return false;
+	}
+	return true;
+}
+
+// There are no corresponding hints on Windows.
+void FileMap::Impl::advise(Mode) {}
+
 #else  // defined _WIN32 || defined _WIN64
 
 FileMap::Impl::Impl() : fd_(-1), ptr_(MAP_FAILED), buf_(NULL), size_(0) {}
@@ -148,6 +165,8 @@ void FileMap::Impl::close()
 		::munmap(ptr_, size_);
 		ptr_ = MAP_FAILED;
 	}
+	else if (buf_ != NULL)
+		::munlock(buf_, size_);
 
 	if (fd_ != -1)
 	{
@@ -172,7 +191,8 @@ bool FileMap::Impl::getFileSize(const Int8 *path, std::size_t *file_size)
 		SSGNC_ERROR << "::stat() failed: " << path << std::endl;
 		return false;
 	}
-	else if (st.st_size > MAX_FILE_SIZE)
+	else if (static_cast<UInt64>(st.st_size) > MAX_FILE_SIZE ||
+		static_cast<UInt64>(st.st_size) > static_cast<std::size_t>(-1))
 	{
 		SSGNC_ERROR << "Too large file: " << st.st_size << std::endl;
 		return false;
@@ -182,7 +202,7 @@ bool FileMap::Impl::getFileSize(const Int8 *path, std::size_t *file_size)
 	return true;
 }
 
-bool FileMap::Impl::mmap(const Int8 *path, std::size_t file_size)
+bool FileMap::Impl::mmap(const Int8 *path, std::size_t file_size, Mode mode)
 {
 	fd_ = ::open(path, O_RDONLY);
 	if (fd_ == -1)
@@ -191,7 +211,13 @@ bool FileMap::Impl::mmap(const Int8 *path, std::size_t file_size)
 		return false;
 	}
 
-	ptr_ = ::mmap(NULL, file_size, PROT_READ, MAP_SHARED, fd_, 0);
+	int flags = MAP_SHARED;
+#ifdef MAP_POPULATE
+	if ((mode & POPULATE_PAGES) != 0)
+		flags |= MAP_POPULATE;
+#endif  // MAP_POPULATE
+
+	ptr_ = ::mmap(NULL, file_size, PROT_READ, flags, fd_, 0);
 	if (ptr_ == MAP_FAILED)
 	{
 		SSGNC_ERROR << "::mmap() failed: " << file_size << std::endl;
@@ -202,6 +228,39 @@ bool FileMap::Impl::mmap(const Int8 *path, std::size_t file_size)
 	return true;
 }
 
+bool FileMap::Impl::lock()
+{
+	if (::mlock(ptr(), size_) != 0)
+	{
+		SSGNC_ERROR << "::mlock() failed: " << size_ << std::endl;
+		return false;
+	}
+	return true;
+}
+
+// The hints are only advisory, so failures are ignored. For example,
+// MADV_HUGEPAGE fails if the kernel does not support transparent huge pages.
+void FileMap::Impl::advise(Mode mode)
+{
+	if (ptr_ == MAP_FAILED)
+		return;
+
+#ifdef MADV_HUGEPAGE
+	if ((mode & HUGE_PAGES) != 0)
+		::madvise(ptr_, size_, MADV_HUGEPAGE);
+#endif  // MADV_HUGEPAGE
+
+#ifndef MAP_POPULATE
+	if ((mode & POPULATE_PAGES) != 0)
+		::madvise(ptr_, size_, MADV_WILLNEED);
+#endif  // MAP_POPULATE
+
+	if ((mode & WILL_NEED) != 0)
+		::madvise(ptr_, size_, MADV_WILLNEED);
+	if ((mode & RANDOM_ACCESS) != 0)
+		::madvise(ptr_, size_, MADV_RANDOM);
+}
+
 #endif  // defined _WIN32 || defined _WIN64
 
 bool FileMap::Impl::open(const Int8 *path, Mode mode)
@@ -211,6 +270,11 @@ bool FileMap::Impl::open(const Int8 *path, Mode mode)
 		SSGNC_ERROR << "Null pointer" << std::endl;
 		return false;
 	}
+	else if ((mode & ~(LOAD_MODE_MASK | FLAGS_MASK)) != 0)
+	{
+		SSGNC_ERROR << "Unknown flags: " << mode << std::endl;
+		return false;
+	}
 
 	std::size_t file_size;
 	if (!getFileSize(path, &file_size))
@@ -220,10 +284,10 @@ bool FileMap::Impl::open(const Int8 *path, Mode mode)
 		return false;
 	}
 
-	switch (mode)
+	switch (mode & LOAD_MODE_MASK)
 	{
 	case MMAP_FILE:
-		if (!mmap(path, file_size))
+		if (!mmap(path, file_size, mode))
 		{
 			SSGNC_ERROR << "ssgnc::FileMap::Impl::mmap() failed: "
 				<< path << std::endl;
@@ -243,6 +307,15 @@ bool FileMap::Impl::open(const Int8 *path, Mode mode)
 		return false;
 	}
 
+	advise(mode);
+
+	if ((mode & LOCK_PAGES) != 0 && !lock())
+	{
+		SSGNC_ERROR << "ssgnc::FileMap::Impl::lock() failed: "
+			<< path << std::endl;
+		return false;
+	}
+
 	return true;
 }
 
@@ -322,7 +395,7 @@ bool FileMap::open(const Int8 *path, Mode mode)
 
 	impl_ = new_impl;
 	ptr_ = impl_->ptr();
-	size_ = static_cast<UInt32>(impl_->size());
+	size_ = static_cast<UInt64>(impl_->size());
 	return true;
 }
 
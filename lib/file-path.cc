@@ -70,6 +70,11 @@ bool FilePath::seek(ssgnc::Int32 file_id)
 }
 
 bool FilePath::read(StringBuilder *path)
+{
+	return read(dirname_.str(), path);
+}
+
+bool FilePath::read(const String &dirname, StringBuilder *path)
 {
 	if (!is_open())
 	{
@@ -87,18 +92,18 @@ bool FilePath::read(StringBuilder *path)
 		return false;
 	}
 
-	StringBuilder basename;
-	if (!basename.appendf(basename_.ptr(), file_id_))
+	filename_.clear();
+	if (!filename_.appendf(basename_.ptr(), file_id_))
 	{
 		SSGNC_ERROR << "ssgnc::StringBuilder::appendf() failed: "
 			<< basename_ << ", " << file_id_ << std::endl;
 		return false;
 	}
 
-	if (!join(dirname_.str(), basename.str(), path))
+	if (!join(dirname, filename_.str(), path))
 	{
 		SSGNC_ERROR << "ssgnc::FilePath::join() failed: "
-			<< dirname_ << ", " << basename << std::endl;
+			<< dirname << ", " << filename_ << std::endl;
 		return false;
 	}
 
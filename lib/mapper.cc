@@ -8,7 +8,7 @@ Mapper::~Mapper()
 		close();
 }
 
-bool Mapper::open(const void *ptr, UInt32 size)
+bool Mapper::open(const void *ptr, UInt64 size)
 {
 	if (is_open())
 	{
@@ -20,9 +20,9 @@ bool Mapper::open(const void *ptr, UInt32 size)
 		SSGNC_ERROR << "Null pointer" << std::endl;
 		return false;
 	}
-	else if (size_ > MAX_SIZE)
+	else if (size > MAX_SIZE)
 	{
-		SSGNC_ERROR << "Too large size: " << size_ << std::endl;
+		SSGNC_ERROR << "Too large size: " << size << std::endl;
 		return false;
 	}
 	ptr_ = ptr;
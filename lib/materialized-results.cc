@@ -0,0 +1,343 @@
+#include "ssgnc/materialized-results.h"
+#include "ssgnc/agent.h"
+#include "ssgnc/mapper.h"
+#include "ssgnc/writer.h"
+
+#include <algorithm>
+
+namespace ssgnc {
+
+namespace {
+
+class KeyIndexComparer
+{
+public:
+	explicit KeyIndexComparer(const std::vector<ResultCache::Key> *keys)
+		: keys_(keys) {}
+
+	bool operator()(UInt32 lhs, UInt32 rhs) const
+	{ return (*keys_)[lhs] < (*keys_)[rhs]; }
+
+private:
+	const std::vector<ResultCache::Key> *keys_;
+};
+
+}  // namespace
+
+void MaterializedResults::Builder::clear()
+{
+	entries_.clear();
+	keys_.clear();
+	pool_.clear();
+}
+
+bool MaterializedResults::Builder::append(const Key &key,
+	const ResultCache::Results &results, bool is_complete, UInt64 total,
+	UInt64 num_scanned)
+{
+	if (contains(key))
+	{
+		SSGNC_ERROR << "Duplicate key" << std::endl;
+		return false;
+	}
+
+	Entry entry;
+	entry.key_offset = 0;
+	entry.key_length = static_cast<UInt32>(key.size());
+	entry.results_offset = static_cast<UInt32>(pool_.size());
+	entry.num_results = static_cast<UInt32>(results.size());
+	entry.is_complete = is_complete ? 1 : 0;
+	entry.total = static_cast<UInt32>((total < MAX_COUNT) ? total : MAX_COUNT);
+	entry.num_scanned = static_cast<UInt32>(
+		(num_scanned < MAX_COUNT) ? num_scanned : MAX_COUNT);
+
+	std::vector<Int32> tokens;
+	try
+	{
+		for (UInt64 i = 0; i < results.size(); ++i)
+		{
+			Int16 encoded_freq;
+			if (!results.get(i, &encoded_freq, &tokens))
+			{
+				SSGNC_ERROR << "ssgnc::ResultCache::Results::get() failed"
+					<< std::endl;
+				pool_.resize(entry.results_offset);
+				return false;
+			}
+
+			pool_.push_back(encoded_freq);
+			pool_.push_back(static_cast<Int32>(tokens.size()));
+			pool_.insert(pool_.end(), tokens.begin(), tokens.end());
+		}
+
+		keys_.push_back(key);
+		entries_.push_back(entry);
+	}
+	catch (...)
+	{
+		SSGNC_ERROR << "std::vector::push_back() failed: "
+			<< pool_.size() << std::endl;
+		pool_.resize(entry.results_offset);
+		if (keys_.size() > entries_.size())
+			keys_.pop_back();
+		return false;
+	}
+	return true;
+}
+
+bool MaterializedResults::Builder::contains(const Key &key) const
+{
+	return std::find(keys_.begin(), keys_.end(), key) != keys_.end();
+}
+
+// The keys are stored after the results, in order of the sorted entries.
+bool MaterializedResults::Builder::write(std::ostream *stream) const
+{
+	if (stream == NULL)
+	{
+		SSGNC_ERROR << "Null pointer" << std::endl;
+		return false;
+	}
+
+	std::vector<UInt32> order(entries_.size());
+	for (std::size_t i = 0; i < order.size(); ++i)
+		order[i] = static_cast<UInt32>(i);
+	std::sort(order.begin(), order.end(), KeyIndexComparer(&keys_));
+
+	std::vector<Entry> sorted_entries(entries_.size());
+	UInt64 key_offset = pool_.size();
+	for (std::size_t i = 0; i < order.size(); ++i)
+	{
+		sorted_entries[i] = entries_[order[i]];
+		sorted_entries[i].key_offset = static_cast<UInt32>(key_offset);
+		key_offset += sorted_entries[i].key_length;
+	}
+	if (key_offset > 0xFFFFFFFFULL)
+	{
+		SSGNC_ERROR << "Too large pool: " << key_offset << std::endl;
+		return false;
+	}
+
+	Writer writer;
+	if (!writer.open(stream))
+	{
+		SSGNC_ERROR << "ssgnc::Writer::open() failed" << std::endl;
+		return false;
+	}
+
+	if (!writer.write(static_cast<UInt32>(FORMAT_MARKER)) ||
+		!writer.write(static_cast<UInt32>(FORMAT_VERSION)) ||
+		!writer.write(num_entries()) ||
+		(!sorted_entries.empty() &&
+		!writer.write(&sorted_entries[0], sorted_entries.size())) ||
+		(!pool_.empty() && !writer.write(&pool_[0], pool_.size())))
+	{
+		SSGNC_ERROR << "ssgnc::Writer::write() failed" << std::endl;
+		return false;
+	}
+
+	for (std::size_t i = 0; i < order.size(); ++i)
+	{
+		const Key &key = keys_[order[i]];
+		if (!key.empty() && !writer.write(&key[0], key.size()))
+		{
+			SSGNC_ERROR << "ssgnc::Writer::write() failed" << std::endl;
+			return false;
+		}
+	}
+	return true;
+}
+
+MaterializedResults::MaterializedResults() : num_entries_(0), entries_(NULL),
+	pool_(NULL), pool_size_(0), file_map_() {}
+
+MaterializedResults::~MaterializedResults()
+{
+	if (is_open())
+		close();
+}
+
+bool MaterializedResults::open(const Int8 *path, FileMap::Mode mode)
+{
+	if (is_open())
+	{
+		SSGNC_ERROR << "Already opened" << std::endl;
+		return false;
+	}
+
+	if (!file_map_.open(path, mode))
+	{
+		SSGNC_ERROR << "ssgnc::FileMap::open() failed: " << path << std::endl;
+		return false;
+	}
+
+	Mapper mapper;
+	const UInt32 *marker, *version, *num_entries;
+	if (!mapper.open(file_map_.ptr(), file_map_.size()) ||
+		!mapper.map(&marker) || !mapper.map(&version))
+	{
+		SSGNC_ERROR << "ssgnc::Mapper::map() failed: header" << std::endl;
+		close();
+		return false;
+	}
+	else if (*marker != FORMAT_MARKER || *version != FORMAT_VERSION)
+	{
+		SSGNC_ERROR << "Unsupported format, rebuild it by ssgnc-materialize: "
+			<< path << std::endl;
+		close();
+		return false;
+	}
+	else if (!mapper.map(&num_entries) ||
+		!mapper.map(&entries_, *num_entries))
+	{
+		SSGNC_ERROR << "ssgnc::Mapper::map() failed: header" << std::endl;
+		close();
+		return false;
+	}
+	num_entries_ = *num_entries;
+
+	pool_size_ = (file_map_.size() - mapper.tell()) / sizeof(Int32);
+	if (pool_size_ != 0 && !mapper.map(&pool_, pool_size_))
+	{
+		SSGNC_ERROR << "ssgnc::Mapper::map() failed: pool" << std::endl;
+		close();
+		return false;
+	}
+	else if (mapper.tell() != file_map_.size())
+	{
+		SSGNC_ERROR << "Extra bytes: "
+			<< (file_map_.size() - mapper.tell()) << std::endl;
+		close();
+		return false;
+	}
+
+	for (UInt32 i = 0; i < num_entries_; ++i)
+	{
+		const Entry &entry = entries_[i];
+		if (static_cast<UInt64>(entry.key_offset) + entry.key_length
+			> pool_size_ || entry.results_offset > pool_size_)
+		{
+			SSGNC_ERROR << "Out of range entry: " << i << std::endl;
+			close();
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool MaterializedResults::close()
+{
+	if (!is_open())
+	{
+		SSGNC_ERROR << "Not opened" << std::endl;
+		return false;
+	}
+
+	num_entries_ = 0;
+	entries_ = NULL;
+	pool_ = NULL;
+	pool_size_ = 0;
+	file_map_.close();
+	return true;
+}
+
+bool MaterializedResults::find(const Key &key, const Query &query,
+	Agent *agent, bool *is_found) const
+{
+	if (!is_open())
+	{
+		SSGNC_ERROR << "Not opened" << std::endl;
+		return false;
+	}
+	else if (agent == NULL || is_found == NULL)
+	{
+		SSGNC_ERROR << "Null pointer" << std::endl;
+		return false;
+	}
+
+	*is_found = false;
+
+	UInt32 begin = 0, end = num_entries_;
+	while (begin < end)
+	{
+		UInt32 middle = begin + ((end - begin) / 2);
+		if (compareKey(entries_[middle], key))
+			begin = middle + 1;
+		else
+			end = middle;
+	}
+	if (begin == num_entries_)
+		return true;
+
+	const Entry &entry = entries_[begin];
+	if (entry.key_length != key.size() || !std::equal(key.begin(), key.end(),
+		pool_ + entry.key_offset))
+		return true;
+
+	UInt64 num_results = entry.num_results;
+	if (query.max_num_results() != 0 &&
+		query.max_num_results() <= num_results)
+		num_results = query.max_num_results();
+	else if (entry.is_complete == 0)
+		return true;
+
+	// A cold search with the limits might stop before the stored results.
+	if ((query.io_limit() != 0 && (entry.total == MAX_COUNT ||
+		entry.total >= query.io_limit())) ||
+		(query.scan_limit() != 0 && (entry.num_scanned == MAX_COUNT ||
+		entry.num_scanned >= query.scan_limit())))
+		return true;
+
+	ResultCache::Results results;
+	std::vector<Int32> tokens;
+	UInt64 offset = entry.results_offset;
+	for (UInt64 i = 0; i < num_results; ++i)
+	{
+		if (offset + 2 > pool_size_ || pool_[offset + 1] < 0 ||
+			offset + 2 + pool_[offset + 1] > pool_size_)
+		{
+			SSGNC_ERROR << "Out of range result: " << offset << std::endl;
+			return false;
+		}
+
+		const Int32 *ptr = pool_ + offset;
+		try
+		{
+			tokens.assign(ptr + 2, ptr + 2 + ptr[1]);
+		}
+		catch (...)
+		{
+			SSGNC_ERROR << "std::vector<ssgnc::Int32>::assign() failed: "
+				<< ptr[1] << std::endl;
+			return false;
+		}
+
+		if (!results.append(static_cast<Int16>(ptr[0]), tokens))
+		{
+			SSGNC_ERROR << "ssgnc::ResultCache::Results::append() failed"
+				<< std::endl;
+			return false;
+		}
+		offset += 2 + ptr[1];
+	}
+
+	if (!agent->openCached(NULL, key, query, &results, entry.total,
+		entry.num_scanned, NULL))
+	{
+		SSGNC_ERROR << "ssgnc::Agent::openCached() failed" << std::endl;
+		return false;
+	}
+	*is_found = true;
+	return true;
+}
+
+// This function returns true if the key of an entry is less than a key.
+bool MaterializedResults::compareKey(const Entry &entry, const Key &key) const
+{
+	const Int32 *entry_key = pool_ + entry.key_offset;
+	return std::lexicographical_compare(entry_key,
+		entry_key + entry.key_length, key.begin(), key.end());
+}
+
+}  // namespace ssgnc
@@ -0,0 +1,273 @@
+#include "ssgnc/ngram-block.h"
+
+namespace ssgnc {
+
+bool NgramBlock::reset(NgramReader *ngram_reader)
+{
+	if (ngram_reader == NULL)
+	{
+		SSGNC_ERROR << "Null pointer" << std::endl;
+		return false;
+	}
+	else if (!ngram_reader->is_open())
+	{
+		SSGNC_ERROR << "Not opened reader" << std::endl;
+		return false;
+	}
+
+	clear();
+
+	std::size_t num_slots = static_cast<std::size_t>(
+		ngram_reader->num_tokens()) * MAX_SIZE;
+	try
+	{
+		if (tokens_.size() < num_slots)
+			tokens_.resize(num_slots);
+		if (encoded_freqs_.empty())
+		{
+			encoded_freqs_.resize(MAX_SIZE);
+			file_ids_.resize(MAX_SIZE);
+			offsets_.resize(MAX_SIZE);
+			tells_.resize(MAX_SIZE + 1);
+			matches_.resize(MAX_SIZE);
+			states_.resize(MAX_SIZE);
+			hits_.resize(MAX_SIZE);
+		}
+	}
+	catch (...)
+	{
+		SSGNC_ERROR << "std::vector::resize() failed: "
+			<< num_slots << std::endl;
+		return false;
+	}
+
+	ngram_reader_ = ngram_reader;
+	num_tokens_ = ngram_reader->num_tokens();
+	tells_[0] = ngram_reader->tell();
+	return true;
+}
+
+void NgramBlock::clear()
+{
+	ngram_reader_ = NULL;
+	num_tokens_ = 0;
+	size_ = 0;
+	pos_ = 0;
+}
+
+void NgramBlock::swap(NgramBlock *target)
+{
+	std::swap(ngram_reader_, target->ngram_reader_);
+	std::swap(num_tokens_, target->num_tokens_);
+	std::swap(size_, target->size_);
+	std::swap(pos_, target->pos_);
+	tokens_.swap(target->tokens_);
+	encoded_freqs_.swap(target->encoded_freqs_);
+	file_ids_.swap(target->file_ids_);
+	offsets_.swap(target->offsets_);
+	tells_.swap(target->tells_);
+	matches_.swap(target->matches_);
+	states_.swap(target->states_);
+	hits_.swap(target->hits_);
+}
+
+bool NgramBlock::read()
+{
+	if (ngram_reader_ == NULL)
+	{
+		SSGNC_ERROR << "No reader" << std::endl;
+		return false;
+	}
+	else if (full())
+	{
+		SSGNC_ERROR << "Full block: " << size_ << std::endl;
+		return false;
+	}
+
+	// The position of an n-gram is taken before its tokens are read, like
+	// Agent::save() takes the position of a reader.
+	file_ids_[size_] = ngram_reader_->file_id();
+	offsets_[size_] = ngram_reader_->offset();
+	if (!ngram_reader_->read(&encoded_freqs_[size_], &tokens_[size_],
+		MAX_SIZE))
+	{
+		SSGNC_ERROR << "ssgnc::NgramReader::read() failed" << std::endl;
+		return false;
+	}
+	tells_[size_ + 1] = ngram_reader_->tell();
+	++size_;
+	return true;
+}
+
+bool NgramBlock::filter(const Query &query)
+{
+	switch (query.order())
+	{
+	case Query::UNORDERED:
+		filterUnordered(query);
+		return true;
+	case Query::ORDERED:
+		filterOrdered(query);
+		return true;
+	case Query::PHRASE:
+		filterPhrase(query);
+		return true;
+	case Query::FIXED:
+		filterFixed(query);
+		return true;
+	default:
+		SSGNC_ERROR << "Undefined token order: " << query.order()
+			<< std::endl;
+		return false;
+	}
+}
+
+void NgramBlock::copyTokens(UInt32 index, Int32 *tokens) const
+{
+	for (Int32 i = 0; i < num_tokens_; ++i)
+		tokens[i] = tokens_[(i * MAX_SIZE) + index];
+}
+
+UInt64 NgramBlock::bytes_used() const
+{
+	return (sizeof(Int32) * tokens_.capacity())
+		+ (sizeof(Int16) * encoded_freqs_.capacity())
+		+ (sizeof(Int32) * file_ids_.capacity())
+		+ (sizeof(UInt64) * (offsets_.capacity() + tells_.capacity()))
+		+ (sizeof(UInt32) * (matches_.capacity() + states_.capacity()
+		+ hits_.capacity()));
+}
+
+// Each query token takes the first unused position which has the same
+// token. states_ has the used positions of each n-gram as a bit mask.
+void NgramBlock::filterUnordered(const Query &query)
+{
+	UInt32 *matches = &matches_[0];
+	UInt32 *masks = &states_[0];
+	UInt32 *hits = &hits_[0];
+	for (UInt32 i = 0; i < size_; ++i)
+	{
+		matches[i] = 1;
+		masks[i] = 0;
+	}
+
+	for (Int32 i = 0; i < query.num_tokens(); ++i)
+	{
+		Int32 token = query.token(i);
+		if (token == Query::META_TOKEN)
+			continue;
+
+		for (UInt32 k = 0; k < size_; ++k)
+			hits[k] = 0;
+		for (Int32 j = 0; j < num_tokens_; ++j)
+		{
+			const Int32 *tokens = column(j);
+			for (UInt32 k = 0; k < size_; ++k)
+			{
+				UInt32 hit = (hits[k] ^ 1) & (((masks[k] >> j) & 1) ^ 1)
+					& static_cast<UInt32>(tokens[k] == token);
+				masks[k] |= hit << j;
+				hits[k] |= hit;
+			}
+		}
+		for (UInt32 k = 0; k < size_; ++k)
+			matches[k] &= hits[k];
+	}
+}
+
+// states_ has the position from which the next query token is searched.
+void NgramBlock::filterOrdered(const Query &query)
+{
+	UInt32 *matches = &matches_[0];
+	UInt32 *starts = &states_[0];
+	UInt32 *hits = &hits_[0];
+	for (UInt32 i = 0; i < size_; ++i)
+	{
+		matches[i] = 1;
+		starts[i] = 0;
+	}
+
+	UInt32 num_tokens = static_cast<UInt32>(num_tokens_);
+	for (Int32 i = 0; i < query.num_tokens(); ++i)
+	{
+		Int32 token = query.token(i);
+		if (token == Query::META_TOKEN)
+		{
+			for (UInt32 k = 0; k < size_; ++k)
+			{
+				matches[k] &= static_cast<UInt32>(starts[k] < num_tokens);
+				++starts[k];
+			}
+			continue;
+		}
+
+		for (UInt32 k = 0; k < size_; ++k)
+			hits[k] = 0;
+		for (UInt32 j = 0; j < num_tokens; ++j)
+		{
+			const Int32 *tokens = column(j);
+			for (UInt32 k = 0; k < size_; ++k)
+			{
+				UInt32 hit = (hits[k] ^ 1)
+					& static_cast<UInt32>(j >= starts[k])
+					& static_cast<UInt32>(tokens[k] == token);
+				starts[k] += hit * (j + 1 - starts[k]);
+				hits[k] |= hit;
+			}
+		}
+		for (UInt32 k = 0; k < size_; ++k)
+			matches[k] &= hits[k];
+	}
+}
+
+// hits_ has the results of each start position of the phrase.
+void NgramBlock::filterPhrase(const Query &query)
+{
+	UInt32 *matches = &matches_[0];
+	UInt32 *hits = &hits_[0];
+	for (UInt32 i = 0; i < size_; ++i)
+		matches[i] = 0;
+
+	Int32 max_start = num_tokens_ - query.num_tokens();
+	for (Int32 start = 0; start <= max_start; ++start)
+	{
+		for (UInt32 k = 0; k < size_; ++k)
+			hits[k] = 1;
+		for (Int32 j = 0; j < query.num_tokens(); ++j)
+		{
+			Int32 token = query.token(j);
+			if (token == Query::META_TOKEN)
+				continue;
+
+			const Int32 *tokens = column(start + j);
+			for (UInt32 k = 0; k < size_; ++k)
+				hits[k] &= static_cast<UInt32>(tokens[k] == token);
+		}
+		for (UInt32 k = 0; k < size_; ++k)
+			matches[k] |= hits[k];
+	}
+}
+
+void NgramBlock::filterFixed(const Query &query)
+{
+	UInt32 *matches = &matches_[0];
+	UInt32 is_fixed = static_cast<UInt32>(
+		num_tokens_ == query.num_tokens());
+	for (UInt32 i = 0; i < size_; ++i)
+		matches[i] = is_fixed;
+	if (!is_fixed)
+		return;
+
+	for (Int32 i = 0; i < query.num_tokens(); ++i)
+	{
+		Int32 token = query.token(i);
+		if (token == Query::META_TOKEN)
+			continue;
+
+		const Int32 *tokens = column(i);
+		for (UInt32 k = 0; k < size_; ++k)
+			matches[k] &= static_cast<UInt32>(tokens[k] == token);
+	}
+}
+
+}  // namespace ssgnc
@@ -27,6 +27,41 @@ bool NgramIndex::FileEntry::set_offset(UInt32 offset)
 	return true;
 }
 
+bool NgramIndex::WideFileEntry::set_file_id(Int32 file_id)
+{
+	if (file_id < 0 || file_id > MAX_FILE_ID)
+	{
+		SSGNC_ERROR << "Out of range file ID: " << file_id << std::endl;
+		return false;
+	}
+	file_id_ = static_cast<UInt16>(file_id);
+	return true;
+}
+
+bool NgramIndex::WideFileEntry::set_offset(UInt64 offset)
+{
+	if (offset > MAX_WIDE_OFFSET)
+	{
+		SSGNC_ERROR << "Too large offset: " << offset << std::endl;
+		return false;
+	}
+	offset_lo_ = static_cast<UInt16>(offset & 0xFFFF);
+	offset_hi_ = static_cast<UInt32>(offset >> 16);
+	return true;
+}
+
+bool NgramIndex::FileEntry::set_key(UInt64 key)
+{
+	return set_file_id(static_cast<Int32>(key >> OFFSET_BITS))
+		&& set_offset(static_cast<UInt32>(key & MAX_OFFSET));
+}
+
+bool NgramIndex::WideFileEntry::set_key(UInt64 key)
+{
+	return set_file_id(static_cast<Int32>(key >> OFFSET_BITS))
+		&& set_offset(key & MAX_WIDE_OFFSET);
+}
+
 bool NgramIndex::Entry::set_file_id(Int32 file_id)
 {
 	if (file_id < 0 || file_id > MAX_FILE_ID)
@@ -38,9 +73,9 @@ bool NgramIndex::Entry::set_file_id(Int32 file_id)
 	return true;
 }
 
-bool NgramIndex::Entry::set_offset(UInt32 offset)
+bool NgramIndex::Entry::set_offset(UInt64 offset)
 {
-	if (offset > MAX_OFFSET)
+	if (offset > MAX_WIDE_OFFSET)
 	{
 		SSGNC_ERROR << "Too large offset: " << offset << std::endl;
 		return false;
@@ -62,7 +97,8 @@ bool NgramIndex::Entry::set_approx_size(Int64 approx_size)
 }
 
 NgramIndex::NgramIndex() : max_num_tokens_(0), max_token_id_(0),
-	entries_(NULL), file_map_() {}
+	format_(0), entries_(NULL), wide_entries_(NULL), sizes_(NULL),
+	sequences_(NULL), file_map_() {}
 
 NgramIndex::~NgramIndex()
 {
@@ -100,6 +136,44 @@ bool NgramIndex::open(const Int8 *path, FileMap::Mode mode)
 	return true;
 }
 
+// FNV-1a is applied to the size and the bytes of the sampled blocks. The
+// last block is always sampled, because it has the end of the index.
+UInt64 NgramIndex::fingerprint() const
+{
+	const UInt8 *ptr = static_cast<const UInt8 *>(file_map_.ptr());
+	UInt64 size = file_map_.size();
+
+	UInt64 hash = 14695981039346656037ULL;
+	for (Int32 i = 0; i < 8; ++i)
+	{
+		hash ^= (size >> (i * 8)) & 0xFF;
+		hash *= 1099511628211ULL;
+	}
+
+	UInt64 num_blocks = (size + FINGERPRINT_BLOCK_SIZE - 1)
+		/ FINGERPRINT_BLOCK_SIZE;
+	UInt64 step = (num_blocks + FINGERPRINT_BLOCKS - 1) / FINGERPRINT_BLOCKS;
+	for (UInt64 block = 0; block < num_blocks; )
+	{
+		UInt64 begin = block * FINGERPRINT_BLOCK_SIZE;
+		UInt64 end = begin + FINGERPRINT_BLOCK_SIZE;
+		if (end > size)
+			end = size;
+		for (UInt64 i = begin; i < end; ++i)
+		{
+			hash ^= ptr[i];
+			hash *= 1099511628211ULL;
+		}
+
+		if (block + 1 == num_blocks)
+			break;
+		block += step;
+		if (block >= num_blocks)
+			block = num_blocks - 1;
+	}
+	return hash;
+}
+
 bool NgramIndex::close()
 {
 	if (!is_open())
@@ -110,7 +184,12 @@ bool NgramIndex::close()
 
 	max_num_tokens_ = 0;
 	max_token_id_ = 0;
+	format_ = 0;
 	entries_ = NULL;
+	wide_entries_ = NULL;
+	sizes_ = NULL;
+	delete [] sequences_;
+	sequences_ = NULL;
 	file_map_.close();
 	return true;
 }
@@ -133,32 +212,76 @@ bool NgramIndex::get(Int32 num_tokens, Int32 token_id, Entry *entry) const
 		return false;
 	}
 
-	UInt32 index = (max_num_tokens_ * token_id) + num_tokens - 1;
-	if (!entry->set_file_id(entries_[index].file_id()))
+	if (is_elias_fano())
+	{
+		const EliasFano &sequence = sequences_[num_tokens - 1];
+		return is_wide() ? getEntry<WideFileEntry>(sequence, token_id, entry)
+			: getEntry<FileEntry>(sequence, token_id, entry);
+	}
+
+	UInt64 index = (static_cast<UInt64>(max_num_tokens_) * token_id)
+		+ num_tokens - 1;
+	if (is_sized())
+		return setEntry(wide_entries_[index], sizes_[index], entry);
+	return is_wide() ? getEntry(wide_entries_, index, entry)
+		: getEntry(entries_, index, entry);
+}
+
+template <typename T>
+bool NgramIndex::getEntry(const T *entries, UInt64 index, Entry *entry) const
+{
+	return getEntry(entries[index], entries[index + max_num_tokens_], entry);
+}
+
+template <typename T>
+bool NgramIndex::getEntry(const EliasFano &sequence, Int32 token_id,
+	Entry *entry) const
+{
+	T begin, end;
+	if (!begin.set_key(sequence[token_id]) ||
+		!end.set_key(sequence[token_id + 1]))
+	{
+		SSGNC_ERROR << "ssgnc::NgramIndex::FileEntry::set_key() failed: "
+			<< token_id << std::endl;
+		return false;
+	}
+	return getEntry(begin, end, entry);
+}
+
+template <typename T>
+bool NgramIndex::getEntry(const T &begin, const T &end, Entry *entry) const
+{
+	return setEntry(begin, end - begin, entry);
+}
+
+template <typename T>
+bool NgramIndex::setEntry(const T &begin, Int64 approx_size,
+	Entry *entry) const
+{
+	if (!entry->set_file_id(begin.file_id()))
 	{
 		SSGNC_ERROR << "ssgnc::NgramIndex::Entry::set_file_id() failed: "
-			<< entries_[index].file_id() << std::endl;
+			<< begin.file_id() << std::endl;
 		return false;
 	}
-	if (!entry->set_offset(entries_[index].offset()))
+	if (!entry->set_offset(begin.offset()))
 	{
 		SSGNC_ERROR << "ssgnc::NgramIndex::Entry::set_offset() failed: "
-			<< entries_[index].offset() << std::endl;
+			<< begin.offset() << std::endl;
 		return false;
 	}
 
-	Int64 diff = entries_[index + max_num_tokens_] - entries_[index];
-	if (!entry->set_approx_size(diff))
+	if (!entry->set_approx_size(approx_size))
 	{
 		SSGNC_ERROR << "ssgnc::NgramIndex::Entry::set_approx_size() failed: "
-			<< diff << std::endl;
+			<< approx_size << std::endl;
 		return false;
 	}
 
 	return true;
 }
 
-bool NgramIndex::mapData(const void *ptr, UInt32 size)
+bool NgramIndex::mapData(const void *ptr, UInt64 size)
 {
 	Mapper mapper;
 	if (!mapper.open(ptr, size))
@@ -168,35 +291,132 @@ bool NgramIndex::mapData(const void *ptr, UInt32 size)
 	}
 
 	const Int32 *max_num_tokens, *max_token_id;
-	if (!mapper.map(&max_num_tokens) || !mapper.map(&max_token_id))
+	if (!mapper.map(&max_num_tokens))
+	{
+		SSGNC_ERROR << "ssgnc::Mapper::map() failed: header" << std::endl;
+		return false;
+	}
+
+	Int32 format = 0;
+	if (*max_num_tokens == FORMAT_MARKER)
+	{
+		const Int32 *format_flags;
+		if (!mapper.map(&format_flags) || !mapper.map(&max_num_tokens))
+		{
+			SSGNC_ERROR << "ssgnc::Mapper::map() failed: header" << std::endl;
+			return false;
+		}
+		else if (*format_flags == 0 || (*format_flags & ~FORMAT_MASK) != 0 ||
+			((*format_flags & SIZED_FORMAT) != 0 &&
+			(*format_flags & FORMAT_MASK) != (WIDE_FORMAT | SIZED_FORMAT)))
+		{
+			SSGNC_ERROR << "Unknown format: " << *format_flags << std::endl;
+			return false;
+		}
+		format = *format_flags;
+	}
+
+	if (!mapper.map(&max_token_id))
 	{
 		SSGNC_ERROR << "ssgnc::Mapper::map() failed: header" << std::endl;
 		return false;
 	}
-	else if (*max_num_tokens == 0 || *max_token_id == 0)
+	else if (*max_num_tokens <= 0 || *max_token_id <= 0)
 	{
 		SSGNC_ERROR << "Wrong header" << std::endl;
 		return false;
 	}
 
-	UInt32 num_entries = *max_num_tokens * (*max_token_id + 2);
-	const FileEntry *entries;
-	if (!mapper.map(&entries, num_entries))
+	const FileEntry *entries = NULL;
+	const WideFileEntry *wide_entries = NULL;
+	const UInt32 *sizes = NULL;
+	EliasFano *sequences = NULL;
+	if ((format & ELIAS_FANO_FORMAT) != 0)
 	{
-		SSGNC_ERROR << "ssgnc::Mapper::map() failed: entries" << std::endl;
-		return false;
+		if (!mapSequences(&mapper, *max_num_tokens, *max_token_id, &sequences))
+		{
+			SSGNC_ERROR << "ssgnc::NgramIndex::mapSequences() failed"
+				<< std::endl;
+			return false;
+		}
+	}
+	else if ((format & SIZED_FORMAT) != 0)
+	{
+		UInt64 num_entries = static_cast<UInt64>(*max_num_tokens)
+			* (static_cast<UInt64>(*max_token_id) + 1);
+		if (!mapper.map(&wide_entries, num_entries) ||
+			!mapper.map(&sizes, num_entries))
+		{
+			SSGNC_ERROR << "ssgnc::Mapper::map() failed: entries" << std::endl;
+			return false;
+		}
+	}
+	else
+	{
+		UInt64 num_entries = static_cast<UInt64>(*max_num_tokens)
+			* (static_cast<UInt64>(*max_token_id) + 2);
+		if ((format & WIDE_FORMAT) != 0
+			? !mapper.map(&wide_entries, num_entries)
+			: !mapper.map(&entries, num_entries))
+		{
+			SSGNC_ERROR << "ssgnc::Mapper::map() failed: entries" << std::endl;
+			return false;
+		}
 	}
 
 	if (mapper.tell() != size)
 	{
 		SSGNC_ERROR << "Extra bytes: " << (size - mapper.tell()) << std::endl;
+		delete [] sequences;
 		return false;
 	}
 
 	max_num_tokens_ = *max_num_tokens;
 	max_token_id_ = *max_token_id;
+	format_ = format;
 	entries_ = entries;
+	wide_entries_ = wide_entries;
+	sizes_ = sizes;
+	sequences_ = sequences;
+
+	return true;
+}
+
+bool NgramIndex::mapSequences(Mapper *mapper, Int32 max_num_tokens,
+	Int32 max_token_id, EliasFano **sequences)
+{
+	EliasFano *new_sequences;
+	try
+	{
+		new_sequences = new EliasFano[max_num_tokens];
+	}
+	catch (...)
+	{
+		SSGNC_ERROR << "new ssgnc::EliasFano[] failed: "
+			<< max_num_tokens << std::endl;
+		return false;
+	}
+
+	for (Int32 i = 0; i < max_num_tokens; ++i)
+	{
+		if (!new_sequences[i].map(mapper))
+		{
+			SSGNC_ERROR << "ssgnc::EliasFano::map() failed: "
+				<< (i + 1) << std::endl;
+			delete [] new_sequences;
+			return false;
+		}
+		else if (new_sequences[i].num_values()
+			!= static_cast<UInt64>(max_token_id) + 2)
+		{
+			SSGNC_ERROR << "Wrong number of keys: "
+				<< new_sequences[i].num_values() << std::endl;
+			delete [] new_sequences;
+			return false;
+		}
+	}
 
+	*sequences = new_sequences;
 	return true;
 }
 
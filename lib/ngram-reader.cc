@@ -1,8 +1,65 @@
 #include "ssgnc/freq-handler.h"
 #include "ssgnc/ngram-reader.h"
 
+#include <algorithm>
+#include <cerrno>
+
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
 namespace ssgnc {
 
+bool NgramReader::PendingRead::prefetch() const
+{
+	if (empty())
+	{
+		SSGNC_ERROR << "No pending read" << std::endl;
+		return false;
+	}
+
+	int result = ::posix_fadvise(fd_, static_cast<off_t>(offset_),
+		static_cast<off_t>(length_), POSIX_FADV_WILLNEED);
+	if (result != 0)
+	{
+		SSGNC_ERROR << "::posix_fadvise() failed: " << result << std::endl;
+		return false;
+	}
+	return true;
+}
+
+bool NgramReader::PendingRead::load() const
+{
+	if (empty())
+	{
+		SSGNC_ERROR << "No pending read" << std::endl;
+		return false;
+	}
+
+	char buf[4 << 10];
+	UInt64 offset = offset_;
+	UInt64 end = offset_ + length_;
+	while (offset < end)
+	{
+		std::size_t size = static_cast<std::size_t>(
+			std::min(static_cast<UInt64>(sizeof(buf)), end - offset));
+		ssize_t result = ::pread(fd_, buf, size,
+			static_cast<off_t>(offset));
+		if (result < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			SSGNC_ERROR << "::pread() failed: " << fd_ << ", "
+				<< offset << std::endl;
+			return false;
+		}
+		else if (result == 0)
+			break;
+		offset += result;
+	}
+	return true;
+}
+
 NgramReader::~NgramReader()
 {
 	if (is_open())
@@ -11,6 +68,24 @@ NgramReader::~NgramReader()
 
 bool NgramReader::open(const String &index_dir, Int32 num_tokens,
 	const NgramIndex::Entry &entry, Int16 min_encoded_freq)
+{
+	return open(index_dir, NULL, num_tokens, entry, min_encoded_freq);
+}
+
+bool NgramReader::open(const ShardMap &shard_map, Int32 num_tokens,
+	const NgramIndex::Entry &entry, Int16 min_encoded_freq)
+{
+	if (!shard_map.is_open())
+	{
+		SSGNC_ERROR << "Not opened shard map" << std::endl;
+		return false;
+	}
+	return open(shard_map.index_dir(), &shard_map, num_tokens, entry,
+		min_encoded_freq);
+}
+
+bool NgramReader::open(const String &index_dir, const ShardMap *shard_map,
+	Int32 num_tokens, const NgramIndex::Entry &entry, Int16 min_encoded_freq)
 {
 	if (is_open())
 	{
@@ -24,27 +99,89 @@ bool NgramReader::open(const String &index_dir, Int32 num_tokens,
 		return false;
 	}
 
-	StringBuilder basename;
-	if (!basename.appendf("%dgm-%%04d.db", num_tokens))
+	if (!openFile(index_dir, shard_map, num_tokens, entry.file_id(),
+		entry.offset()))
+	{
+		SSGNC_ERROR << "ssgnc::NgramReader::openFile() failed" << std::endl;
+		return false;
+	}
+
+	// A list which starts a new file has the end of the previous file as its
+	// start position.
+	if (!readEncodedFreq() && (byte_reader_.bad() ||
+		!openNextFile() || !readEncodedFreq()))
+	{
+		SSGNC_ERROR << "ssgnc::NgramReader::readEncodedFreq() failed: "
+			<< std::endl;
+		close();
+		return false;
+	}
+
+	min_encoded_freq_ = min_encoded_freq;
+
+	return true;
+}
+
+bool NgramReader::resume(const ShardMap &shard_map, Int32 num_tokens,
+	Int32 file_id, UInt64 offset, Int16 encoded_freq, Int16 min_encoded_freq)
+{
+	if (is_open())
+	{
+		SSGNC_ERROR << "Already opened" << std::endl;
+		return false;
+	}
+	else if (!shard_map.is_open())
+	{
+		SSGNC_ERROR << "Not opened shard map" << std::endl;
+		return false;
+	}
+	else if (min_encoded_freq <= 0 || encoded_freq < min_encoded_freq)
+	{
+		SSGNC_ERROR << "Invalid encoded freq: " << encoded_freq
+			<< ", " << min_encoded_freq << std::endl;
+		return false;
+	}
+
+	if (!openFile(shard_map.index_dir(), &shard_map, num_tokens, file_id,
+		offset))
+	{
+		SSGNC_ERROR << "ssgnc::NgramReader::openFile() failed" << std::endl;
+		return false;
+	}
+
+	encoded_freq_ = encoded_freq;
+	min_encoded_freq_ = min_encoded_freq;
+
+	return true;
+}
+
+bool NgramReader::openFile(const String &index_dir, const ShardMap *shard_map,
+	Int32 num_tokens, Int32 file_id, UInt64 offset)
+{
+	basename_.clear();
+	if (!basename_.appendf("%dgm-%%04d.db", num_tokens))
 	{
 		SSGNC_ERROR << "ssgnc::StringBuilder::appendf() failed" << std::endl;
 		return false;
 	}
 
-	if (!file_path_.open(index_dir, basename.str()))
+	if (!file_path_.open(index_dir, basename_.str()))
 	{
 		SSGNC_ERROR << "ssgnc::FilePath::open() failed: "
-			<< index_dir << ", " << basename << std::endl;
+			<< index_dir << ", " << basename_ << std::endl;
 		return false;
 	}
-	else if (!file_path_.seek(entry.file_id()))
+	else if (!file_path_.seek(file_id))
 	{
 		SSGNC_ERROR << "ssgnc::FilePath::seek() failed: "
-			<< entry.file_id() << std::endl;
+			<< file_id << std::endl;
 		close();
 		return false;
 	}
 
+	num_tokens_ = num_tokens;
+	shard_map_ = shard_map;
+
 	if (!openNextFile())
 	{
 		SSGNC_ERROR << "ssgnc::NgramReader::openNextFile() failed"
@@ -53,24 +190,14 @@ bool NgramReader::open(const String &index_dir, Int32 num_tokens,
 		return false;
 	}
 
-	if (entry.offset() != 0 && !file_.seekg(entry.offset()))
+	if (offset != 0 && !file_.seekg(static_cast<std::streamoff>(offset)))
 	{
-		SSGNC_ERROR << "ssgnc::ifstream::seek() failed: "
-			<< entry.offset() << std::endl;
+		SSGNC_ERROR << "std::istream::seekg() failed: "
+			<< offset << std::endl;
 		close();
 		return false;
 	}
-
-	if (!readEncodedFreq())
-	{
-		SSGNC_ERROR << "ssgnc::NgramReader::readEncodedFreq() failed: "
-			<< std::endl;
-		close();
-		return false;
-	}
-
-	num_tokens_ = num_tokens;
-	min_encoded_freq_ = min_encoded_freq;
+	file_offset_ = offset;
 
 	return true;
 }
@@ -84,11 +211,14 @@ bool NgramReader::close()
 	}
 
 	num_tokens_ = 0;
+	shard_map_ = NULL;
 	file_path_.close();
-	if (file_.is_open())
-		file_.close();
+	if (file_buf_.is_open())
+		file_buf_.close();
+	file_.clear();
 	if (byte_reader_.is_open())
 		byte_reader_.close();
+	file_offset_ = 0;
 	min_encoded_freq_ = 1;
 	encoded_freq_ = -1;
 	total_ = 0;
@@ -97,29 +227,54 @@ bool NgramReader::close()
 
 bool NgramReader::read(Int16 *encoded_freq, std::vector<Int32> *tokens)
 {
-	if (!is_open())
+	if (tokens == NULL)
 	{
-		SSGNC_ERROR << "Not opened" << std::endl;
+		SSGNC_ERROR << "Null pointer" << std::endl;
 		return false;
 	}
-	else if (encoded_freq == NULL)
+
+	tokens->clear();
+	if (is_open() && good())
 	{
-		SSGNC_ERROR << "Null pointer" << std::endl;
+		try
+		{
+			tokens->resize(num_tokens_);
+		}
+		catch (...)
+		{
+			SSGNC_ERROR << "std::vector<ssgnc::Int32>::resize() failed: "
+				<< sizeof(Int32) << " * " << num_tokens_ << std::endl;
+			return false;
+		}
+	}
+
+	return read(encoded_freq, tokens->empty() ? NULL : &(*tokens)[0]);
+}
+
+bool NgramReader::read(Int16 *encoded_freq, Int32 *tokens, Int32 stride)
+{
+	if (!is_open())
+	{
+		SSGNC_ERROR << "Not opened" << std::endl;
 		return false;
 	}
-	else if (tokens == NULL)
+	else if (encoded_freq == NULL)
 	{
 		SSGNC_ERROR << "Null pointer" << std::endl;
 		return false;
 	}
 
 	*encoded_freq = encoded_freq_;
-	tokens->clear();
 
 	if (fail())
 		return false;
+	else if (tokens == NULL)
+	{
+		SSGNC_ERROR << "Null pointer" << std::endl;
+		return false;
+	}
 
-	if (!readTokens(tokens))
+	if (!readTokens(tokens, stride))
 	{
 		SSGNC_ERROR << "ssgnc::NgramReader::readTokens() failed" << std::endl;
 		return false;
@@ -153,24 +308,95 @@ bool NgramReader::read(Int16 *encoded_freq, std::vector<Int32> *tokens)
 	return true;
 }
 
+bool NgramReader::isReady(PendingRead *pending_read)
+{
+	if (pending_read == NULL)
+	{
+		SSGNC_ERROR << "Null pointer" << std::endl;
+		return false;
+	}
+
+	// An n-gram and the encoded frequency of the next n-gram are read from
+	// the buffer if it has enough bytes.
+	pending_read->clear();
+	if (!is_open() || fail() || byte_reader_.avail() >=
+		static_cast<UInt32>((num_tokens_ * ByteReader::MAX_TOKEN_LENGTH)
+		+ ByteReader::MAX_FREQ_LENGTH))
+		return true;
+
+	return probe(pending_read);
+}
+
+// The next fill of the byte reader is tested by reading one byte of each
+// page of the range with RWF_NOWAIT, which fails with EAGAIN if the page is
+// not resident. The fill itself is left to the byte reader, so the bytes
+// are not read twice.
+bool NgramReader::probe(PendingRead *pending_read)
+{
+#ifdef RWF_NOWAIT
+	int fd = file_buf_.fd();
+	off_t offset = ::lseek(fd, 0, SEEK_CUR);
+	if (offset < 0)
+		return true;
+
+	off_t end = offset + BYTE_READER_BUF_SIZE;
+	while (offset < end)
+	{
+		char byte;
+		struct iovec iov;
+		iov.iov_base = &byte;
+		iov.iov_len = 1;
+		ssize_t size = ::preadv2(fd, &iov, 1, offset, RWF_NOWAIT);
+		if (size < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			else if (errno == EAGAIN)
+			{
+				pending_read->set(fd, static_cast<UInt64>(offset),
+					static_cast<UInt32>(end - offset));
+				return false;
+			}
+			// Reads are not tested if RWF_NOWAIT is not supported.
+			return true;
+		}
+		else if (size == 0)
+			break;
+
+		offset = ((offset / PROBE_INTERVAL) + 1) * PROBE_INTERVAL;
+	}
+#endif  // RWF_NOWAIT
+	return true;
+}
+
 bool NgramReader::openNextFile()
 {
-	StringBuilder path;
-	if (!file_path_.read(&path))
+	if (shard_map_ != NULL ? !file_path_.read(shard_map_->dirname(
+		shard_map_->find(num_tokens_, file_path_.tell())), &path_)
+		: !file_path_.read(&path_))
 	{
 		encoded_freq_ = -1;
 		SSGNC_ERROR << "ssgnc::FilePath::read() failed" << std::endl;
 		return false;
 	}
 
-	if (file_.is_open())
-		file_.close();
-	file_.open(path.ptr(), std::ios::binary);
-	if (!file_)
+	if (file_buf_.is_open())
+		file_buf_.close();
+	file_.clear();
+
+	int fd = ::open(path_.ptr(), O_RDONLY);
+	if (fd == -1)
+	{
+		encoded_freq_ = -1;
+		SSGNC_ERROR << "::open() failed: " << path_.str() << std::endl;
+		return false;
+	}
+	else if (!file_buf_.open(fd, FILE_BUF_SIZE))
 	{
+		::close(fd);
 		encoded_freq_ = -1;
-		SSGNC_ERROR << "std::ifstream::open() failed: "
-			<< path.str() << std::endl;
+		SSGNC_ERROR << "ssgnc::FdStreambuf::open() failed: "
+			<< path_.str() << std::endl;
 		return false;
 	}
 
@@ -179,6 +405,7 @@ bool NgramReader::openNextFile()
 		total_ += byte_reader_.tell();
 		byte_reader_.close();
 	}
+	file_offset_ = 0;
 	if (!byte_reader_.open(&file_, BYTE_READER_BUF_SIZE))
 	{
 		encoded_freq_ = -1;
@@ -204,22 +431,11 @@ bool NgramReader::readEncodedFreq()
 	return true;
 }
 
-bool NgramReader::readTokens(std::vector<Int32> *tokens)
+bool NgramReader::readTokens(Int32 *tokens, Int32 stride)
 {
-	try
-	{
-		tokens->resize(num_tokens_);
-	}
-	catch (...)
-	{
-		SSGNC_ERROR << "std::vector<ssgnc::Int32>::resize() failed: "
-			<< sizeof(Int32) << " * " << num_tokens_ << std::endl;
-		return false;
-	}
-
 	for (Int32 i = 0; i < num_tokens_; ++i)
 	{
-		if (!byte_reader_.readToken(&(*tokens)[i]))
+		if (!byte_reader_.readToken(&tokens[i * stride]))
 		{
 			encoded_freq_ = -1;
 			SSGNC_ERROR << "ssgnc::ByteReader::readToken() failed"
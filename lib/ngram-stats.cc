@@ -0,0 +1,522 @@
+#include "ssgnc/ngram-stats.h"
+#include "ssgnc/mapper.h"
+#include "ssgnc/writer.h"
+
+#include <algorithm>
+
+namespace ssgnc {
+
+namespace {
+
+// The hashes are sorted at least once in this number of pairs.
+enum { MIN_PAIR_HASH_BUF_SIZE = 1 << 20 };
+
+}  // namespace
+
+void NgramStats::Sketch::clear()
+{
+	for (Int32 i = 0; i < SKETCH_DEPTH; ++i)
+	{
+		for (Int32 j = 0; j < SKETCH_WIDTH; ++j)
+			counts[i][j] = 0;
+	}
+}
+
+void NgramStats::Sketch::add(const Int32 *tokens, Int32 num_tokens)
+{
+	for (Int32 i = 0; i < num_tokens; ++i)
+	{
+		for (Int32 j = 0; j < SKETCH_DEPTH; ++j)
+		{
+			UInt32 &count = counts[j][hash(j, tokens[i], i)];
+			if (count < MAX_LIST_SIZE)
+				++count;
+		}
+	}
+}
+
+UInt32 NgramStats::Sketch::count(Int32 token_id, Int32 position) const
+{
+	UInt32 min_count = counts[0][hash(0, token_id, position)];
+	for (Int32 i = 1; i < SKETCH_DEPTH; ++i)
+	{
+		UInt32 count = counts[i][hash(i, token_id, position)];
+		if (count < min_count)
+			min_count = count;
+	}
+	return min_count;
+}
+
+// The rows use multiplicative hashing with different odd multipliers, and
+// the upper bits of the products are taken as the columns.
+UInt32 NgramStats::Sketch::hash(Int32 row, Int32 token_id, Int32 position)
+{
+	static const UInt64 MULTIPLIERS[] = {
+		0x9E3779B97F4A7C15ULL, 0xC2B2AE3D27D4EB4FULL
+	};
+
+	UInt64 key = (static_cast<UInt64>(static_cast<UInt32>(token_id)) << 8)
+		+ static_cast<UInt32>(position);
+	return static_cast<UInt32>((key * MULTIPLIERS[row])
+		>> (64 - SKETCH_WIDTH_BITS));
+}
+
+// The tokens are mixed with the order by the finalizer of MurmurHash3.
+UInt64 NgramStats::PairFilter::hash(Int32 num_tokens, Int32 token_id,
+	Int32 token_id2)
+{
+	if (token_id > token_id2)
+		std::swap(token_id, token_id2);
+
+	UInt64 key = (static_cast<UInt64>(static_cast<UInt32>(token_id)) << 32)
+		| static_cast<UInt32>(token_id2);
+	key ^= static_cast<UInt64>(num_tokens) * 0x9E3779B97F4A7C15ULL;
+	key ^= key >> 33;
+	key *= 0xFF51AFD7ED558CCDULL;
+	key ^= key >> 33;
+	key *= 0xC4CEB9FE1A85EC53ULL;
+	key ^= key >> 33;
+	return key;
+}
+
+bool NgramStats::Builder::init(Int32 max_num_tokens, Int32 max_token_id)
+{
+	if (max_num_tokens <= 0)
+	{
+		SSGNC_ERROR << "Out of range #tokens: " << max_num_tokens << std::endl;
+		return false;
+	}
+	else if (max_token_id < 0)
+	{
+		SSGNC_ERROR << "Out of range token ID: " << max_token_id << std::endl;
+		return false;
+	}
+
+	clear();
+
+	std::size_t num_lists = static_cast<std::size_t>(max_num_tokens)
+		* (static_cast<std::size_t>(max_token_id) + 1);
+	try
+	{
+		num_ngrams_.resize(max_num_tokens, 0);
+		list_sizes_.resize(num_lists, 0);
+	}
+	catch (...)
+	{
+		SSGNC_ERROR << "std::vector::resize() failed: " << num_lists
+			<< std::endl;
+		clear();
+		return false;
+	}
+
+	max_num_tokens_ = max_num_tokens;
+	max_token_id_ = max_token_id;
+	return true;
+}
+
+void NgramStats::Builder::clear()
+{
+	max_num_tokens_ = 0;
+	max_token_id_ = 0;
+	scan_cost_ = 0;
+	index_size_ = 0;
+	index_fingerprint_ = 0;
+	num_ngrams_.clear();
+	list_sizes_.clear();
+	histograms_.clear();
+	sketches_.clear();
+	pair_hashes_.clear();
+	num_sorted_pair_hashes_ = 0;
+}
+
+bool NgramStats::Builder::appendList(Int32 num_tokens, Int32 token_id,
+	const UInt64 *freq_counts, const Sketch &sketch,
+	UInt64 num_first_ngrams)
+{
+	if (num_tokens < 1 || num_tokens > max_num_tokens_)
+	{
+		SSGNC_ERROR << "Out of range #tokens: " << num_tokens << std::endl;
+		return false;
+	}
+	else if (token_id < 0 || token_id > max_token_id_)
+	{
+		SSGNC_ERROR << "Out of range token ID: " << token_id << std::endl;
+		return false;
+	}
+	else if (freq_counts == NULL)
+	{
+		SSGNC_ERROR << "Null pointer" << std::endl;
+		return false;
+	}
+	else if (!histograms_.empty() &&
+		(histograms_.back().num_tokens > num_tokens ||
+		(histograms_.back().num_tokens == num_tokens &&
+		histograms_.back().token_id >= token_id)))
+	{
+		SSGNC_ERROR << "Wrong order: " << num_tokens << ", " << token_id
+			<< std::endl;
+		return false;
+	}
+
+	UInt64 num_ngrams = 0;
+	for (Int32 i = 0; i < NUM_FREQ_BUCKETS; ++i)
+		num_ngrams += freq_counts[i];
+
+	if (num_ngrams >= MIN_HISTOGRAM_SIZE)
+	{
+		Histogram histogram;
+		histogram.num_tokens = num_tokens;
+		histogram.token_id = token_id;
+		for (Int32 i = 0; i < NUM_FREQ_BUCKETS; ++i)
+		{
+			histogram.freq_counts[i] = static_cast<UInt32>(
+				(freq_counts[i] < MAX_LIST_SIZE) ?
+				freq_counts[i] : MAX_LIST_SIZE);
+		}
+
+		try
+		{
+			histograms_.push_back(histogram);
+			sketches_.push_back(sketch);
+		}
+		catch (...)
+		{
+			SSGNC_ERROR << "std::vector::push_back() failed: "
+				<< histograms_.size() << std::endl;
+			if (histograms_.size() > sketches_.size())
+				histograms_.pop_back();
+			return false;
+		}
+	}
+
+	UInt64 index = (static_cast<UInt64>(max_num_tokens_) * token_id)
+		+ num_tokens - 1;
+	list_sizes_[index] = static_cast<UInt32>(
+		(num_ngrams < MAX_LIST_SIZE) ? num_ngrams : MAX_LIST_SIZE);
+	num_ngrams_[num_tokens - 1] += num_first_ngrams;
+	return true;
+}
+
+bool NgramStats::Builder::appendPairs(const Int32 *tokens,
+	Int32 num_tokens)
+{
+	if (num_tokens < 1 || num_tokens > max_num_tokens_)
+	{
+		SSGNC_ERROR << "Out of range #tokens: " << num_tokens << std::endl;
+		return false;
+	}
+	else if (tokens == NULL)
+	{
+		SSGNC_ERROR << "Null pointer" << std::endl;
+		return false;
+	}
+
+	try
+	{
+		for (Int32 i = 0; i < num_tokens; ++i)
+		{
+			for (Int32 j = i + 1; j < num_tokens; ++j)
+			{
+				if (tokens[i] == tokens[j])
+					continue;
+
+				pair_hashes_.push_back(
+					PairFilter::hash(num_tokens, tokens[i], tokens[j]));
+			}
+		}
+	}
+	catch (...)
+	{
+		SSGNC_ERROR << "std::vector::push_back() failed: "
+			<< pair_hashes_.size() << std::endl;
+		return false;
+	}
+
+	if (pair_hashes_.size() - num_sorted_pair_hashes_ >=
+		std::max(num_sorted_pair_hashes_,
+		static_cast<std::size_t>(MIN_PAIR_HASH_BUF_SIZE)))
+		sortPairHashes();
+	return true;
+}
+
+void NgramStats::Builder::sortPairHashes()
+{
+	std::sort(pair_hashes_.begin(), pair_hashes_.end());
+	pair_hashes_.erase(std::unique(pair_hashes_.begin(), pair_hashes_.end()),
+		pair_hashes_.end());
+	num_sorted_pair_hashes_ = pair_hashes_.size();
+}
+
+// The size is a power of 2, so that the positions are masked.
+UInt32 NgramStats::Builder::pairFilterSizeBits(UInt64 num_pairs)
+{
+	UInt32 size_bits = MIN_PAIR_FILTER_SIZE_BITS;
+	while (size_bits < MAX_PAIR_FILTER_SIZE_BITS &&
+		(1ULL << size_bits) < num_pairs * PAIR_FILTER_BITS_PER_PAIR)
+		++size_bits;
+	return size_bits;
+}
+
+bool NgramStats::Builder::write(std::ostream *stream)
+{
+	if (stream == NULL)
+	{
+		SSGNC_ERROR << "Null pointer" << std::endl;
+		return false;
+	}
+	else if (max_num_tokens_ == 0)
+	{
+		SSGNC_ERROR << "Not initialized" << std::endl;
+		return false;
+	}
+
+	Header header;
+	header.max_num_tokens = max_num_tokens_;
+	header.max_token_id = max_token_id_;
+	header.num_freq_buckets = NUM_FREQ_BUCKETS;
+	header.num_histograms = num_histograms();
+	header.sketch_depth = SKETCH_DEPTH;
+	header.sketch_width = SKETCH_WIDTH;
+	header.scan_cost = scan_cost_;
+	header.index_size = index_size_;
+	header.index_fingerprint = index_fingerprint_;
+
+	sortPairHashes();
+	header.num_pairs = pair_hashes_.size();
+	header.pair_filter_size_bits = pairFilterSizeBits(header.num_pairs);
+
+	std::vector<UInt64> pair_filter;
+	try
+	{
+		pair_filter.resize(static_cast<std::size_t>(1)
+			<< (header.pair_filter_size_bits - 6), 0);
+	}
+	catch (...)
+	{
+		SSGNC_ERROR << "std::vector::resize() failed: "
+			<< header.pair_filter_size_bits << std::endl;
+		return false;
+	}
+
+	UInt64 mask = (1ULL << header.pair_filter_size_bits) - 1;
+	for (std::size_t i = 0; i < pair_hashes_.size(); ++i)
+	{
+		for (Int32 j = 0; j < PAIR_FILTER_NUM_HASHES; ++j)
+		{
+			UInt64 position = PairFilter::position(pair_hashes_[i], j) & mask;
+			pair_filter[position >> 6] |= 1ULL << (position & 63);
+		}
+	}
+
+	header.pair_filter_num_set_bits = 0;
+	for (std::size_t i = 0; i < pair_filter.size(); ++i)
+	{
+		header.pair_filter_num_set_bits +=
+			__builtin_popcountll(pair_filter[i]);
+	}
+
+	Writer writer;
+	if (!writer.open(stream))
+	{
+		SSGNC_ERROR << "ssgnc::Writer::open() failed" << std::endl;
+		return false;
+	}
+
+	if (!writer.write(header) ||
+		!writer.write(&num_ngrams_[0], num_ngrams_.size()) ||
+		!writer.write(&list_sizes_[0], list_sizes_.size()) ||
+		(!histograms_.empty() &&
+		(!writer.write(&histograms_[0], histograms_.size()) ||
+		!writer.write(&sketches_[0], sketches_.size()))) ||
+		!writer.write(&pair_filter[0], pair_filter.size()))
+	{
+		SSGNC_ERROR << "ssgnc::Writer::write() failed" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+NgramStats::NgramStats() : max_num_tokens_(0), max_token_id_(0),
+	scan_cost_(0), index_size_(0), index_fingerprint_(0), num_pairs_(0),
+	num_histograms_(0), num_ngrams_(NULL), list_sizes_(NULL),
+	histograms_(NULL), sketches_(NULL), pair_filter_mask_(0),
+	pair_filter_num_set_bits_(0), pair_filter_(NULL), file_map_() {}
+
+NgramStats::~NgramStats()
+{
+	if (is_open())
+		close();
+}
+
+bool NgramStats::open(const Int8 *path, FileMap::Mode mode)
+{
+	if (is_open())
+	{
+		SSGNC_ERROR << "Already opened" << std::endl;
+		return false;
+	}
+
+	if (!file_map_.open(path, mode))
+	{
+		SSGNC_ERROR << "ssgnc::FileMap::open() failed: " << path << std::endl;
+		return false;
+	}
+
+	Mapper mapper;
+	const Header *header;
+	if (!mapper.open(file_map_.ptr(), file_map_.size()) ||
+		!mapper.map(&header))
+	{
+		SSGNC_ERROR << "ssgnc::Mapper::map() failed: header" << std::endl;
+		close();
+		return false;
+	}
+	else if (header->max_num_tokens <= 0 || header->max_token_id < 0 ||
+		header->num_freq_buckets != NUM_FREQ_BUCKETS ||
+		header->sketch_depth != SKETCH_DEPTH ||
+		header->sketch_width != SKETCH_WIDTH ||
+		(header->pair_filter_size_bits != 0 &&
+		(header->pair_filter_size_bits < MIN_PAIR_FILTER_SIZE_BITS ||
+		header->pair_filter_size_bits > MAX_PAIR_FILTER_SIZE_BITS ||
+		header->pair_filter_num_set_bits >
+		(1ULL << header->pair_filter_size_bits))))
+	{
+		SSGNC_ERROR << "Wrong header: " << header->max_num_tokens << ", "
+			<< header->max_token_id << ", " << header->num_freq_buckets
+			<< ", " << header->sketch_depth << ", " << header->sketch_width
+			<< ", " << header->pair_filter_size_bits << std::endl;
+		close();
+		return false;
+	}
+
+	UInt64 num_lists = static_cast<UInt64>(header->max_num_tokens)
+		* (static_cast<UInt64>(header->max_token_id) + 1);
+	if (!mapper.map(&num_ngrams_, header->max_num_tokens) ||
+		!mapper.map(&list_sizes_, num_lists) ||
+		(header->num_histograms != 0 &&
+		(!mapper.map(&histograms_, header->num_histograms) ||
+		!mapper.map(&sketches_, header->num_histograms))) ||
+		(header->pair_filter_size_bits != 0 &&
+		!mapper.map(&pair_filter_, static_cast<std::size_t>(1)
+		<< (header->pair_filter_size_bits - 6))))
+	{
+		SSGNC_ERROR << "ssgnc::Mapper::map() failed: lists" << std::endl;
+		close();
+		return false;
+	}
+	else if (mapper.tell() != file_map_.size())
+	{
+		SSGNC_ERROR << "Extra bytes: "
+			<< (file_map_.size() - mapper.tell()) << std::endl;
+		close();
+		return false;
+	}
+
+	max_num_tokens_ = header->max_num_tokens;
+	max_token_id_ = header->max_token_id;
+	scan_cost_ = header->scan_cost;
+	index_size_ = header->index_size;
+	index_fingerprint_ = header->index_fingerprint;
+	num_pairs_ = header->num_pairs;
+	num_histograms_ = header->num_histograms;
+	if (pair_filter_ != NULL)
+	{
+		pair_filter_mask_ = (1ULL << header->pair_filter_size_bits) - 1;
+		pair_filter_num_set_bits_ = header->pair_filter_num_set_bits;
+	}
+	return true;
+}
+
+bool NgramStats::close()
+{
+	if (!is_open())
+	{
+		SSGNC_ERROR << "Not opened" << std::endl;
+		return false;
+	}
+
+	max_num_tokens_ = 0;
+	max_token_id_ = 0;
+	scan_cost_ = 0;
+	index_size_ = 0;
+	index_fingerprint_ = 0;
+	num_pairs_ = 0;
+	num_histograms_ = 0;
+	num_ngrams_ = NULL;
+	list_sizes_ = NULL;
+	histograms_ = NULL;
+	sketches_ = NULL;
+	pair_filter_mask_ = 0;
+	pair_filter_num_set_bits_ = 0;
+	pair_filter_ = NULL;
+	file_map_.close();
+	return true;
+}
+
+bool NgramStats::mayHavePair(Int32 num_tokens, Int32 token_id,
+	Int32 token_id2) const
+{
+	if (pair_filter_ == NULL || token_id == token_id2)
+		return true;
+
+	UInt64 hash = PairFilter::hash(num_tokens, token_id, token_id2);
+	for (Int32 i = 0; i < PAIR_FILTER_NUM_HASHES; ++i)
+	{
+		UInt64 position = PairFilter::position(hash, i) & pair_filter_mask_;
+		if ((pair_filter_[position >> 6] & (1ULL << (position & 63))) == 0)
+			return false;
+	}
+	return true;
+}
+
+bool NgramStats::get(Int32 num_tokens, Int32 token_id, Entry *entry) const
+{
+	if (num_tokens < 1 || num_tokens > max_num_tokens_)
+	{
+		SSGNC_ERROR << "Out of range #tokens: " << num_tokens << std::endl;
+		return false;
+	}
+	else if (token_id < 0 || token_id > max_token_id_)
+	{
+		SSGNC_ERROR << "Out of range token ID: " << token_id << std::endl;
+		return false;
+	}
+	else if (entry == NULL)
+	{
+		SSGNC_ERROR << "Null pointer" << std::endl;
+		return false;
+	}
+
+	UInt64 index = (static_cast<UInt64>(max_num_tokens_) * token_id)
+		+ num_tokens - 1;
+	entry->set_num_ngrams(list_sizes_[index]);
+	entry->set_freq_counts(NULL);
+	entry->set_sketch(NULL);
+	if (list_sizes_[index] < MIN_HISTOGRAM_SIZE)
+		return true;
+
+	// The histograms are sorted by their orders and tokens.
+	UInt32 begin = 0, end = num_histograms_;
+	while (begin < end)
+	{
+		UInt32 middle = begin + ((end - begin) / 2);
+		const Histogram &histogram = histograms_[middle];
+		if (histogram.num_tokens < num_tokens ||
+			(histogram.num_tokens == num_tokens &&
+			histogram.token_id < token_id))
+			begin = middle + 1;
+		else
+			end = middle;
+	}
+
+	if (begin < num_histograms_ &&
+		histograms_[begin].num_tokens == num_tokens &&
+		histograms_[begin].token_id == token_id)
+	{
+		entry->set_freq_counts(histograms_[begin].freq_counts);
+		entry->set_sketch(&sketches_[begin]);
+	}
+	return true;
+}
+
+}  // namespace ssgnc
@@ -0,0 +1,419 @@
+#include "ssgnc/planner.h"
+
+namespace ssgnc {
+
+void Planner::Explanation::clear()
+{
+	access_ = NO_SOURCES;
+	has_stats_ = false;
+	scan_cost_ = 0;
+	estimates_.clear();
+}
+
+double Planner::Explanation::num_scans() const
+{
+	double num_scans = 0.0;
+	for (std::size_t i = 0; i < estimates_.size(); ++i)
+		num_scans += estimates_[i].num_scans;
+	return num_scans;
+}
+
+double Planner::Explanation::num_bytes() const
+{
+	double num_bytes = 0.0;
+	for (std::size_t i = 0; i < estimates_.size(); ++i)
+		num_bytes += estimates_[i].num_bytes;
+	return num_bytes;
+}
+
+double Planner::Explanation::num_matches() const
+{
+	double num_matches = 0.0;
+	for (std::size_t i = 0; i < estimates_.size(); ++i)
+		num_matches += estimates_[i].num_matches;
+	return num_matches;
+}
+
+double Planner::Explanation::num_total_matches() const
+{
+	double num_total_matches = 0.0;
+	for (std::size_t i = 0; i < estimates_.size(); ++i)
+		num_total_matches += estimates_[i].num_total_matches;
+	return num_total_matches;
+}
+
+bool Planner::Explanation::write(std::ostream *stream) const
+{
+	if (stream == NULL)
+	{
+		SSGNC_ERROR << "Null pointer" << std::endl;
+		return false;
+	}
+
+	*stream << "access: " << accessName(access_)
+		<< (has_stats_ ? " (stats)" : " (no stats)") << '\n';
+	for (std::size_t i = 0; i < estimates_.size(); ++i)
+	{
+		const Estimate &estimate = estimates_[i];
+		*stream << "list: " << estimate.num_tokens << "-gram, token "
+			<< estimate.token_id << ", " << estimate.approx_size << " bytes, ";
+		if (has_stats_)
+		{
+			*stream << estimate.num_ngrams << " n-grams, density "
+				<< estimate.density << ", scans " << estimate.num_scans;
+		}
+		else
+			*stream << "? n-grams, density ?, scans ?";
+		*stream << ", bytes " << estimate.num_bytes << ", matches ";
+		if (has_stats_)
+			*stream << estimate.num_matches << '\n';
+		else
+			*stream << "?\n";
+	}
+
+	*stream << "total: " << estimates_.size() << " lists, scans ";
+	if (has_stats_)
+		*stream << num_scans();
+	else
+		*stream << '?';
+	*stream << ", bytes " << num_bytes() << ", matches ";
+	if (has_stats_)
+	{
+		*stream << num_matches() << " of " << num_total_matches()
+			<< ", time " << search_time() << "us\n";
+	}
+	else
+		*stream << "?\n";
+
+	if (!*stream)
+	{
+		SSGNC_ERROR << "std::ostream::operator<<() failed" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+const char *Planner::Explanation::accessName(Access access)
+{
+	switch (access)
+	{
+	case NO_SOURCES:
+		return "no-sources";
+	case MATERIALIZED_RESULTS:
+		return "materialized-results";
+	case LISTS:
+		return "lists";
+	default:
+		return "unknown";
+	}
+}
+
+bool Planner::plan(const Query &query, Int32 min_num_tokens,
+	Int32 max_num_tokens, std::vector<Agent::Source> *sources,
+	std::vector<Estimate> *estimates) const
+{
+	if (ngram_index_ == NULL || !ngram_index_->is_open())
+	{
+		SSGNC_ERROR << "Not opened" << std::endl;
+		return false;
+	}
+	else if (sources == NULL)
+	{
+		SSGNC_ERROR << "Null pointer" << std::endl;
+		return false;
+	}
+
+	sources->clear();
+	if (estimates != NULL)
+		estimates->clear();
+
+	// A query with an unknown token has no source.
+	for (Int32 i = 0; i < query.num_tokens(); ++i)
+	{
+		if (query.token(i) == Query::UNKNOWN_TOKEN)
+			return true;
+	}
+
+	bool has_stats = this->has_stats();
+	for (Int32 i = min_num_tokens; i <= max_num_tokens; ++i)
+	{
+		// An order is skipped if a pair of the tokens never co-occurs.
+		if (has_stats && !hasPairs(query, i))
+			continue;
+
+		NgramIndex::Entry min_entry;
+		NgramStats::Entry min_stats;
+		Int32 min_token = Query::META_TOKEN;
+		for (Int32 j = 0; j < query.num_tokens(); ++j)
+		{
+			Int32 token = query.token(j);
+			if (token == Query::META_TOKEN)
+				continue;
+
+			NgramIndex::Entry entry;
+			if (!ngram_index_->get(i, token, &entry))
+			{
+				SSGNC_ERROR << "ssgnc::NgramIndex::get() failed" << std::endl;
+				return false;
+			}
+
+			// The exact number of n-grams is compared first, and the bytes
+			// break ties.
+			NgramStats::Entry stats;
+			if (has_stats && !ngram_stats_->get(i, token, &stats))
+			{
+				SSGNC_ERROR << "ssgnc::NgramStats::get() failed" << std::endl;
+				return false;
+			}
+
+			if (min_entry.approx_size() == 0 ||
+				stats.num_ngrams() < min_stats.num_ngrams() ||
+				(stats.num_ngrams() == min_stats.num_ngrams() &&
+				entry.approx_size() < min_entry.approx_size()))
+			{
+				min_entry = entry;
+				min_stats = stats;
+				min_token = token;
+			}
+		}
+
+		// An empty list has only its terminator.
+		if (min_entry.approx_size() <= 1 ||
+			(has_stats && min_stats.num_ngrams() == 0))
+			continue;
+
+		try
+		{
+			sources->push_back(Agent::Source(i, min_token, min_entry));
+		}
+		catch (...)
+		{
+			SSGNC_ERROR << "std::vector<ssgnc::Agent::Source>::"
+				"push_back(): " << sources->size() << std::endl;
+			return false;
+		}
+
+		if (estimates == NULL)
+			continue;
+
+		Estimate estimate;
+		estimate.num_tokens = i;
+		estimate.token_id = min_token;
+		estimate.approx_size = min_entry.approx_size();
+		estimate.num_ngrams = min_stats.num_ngrams();
+		estimate.freq_counts = min_stats.freq_counts();
+		estimate.sketch = min_stats.sketch();
+		estimate.density = 1.0;
+		estimate.num_scans = 0.0;
+		estimate.num_bytes = 0.0;
+		estimate.num_matches = 0.0;
+		estimate.num_total_matches = 0.0;
+		if (has_stats && !estimateDensity(query, &estimate))
+		{
+			SSGNC_ERROR << "ssgnc::Planner::estimateDensity() failed"
+				<< std::endl;
+			return false;
+		}
+
+		try
+		{
+			estimates->push_back(estimate);
+		}
+		catch (...)
+		{
+			SSGNC_ERROR << "std::vector<ssgnc::Planner::Estimate>::"
+				"push_back(): " << estimates->size() << std::endl;
+			return false;
+		}
+	}
+
+	if (estimates != NULL)
+		estimate(query, estimates);
+	return true;
+}
+
+void Planner::estimate(const Query &query, std::vector<Estimate> *estimates)
+{
+	Int32 min_bucket = 0;
+	if (query.min_encoded_freq() > 0)
+		min_bucket = NgramStats::freqBucket(query.min_encoded_freq());
+
+	// The search stops at the minimum frequency. A list without a histogram
+	// is small, so it is regarded as read to the end.
+	double total_matches = 0.0;
+	double limit = static_cast<double>(query.max_num_results());
+	for (std::size_t i = 0; i < estimates->size(); ++i)
+	{
+		Estimate &estimate = (*estimates)[i];
+		if (estimate.freq_counts == NULL)
+		{
+			estimate.num_scans = static_cast<double>(estimate.num_ngrams);
+			limit -= estimate.num_scans * estimate.density;
+		}
+		else
+		{
+			estimate.num_scans = 0.0;
+			for (Int32 j = min_bucket; j < NgramStats::NUM_FREQ_BUCKETS; ++j)
+				estimate.num_scans += estimate.freq_counts[j];
+		}
+		estimate.num_total_matches = estimate.num_scans * estimate.density;
+		total_matches += estimate.num_total_matches;
+	}
+
+	if (query.max_num_results() != 0 &&
+		total_matches > static_cast<double>(query.max_num_results()))
+	{
+		if (limit < 0.0)
+			limit = 0.0;
+
+		Int32 bucket = NgramStats::NUM_FREQ_BUCKETS - 1;
+		double num_matches = 0.0;
+		double bucket_matches = 0.0;
+		for ( ; bucket >= min_bucket; --bucket)
+		{
+			bucket_matches = 0.0;
+			for (std::size_t i = 0; i < estimates->size(); ++i)
+			{
+				const Estimate &estimate = (*estimates)[i];
+				if (estimate.freq_counts != NULL)
+				{
+					bucket_matches += estimate.freq_counts[bucket]
+						* estimate.density;
+				}
+			}
+			if (num_matches + bucket_matches >= limit)
+				break;
+			num_matches += bucket_matches;
+		}
+
+		// The n-grams of the last bucket are read in proportion to the rest
+		// of the limit.
+		if (bucket >= min_bucket)
+		{
+			double ratio = (bucket_matches > 0.0) ?
+				((limit - num_matches) / bucket_matches) : 0.0;
+			for (std::size_t i = 0; i < estimates->size(); ++i)
+			{
+				Estimate &estimate = (*estimates)[i];
+				if (estimate.freq_counts == NULL)
+					continue;
+
+				estimate.num_scans = ratio * estimate.freq_counts[bucket];
+				for (Int32 j = bucket + 1; j < NgramStats::NUM_FREQ_BUCKETS;
+					++j)
+					estimate.num_scans += estimate.freq_counts[j];
+			}
+		}
+	}
+
+	// A list without the statistics is regarded as read to the end.
+	double total_scans = 0.0;
+	double total_bytes = 0.0;
+	for (std::size_t i = 0; i < estimates->size(); ++i)
+	{
+		Estimate &estimate = (*estimates)[i];
+		if (estimate.num_ngrams == 0)
+			estimate.num_bytes = static_cast<double>(estimate.approx_size);
+		else
+		{
+			estimate.num_bytes = estimate.num_scans * estimate.approx_size
+				/ estimate.num_ngrams;
+		}
+		total_scans += estimate.num_scans;
+		total_bytes += estimate.num_bytes;
+	}
+
+	// The scan limit and the I/O limit are shared by the lists.
+	double scale = 1.0;
+	if (query.scan_limit() != 0 &&
+		total_scans > static_cast<double>(query.scan_limit()))
+		scale = static_cast<double>(query.scan_limit()) / total_scans;
+	if (query.io_limit() != 0 &&
+		total_bytes * scale > static_cast<double>(query.io_limit()))
+		scale = static_cast<double>(query.io_limit()) / total_bytes;
+
+	for (std::size_t i = 0; i < estimates->size(); ++i)
+	{
+		Estimate &estimate = (*estimates)[i];
+		estimate.num_scans *= scale;
+		estimate.num_bytes *= scale;
+		estimate.num_matches = estimate.num_scans * estimate.density;
+	}
+}
+
+bool Planner::hasPairs(const Query &query, Int32 num_tokens) const
+{
+	if (!ngram_stats_->has_pair_filter() ||
+		ngram_stats_->is_pair_filter_saturated())
+		return true;
+
+	for (Int32 i = 0; i < query.num_tokens(); ++i)
+	{
+		if (query.token(i) < 0)
+			continue;
+
+		for (Int32 j = i + 1; j < query.num_tokens(); ++j)
+		{
+			if (query.token(j) >= 0 && !ngram_stats_->mayHavePair(
+				num_tokens, query.token(i), query.token(j)))
+				return false;
+		}
+	}
+	return true;
+}
+
+// The density is the product of the ratios of the n-grams which contain the
+// other tokens of the query. The chosen token is excluded once. A sketch
+// gives the n-grams of the list which have a token, and the positions of
+// tokens are taken into account for a query of the fixed order.
+bool Planner::estimateDensity(const Query &query, Estimate *estimate) const
+{
+	UInt64 num_ngrams = ngram_stats_->num_ngrams(estimate->num_tokens);
+	if (num_ngrams == 0 || estimate->num_ngrams == 0)
+	{
+		estimate->density = 0.0;
+		return true;
+	}
+
+	bool is_excluded = false;
+	for (Int32 i = 0; i < query.num_tokens(); ++i)
+	{
+		Int32 token = query.token(i);
+		if (token == Query::META_TOKEN)
+			continue;
+		else if (token == estimate->token_id && !is_excluded)
+		{
+			is_excluded = true;
+			continue;
+		}
+
+		NgramStats::Entry stats;
+		if (!ngram_stats_->get(estimate->num_tokens, token, &stats))
+		{
+			SSGNC_ERROR << "ssgnc::NgramStats::get() failed" << std::endl;
+			return false;
+		}
+
+		double ratio;
+		if (estimate->sketch != NULL)
+		{
+			UInt64 count = 0;
+			if (query.order() == Query::FIXED)
+				count = estimate->sketch->count(token, i);
+			else
+			{
+				for (Int32 j = 0; j < estimate->num_tokens; ++j)
+					count += estimate->sketch->count(token, j);
+			}
+			if (count > stats.num_ngrams())
+				count = stats.num_ngrams();
+			ratio = static_cast<double>(count) / estimate->num_ngrams;
+		}
+		else
+			ratio = static_cast<double>(stats.num_ngrams()) / num_ngrams;
+		estimate->density *= (ratio < 1.0) ? ratio : 1.0;
+	}
+	return true;
+}
+
+}  // namespace ssgnc
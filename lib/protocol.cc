@@ -0,0 +1,380 @@
+#include "ssgnc/protocol.h"
+
+namespace ssgnc {
+
+bool Protocol::writeQuery(Writer *writer, const Query &query)
+{
+	if (writer == NULL)
+	{
+		SSGNC_ERROR << "Null pointer" << std::endl;
+		return false;
+	}
+
+	if (!writer->write(static_cast<Int32>(QUERY_MARKER)) ||
+		!writeOptions(writer, query) || !writer->write(query.num_tokens()))
+	{
+		SSGNC_ERROR << "ssgnc::Writer::write() failed: header" << std::endl;
+		return false;
+	}
+
+	for (Int32 i = 0; i < query.num_tokens(); ++i)
+	{
+		if (!writer->write(query.token(i)))
+		{
+			SSGNC_ERROR << "ssgnc::Writer::write() failed: token" << std::endl;
+			return false;
+		}
+	}
+	return true;
+}
+
+bool Protocol::readQuery(Reader *reader, Query *query)
+{
+	if (reader == NULL)
+	{
+		SSGNC_ERROR << "Null pointer" << std::endl;
+		return false;
+	}
+	else if (query == NULL)
+	{
+		SSGNC_ERROR << "Null pointer" << std::endl;
+		return false;
+	}
+
+	Int32 marker, num_tokens;
+	if (!reader->read(&marker))
+	{
+		SSGNC_ERROR << "ssgnc::Reader::read() failed: marker" << std::endl;
+		return false;
+	}
+	else if (marker != QUERY_MARKER)
+	{
+		SSGNC_ERROR << "Wrong marker: " << marker << std::endl;
+		return false;
+	}
+
+	query->clear();
+	if (!readOptions(reader, query))
+	{
+		SSGNC_ERROR << "ssgnc::Protocol::readOptions() failed" << std::endl;
+		return false;
+	}
+	else if (!reader->read(&num_tokens))
+	{
+		SSGNC_ERROR << "ssgnc::Reader::read() failed: #tokens" << std::endl;
+		return false;
+	}
+	else if (num_tokens < 0 || num_tokens > Query::MAX_NUM_TOKENS)
+	{
+		SSGNC_ERROR << "Out of range #tokens: " << num_tokens << std::endl;
+		return false;
+	}
+
+	for (Int32 i = 0; i < num_tokens; ++i)
+	{
+		Int32 token;
+		if (!reader->read(&token))
+		{
+			SSGNC_ERROR << "ssgnc::Reader::read() failed: token" << std::endl;
+			return false;
+		}
+		else if (!query->appendToken(token))
+		{
+			SSGNC_ERROR << "ssgnc::Query::appendToken() failed: "
+				<< token << std::endl;
+			return false;
+		}
+	}
+	return true;
+}
+
+bool Protocol::writeResult(Writer *writer, Int16 encoded_freq,
+	const std::vector<Int32> &tokens, UInt64 total)
+{
+	if (writer == NULL)
+	{
+		SSGNC_ERROR << "Null pointer" << std::endl;
+		return false;
+	}
+	else if (encoded_freq <= END_OF_RESULTS)
+	{
+		SSGNC_ERROR << "Out of range encoded freq: "
+			<< encoded_freq << std::endl;
+		return false;
+	}
+
+	if (!writer->write(encoded_freq) || !writer->write(total) ||
+		!writer->write(static_cast<Int32>(tokens.size())) ||
+		(!tokens.empty() && !writer->write(&tokens[0], tokens.size())))
+	{
+		SSGNC_ERROR << "ssgnc::Writer::write() failed" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+bool Protocol::writeEnd(Writer *writer, bool is_ok, UInt64 total)
+{
+	if (writer == NULL)
+	{
+		SSGNC_ERROR << "Null pointer" << std::endl;
+		return false;
+	}
+
+	Int16 encoded_freq = is_ok ? END_OF_RESULTS : ERROR_OF_RESULTS;
+	if (!writer->write(encoded_freq) || !writer->write(total))
+	{
+		SSGNC_ERROR << "ssgnc::Writer::write() failed" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+bool Protocol::readResult(Reader *reader, Int16 *encoded_freq,
+	std::vector<Int32> *tokens, UInt64 *total)
+{
+	if (reader == NULL)
+	{
+		SSGNC_ERROR << "Null pointer" << std::endl;
+		return false;
+	}
+	else if (encoded_freq == NULL || tokens == NULL || total == NULL)
+	{
+		SSGNC_ERROR << "Null pointer" << std::endl;
+		return false;
+	}
+
+	tokens->clear();
+	if (!reader->read(encoded_freq) || !reader->read(total))
+	{
+		SSGNC_ERROR << "ssgnc::Reader::read() failed" << std::endl;
+		return false;
+	}
+	else if (*encoded_freq <= END_OF_RESULTS)
+		return true;
+
+	Int32 num_tokens;
+	if (!reader->read(&num_tokens))
+	{
+		SSGNC_ERROR << "ssgnc::Reader::read() failed" << std::endl;
+		return false;
+	}
+	else if (num_tokens <= 0 || num_tokens > Query::MAX_NUM_TOKENS)
+	{
+		SSGNC_ERROR << "Out of range #tokens: " << num_tokens << std::endl;
+		return false;
+	}
+
+	try
+	{
+		tokens->resize(num_tokens);
+	}
+	catch (...)
+	{
+		SSGNC_ERROR << "std::vector<ssgnc::Int32>::resize() failed: "
+			<< num_tokens << std::endl;
+		return false;
+	}
+
+	if (!reader->read(&(*tokens)[0], tokens->size()))
+	{
+		SSGNC_ERROR << "ssgnc::Reader::read() failed" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+bool Protocol::writeRequest(Writer *writer, const Query &options,
+	const String &query_str)
+{
+	if (writer == NULL)
+	{
+		SSGNC_ERROR << "Null pointer" << std::endl;
+		return false;
+	}
+
+	if (!writer->write(static_cast<Int32>(REQUEST_MARKER)) ||
+		!writeOptions(writer, options) || !writeString(writer, query_str))
+	{
+		SSGNC_ERROR << "ssgnc::Writer::write() failed" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+bool Protocol::readRequest(Reader *reader, Query *options,
+	StringBuilder *query_str)
+{
+	if (reader == NULL)
+	{
+		SSGNC_ERROR << "Null pointer" << std::endl;
+		return false;
+	}
+	else if (options == NULL || query_str == NULL)
+	{
+		SSGNC_ERROR << "Null pointer" << std::endl;
+		return false;
+	}
+
+	Int32 marker;
+	if (!reader->read(&marker))
+	{
+		SSGNC_ERROR << "ssgnc::Reader::read() failed: marker" << std::endl;
+		return false;
+	}
+	else if (marker != REQUEST_MARKER)
+	{
+		SSGNC_ERROR << "Wrong marker: " << marker << std::endl;
+		return false;
+	}
+
+	options->clear();
+	if (!readOptions(reader, options))
+	{
+		SSGNC_ERROR << "ssgnc::Protocol::readOptions() failed" << std::endl;
+		return false;
+	}
+
+	Int32 length;
+	if (!readString(reader, &length, query_str) || length < 0)
+	{
+		SSGNC_ERROR << "ssgnc::Protocol::readString() failed" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+bool Protocol::writeNgram(Writer *writer, const String &ngram)
+{
+	if (writer == NULL)
+	{
+		SSGNC_ERROR << "Null pointer" << std::endl;
+		return false;
+	}
+
+	if (!writeString(writer, ngram))
+	{
+		SSGNC_ERROR << "ssgnc::Protocol::writeString() failed" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+bool Protocol::writeEndOfNgrams(Writer *writer, bool is_ok)
+{
+	if (writer == NULL)
+	{
+		SSGNC_ERROR << "Null pointer" << std::endl;
+		return false;
+	}
+
+	Int32 length = is_ok ? END_OF_NGRAMS : ERROR_OF_NGRAMS;
+	if (!writer->write(length))
+	{
+		SSGNC_ERROR << "ssgnc::Writer::write() failed" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+bool Protocol::readNgram(Reader *reader, Int32 *length, StringBuilder *ngram)
+{
+	if (reader == NULL)
+	{
+		SSGNC_ERROR << "Null pointer" << std::endl;
+		return false;
+	}
+	else if (length == NULL || ngram == NULL)
+	{
+		SSGNC_ERROR << "Null pointer" << std::endl;
+		return false;
+	}
+
+	if (!readString(reader, length, ngram))
+	{
+		SSGNC_ERROR << "ssgnc::Protocol::readString() failed" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+bool Protocol::writeOptions(Writer *writer, const Query &query)
+{
+	return writer->write(static_cast<Int32>(query.order())) &&
+		writer->write(query.min_encoded_freq()) &&
+		writer->write(query.min_num_tokens()) &&
+		writer->write(query.max_num_tokens()) &&
+		writer->write(query.max_num_results()) &&
+		writer->write(query.io_limit()) &&
+		writer->write(query.time_limit()) &&
+		writer->write(query.scan_limit());
+}
+
+bool Protocol::readOptions(Reader *reader, Query *query)
+{
+	Int32 order, min_num_tokens, max_num_tokens;
+	Int16 min_encoded_freq;
+	UInt64 max_num_results, io_limit, time_limit, scan_limit;
+	if (!reader->read(&order) || !reader->read(&min_encoded_freq) ||
+		!reader->read(&min_num_tokens) || !reader->read(&max_num_tokens) ||
+		!reader->read(&max_num_results) || !reader->read(&io_limit) ||
+		!reader->read(&time_limit) || !reader->read(&scan_limit))
+	{
+		SSGNC_ERROR << "ssgnc::Reader::read() failed" << std::endl;
+		return false;
+	}
+
+	if (!query->set_order(static_cast<Query::TokenOrder>(order)) ||
+		!query->set_min_encoded_freq(min_encoded_freq) ||
+		!query->set_min_num_tokens(min_num_tokens) ||
+		!query->set_max_num_tokens(max_num_tokens) ||
+		!query->set_max_num_results(static_cast<Int64>(max_num_results)) ||
+		!query->set_io_limit(static_cast<Int64>(io_limit)) ||
+		!query->set_time_limit(static_cast<Int64>(time_limit)) ||
+		!query->set_scan_limit(static_cast<Int64>(scan_limit)))
+	{
+		SSGNC_ERROR << "ssgnc::Query::set_*() failed" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+bool Protocol::writeString(Writer *writer, const String &str)
+{
+	return writer->write(static_cast<Int32>(str.length())) &&
+		(str.empty() || writer->write(str.ptr(), str.length()));
+}
+
+// A negative length is a marker and no string follows it.
+bool Protocol::readString(Reader *reader, Int32 *length, StringBuilder *str)
+{
+	str->clear();
+	if (!reader->read(length))
+	{
+		SSGNC_ERROR << "ssgnc::Reader::read() failed: length" << std::endl;
+		return false;
+	}
+	else if (*length > MAX_STRING_LENGTH)
+	{
+		SSGNC_ERROR << "Too long string: " << *length << std::endl;
+		return false;
+	}
+
+	else if (*length <= 0)
+		return true;
+
+	if (!str->resize(*length))
+	{
+		SSGNC_ERROR << "ssgnc::StringBuilder::resize() failed: "
+			<< *length << std::endl;
+		return false;
+	}
+	else if (!reader->read(str->buf(), *length))
+	{
+		SSGNC_ERROR << "ssgnc::Reader::read() failed: string" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+}  // namespace ssgnc
@@ -4,8 +4,8 @@ namespace ssgnc {
 
 Query::Query() : tokens_(), min_freq_(MIN_FREQ),
 	min_encoded_freq_(MIN_ENCODED_FREQ), min_num_tokens_(0),
-	max_num_tokens_(0), max_num_results_(0), io_limit_(0),
-	order_(DEFAULT_ORDER), freq_handler_() {}
+	max_num_tokens_(0), max_num_results_(0), io_limit_(0), time_limit_(0),
+	scan_limit_(0), order_(DEFAULT_ORDER), freq_handler_() {}
 
 void Query::clear()
 {
@@ -16,6 +16,8 @@ void Query::clear()
 	max_num_tokens_ = 0;
 	max_num_results_ = 0;
 	io_limit_ = 0;
+	time_limit_ = 0;
+	scan_limit_ = 0;
 	order_ = DEFAULT_ORDER;
 }
 
@@ -43,6 +45,8 @@ bool Query::clone(Query *dest) const
 	dest->max_num_tokens_ = max_num_tokens_;
 	dest->max_num_results_ = max_num_results_;
 	dest->io_limit_ = io_limit_;
+	dest->time_limit_ = time_limit_;
+	dest->scan_limit_ = scan_limit_;
 	dest->order_ = order_;
 
 	return true;
@@ -163,6 +167,30 @@ bool Query::set_io_limit(Int64 value)
 	return true;
 }
 
+bool Query::set_time_limit(Int64 value)
+{
+	if (value < MIN_TIME_LIMIT || value > MAX_TIME_LIMIT)
+	{
+		SSGNC_ERROR << "Out of range time limit: " << value << std::endl;
+		return false;
+	}
+
+	time_limit_ = static_cast<UInt64>(value);
+	return true;
+}
+
+bool Query::set_scan_limit(Int64 value)
+{
+	if (value < MIN_SCAN_LIMIT || value > MAX_SCAN_LIMIT)
+	{
+		SSGNC_ERROR << "Out of range scan limit: " << value << std::endl;
+		return false;
+	}
+
+	scan_limit_ = static_cast<UInt64>(value);
+	return true;
+}
+
 bool Query::set_order(TokenOrder value)
 {
 	switch (value)
@@ -329,6 +357,8 @@ bool Query::parseKeyValue(const String &key, const String &value)
 	static const String MAX_NUM_RESULTS_OPTION_KEY =
 		"--ssgnc-max-num-results";
 	static const String IO_LIMIT_OPTION_KEY = "--ssgnc-io-limit";
+	static const String TIME_LIMIT_OPTION_KEY = "--ssgnc-time-limit";
+	static const String SCAN_LIMIT_OPTION_KEY = "--ssgnc-scan-limit";
 	static const String ORDER_OPTION_KEY = "--ssgnc-order";
 
 	if (key == "f" || key == MIN_FREQ_OPTION_KEY)
@@ -385,6 +415,24 @@ bool Query::parseKeyValue(const String &key, const String &value)
 			return false;
 		}
 	}
+	else if (key == TIME_LIMIT_OPTION_KEY)
+	{
+		if (!parseTimeLimit(value))
+		{
+			SSGNC_ERROR << "ssgnc::Query::parseTimeLimit() failed: "
+				<< value << std::endl;
+			return false;
+		}
+	}
+	else if (key == SCAN_LIMIT_OPTION_KEY)
+	{
+		if (!parseScanLimit(value))
+		{
+			SSGNC_ERROR << "ssgnc::Query::parseScanLimit() failed: "
+				<< value << std::endl;
+			return false;
+		}
+	}
 	else if (key == "o" || key == ORDER_OPTION_KEY)
 	{
 		if (!parseOrder(value))
@@ -530,6 +578,38 @@ bool Query::parseIOLimit(const String &str)
 	return true;
 }
 
+bool Query::parseTimeLimit(const String &str)
+{
+	Int64 value;
+	if (!parseInt(str, &value))
+	{
+		SSGNC_ERROR << "ssgnc::Query::parseInt() failed: " << str << std::endl;
+		return false;
+	}
+	else if (!set_time_limit(value))
+	{
+		SSGNC_ERROR << "ssgnc::Query::set_time_limit: " << value << std::endl;
+		return false;
+	}
+	return true;
+}
+
+bool Query::parseScanLimit(const String &str)
+{
+	Int64 value;
+	if (!parseInt(str, &value))
+	{
+		SSGNC_ERROR << "ssgnc::Query::parseInt() failed: " << str << std::endl;
+		return false;
+	}
+	else if (!set_scan_limit(value))
+	{
+		SSGNC_ERROR << "ssgnc::Query::set_scan_limit: " << value << std::endl;
+		return false;
+	}
+	return true;
+}
+
 bool Query::parseOrder(const String &str)
 {
 	if (str.empty())
@@ -583,6 +663,10 @@ bool Query::showOptions(std::ostream *out)
 		<< '[' << MIN_NUM_RESULTS << '-' << MAX_NUM_RESULTS << "]\n"
 		<< "  --ssgnc-io-limit="
 		<< '[' << MIN_IO_LIMIT << '-' << MAX_IO_LIMIT << "]\n"
+		<< "  --ssgnc-time-limit="
+		<< '[' << MIN_TIME_LIMIT << '-' << MAX_TIME_LIMIT << "] (usec)\n"
+		<< "  --ssgnc-scan-limit="
+		<< '[' << MIN_SCAN_LIMIT << '-' << MAX_SCAN_LIMIT << "]\n"
 		<< "  --ssgnc-order="
 		<< "[UNORDERED, ORDERED, PHRASE, FIXED]\n";
 	if (!*out)
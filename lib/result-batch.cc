@@ -0,0 +1,91 @@
+#include "ssgnc/result-batch.h"
+
+namespace ssgnc {
+
+void ResultBatch::clear()
+{
+	encoded_freqs_.clear();
+	num_tokens_.clear();
+	offsets_.clear();
+	tokens_.clear();
+}
+
+bool ResultBatch::append(Int16 encoded_freq, const Int32 *tokens,
+	Int32 num_tokens)
+{
+	if (tokens == NULL && num_tokens != 0)
+	{
+		SSGNC_ERROR << "Null pointer" << std::endl;
+		return false;
+	}
+
+	Int32 *dest;
+	if (!reserve(num_tokens, &dest))
+	{
+		SSGNC_ERROR << "ssgnc::ResultBatch::reserve() failed: "
+			<< num_tokens << std::endl;
+		return false;
+	}
+
+	for (Int32 i = 0; i < num_tokens; ++i)
+		dest[i] = tokens[i];
+
+	if (!commit(encoded_freq, num_tokens))
+	{
+		SSGNC_ERROR << "ssgnc::ResultBatch::commit() failed" << std::endl;
+		rollback(num_tokens);
+		return false;
+	}
+	return true;
+}
+
+bool ResultBatch::reserve(Int32 num_tokens, Int32 **tokens)
+{
+	if (num_tokens < 0)
+	{
+		SSGNC_ERROR << "Negative number of tokens: " << num_tokens
+			<< std::endl;
+		return false;
+	}
+
+	std::size_t offset = tokens_.size();
+	try
+	{
+		tokens_.resize(offset + num_tokens);
+	}
+	catch (...)
+	{
+		SSGNC_ERROR << "std::vector<ssgnc::Int32>::resize() failed: "
+			<< (offset + num_tokens) << std::endl;
+		return false;
+	}
+
+	*tokens = tokens_.empty() ? NULL : &tokens_[0] + offset;
+	return true;
+}
+
+bool ResultBatch::commit(Int16 encoded_freq, Int32 num_tokens)
+{
+	try
+	{
+		encoded_freqs_.push_back(encoded_freq);
+		num_tokens_.push_back(num_tokens);
+		offsets_.push_back(static_cast<UInt32>(tokens_.size() - num_tokens));
+	}
+	catch (...)
+	{
+		SSGNC_ERROR << "std::vector::push_back() failed: "
+			<< size() << std::endl;
+		encoded_freqs_.resize(offsets_.size());
+		num_tokens_.resize(offsets_.size());
+		return false;
+	}
+	return true;
+}
+
+void ResultBatch::rollback(Int32 num_tokens)
+{
+	tokens_.resize(tokens_.size() - num_tokens);
+}
+
+}  // namespace ssgnc
@@ -0,0 +1,395 @@
+#include "ssgnc/result-cache.h"
+#include "ssgnc/agent.h"
+#include "ssgnc/mutex-lock.h"
+
+namespace ssgnc {
+
+void ResultCache::Results::clear()
+{
+	encoded_freqs_.clear();
+	tokens_.clear();
+	ends_.clear();
+}
+
+void ResultCache::Results::swap(Results *target)
+{
+	encoded_freqs_.swap(target->encoded_freqs_);
+	tokens_.swap(target->tokens_);
+	ends_.swap(target->ends_);
+}
+
+bool ResultCache::Results::assign(const Results &results)
+{
+	try
+	{
+		encoded_freqs_ = results.encoded_freqs_;
+		tokens_ = results.tokens_;
+		ends_ = results.ends_;
+	}
+	catch (...)
+	{
+		SSGNC_ERROR << "std::vector::operator=() failed: "
+			<< results.size() << std::endl;
+		clear();
+		return false;
+	}
+	return true;
+}
+
+bool ResultCache::Results::append(Int16 encoded_freq,
+	const std::vector<Int32> &tokens)
+{
+	return append(encoded_freq, tokens.empty() ? NULL : &tokens[0],
+		static_cast<Int32>(tokens.size()));
+}
+
+bool ResultCache::Results::append(Int16 encoded_freq, const Int32 *tokens,
+	Int32 num_tokens)
+{
+	try
+	{
+		tokens_.insert(tokens_.end(), tokens, tokens + num_tokens);
+		ends_.push_back(static_cast<UInt32>(tokens_.size()));
+		encoded_freqs_.push_back(encoded_freq);
+	}
+	catch (...)
+	{
+		SSGNC_ERROR << "std::vector::push_back() failed: "
+			<< size() << std::endl;
+		clear();
+		return false;
+	}
+	return true;
+}
+
+bool ResultCache::Results::get(UInt64 index, Int16 *encoded_freq,
+	std::vector<Int32> *tokens) const
+{
+	if (index >= size())
+	{
+		SSGNC_ERROR << "Out of range index: " << index << std::endl;
+		return false;
+	}
+
+	UInt32 begin = (index == 0) ? 0 : ends_[index - 1];
+	try
+	{
+		tokens->assign(tokens_.begin() + begin, tokens_.begin() + ends_[index]);
+	}
+	catch (...)
+	{
+		SSGNC_ERROR << "std::vector<ssgnc::Int32>::assign() failed: "
+			<< (ends_[index] - begin) << std::endl;
+		return false;
+	}
+	*encoded_freq = encoded_freqs_[index];
+	return true;
+}
+
+bool ResultCache::Results::get(UInt64 index, Int16 *encoded_freq,
+	const Int32 **tokens, Int32 *num_tokens) const
+{
+	if (index >= size())
+	{
+		SSGNC_ERROR << "Out of range index: " << index << std::endl;
+		return false;
+	}
+
+	UInt32 begin = (index == 0) ? 0 : ends_[index - 1];
+	*encoded_freq = encoded_freqs_[index];
+	*tokens = tokens_.empty() ? NULL : &tokens_[0] + begin;
+	*num_tokens = static_cast<Int32>(ends_[index] - begin);
+	return true;
+}
+
+UInt64 ResultCache::Results::bytes() const
+{
+	return (sizeof(Int16) + sizeof(UInt32)) * encoded_freqs_.size()
+		+ sizeof(Int32) * tokens_.size();
+}
+
+ResultCache::ResultCache() : is_open_(false), max_bytes_(0),
+	max_num_agents_(0), num_bytes_(0), num_agents_(0), entries_(), map_(),
+	num_hits_(0), num_resumes_(0), num_misses_(0), mutex_()
+{
+	::pthread_mutex_init(&mutex_, NULL);
+}
+
+ResultCache::~ResultCache()
+{
+	if (is_open())
+		close();
+	::pthread_mutex_destroy(&mutex_);
+}
+
+bool ResultCache::open(UInt64 max_bytes, UInt32 max_num_agents)
+{
+	if (is_open())
+	{
+		SSGNC_ERROR << "Already opened" << std::endl;
+		return false;
+	}
+	else if (max_bytes == 0)
+	{
+		SSGNC_ERROR << "Zero cache size" << std::endl;
+		return false;
+	}
+
+	is_open_ = true;
+	max_bytes_ = max_bytes;
+	max_num_agents_ = max_num_agents;
+	return true;
+}
+
+bool ResultCache::close()
+{
+	if (!is_open())
+	{
+		SSGNC_ERROR << "Not opened" << std::endl;
+		return false;
+	}
+
+	MutexLock lock(&mutex_);
+	clearEntries();
+
+	is_open_ = false;
+	max_bytes_ = 0;
+	max_num_agents_ = 0;
+	num_hits_ = 0;
+	num_resumes_ = 0;
+	num_misses_ = 0;
+	return true;
+}
+
+bool ResultCache::makeKey(const Query &query, Int32 min_num_tokens,
+	Int32 max_num_tokens, Key *key)
+{
+	if (key == NULL)
+	{
+		SSGNC_ERROR << "Null pointer" << std::endl;
+		return false;
+	}
+
+	try
+	{
+		key->clear();
+		key->reserve(4 + query.num_tokens());
+		key->push_back(query.order());
+		key->push_back(query.min_encoded_freq());
+		key->push_back(min_num_tokens);
+		key->push_back(max_num_tokens);
+		for (Int32 i = 0; i < query.num_tokens(); ++i)
+			key->push_back(query.token(i));
+	}
+	catch (...)
+	{
+		SSGNC_ERROR << "std::vector<ssgnc::Int32>::push_back() failed: "
+			<< key->size() << std::endl;
+		return false;
+	}
+	return true;
+}
+
+bool ResultCache::find(const Key &key, const Query &query, Agent *agent)
+{
+	if (agent == NULL)
+	{
+		SSGNC_ERROR << "Null pointer" << std::endl;
+		return false;
+	}
+
+	MutexLock lock(&mutex_);
+
+	EntryMap::iterator it = map_.find(key);
+	if (it == map_.end())
+	{
+		++num_misses_;
+		return false;
+	}
+
+	// A cold search with the limits might stop before the cached results.
+	Entry *entry = *it->second;
+	if ((query.io_limit() != 0 && entry->total >= query.io_limit()) ||
+		(query.scan_limit() != 0 &&
+		entry->num_scanned >= query.scan_limit()))
+	{
+		++num_misses_;
+		return false;
+	}
+
+	bool is_enough = entry->is_complete || (query.max_num_results() != 0 &&
+		entry->results.size() >= query.max_num_results());
+
+	Results results;
+	if (is_enough)
+	{
+		// The results are copied because the entry stays in the cache.
+		if (!results.assign(entry->results))
+			return false;
+		entries_.splice(entries_.begin(), entries_, it->second);
+
+		++num_hits_;
+		return agent->openCached(this, key, query, &results, entry->total,
+			entry->num_scanned, NULL);
+	}
+	else if (entry->agent == NULL)
+	{
+		++num_misses_;
+		return false;
+	}
+
+	// The agent is taken out of the cache and given back when the resumed
+	// search is finished.
+	Agent *suspended = entry->agent;
+	UInt64 total = entry->total;
+	UInt64 num_scanned = entry->num_scanned;
+	results.swap(&entry->results);
+	entry->agent = NULL;
+	--num_agents_;
+	remove(it);
+
+	++num_resumes_;
+	return agent->openCached(this, key, query, &results, total, num_scanned,
+		suspended);
+}
+
+void ResultCache::insert(const Key &key, Results *results, bool is_complete,
+	UInt64 total, UInt64 num_scanned, Agent *agent)
+{
+	MutexLock lock(&mutex_);
+
+	EntryMap::iterator it = map_.find(key);
+	if (it != map_.end())
+	{
+		const Entry *entry = *it->second;
+		if (!is_complete && (entry->is_complete ||
+			entry->results.size() > results->size()))
+		{
+			delete agent;
+			return;
+		}
+		remove(it);
+	}
+
+	if (agent != NULL && num_agents_ >= max_num_agents_)
+	{
+		delete agent;
+		agent = NULL;
+	}
+
+	UInt64 bytes = sizeof(Entry) + (sizeof(Int32) * key.size())
+		+ results->bytes();
+	if (agent != NULL)
+	{
+		bytes += sizeof(Agent) + (READER_BYTES * agent->ngram_readers_.size())
+			+ agent->block_.bytes_used();
+	}
+	if (bytes > max_bytes_)
+	{
+		delete agent;
+		return;
+	}
+
+	Entry *entry = NULL;
+	try
+	{
+		entry = new Entry;
+		entry->key = key;
+		entries_.push_front(entry);
+		map_[key] = entries_.begin();
+	}
+	catch (...)
+	{
+		SSGNC_ERROR << "Failed to insert an entry" << std::endl;
+		if (entry != NULL && !entries_.empty() && entries_.front() == entry)
+			entries_.pop_front();
+		delete entry;
+		delete agent;
+		return;
+	}
+
+	entry->results.swap(results);
+	entry->is_complete = is_complete;
+	entry->total = total;
+	entry->num_scanned = num_scanned;
+	entry->agent = agent;
+	entry->bytes = bytes;
+
+	num_bytes_ += bytes;
+	if (agent != NULL)
+		++num_agents_;
+
+	while (num_bytes_ > max_bytes_)
+		remove(map_.find(entries_.back()->key));
+}
+
+UInt64 ResultCache::num_bytes() const
+{
+	MutexLock lock(&mutex_);
+	return num_bytes_;
+}
+
+UInt64 ResultCache::num_entries() const
+{
+	MutexLock lock(&mutex_);
+	return map_.size();
+}
+
+UInt64 ResultCache::num_hits() const
+{
+	MutexLock lock(&mutex_);
+	return num_hits_;
+}
+
+UInt64 ResultCache::num_resumes() const
+{
+	MutexLock lock(&mutex_);
+	return num_resumes_;
+}
+
+UInt64 ResultCache::num_misses() const
+{
+	MutexLock lock(&mutex_);
+	return num_misses_;
+}
+
+double ResultCache::hit_rate() const
+{
+	MutexLock lock(&mutex_);
+
+	UInt64 num_lookups = num_hits_ + num_resumes_ + num_misses_;
+	if (num_lookups == 0)
+		return 0.0;
+	return static_cast<double>(num_hits_ + num_resumes_) / num_lookups;
+}
+
+void ResultCache::remove(EntryMap::iterator it)
+{
+	Entry *entry = *it->second;
+	entries_.erase(it->second);
+	map_.erase(it);
+	deleteEntry(entry);
+}
+
+void ResultCache::deleteEntry(Entry *entry)
+{
+	num_bytes_ -= entry->bytes;
+	if (entry->agent != NULL)
+	{
+		delete entry->agent;
+		--num_agents_;
+	}
+	delete entry;
+}
+
+void ResultCache::clearEntries()
+{
+	for (EntryList::iterator it = entries_.begin(); it != entries_.end(); ++it)
+		deleteEntry(*it);
+	entries_.clear();
+	map_.clear();
+	num_bytes_ = 0;
+	num_agents_ = 0;
+}
+
+}  // namespace ssgnc
@@ -0,0 +1,192 @@
+#include "ssgnc/shard-map.h"
+#include "ssgnc/file-path.h"
+
+#include <algorithm>
+#include <sstream>
+
+namespace ssgnc {
+
+ShardMap::~ShardMap()
+{
+	if (is_open())
+		close();
+}
+
+bool ShardMap::open(const String &index_dir)
+{
+	if (is_open())
+	{
+		SSGNC_ERROR << "Already opened" << std::endl;
+		return false;
+	}
+
+	if (!index_dir_.append(index_dir.empty() ? String(".") : index_dir) ||
+		!index_dir_.append())
+	{
+		SSGNC_ERROR << "ssgnc::StringBuilder::append() failed" << std::endl;
+		index_dir_.clear();
+		return false;
+	}
+
+	StringBuilder path;
+	if (!FilePath::join(index_dir_.str(), "ngms.shards", &path))
+	{
+		SSGNC_ERROR << "ssgnc::FilePath::join() failed" << std::endl;
+		close();
+		return false;
+	}
+
+	// An index without ngms.shards has only one shard.
+	std::ifstream file(path.ptr(), std::ios::binary);
+	if (!file)
+		return true;
+
+	if (!readShards(&file))
+	{
+		SSGNC_ERROR << "ssgnc::ShardMap::readShards() failed: "
+			<< path << std::endl;
+		close();
+		return false;
+	}
+
+	return true;
+}
+
+bool ShardMap::close()
+{
+	if (!is_open())
+	{
+		SSGNC_ERROR << "Not opened" << std::endl;
+		return false;
+	}
+
+	index_dir_.clear();
+	ranges_.clear();
+	dirnames_.clear();
+	return true;
+}
+
+Int32 ShardMap::find(Int32 num_tokens, Int32 file_id) const
+{
+	Range key;
+	key.num_tokens = num_tokens;
+	key.first_file_id = file_id;
+	key.shard_id = 0;
+
+	std::vector<Range>::const_iterator it =
+		std::upper_bound(ranges_.begin(), ranges_.end(), key);
+	if (it == ranges_.begin() || (--it)->num_tokens != num_tokens)
+		return 0;
+	return it->shard_id;
+}
+
+String ShardMap::dirname(Int32 shard_id) const
+{
+	if (shard_id <= 0 || shard_id > static_cast<Int32>(dirnames_.size()))
+		return index_dir_.str();
+
+	const std::string &dirname = dirnames_[shard_id - 1];
+	return String(dirname.c_str(), static_cast<UInt32>(dirname.length()));
+}
+
+bool ShardMap::readShards(std::istream *stream)
+{
+	std::string line;
+	while (std::getline(*stream, line))
+	{
+		if (line.empty() || line[0] == '#')
+			continue;
+
+		std::istringstream line_stream(line);
+		Int32 num_tokens, first_file_id;
+		std::string dirname, extra;
+		if (!(line_stream >> num_tokens >> first_file_id >> dirname) ||
+			(line_stream >> extra))
+		{
+			SSGNC_ERROR << "Invalid line: " << line << std::endl;
+			return false;
+		}
+		else if (num_tokens <= 0)
+		{
+			SSGNC_ERROR << "Out of range #tokens: " << num_tokens << std::endl;
+			return false;
+		}
+		else if (first_file_id < 0 || first_file_id > FilePath::MAX_FILE_ID)
+		{
+			SSGNC_ERROR << "Out of range file ID: "
+				<< first_file_id << std::endl;
+			return false;
+		}
+
+		if (!addRange(num_tokens, first_file_id, dirname))
+		{
+			SSGNC_ERROR << "ssgnc::ShardMap::addRange() failed" << std::endl;
+			return false;
+		}
+	}
+
+	if (stream->bad())
+	{
+		SSGNC_ERROR << "std::getline() failed" << std::endl;
+		return false;
+	}
+
+	std::sort(ranges_.begin(), ranges_.end());
+	for (std::size_t i = 1; i < ranges_.size(); ++i)
+	{
+		if (!(ranges_[i - 1] < ranges_[i]))
+		{
+			SSGNC_ERROR << "Duplicate range: " << ranges_[i].num_tokens
+				<< ", " << ranges_[i].first_file_id << std::endl;
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// The ranges in the same directory share a shard ID, because the shards
+// are read in parallel per directory.
+bool ShardMap::addRange(Int32 num_tokens, Int32 first_file_id,
+	const std::string &dirname)
+{
+	try
+	{
+		std::string path = dirname;
+		if (path[0] != '/')
+		{
+			StringBuilder joined_path;
+			if (!FilePath::join(index_dir_.str(), String(dirname.c_str(),
+				static_cast<UInt32>(dirname.length())), &joined_path))
+			{
+				SSGNC_ERROR << "ssgnc::FilePath::join() failed" << std::endl;
+				return false;
+			}
+			path.assign(joined_path.ptr(), joined_path.length());
+		}
+
+		Int32 shard_id = 0;
+		if (path != std::string(index_dir_.ptr(), index_dir_.length()))
+		{
+			shard_id = static_cast<Int32>(std::find(dirnames_.begin(),
+				dirnames_.end(), path) - dirnames_.begin()) + 1;
+			if (shard_id > static_cast<Int32>(dirnames_.size()))
+				dirnames_.push_back(path);
+		}
+
+		Range range;
+		range.num_tokens = num_tokens;
+		range.first_file_id = first_file_id;
+		range.shard_id = shard_id;
+		ranges_.push_back(range);
+	}
+	catch (...)
+	{
+		SSGNC_ERROR << "std::vector::push_back() failed: "
+			<< ranges_.size() << std::endl;
+		return false;
+	}
+	return true;
+}
+
+}  // namespace ssgnc
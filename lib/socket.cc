@@ -0,0 +1,253 @@
+#include "ssgnc/socket.h"
+
+#include <cerrno>
+#include <cstring>
+#include <string>
+
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace ssgnc {
+
+namespace {
+
+bool makeUnixAddress(const String &path, struct sockaddr_un *address)
+{
+	std::memset(address, 0, sizeof(*address));
+	if (path.empty() || path.length() >= sizeof(address->sun_path))
+	{
+		SSGNC_ERROR << "Invalid socket path: " << path << std::endl;
+		return false;
+	}
+	address->sun_family = AF_UNIX;
+	std::memcpy(address->sun_path, path.ptr(), path.length());
+	return true;
+}
+
+bool resolveTcpAddress(const String &address, bool is_passive,
+	struct addrinfo **result)
+{
+	const Int8 *delim = address.end();
+	while (delim > address.begin() && delim[-1] != ':')
+		--delim;
+
+	std::string host(address.begin(), delim - 1);
+	std::string port(delim, address.end());
+	if (port.empty())
+	{
+		SSGNC_ERROR << "No port: " << address << std::endl;
+		return false;
+	}
+
+	struct addrinfo hints;
+	std::memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	if (is_passive)
+		hints.ai_flags = AI_PASSIVE;
+
+	int ret = ::getaddrinfo(host.empty() ? NULL : host.c_str(),
+		port.c_str(), &hints, result);
+	if (ret != 0)
+	{
+		SSGNC_ERROR << "::getaddrinfo() failed: " << address << ": "
+			<< ::gai_strerror(ret) << std::endl;
+		return false;
+	}
+	return true;
+}
+
+// Requests and responses are small, so they are sent without delay.
+void setNoDelay(int fd)
+{
+	int value = 1;
+	::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &value, sizeof(value));
+}
+
+}  // namespace
+
+bool Socket::listen(const String &address, int *listen_fd)
+{
+	if (listen_fd == NULL)
+	{
+		SSGNC_ERROR << "Null pointer" << std::endl;
+		return false;
+	}
+
+	return isTcp(address) ? listenTcp(address, listen_fd)
+		: listenUnix(address, listen_fd);
+}
+
+bool Socket::accept(int listen_fd, int *fd)
+{
+	if (fd == NULL)
+	{
+		SSGNC_ERROR << "Null pointer" << std::endl;
+		return false;
+	}
+
+	for ( ; ; )
+	{
+		int temp_fd = ::accept(listen_fd, NULL, NULL);
+		if (temp_fd != -1)
+		{
+			setNoDelay(temp_fd);
+			*fd = temp_fd;
+			return true;
+		}
+		else if (errno != EINTR && errno != ECONNABORTED)
+		{
+			SSGNC_ERROR << "::accept() failed: " << std::strerror(errno)
+				<< std::endl;
+			return false;
+		}
+	}
+}
+
+bool Socket::connect(const String &address, int *fd)
+{
+	if (fd == NULL)
+	{
+		SSGNC_ERROR << "Null pointer" << std::endl;
+		return false;
+	}
+
+	return isTcp(address) ? connectTcp(address, fd)
+		: connectUnix(address, fd);
+}
+
+bool Socket::isTcp(const String &address)
+{
+	return address.contains(':') && !address.contains('/');
+}
+
+bool Socket::listenUnix(const String &path, int *listen_fd)
+{
+	struct sockaddr_un address;
+	if (!makeUnixAddress(path, &address))
+		return false;
+
+	int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd == -1)
+	{
+		SSGNC_ERROR << "::socket() failed" << std::endl;
+		return false;
+	}
+
+	// A socket file left by a previous process is replaced.
+	::unlink(address.sun_path);
+	if (::bind(fd, reinterpret_cast<struct sockaddr *>(&address),
+		sizeof(address)) != 0)
+	{
+		SSGNC_ERROR << "::bind() failed: " << path << std::endl;
+		::close(fd);
+		return false;
+	}
+	else if (::listen(fd, SOMAXCONN) != 0)
+	{
+		SSGNC_ERROR << "::listen() failed: " << path << std::endl;
+		::close(fd);
+		return false;
+	}
+
+	*listen_fd = fd;
+	return true;
+}
+
+bool Socket::listenTcp(const String &address, int *listen_fd)
+{
+	struct addrinfo *result;
+	if (!resolveTcpAddress(address, true, &result))
+		return false;
+
+	int fd = -1;
+	for (struct addrinfo *info = result; info != NULL; info = info->ai_next)
+	{
+		fd = ::socket(info->ai_family, info->ai_socktype, info->ai_protocol);
+		if (fd == -1)
+			continue;
+
+		int value = 1;
+		::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &value, sizeof(value));
+		if (::bind(fd, info->ai_addr, info->ai_addrlen) == 0 &&
+			::listen(fd, SOMAXCONN) == 0)
+			break;
+
+		::close(fd);
+		fd = -1;
+	}
+	::freeaddrinfo(result);
+
+	if (fd == -1)
+	{
+		SSGNC_ERROR << "::bind() failed: " << address << std::endl;
+		return false;
+	}
+
+	*listen_fd = fd;
+	return true;
+}
+
+bool Socket::connectUnix(const String &path, int *fd)
+{
+	struct sockaddr_un address;
+	if (!makeUnixAddress(path, &address))
+		return false;
+
+	int temp_fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+	if (temp_fd == -1)
+	{
+		SSGNC_ERROR << "::socket() failed" << std::endl;
+		return false;
+	}
+
+	if (::connect(temp_fd, reinterpret_cast<struct sockaddr *>(&address),
+		sizeof(address)) != 0)
+	{
+		SSGNC_ERROR << "::connect() failed: " << path << std::endl;
+		::close(temp_fd);
+		return false;
+	}
+
+	*fd = temp_fd;
+	return true;
+}
+
+bool Socket::connectTcp(const String &address, int *fd)
+{
+	struct addrinfo *result;
+	if (!resolveTcpAddress(address, false, &result))
+		return false;
+
+	int temp_fd = -1;
+	for (struct addrinfo *info = result; info != NULL; info = info->ai_next)
+	{
+		temp_fd = ::socket(info->ai_family, info->ai_socktype,
+			info->ai_protocol);
+		if (temp_fd == -1)
+			continue;
+
+		if (::connect(temp_fd, info->ai_addr, info->ai_addrlen) == 0)
+			break;
+
+		::close(temp_fd);
+		temp_fd = -1;
+	}
+	::freeaddrinfo(result);
+
+	if (temp_fd == -1)
+	{
+		SSGNC_ERROR << "::connect() failed: " << address << std::endl;
+		return false;
+	}
+
+	setNoDelay(temp_fd);
+	*fd = temp_fd;
+	return true;
+}
+
+}  // namespace ssgnc
@@ -3,7 +3,8 @@
 namespace ssgnc {
 
 VocabDic::VocabDic() : num_keys_(0), table_size_(0), total_size_(0),
-	table_(NULL), offsets_(NULL), keys_(NULL), file_map_() {}
+	table_(NULL), offsets_(NULL), large_offsets_(NULL), keys_(NULL),
+	file_map_() {}
 
 VocabDic::~VocabDic()
 {
@@ -55,6 +56,7 @@ bool VocabDic::close()
 
 	table_ = NULL;
 	offsets_ = NULL;
+	large_offsets_ = NULL;
 	keys_ = NULL;
 
 	file_map_.close();
@@ -82,7 +84,8 @@ bool VocabDic::find(const String &key, Int32 *key_id) const
 	}
 }
 
-bool VocabDic::build(const Int8 *path, const std::vector<String> &keys)
+bool VocabDic::build(const Int8 *path, const std::vector<String> &keys,
+	bool force_large)
 {
 	if (path == NULL)
 	{
@@ -98,7 +101,7 @@ bool VocabDic::build(const Int8 *path, const std::vector<String> &keys)
 	UInt32 num_keys = static_cast<UInt32>(keys.size());
 	UInt32 table_size = num_keys + (num_keys / 4) + 1;
 
-	UInt32 total_length = 0;
+	UInt64 total_length = 0;
 	for (UInt32 i = 0; i < num_keys; ++i)
 		total_length += keys[i].length();
 
@@ -114,15 +117,15 @@ bool VocabDic::build(const Int8 *path, const std::vector<String> &keys)
 		return false;
 	}
 
-	std::vector<UInt32> offsets;
+	std::vector<UInt64> offsets;
 	try
 	{
 		offsets.reserve(num_keys + 1);
 	}
 	catch (...)
 	{
-		SSGNC_ERROR << "std::vector<UInt32>::reserve() failed: "
-			<< sizeof(UInt32) << " * " << (num_keys + 1) << std::endl;
+		SSGNC_ERROR << "std::vector<UInt64>::reserve() failed: "
+			<< sizeof(UInt64) << " * " << (num_keys + 1) << std::endl;
 		return false;
 	}
 
@@ -138,10 +141,17 @@ bool VocabDic::build(const Int8 *path, const std::vector<String> &keys)
 		return false;
 	}
 
-	UInt32 total_size = static_cast<UInt32>(
-		sizeof(table[0]) * table.size()
-		+ sizeof(offsets[0]) * (num_keys + 1)
-		+ total_length);
+	// The large format is used only if the sizes do not fit in 32 bits, so
+	// that small dictionaries are still readable by older versions.
+	UInt64 total_size = sizeof(table[0]) * table.size()
+		+ sizeof(UInt32) * (num_keys + 1) + total_length;
+	bool is_large = force_large || total_size > 0xFFFFFFFFU;
+	UInt32 num_paddings = is_large ? (table_size % 2) : 0;
+	if (is_large)
+	{
+		total_size = sizeof(table[0]) * (table.size() + num_paddings)
+			+ sizeof(UInt64) * (num_keys + 1) + total_length;
+	}
 
 	offsets.push_back(0);
 	for (UInt32 i = 0; i < num_keys; ++i)
@@ -173,7 +183,7 @@ bool VocabDic::build(const Int8 *path, const std::vector<String> &keys)
 		{
 			for (UInt32 j = 0; j < keys[i].length(); ++j)
 				keys_buf.push_back(keys[i][j]);
-			offsets.push_back(static_cast<UInt32>(keys_buf.size()));
+			offsets.push_back(keys_buf.size());
 		}
 		catch (...)
 		{
@@ -196,8 +206,20 @@ bool VocabDic::build(const Int8 *path, const std::vector<String> &keys)
 		return false;
 	}
 
-	if (!writer.write(num_keys) || !writer.write(table_size) ||
-		!writer.write(total_size))
+	if (is_large)
+	{
+		if (!writer.write(static_cast<UInt32>(LARGE_FORMAT_MARKER)) ||
+			!writer.write(static_cast<UInt32>(LARGE_FORMAT)) ||
+			!writer.write(num_keys) || !writer.write(table_size) ||
+			!writer.write(total_size))
+		{
+			SSGNC_ERROR << "ssgnc::Writer::write() failed: header"
+				<< std::endl;
+			return false;
+		}
+	}
+	else if (!writer.write(num_keys) || !writer.write(table_size) ||
+		!writer.write(static_cast<UInt32>(total_size)))
 	{
 		SSGNC_ERROR << "ssgnc::Writer::write() failed: header" << std::endl;
 		return false;
@@ -209,10 +231,32 @@ bool VocabDic::build(const Int8 *path, const std::vector<String> &keys)
 		return false;
 	}
 
-	if (!writer.write(&offsets[0], num_keys + 1))
+	if (is_large)
 	{
-		SSGNC_ERROR << "ssgnc::Writer::write() failed: offsets" << std::endl;
-		return false;
+		if (num_paddings != 0 && !writer.write(static_cast<Int32>(0)))
+		{
+			SSGNC_ERROR << "ssgnc::Writer::write() failed: padding"
+				<< std::endl;
+			return false;
+		}
+		else if (!writer.write(&offsets[0], num_keys + 1))
+		{
+			SSGNC_ERROR << "ssgnc::Writer::write() failed: offsets"
+				<< std::endl;
+			return false;
+		}
+	}
+	else
+	{
+		for (UInt32 i = 0; i <= num_keys; ++i)
+		{
+			if (!writer.write(static_cast<UInt32>(offsets[i])))
+			{
+				SSGNC_ERROR << "ssgnc::Writer::write() failed: offsets"
+					<< std::endl;
+				return false;
+			}
+		}
 	}
 
 	if (!writer.write(&keys_buf[0], offsets[num_keys]))
@@ -224,7 +268,7 @@ bool VocabDic::build(const Int8 *path, const std::vector<String> &keys)
 	return true;
 }
 
-bool VocabDic::mapData(const void *ptr, UInt32 size)
+bool VocabDic::mapData(const void *ptr, UInt64 size)
 {
 	Mapper mapper;
 	if (!mapper.open(ptr, size))
@@ -233,13 +277,100 @@ bool VocabDic::mapData(const void *ptr, UInt32 size)
 		return false;
 	}
 
-	const UInt32 *num_keys, *table_size, *total_size;
-	if (!mapper.map(&num_keys) || !mapper.map(&table_size) ||
-		!mapper.map(&total_size))
+	const UInt32 *num_keys;
+	if (!mapper.map(&num_keys))
 	{
 		SSGNC_ERROR << "ssgnc::Mapper::map() failed: header" << std::endl;
 		return false;
 	}
+	else if (*num_keys == LARGE_FORMAT_MARKER)
+	{
+		if (!mapLargeData(&mapper))
+		{
+			SSGNC_ERROR << "ssgnc::VocabDic::mapLargeData() failed"
+				<< std::endl;
+			return false;
+		}
+	}
+	else
+	{
+		const UInt32 *table_size, *total_size;
+		if (!mapper.map(&table_size) || !mapper.map(&total_size))
+		{
+			SSGNC_ERROR << "ssgnc::Mapper::map() failed: header" << std::endl;
+			return false;
+		}
+		else if (*table_size == 0 || *total_size == 0)
+		{
+			SSGNC_ERROR << "Wrong header" << std::endl;
+			return false;
+		}
+
+		const Int32 *table;
+		if (!mapper.map(&table, *table_size))
+		{
+			SSGNC_ERROR << "ssgnc::Mapper::map() failed: table" << std::endl;
+			return false;
+		}
+
+		const UInt32 *offsets;
+		if (!mapper.map(&offsets, *num_keys + 1))
+		{
+			SSGNC_ERROR << "ssgnc::Mapper::map() failed: offsets"
+				<< std::endl;
+			return false;
+		}
+
+		const Int8 *keys;
+		if (!mapper.map(&keys, offsets[*num_keys]))
+		{
+			SSGNC_ERROR << "ssgnc::Mapper::map() failed: keys" << std::endl;
+			return false;
+		}
+
+		if (sizeof(table[0]) * *table_size
+			+ sizeof(offsets[0]) * (*num_keys + 1)
+			+ offsets[*num_keys] != *total_size)
+		{
+			SSGNC_ERROR << "Conflicted sizes: " << *table_size
+				<< ", " << *num_keys << ", " << offsets[*num_keys]
+				<< ", " << *total_size << std::endl;
+			return false;
+		}
+
+		num_keys_ = *num_keys;
+		table_size_ = *table_size;
+		total_size_ = *total_size;
+
+		table_ = table;
+		offsets_ = offsets;
+		keys_ = keys;
+	}
+
+	if (mapper.tell() != size)
+	{
+		SSGNC_ERROR << "Extra bytes: " << (size - mapper.tell()) << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+bool VocabDic::mapLargeData(Mapper *mapper)
+{
+	const UInt32 *format, *num_keys, *table_size;
+	const UInt64 *total_size;
+	if (!mapper->map(&format) || !mapper->map(&num_keys) ||
+		!mapper->map(&table_size) || !mapper->map(&total_size))
+	{
+		SSGNC_ERROR << "ssgnc::Mapper::map() failed: header" << std::endl;
+		return false;
+	}
+	else if (*format != LARGE_FORMAT)
+	{
+		SSGNC_ERROR << "Unknown format: " << *format << std::endl;
+		return false;
+	}
 	else if (*num_keys == 0 || *table_size == 0 || *total_size == 0)
 	{
 		SSGNC_ERROR << "Wrong header" << std::endl;
@@ -247,48 +378,55 @@ bool VocabDic::mapData(const void *ptr, UInt32 size)
 	}
 
 	const Int32 *table;
-	if (!mapper.map(&table, *table_size))
+	if (!mapper->map(&table, *table_size))
 	{
 		SSGNC_ERROR << "ssgnc::Mapper::map() failed: table" << std::endl;
 		return false;
 	}
 
-	const UInt32 *offsets;
-	if (!mapper.map(&offsets, *num_keys + 1))
+	UInt32 num_paddings = *table_size % 2;
+	const Int32 *paddings;
+	if (num_paddings != 0 && !mapper->map(&paddings, num_paddings))
+	{
+		SSGNC_ERROR << "ssgnc::Mapper::map() failed: padding" << std::endl;
+		return false;
+	}
+
+	const UInt64 *offsets;
+	if (!mapper->map(&offsets, static_cast<UInt64>(*num_keys) + 1))
 	{
 		SSGNC_ERROR << "ssgnc::Mapper::map() failed: offsets" << std::endl;
 		return false;
 	}
+	else if (reinterpret_cast<std::size_t>(offsets) % sizeof(UInt64) != 0)
+	{
+		SSGNC_ERROR << "Misaligned offsets" << std::endl;
+		return false;
+	}
 
 	const Int8 *keys;
-	if (!mapper.map(&keys, offsets[*num_keys]))
+	if (!mapper->map(&keys, offsets[*num_keys]))
 	{
 		SSGNC_ERROR << "ssgnc::Mapper::map() failed: keys" << std::endl;
 		return false;
 	}
 
-	if (sizeof(table[0]) * *table_size
-		+ sizeof(offsets[0]) * (*num_keys + 1)
+	if (sizeof(table[0]) * (static_cast<UInt64>(*table_size) + num_paddings)
+		+ sizeof(offsets[0]) * (static_cast<UInt64>(*num_keys) + 1)
 		+ offsets[*num_keys] != *total_size)
 	{
 		SSGNC_ERROR << "Conflicted sizes: " << *table_size
-			<< ", " << *num_keys << ", " << offsets_[*num_keys]
+			<< ", " << *num_keys << ", " << offsets[*num_keys]
 			<< ", " << *total_size << std::endl;
 		return false;
 	}
 
-	if (mapper.tell() != size)
-	{
-		SSGNC_ERROR << "Extra bytes: " << (size - mapper.tell()) << std::endl;
-		return false;
-	}
-
 	num_keys_ = *num_keys;
 	table_size_ = *table_size;
 	total_size_ = *total_size;
 
 	table_ = table;
-	offsets_ = offsets;
+	large_offsets_ = offsets;
 	keys_ = keys;
 
 	return true;
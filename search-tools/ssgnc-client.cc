@@ -0,0 +1,176 @@
+#include <ssgnc.h>
+
+#include <csignal>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+namespace {
+
+// Up to this number of requests are sent before their responses are read.
+// Requests are small enough to fit into the socket buffer.
+enum { MAX_NUM_PENDINGS = 16 };
+
+// This function reads a line from `in' and stores it into `line'.
+// If the stream reaches its end or an unexpected error occurs,
+// this function returns false. And in the latter case,
+// the bad bit of `in' is set to true.
+bool readLine(std::istream *in, std::string *line)
+{
+	try
+	{
+		if (!std::getline(*in, *line))
+			return false;
+		return true;
+	}
+	catch (...)
+	{
+		in->setstate(std::ios::badbit);
+		return false;
+	}
+}
+
+// A response is printed in the same format as ssgnc-search.
+bool readResponse(ssgnc::Reader *reader, ssgnc::StringBuilder *ngram)
+{
+	ssgnc::Int32 length;
+	for ( ; ; )
+	{
+		if (!ssgnc::Protocol::readNgram(reader, &length, ngram))
+		{
+			SSGNC_ERROR << "ssgnc::Protocol::readNgram() failed" << std::endl;
+			return false;
+		}
+		else if (length < 0)
+			break;
+
+		std::cout << *ngram << '\n';
+	}
+
+	if (length == ssgnc::Protocol::ERROR_OF_NGRAMS)
+		SSGNC_ERROR << "The server failed to search n-grams" << std::endl;
+
+	std::cout << '\n';
+	if (!std::cout)
+	{
+		SSGNC_ERROR << "std::ostream::operator<<() failed" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+bool searchNgrams(std::istream *in, const ssgnc::Query &options,
+	std::iostream *stream, ssgnc::Reader *reader, ssgnc::Writer *writer)
+{
+	ssgnc::StringBuilder ngram;
+	std::size_t num_pendings = 0;
+
+	std::string line;
+	while (readLine(in, &line))
+	{
+		ssgnc::String query_str(line.c_str(), line.length());
+		if (!ssgnc::Protocol::writeRequest(writer, options, query_str))
+		{
+			SSGNC_ERROR << "ssgnc::Protocol::writeRequest() failed"
+				<< std::endl;
+			return false;
+		}
+
+		if (++num_pendings < MAX_NUM_PENDINGS)
+			continue;
+
+		if (!stream->flush())
+		{
+			SSGNC_ERROR << "std::iostream::flush() failed" << std::endl;
+			return false;
+		}
+		else if (!readResponse(reader, &ngram))
+			return false;
+		--num_pendings;
+	}
+
+	if (in->bad())
+	{
+		SSGNC_ERROR << "::readLine() failed" << std::endl;
+		return false;
+	}
+
+	if (!stream->flush())
+	{
+		SSGNC_ERROR << "std::iostream::flush() failed" << std::endl;
+		return false;
+	}
+
+	for ( ; num_pendings > 0; --num_pendings)
+	{
+		if (!readResponse(reader, &ngram))
+			return false;
+	}
+
+	if (!std::cout.flush())
+	{
+		SSGNC_ERROR << "std::ostream::flush() failed" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+}  // namespace
+
+int main(int argc, char *argv[])
+{
+	ssgnc::Query options;
+	options.set_max_num_results(10);
+
+	if (!options.parseOptions(&argc, argv))
+		return 1;
+
+	if (argc < 2)
+	{
+		std::cerr << "Usage: " << argv[0]
+			<< " [OPTION]... ADDRESS [FILE]...\n\n"
+			<< "ADDRESS: the address of ssgnc-server, [HOST]:PORT or the path"
+			" of a Unix\ndomain socket\n\n";
+		ssgnc::Query::showOptions(&std::cerr);
+		return 2;
+	}
+
+	std::signal(SIGPIPE, SIG_IGN);
+
+	int fd;
+	if (!ssgnc::Socket::connect(argv[1], &fd))
+		return 3;
+
+	ssgnc::FdStreambuf streambuf;
+	if (!streambuf.open(fd))
+		return 3;
+
+	std::iostream stream(&streambuf);
+	ssgnc::Reader reader;
+	ssgnc::Writer writer;
+	if (!reader.open(&stream) || !writer.open(&stream))
+		return 3;
+
+	if (argc == 2)
+	{
+		if (!searchNgrams(&std::cin, options, &stream, &reader, &writer))
+			return 4;
+	}
+
+	for (int i = 2; i < argc; ++i)
+	{
+		std::cerr << "> " << argv[i] << std::endl;
+		std::ifstream file(argv[i], std::ios::binary);
+		if (!file)
+		{
+			SSGNC_ERROR << "ssgnc::ifstream::open() failed: "
+				<< argv[i] << std::endl;
+			continue;
+		}
+
+		if (!searchNgrams(&file, options, &stream, &reader, &writer))
+			return 4;
+	}
+
+	return 0;
+}
@@ -1,6 +1,8 @@
 #include <ssgnc.h>
 
+#include <cstdlib>
 #include <iostream>
+#include <sstream>
 #include <string>
 
 namespace {
@@ -24,7 +26,111 @@ bool readLine(std::istream *in, std::string *line)
 	}
 }
 
+// An n-gram consists of its encoded frequency and the IDs of its tokens.
+// Both ssgnc::Agent and ssgnc::Coordinator return n-grams in this form.
+template <typename T>
+bool printNgrams(const ssgnc::Database &database, T *agent)
+{
+	ssgnc::Int16 encoded_freq;
+	std::vector<ssgnc::Int32> tokens;
+	ssgnc::StringBuilder ngram_str;
+
+	// An n-gram can be decoded by decode() of the database.
+	while (agent->read(&encoded_freq, &tokens))
+	{
+		// A string, formatted "1st_token ' ' 2nd_token ' ' ... '\t' freq",
+		// is available by decode() of the database.
+		if (!database.decode(encoded_freq, tokens, &ngram_str))
+		{
+			SSGNC_ERROR << "ssgnc::Database::decode() failed" << std::endl;
+			return false;
+		}
+
+		std::cout << ngram_str << '\n';
+		if (!std::cout)
+		{
+			SSGNC_ERROR << "std::ostream::operator<<() failed" << std::endl;
+			return false;
+		}
+	}
+
+	// The bad bit of `agent' indicates if an error has occured or not.
+	if (agent->bad())
+	{
+		SSGNC_ERROR << "read() failed" << std::endl;
+		return false;
+	}
+
+	std::cout << '\n';
+	if (!std::cout)
+	{
+		SSGNC_ERROR << "std::ostream::operator<<() failed" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+// An agent can also return n-grams in batches, which are decoded at once.
+// This is faster than read() for queries with many results.
+bool printBatches(const ssgnc::Database &database, ssgnc::Agent *agent)
+{
+	enum { BATCH_SIZE = 1 << 10 };
+
+	ssgnc::ResultBatch batch;
+	ssgnc::StringBuilder batch_str;
+	while (agent->readBatch(&batch, BATCH_SIZE))
+	{
+		if (!database.decode(batch, &batch_str))
+		{
+			SSGNC_ERROR << "ssgnc::Database::decode() failed" << std::endl;
+			return false;
+		}
+
+		std::cout.write(batch_str.ptr(), batch_str.length());
+		if (!std::cout)
+		{
+			SSGNC_ERROR << "std::ostream::write() failed" << std::endl;
+			return false;
+		}
+	}
+
+	if (agent->bad())
+	{
+		SSGNC_ERROR << "ssgnc::Agent::readBatch() failed" << std::endl;
+		return false;
+	}
+
+	std::cout << '\n';
+	if (!std::cout)
+	{
+		SSGNC_ERROR << "std::ostream::operator<<() failed" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+// An explanation shows the lists chosen by the planner and the estimated
+// cost of the search, which is written to the standard error.
+bool explainQuery(const ssgnc::Database &database, const ssgnc::Query &query)
+{
+	ssgnc::Planner::Explanation explanation;
+	if (!database.explain(query, &explanation))
+	{
+		SSGNC_ERROR << "ssgnc::Database::explain() failed" << std::endl;
+		return false;
+	}
+
+	if (!explanation.write(&std::cerr))
+	{
+		SSGNC_ERROR << "ssgnc::Planner::Explanation::write() failed"
+			<< std::endl;
+		return false;
+	}
+	return true;
+}
+
 bool searchNgrams(std::istream *in, const ssgnc::Database &database,
+	const std::vector<ssgnc::String> &workers, bool is_explained,
 	ssgnc::Query *query)
 {
 	std::string line;
@@ -41,55 +147,40 @@ bool searchNgrams(std::istream *in, const ssgnc::Database &database,
 			return false;
 		}
 
-		// ssgnc::Agent opens .db files corresponding to the query. Then,
-		// the agent's read() returns n-grams one by one.
-		// If you want to reuse the agent for efficiency, please call close()
-		// before() the next search. Otherwise, the next search fails.
-		ssgnc::Agent agent;
-		if (!database.search(*query, &agent))
-		{
-			SSGNC_ERROR << "ssgnc::Database::search() failed" << std::endl;
+		if (is_explained && !explainQuery(database, *query))
 			return false;
-		}
-
-		ssgnc::Int16 encoded_freq;
-		std::vector<ssgnc::Int32> tokens;
-		ssgnc::StringBuilder ngram_str;
 
-		// An n-gram consists of its encoded frequency and the IDs of its
-		// tokens. And the n-gram can be decoded by decode() of the database.
-		while (agent.read(&encoded_freq, &tokens))
+		// ssgnc::Coordinator sends the query to workers and merges their
+		// results. The workers must serve the same index as `database'.
+		if (!workers.empty())
 		{
-			// A string, formatted "1st_token ' ' 2nd_token ' ' ... '\t' freq",
-			// is available by decode() of the database.
-			if (!database.decode(encoded_freq, tokens, &ngram_str))
+			ssgnc::Coordinator coordinator;
+			if (!coordinator.open(workers, *query))
 			{
-				SSGNC_ERROR << "ssgnc::Database::decode() failed" << std::endl;
+				SSGNC_ERROR << "ssgnc::Coordinator::open() failed"
+					<< std::endl;
 				return false;
 			}
 
-			std::cout << ngram_str << '\n';
-			if (!std::cout)
-			{
-				SSGNC_ERROR << "std::ostream::operator<<() failed"
-					<< std::endl;
+			if (!printNgrams(database, &coordinator))
 				return false;
-			}
+			continue;
 		}
 
-		// The bad bit of `agent' indicates if an error has occured or not.
-		if (agent.bad())
+		// ssgnc::Agent opens .db files corresponding to the query. Then,
+		// the agent's read() returns n-grams one by one, and readBatch()
+		// returns them in batches.
+		// If you want to reuse the agent for efficiency, please call close()
+		// before() the next search. Otherwise, the next search fails.
+		ssgnc::Agent agent;
+		if (!database.search(*query, &agent))
 		{
-			SSGNC_ERROR << "ssgnc::Agent::read() failed" << std::endl;
+			SSGNC_ERROR << "ssgnc::Database::search() failed" << std::endl;
 			return false;
 		}
 
-		std::cout << '\n';
-		if (!std::cout)
-		{
-			SSGNC_ERROR << "std::ostream::operator<<() failed" << std::endl;
+		if (!printBatches(database, &agent))
 			return false;
-		}
 	}
 
 	// The bad bit of `in' indicates whether an error has occured or not.
@@ -136,17 +227,78 @@ int main(int argc, char *argv[])
 
 	// A dictionary file and an index file are opend as memory-mapped files.
 	// If open() takes ssgnc::FileMap::READ_FILE as the 2nd argument,
-	// the entire files are loaded in this function.
+	// the entire files are loaded in this function. Flags such as
+	// ssgnc::FileMap::POPULATE_PAGES and ssgnc::FileMap::LOCK_PAGES can be
+	// combined with the mode by operator|() to keep the files in memory.
 	// Database files containing n-grams are opened when a query is given.
 	ssgnc::Database database;
 	if (!database.open(argv[1]))
 		return 3;
 
+	// If SSGNC_ACCESS_LOG is set, the byte ranges read by searches are
+	// appended to the file. ssgnc-warmup reads the log and loads the same
+	// ranges into the page cache.
+	std::ofstream access_log_file;
+	ssgnc::AccessLog access_log;
+	const char *access_log_path = std::getenv("SSGNC_ACCESS_LOG");
+	if (access_log_path != NULL)
+	{
+		access_log_file.open(access_log_path, std::ios::app);
+		if (!access_log_file || !access_log.open(&access_log_file))
+		{
+			SSGNC_ERROR << "std::ofstream::open() failed: "
+				<< access_log_path << std::endl;
+			return 3;
+		}
+		database.set_access_log(&access_log);
+	}
+
+	// If SSGNC_RESULT_CACHE is set, the results of queries are cached in
+	// memory of the given number of bytes. Repeated queries are answered
+	// from the cache.
+	ssgnc::ResultCache result_cache;
+	const char *result_cache_size = std::getenv("SSGNC_RESULT_CACHE");
+	if (result_cache_size != NULL)
+	{
+		ssgnc::Int64 cache_size = std::strtoll(result_cache_size, NULL, 10);
+		if (cache_size <= 0 ||
+			!result_cache.open(static_cast<ssgnc::UInt64>(cache_size)))
+			return 3;
+		database.set_result_cache(&result_cache);
+	}
+
+	// If SSGNC_WORKERS is set, queries are sent to ssgnc-worker processes,
+	// which listen on the comma-separated addresses. The local index is
+	// still used to parse queries and to decode results.
+	std::vector<std::string> worker_paths;
+	std::vector<ssgnc::String> workers;
+	const char *workers_str = std::getenv("SSGNC_WORKERS");
+	if (workers_str != NULL)
+	{
+		std::istringstream workers_stream(workers_str);
+		std::string worker_path;
+		while (std::getline(workers_stream, worker_path, ','))
+		{
+			if (!worker_path.empty())
+				worker_paths.push_back(worker_path);
+		}
+		for (std::size_t i = 0; i < worker_paths.size(); ++i)
+		{
+			workers.push_back(ssgnc::String(worker_paths[i].c_str(),
+				worker_paths[i].length()));
+		}
+	}
+
+	// If SSGNC_EXPLAIN is set, the plan of each query is written to the
+	// standard error before its results.
+	bool is_explained = std::getenv("SSGNC_EXPLAIN") != NULL;
+
 	// If there are no more arguments,
 	// queries are read from the standard input.
 	if (argc == 2)
 	{
-		if (!searchNgrams(&std::cin, database, &query))
+		if (!searchNgrams(&std::cin, database, workers, is_explained,
+			&query))
 			return 4;
 	}
 
@@ -163,9 +315,18 @@ int main(int argc, char *argv[])
 			continue;
 		}
 
-		if (!searchNgrams(&file, database, &query))
+		if (!searchNgrams(&file, database, workers, is_explained, &query))
 			return 4;
 	}
 
+	if (result_cache.is_open())
+	{
+		std::cerr << "Cache hits: " << result_cache.num_hits()
+			<< ", Resumes: " << result_cache.num_resumes()
+			<< ", Misses: " << result_cache.num_misses()
+			<< ", Hit rate: " << result_cache.hit_rate() << std::endl;
+		result_cache.close();
+	}
+
 	return 0;
 }
@@ -0,0 +1,374 @@
+#include <ssgnc.h>
+
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+namespace {
+
+enum { DEFAULT_NUM_THREADS = 4, MAX_NUM_THREADS = 256 };
+enum { BUF_SIZE = 1 << 16 };
+
+// A connection which sends nothing for IDLE_TIMEOUT seconds is closed, so
+// that idle clients do not hold all the threads.
+enum { IDLE_TIMEOUT = 60 };
+
+// A session keeps the objects used by a thread, so that requests are served
+// without reallocating them.
+class Session
+{
+public:
+	explicit Session(ssgnc::DatabaseHandle *handle)
+		: handle_(handle), snapshot_(), waiter_(), query_(), query_str_(),
+		tokens_(), ngram_str_() {}
+
+	bool serve(int fd);
+
+private:
+	ssgnc::DatabaseHandle *handle_;
+	ssgnc::DatabaseHandle::Ref snapshot_;
+	ssgnc::Coalescer::Waiter waiter_;
+	ssgnc::Query query_;
+	ssgnc::StringBuilder query_str_;
+	std::vector<ssgnc::Int32> tokens_;
+	ssgnc::StringBuilder ngram_str_;
+
+	bool searchNgrams(ssgnc::Writer *writer);
+
+	// Disallows copies.
+	Session(const Session &);
+	Session &operator=(const Session &);
+};
+
+struct Task
+{
+	ssgnc::DatabaseHandle *handle;
+	const char *index_dir;
+	const char *warmup_path;
+	int listen_fd;
+};
+
+// Requests are served in order until the client closes the connection.
+// Responses are flushed only when no more requests are buffered, so that
+// pipelined requests are answered with fewer system calls.
+bool Session::serve(int fd)
+{
+	ssgnc::FdStreambuf streambuf;
+	if (!streambuf.open(fd, BUF_SIZE))
+	{
+		SSGNC_ERROR << "ssgnc::FdStreambuf::open() failed" << std::endl;
+		::close(fd);
+		return false;
+	}
+
+	std::iostream stream(&streambuf);
+	ssgnc::Reader reader;
+	ssgnc::Writer writer;
+	if (!reader.open(&stream) || !writer.open(&stream))
+	{
+		SSGNC_ERROR << "ssgnc::Reader::open() failed" << std::endl;
+		return false;
+	}
+
+	for ( ; ; )
+	{
+		if (streambuf.in_avail() <= 0 && !stream.flush())
+		{
+			SSGNC_ERROR << "std::iostream::flush() failed" << std::endl;
+			return false;
+		}
+		else if (stream.peek() == std::char_traits<char>::eof())
+			return true;
+
+		if (!ssgnc::Protocol::readRequest(&reader, &query_, &query_str_))
+		{
+			SSGNC_ERROR << "ssgnc::Protocol::readRequest() failed"
+				<< std::endl;
+			return false;
+		}
+
+		// A request holds the current snapshot, so that a reload does not
+		// close the index while its results are being read.
+		bool is_ok = snapshot_.acquire(handle_) && searchNgrams(&writer);
+		if (waiter_.is_open())
+			waiter_.close();
+		if (snapshot_.is_open())
+			snapshot_.release();
+
+		if (!ssgnc::Protocol::writeEndOfNgrams(&writer, is_ok))
+		{
+			SSGNC_ERROR << "ssgnc::Protocol::writeEndOfNgrams() failed"
+				<< std::endl;
+			return false;
+		}
+	}
+}
+
+bool Session::searchNgrams(ssgnc::Writer *writer)
+{
+	const ssgnc::Database &database = snapshot_->database();
+	if (!database.parseQuery(query_str_.str(), &query_))
+	{
+		SSGNC_ERROR << "ssgnc::Database::parseQuery() failed" << std::endl;
+		return false;
+	}
+	else if (!snapshot_->coalescer()->search(query_, &waiter_))
+	{
+		SSGNC_ERROR << "ssgnc::Coalescer::search() failed" << std::endl;
+		return false;
+	}
+
+	ssgnc::Int16 encoded_freq;
+	while (waiter_.read(&encoded_freq, &tokens_))
+	{
+		if (!database.decode(encoded_freq, tokens_, &ngram_str_))
+		{
+			SSGNC_ERROR << "ssgnc::Database::decode() failed" << std::endl;
+			return false;
+		}
+		else if (!ssgnc::Protocol::writeNgram(writer, ngram_str_.str()))
+		{
+			SSGNC_ERROR << "ssgnc::Protocol::writeNgram() failed" << std::endl;
+			return false;
+		}
+	}
+
+	if (waiter_.bad())
+	{
+		SSGNC_ERROR << "ssgnc::Coalescer::Waiter::read() failed"
+			<< std::endl;
+		return false;
+	}
+	return true;
+}
+
+// A read which times out fails like the end of the connection.
+bool setIdleTimeout(int fd)
+{
+	struct timeval timeout;
+	timeout.tv_sec = IDLE_TIMEOUT;
+	timeout.tv_usec = 0;
+	if (::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO,
+		&timeout, sizeof(timeout)) != 0)
+	{
+		SSGNC_ERROR << "::setsockopt() failed: " << std::strerror(errno)
+			<< std::endl;
+		return false;
+	}
+	return true;
+}
+
+// Threads accept connections from the same socket. A connection is served
+// by one thread until it is closed.
+void *serveConnections(void *arg)
+{
+	const Task *task = static_cast<const Task *>(arg);
+
+	Session session(task->handle);
+	for ( ; ; )
+	{
+		int fd;
+		if (!ssgnc::Socket::accept(task->listen_fd, &fd))
+			break;
+
+		if (!setIdleTimeout(fd))
+		{
+			SSGNC_ERROR << "setIdleTimeout() failed" << std::endl;
+			::close(fd);
+			continue;
+		}
+
+		if (!session.serve(fd))
+			SSGNC_ERROR << "Session::serve() failed" << std::endl;
+	}
+	return NULL;
+}
+
+// A warm-up file has a query per line, e.g. recent queries from a log.
+// Empty lines are ignored.
+bool readQueries(const char *path, std::vector<std::string> *queries)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file)
+	{
+		SSGNC_ERROR << "std::ifstream::open() failed: " << path << std::endl;
+		return false;
+	}
+
+	queries->clear();
+	std::string line;
+	while (std::getline(file, line))
+	{
+		if (!line.empty())
+			queries->push_back(line);
+	}
+
+	if (file.bad())
+	{
+		SSGNC_ERROR << "std::getline() failed: " << path << std::endl;
+		return false;
+	}
+	return true;
+}
+
+// SIGHUP reloads the index from INDEX_DIR. A new index is deployed by
+// replacing INDEX_DIR, e.g. a symbolic link, and then sending SIGHUP. If a
+// warm-up file is given, it is read again for each reload and its queries
+// are searched on the new index before it replaces the current one.
+void *reloadIndex(void *arg)
+{
+	const Task *task = static_cast<const Task *>(arg);
+
+	sigset_t signals;
+	::sigemptyset(&signals);
+	::sigaddset(&signals, SIGHUP);
+	std::vector<std::string> queries;
+	for ( ; ; )
+	{
+		int signal_number;
+		if (::sigwait(&signals, &signal_number) != 0)
+		{
+			SSGNC_ERROR << "::sigwait() failed" << std::endl;
+			break;
+		}
+
+		if (task->warmup_path != NULL &&
+			!readQueries(task->warmup_path, &queries))
+		{
+			SSGNC_ERROR << "readQueries() failed: " << task->warmup_path
+				<< std::endl;
+			continue;
+		}
+
+		if (!task->handle->reload(task->index_dir,
+			(task->warmup_path != NULL) ? &queries : NULL))
+		{
+			SSGNC_ERROR << "ssgnc::DatabaseHandle::reload() failed: "
+				<< task->index_dir << std::endl;
+			continue;
+		}
+		std::cerr << "Reloaded: " << task->index_dir << ", Generation: "
+			<< task->handle->generation() << std::endl;
+	}
+	return NULL;
+}
+
+bool parseNumThreads(const char *str, std::size_t *num_threads)
+{
+	char *end_of_value;
+	long value = std::strtol(str, &end_of_value, 10);
+	if (*end_of_value != '\0' || value < 1 || value > MAX_NUM_THREADS)
+	{
+		SSGNC_ERROR << "Out of range #threads: " << str << std::endl;
+		return false;
+	}
+	*num_threads = static_cast<std::size_t>(value);
+	return true;
+}
+
+bool parseCacheSize(const char *str, ssgnc::UInt64 *cache_size)
+{
+	char *end_of_value;
+	errno = 0;
+	ssgnc::Int64 value = std::strtoll(str, &end_of_value, 10);
+	if (end_of_value == str || *end_of_value != '\0' || errno == ERANGE ||
+		value < 0)
+	{
+		SSGNC_ERROR << "Out of range cache size: " << str << std::endl;
+		return false;
+	}
+	*cache_size = static_cast<ssgnc::UInt64>(value);
+	return true;
+}
+
+}  // namespace
+
+int main(int argc, char *argv[])
+{
+	if (argc < 3 || argc > 6)
+	{
+		std::cerr << "Usage: " << argv[0]
+			<< " INDEX_DIR ADDRESS [NUM_THREADS [CACHE_SIZE [WARMUP_FILE]]]"
+			"\n\n"
+			<< "ADDRESS: [HOST]:PORT or the path of a Unix domain socket\n"
+			<< "NUM_THREADS: [1-" << MAX_NUM_THREADS << "] (default: "
+			<< DEFAULT_NUM_THREADS << ")\n"
+			<< "CACHE_SIZE: the size of the result cache in bytes"
+			" (default: 0, disabled)\n"
+			<< "WARMUP_FILE: queries, one per line, which are searched to"
+			" warm a reloaded index" << std::endl;
+		return 1;
+	}
+
+	std::size_t num_threads = DEFAULT_NUM_THREADS;
+	if (argc >= 4 && !parseNumThreads(argv[3], &num_threads))
+		return 1;
+
+	ssgnc::UInt64 cache_size = 0;
+	if (argc >= 5 && !parseCacheSize(argv[4], &cache_size))
+		return 1;
+
+	// The warm-up file is read once here to find a wrong path early.
+	std::vector<std::string> queries;
+	if (argc >= 6 && !readQueries(argv[5], &queries))
+		return 1;
+
+	// The dictionary, the index and the result cache are opened once and
+	// shared by threads. Identical queries in flight share an agent, so that
+	// a spike of a popular query reads its lists only once.
+	ssgnc::DatabaseHandle handle;
+	if (!handle.open(argv[1], ssgnc::FileMap::DEFAULT_MODE, cache_size))
+		return 2;
+
+	Task task;
+	task.handle = &handle;
+	task.index_dir = argv[1];
+	task.warmup_path = (argc >= 6) ? argv[5] : NULL;
+	if (!ssgnc::Socket::listen(argv[2], &task.listen_fd))
+		return 3;
+
+	// A client may close its connection before the end of a response.
+	std::signal(SIGPIPE, SIG_IGN);
+
+	// SIGHUP is blocked in all the threads and received by reloadIndex().
+	sigset_t signals;
+	::sigemptyset(&signals);
+	::sigaddset(&signals, SIGHUP);
+	::pthread_sigmask(SIG_BLOCK, &signals, NULL);
+
+	pthread_t reload_thread;
+	if (::pthread_create(&reload_thread, NULL, reloadIndex, &task) != 0)
+	{
+		SSGNC_ERROR << "::pthread_create() failed" << std::endl;
+		return 4;
+	}
+	::pthread_detach(reload_thread);
+
+	std::vector<pthread_t> threads(num_threads);
+	std::size_t num_started = 0;
+	for ( ; num_started < num_threads; ++num_started)
+	{
+		if (::pthread_create(&threads[num_started], NULL,
+			serveConnections, &task) != 0)
+		{
+			SSGNC_ERROR << "::pthread_create() failed" << std::endl;
+			break;
+		}
+	}
+
+	// Threads return only if accept() fails.
+	for (std::size_t i = 0; i < num_started; ++i)
+		::pthread_join(threads[i], NULL);
+
+	::close(task.listen_fd);
+	return 4;
+}
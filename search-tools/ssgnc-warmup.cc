@@ -0,0 +1,397 @@
+#include <ssgnc.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+enum { MAX_NUM_THREADS = 64 };
+
+// A byte range of a file to be loaded into the page cache.
+struct Range
+{
+	Range() : path(), offset(0), length(0) {}
+
+	std::string path;
+	ssgnc::UInt64 offset;
+	ssgnc::UInt64 length;
+};
+
+// Records are merged by their list heads. A list is always read from its
+// head, so the longest length covers the other records.
+struct Access
+{
+	ssgnc::UInt64 length;
+	ssgnc::UInt64 count;
+};
+
+typedef std::pair<std::pair<ssgnc::Int32, ssgnc::Int32>, ssgnc::UInt64>
+	ListHead;
+typedef std::map<ListHead, Access> AccessMap;
+typedef std::pair<ListHead, Access> AccessPair;
+
+struct Task
+{
+	const std::vector<Range> *ranges;
+	std::size_t thread_id;
+	std::size_t num_threads;
+	ssgnc::UInt64 total;
+	bool is_ok;
+};
+
+// This function reads a line from `in' and stores it into `line'.
+// If the stream reaches its end or an unexpected error occurs,
+// this function returns false. And in the latter case,
+// the bad bit of `in' is set to true.
+bool readLine(std::istream *in, std::string *line)
+{
+	try
+	{
+		if (!std::getline(*in, *line))
+			return false;
+		return true;
+	}
+	catch (...)
+	{
+		in->setstate(std::ios::badbit);
+		return false;
+	}
+}
+
+bool parseUInt64(const char *str, ssgnc::UInt64 *value)
+{
+	char *end_of_value;
+	ssgnc::Int64 temp = std::strtoll(str, &end_of_value, 10);
+	if (*end_of_value != '\0' || temp < 0)
+	{
+		SSGNC_ERROR << "Invalid value: " << str << std::endl;
+		return false;
+	}
+	*value = static_cast<ssgnc::UInt64>(temp);
+	return true;
+}
+
+bool readAccessLog(std::istream *in, AccessMap *accesses)
+{
+	std::string line;
+	while (readLine(in, &line))
+	{
+		if (line.empty())
+			continue;
+
+		ssgnc::AccessLog::Record record;
+		if (!ssgnc::AccessLog::parse(ssgnc::String(line.c_str(),
+			static_cast<ssgnc::UInt32>(line.length())), &record))
+		{
+			SSGNC_ERROR << "ssgnc::AccessLog::parse() failed" << std::endl;
+			continue;
+		}
+
+		ListHead head(std::make_pair(record.num_tokens(), record.file_id()),
+			record.offset());
+		Access &access = (*accesses)[head];
+		if (record.length() > access.length)
+			access.length = record.length();
+		++access.count;
+	}
+
+	if (in->bad())
+	{
+		SSGNC_ERROR << "::readLine() failed" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+// Frequently accessed lists come first. Short lists are preferred among
+// lists with the same count because they cost less of the budget.
+bool compareAccesses(const AccessPair &lhs, const AccessPair &rhs)
+{
+	if (lhs.second.count != rhs.second.count)
+		return lhs.second.count > rhs.second.count;
+	return lhs.second.length < rhs.second.length;
+}
+
+bool getFileSize(const std::string &path, ssgnc::UInt64 *file_size)
+{
+	struct stat file_stat;
+	if (::stat(path.c_str(), &file_stat) != 0)
+		return false;
+	*file_size = static_cast<ssgnc::UInt64>(file_stat.st_size);
+	return true;
+}
+
+bool appendRange(const std::string &path, ssgnc::UInt64 offset,
+	ssgnc::UInt64 length, std::vector<Range> *ranges)
+{
+	Range range;
+	range.path = path;
+	range.offset = offset;
+	range.length = length;
+
+	try
+	{
+		ranges->push_back(range);
+	}
+	catch (...)
+	{
+		SSGNC_ERROR << "std::vector<Range>::push_back() failed: "
+			<< ranges->size() << std::endl;
+		return false;
+	}
+	return true;
+}
+
+bool appendFile(const ssgnc::String &index_dir, const ssgnc::String &basename,
+	ssgnc::UInt64 *budget, std::vector<Range> *ranges)
+{
+	ssgnc::StringBuilder path;
+	if (!ssgnc::FilePath::join(index_dir, basename, &path))
+	{
+		SSGNC_ERROR << "ssgnc::FilePath::join() failed" << std::endl;
+		return false;
+	}
+
+	ssgnc::UInt64 file_size;
+	if (!getFileSize(path.ptr(), &file_size))
+	{
+		SSGNC_ERROR << "::stat() failed: " << path << std::endl;
+		return false;
+	}
+
+	if (file_size > *budget)
+		file_size = *budget;
+	*budget -= file_size;
+
+	return appendRange(path.ptr(), 0, file_size, ranges);
+}
+
+// A range of the original format may continue to the following files.
+bool appendList(const ssgnc::ShardMap &shard_map, const ListHead &head,
+	ssgnc::UInt64 length, ssgnc::UInt64 *budget, std::vector<Range> *ranges)
+{
+	ssgnc::String index_dir = shard_map.index_dir();
+
+	ssgnc::StringBuilder basename;
+	if (!basename.appendf("%dgm-%%04d.db", head.first.first))
+	{
+		SSGNC_ERROR << "ssgnc::StringBuilder::appendf() failed" << std::endl;
+		return false;
+	}
+
+	ssgnc::FilePath file_path;
+	if (!file_path.open(index_dir, basename.str()) ||
+		!file_path.seek(head.first.second))
+	{
+		SSGNC_ERROR << "ssgnc::FilePath::open() failed: "
+			<< index_dir << ", " << basename << std::endl;
+		return false;
+	}
+
+	ssgnc::UInt64 offset = head.second;
+	if (length > *budget)
+		length = *budget;
+	while (length > 0)
+	{
+		ssgnc::StringBuilder path;
+		if (!file_path.read(shard_map.dirname(shard_map.find(
+			head.first.first, file_path.tell())), &path))
+		{
+			SSGNC_ERROR << "ssgnc::FilePath::read() failed" << std::endl;
+			return false;
+		}
+
+		ssgnc::UInt64 file_size;
+		if (!getFileSize(path.ptr(), &file_size))
+		{
+			SSGNC_ERROR << "::stat() failed: " << path << std::endl;
+			return false;
+		}
+		else if (offset >= file_size)
+		{
+			offset -= file_size;
+			continue;
+		}
+
+		ssgnc::UInt64 range_length = file_size - offset;
+		if (range_length > length)
+			range_length = length;
+		if (!appendRange(path.ptr(), offset, range_length, ranges))
+			return false;
+
+		*budget -= range_length;
+		length -= range_length;
+		offset = 0;
+	}
+	return true;
+}
+
+bool loadRange(const Range &range)
+{
+	int fd = ::open(range.path.c_str(), O_RDONLY);
+	if (fd == -1)
+	{
+		SSGNC_ERROR << "::open() failed: " << range.path << std::endl;
+		return false;
+	}
+
+	// readahead() blocks until the range is read, so the threads keep the
+	// device busy. posix_fadvise() only starts reading.
+#ifdef __linux__
+	int ret = ::readahead(fd, static_cast<off64_t>(range.offset),
+		static_cast<std::size_t>(range.length));
+#else  // __linux__
+	int ret = ::posix_fadvise(fd, static_cast<off_t>(range.offset),
+		static_cast<off_t>(range.length), POSIX_FADV_WILLNEED);
+#endif  // __linux__
+	::close(fd);
+
+	if (ret != 0)
+	{
+		SSGNC_ERROR << "::readahead() failed: " << range.path << ", "
+			<< range.offset << ", " << range.length << std::endl;
+		return false;
+	}
+	return true;
+}
+
+void *loadRanges(void *arg)
+{
+	Task *task = static_cast<Task *>(arg);
+	const std::vector<Range> &ranges = *task->ranges;
+	for (std::size_t i = task->thread_id; i < ranges.size();
+		i += task->num_threads)
+	{
+		if (loadRange(ranges[i]))
+			task->total += ranges[i].length;
+		else
+			task->is_ok = false;
+	}
+	return NULL;
+}
+
+bool warmUp(const std::vector<Range> &ranges, std::size_t num_threads)
+{
+	std::vector<Task> tasks(num_threads);
+	std::vector<pthread_t> threads(num_threads);
+	for (std::size_t i = 0; i < num_threads; ++i)
+	{
+		tasks[i].ranges = &ranges;
+		tasks[i].thread_id = i;
+		tasks[i].num_threads = num_threads;
+		tasks[i].total = 0;
+		tasks[i].is_ok = true;
+	}
+
+	std::size_t num_started = 0;
+	for ( ; num_started < num_threads; ++num_started)
+	{
+		if (::pthread_create(&threads[num_started], NULL,
+			loadRanges, &tasks[num_started]) != 0)
+		{
+			SSGNC_ERROR << "::pthread_create() failed" << std::endl;
+			break;
+		}
+	}
+
+	bool is_ok = (num_started == num_threads);
+	ssgnc::UInt64 total = 0;
+	for (std::size_t i = 0; i < num_started; ++i)
+	{
+		::pthread_join(threads[i], NULL);
+		total += tasks[i].total;
+		if (!tasks[i].is_ok)
+			is_ok = false;
+	}
+
+	std::cerr << "No. ranges: " << ranges.size()
+		<< ", Total size: " << total << std::endl;
+
+	return is_ok;
+}
+
+}  // namespace
+
+int main(int argc, char *argv[])
+{
+	if (argc < 4)
+	{
+		std::cerr << "Usage: " << argv[0]
+			<< " INDEX_DIR BUDGET NUM_THREADS [ACCESS_LOG]...\n\n"
+			<< "BUDGET: the maximum number of bytes to load (0: unlimited)\n"
+			<< "NUM_THREADS: [1-" << MAX_NUM_THREADS << "]\n"
+			<< "ACCESS_LOG: written by SSGNC_ACCESS_LOG=FILE ssgnc-search"
+			<< std::endl;
+		return 1;
+	}
+
+	ssgnc::String index_dir = argv[1];
+
+	ssgnc::UInt64 budget, num_threads;
+	if (!parseUInt64(argv[2], &budget) ||
+		!parseUInt64(argv[3], &num_threads))
+		return 1;
+	else if (num_threads < 1 || num_threads > MAX_NUM_THREADS)
+	{
+		SSGNC_ERROR << "Out of range #threads: " << num_threads << std::endl;
+		return 1;
+	}
+
+	if (budget == 0)
+		budget = ~0ULL;
+
+	AccessMap accesses;
+	if (argc == 4)
+	{
+		if (!readAccessLog(&std::cin, &accesses))
+			return 2;
+	}
+	for (int i = 4; i < argc; ++i)
+	{
+		std::ifstream file(argv[i], std::ios::binary);
+		if (!file)
+		{
+			SSGNC_ERROR << "std::ifstream::open() failed: "
+				<< argv[i] << std::endl;
+			continue;
+		}
+
+		if (!readAccessLog(&file, &accesses))
+			return 2;
+	}
+
+	ssgnc::ShardMap shard_map;
+	if (!shard_map.open(index_dir))
+		return 3;
+
+	// The dictionary and the index are used by every query.
+	std::vector<Range> ranges;
+	if (!appendFile(index_dir, "vocab.dic", &budget, &ranges) ||
+		!appendFile(index_dir, "ngms.idx", &budget, &ranges))
+		return 3;
+
+	std::vector<AccessPair> sorted_accesses(accesses.begin(), accesses.end());
+	std::sort(sorted_accesses.begin(), sorted_accesses.end(),
+		compareAccesses);
+	for (std::size_t i = 0; i < sorted_accesses.size() && budget > 0; ++i)
+	{
+		if (!appendList(shard_map, sorted_accesses[i].first,
+			sorted_accesses[i].second.length, &budget, &ranges))
+			return 3;
+	}
+
+	if (!warmUp(ranges, static_cast<std::size_t>(num_threads)))
+		return 4;
+
+	return 0;
+}
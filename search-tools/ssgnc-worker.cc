@@ -0,0 +1,202 @@
+#include <ssgnc.h>
+
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+
+#include <unistd.h>
+
+namespace {
+
+// A worker serves lists of orders from `min_num_tokens' to `max_num_tokens'
+// whose tokens are from `min_token_id' to `max_token_id'. Workers which
+// cover disjoint partitions of an index return disjoint results.
+struct Partition
+{
+	Partition() : min_num_tokens(1), max_num_tokens(ssgnc::Query::MAX_NUM_TOKENS),
+		min_token_id(0), max_token_id(0x7FFFFFFF) {}
+
+	ssgnc::Int32 min_num_tokens;
+	ssgnc::Int32 max_num_tokens;
+	ssgnc::Int32 min_token_id;
+	ssgnc::Int32 max_token_id;
+
+	bool contains(const ssgnc::Agent::Source &source) const
+	{
+		return source.num_tokens() >= min_num_tokens &&
+			source.num_tokens() <= max_num_tokens &&
+			source.token_id() >= min_token_id &&
+			source.token_id() <= max_token_id;
+	}
+};
+
+bool parseInt32(const char *str, ssgnc::Int32 *value)
+{
+	char *end_of_value;
+	long temp = std::strtol(str, &end_of_value, 10);
+	if (*end_of_value != '\0' || temp < 0 || temp > 0x7FFFFFFFL)
+	{
+		SSGNC_ERROR << "Invalid value: " << str << std::endl;
+		return false;
+	}
+	*value = static_cast<ssgnc::Int32>(temp);
+	return true;
+}
+
+bool searchNgrams(const ssgnc::Database &database,
+	const Partition &partition, ssgnc::Reader *reader, ssgnc::Writer *writer)
+{
+	ssgnc::Query query;
+	if (!ssgnc::Protocol::readQuery(reader, &query))
+	{
+		SSGNC_ERROR << "ssgnc::Protocol::readQuery() failed" << std::endl;
+		return false;
+	}
+
+	std::vector<ssgnc::Agent::Source> sources;
+	if (!database.plan(query, &sources))
+	{
+		SSGNC_ERROR << "ssgnc::Database::plan() failed" << std::endl;
+		return false;
+	}
+
+	std::vector<ssgnc::Agent::Source> partition_sources;
+	for (std::size_t i = 0; i < sources.size(); ++i)
+	{
+		if (partition.contains(sources[i]))
+			partition_sources.push_back(sources[i]);
+	}
+
+	ssgnc::Agent agent;
+	if (!agent.open(database.shard_map(), query, partition_sources))
+	{
+		SSGNC_ERROR << "ssgnc::Agent::open() failed" << std::endl;
+		return false;
+	}
+
+	// The number of bytes read so far goes with each result, so that the
+	// coordinator can apply the I/O limit to the sum of the workers.
+	ssgnc::Int16 encoded_freq;
+	std::vector<ssgnc::Int32> tokens;
+	while (agent.read(&encoded_freq, &tokens))
+	{
+		if (!ssgnc::Protocol::writeResult(writer, encoded_freq, tokens,
+			agent.tell()))
+		{
+			SSGNC_ERROR << "ssgnc::Protocol::writeResult() failed"
+				<< std::endl;
+			return false;
+		}
+	}
+
+	if (agent.bad())
+	{
+		SSGNC_ERROR << "ssgnc::Agent::read() failed" << std::endl;
+		return false;
+	}
+
+	if (!ssgnc::Protocol::writeEnd(writer, true, agent.tell()))
+	{
+		SSGNC_ERROR << "ssgnc::Protocol::writeEnd() failed" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+// A connection carries one query and its results.
+bool serve(const ssgnc::Database &database, const Partition &partition,
+	int fd)
+{
+	ssgnc::FdStreambuf streambuf;
+	if (!streambuf.open(fd))
+	{
+		SSGNC_ERROR << "ssgnc::FdStreambuf::open() failed" << std::endl;
+		::close(fd);
+		return false;
+	}
+
+	std::iostream stream(&streambuf);
+	ssgnc::Reader reader;
+	ssgnc::Writer writer;
+	if (!reader.open(&stream) || !writer.open(&stream))
+	{
+		SSGNC_ERROR << "ssgnc::Reader::open() failed" << std::endl;
+		return false;
+	}
+
+	bool is_ok = searchNgrams(database, partition, &reader, &writer);
+	if (!is_ok && writer.good())
+	{
+		if (!ssgnc::Protocol::writeEnd(&writer, false, 0))
+			SSGNC_ERROR << "ssgnc::Protocol::writeEnd() failed" << std::endl;
+	}
+
+	if (!stream.flush())
+	{
+		SSGNC_ERROR << "std::iostream::flush() failed" << std::endl;
+		return false;
+	}
+	return is_ok;
+}
+
+}  // namespace
+
+int main(int argc, char *argv[])
+{
+	if (argc != 3 && argc != 5 && argc != 7)
+	{
+		std::cerr << "Usage: " << argv[0] << " INDEX_DIR ADDRESS"
+			" [MIN_NUM_TOKENS MAX_NUM_TOKENS [MIN_TOKEN_ID MAX_TOKEN_ID]]\n\n"
+			<< "The worker serves the lists of orders from MIN_NUM_TOKENS to"
+			" MAX_NUM_TOKENS\nand tokens from MIN_TOKEN_ID to MAX_TOKEN_ID."
+			" Run ssgnc-search with\nSSGNC_WORKERS=ADDRESS,... to merge"
+			" the results of workers.\nADDRESS: [HOST]:PORT or the path of"
+			" a Unix domain socket" << std::endl;
+		return 1;
+	}
+
+	Partition partition;
+	if (argc >= 5 && (!parseInt32(argv[3], &partition.min_num_tokens) ||
+		!parseInt32(argv[4], &partition.max_num_tokens)))
+		return 1;
+	if (argc >= 7 && (!parseInt32(argv[5], &partition.min_token_id) ||
+		!parseInt32(argv[6], &partition.max_token_id)))
+		return 1;
+
+	// The index is mapped before fork(), so that the processes share it.
+	ssgnc::Database database;
+	if (!database.open(argv[1]))
+		return 2;
+
+	int listen_fd;
+	if (!ssgnc::Socket::listen(argv[2], &listen_fd))
+		return 3;
+
+	// A coordinator may close a connection before the end of the results.
+	// Finished processes are reaped automatically.
+	std::signal(SIGPIPE, SIG_IGN);
+	std::signal(SIGCHLD, SIG_IGN);
+
+	for ( ; ; )
+	{
+		int fd;
+		if (!ssgnc::Socket::accept(listen_fd, &fd))
+			return 4;
+
+		pid_t pid = ::fork();
+		if (pid == -1)
+		{
+			SSGNC_ERROR << "::fork() failed" << std::endl;
+			::close(fd);
+			continue;
+		}
+		else if (pid == 0)
+		{
+			::close(listen_fd);
+			::_exit(serve(database, partition, fd) ? 0 : 5);
+		}
+		::close(fd);
+	}
+
+	return 0;
+}
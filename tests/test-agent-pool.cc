@@ -0,0 +1,422 @@
+#include "ssgnc.h"
+
+#include <cassert>
+#include <cstdio>
+#include <sstream>
+
+#include <pthread.h>
+#include <sys/stat.h>
+
+namespace {
+
+enum { NUM_TOKENS = 5, NUM_NGRAMS = 300, NUM_THREADS = 8, NUM_LOOPS = 200 };
+enum { NUM_KEYS = 16, MAX_NUM_TOKENS = 2, NUM_DATABASE_LOOPS = 20 };
+
+const char INDEX_DIR[] = "test-agent-pool.d";
+
+struct Task
+{
+	ssgnc::AgentPool *pool;
+	const std::vector<ssgnc::Agent::Source> *sources;
+	int thread_id;
+	bool is_ok;
+};
+
+struct QuerySpec
+{
+	std::string str;
+	ssgnc::Int64 max_num_results;
+};
+
+struct DatabaseTask
+{
+	const ssgnc::Database *database;
+	ssgnc::AgentPool *pool;
+	const std::vector<QuerySpec> *queries;
+	const std::vector<std::string> *outputs;
+	int thread_id;
+	bool is_ok;
+};
+
+bool writeValue(ssgnc::Int32 value, std::ostream *out)
+{
+	ssgnc::UInt8 temp_buf[8];
+	ssgnc::Int32 num_bytes = 0;
+
+	while (value >= 0x80)
+	{
+		temp_buf[num_bytes++] = static_cast<ssgnc::UInt8>(value & 0x7F);
+		value >>= 7;
+	}
+	temp_buf[num_bytes++] = static_cast<ssgnc::UInt8>(value & 0x7F);
+
+	for (ssgnc::Int32 i = 1; i < num_bytes; ++i)
+		out->put(temp_buf[num_bytes - i] | 0x80);
+	out->put(temp_buf[0]);
+
+	return !!*out;
+}
+
+// The n-gram of ID i is (1, i + 2, 3, 4, 5) and its frequency is
+// NUM_NGRAMS - i. Every n-gram has the token 1, and only one has 7.
+bool searchNgrams(const Task &task, bool has_seven)
+{
+	ssgnc::Query query;
+	if (!query.appendToken(1) || (has_seven && !query.appendToken(7)))
+		return false;
+
+	ssgnc::Agent *agent = task.pool->acquire();
+	if (agent == NULL)
+		return false;
+
+	bool is_ok = agent->open(".", query, *task.sources);
+
+	ssgnc::Int16 encoded_freq;
+	std::vector<ssgnc::Int32> tokens;
+	ssgnc::Int32 num_results = 0;
+	ssgnc::Int16 prev_freq = NUM_NGRAMS + 1;
+	while (is_ok && agent->read(&encoded_freq, &tokens))
+	{
+		if (tokens.size() != NUM_TOKENS || tokens[0] != 1 ||
+			encoded_freq >= prev_freq)
+			is_ok = false;
+		prev_freq = encoded_freq;
+		++num_results;
+	}
+
+	if (agent->bad())
+		is_ok = false;
+	else if (num_results != (has_seven ? 1 : NUM_NGRAMS))
+		is_ok = false;
+
+	task.pool->release(agent);
+	return is_ok;
+}
+
+void *stress(void *arg)
+{
+	Task *task = static_cast<Task *>(arg);
+	for (int i = 0; i < NUM_LOOPS; ++i)
+	{
+		if (!searchNgrams(*task, (i % 2) != 0))
+			task->is_ok = false;
+
+		SSGNC_ERROR << "thread " << task->thread_id
+			<< ", loop " << i << std::endl;
+	}
+	return NULL;
+}
+
+std::string indexPath(const char *basename)
+{
+	return std::string(INDEX_DIR) + "/" + basename;
+}
+
+// The tokens are "a", "b", ... and each pair of different tokens is a
+// bigram. The k-th bigram has a frequency of 900 - k, so the lists are
+// written in order of frequency.
+void writeDatabase()
+{
+	::mkdir(INDEX_DIR, 0755);
+
+	std::vector<std::string> key_strs;
+	std::vector<ssgnc::String> keys;
+	for (int i = 0; i < NUM_KEYS; ++i)
+		key_strs.push_back(std::string(1, static_cast<char>('a' + i)));
+	for (int i = 0; i < NUM_KEYS; ++i)
+		keys.push_back(key_strs[i].c_str());
+	assert(ssgnc::VocabDic::build(indexPath("vocab.dic").c_str(), keys));
+
+	std::vector<ssgnc::NgramIndex::FileEntry> entries(
+		MAX_NUM_TOKENS * (NUM_KEYS + 1));
+	for (int num_tokens = 1; num_tokens <= MAX_NUM_TOKENS; ++num_tokens)
+	{
+		char basename[16];
+		std::sprintf(basename, "%dgm-0000.db", num_tokens);
+		std::ofstream file(indexPath(basename).c_str(), std::ios::binary);
+		assert(file);
+
+		for (int i = 0; i <= NUM_KEYS; ++i)
+		{
+			ssgnc::NgramIndex::FileEntry &entry =
+				entries[(MAX_NUM_TOKENS * i) + num_tokens - 1];
+			assert(entry.set_file_id(0));
+			assert(entry.set_offset(
+				static_cast<ssgnc::UInt32>(file.tellp())));
+			if (i == NUM_KEYS)
+				break;
+
+			if (num_tokens == 1)
+			{
+				assert(writeValue(990 - i, &file));
+				assert(writeValue(i, &file));
+			}
+			else
+			{
+				int k = 0;
+				for (int j = 0; j < NUM_KEYS; ++j)
+				{
+					for (int l = 0; l < NUM_KEYS; ++l)
+					{
+						if (j == l)
+							continue;
+						else if (j == i || l == i)
+						{
+							assert(writeValue(900 - k, &file));
+							assert(writeValue(j, &file));
+							assert(writeValue(l, &file));
+						}
+						++k;
+					}
+				}
+			}
+			assert(writeValue(0, &file));
+		}
+	}
+
+	std::ofstream file(indexPath("ngms.idx").c_str(), std::ios::binary);
+	ssgnc::Writer writer;
+	assert(writer.open(&file));
+	assert(writer.write(static_cast<ssgnc::Int32>(MAX_NUM_TOKENS)));
+	assert(writer.write(static_cast<ssgnc::Int32>(NUM_KEYS - 1)));
+	assert(writer.write(&entries[0], entries.size()));
+}
+
+// Queries of a single token, two tokens and a wildcard. A query with a
+// limit shares the cache entry of the same query without a limit.
+void makeQueries(std::vector<QuerySpec> *queries)
+{
+	for (int i = 0; i < NUM_KEYS; ++i)
+	{
+		std::string token(1, static_cast<char>('a' + i));
+		std::string other(1, static_cast<char>('a' + ((i + 3) % NUM_KEYS)));
+
+		QuerySpec spec = { token, 0 };
+		queries->push_back(spec);
+		spec.max_num_results = 5;
+		queries->push_back(spec);
+		spec.str = token + " " + other;
+		spec.max_num_results = 0;
+		queries->push_back(spec);
+		spec.str = "* " + token;
+		queries->push_back(spec);
+	}
+
+	QuerySpec spec = { "unknown", 0 };
+	queries->push_back(spec);
+}
+
+// The results are decoded into lines of the output.
+bool runQuery(const ssgnc::Database &database, ssgnc::AgentPool *pool,
+	const QuerySpec &spec, std::string *output)
+{
+	ssgnc::Query query;
+	if (!database.parseQuery(spec.str.c_str(), &query) ||
+		(spec.max_num_results != 0 &&
+		!query.set_max_num_results(spec.max_num_results)))
+		return false;
+
+	ssgnc::Agent *agent = pool->acquire();
+	if (agent == NULL)
+		return false;
+
+	bool is_ok = database.search(query, agent);
+
+	ssgnc::Int16 encoded_freq;
+	std::vector<ssgnc::Int32> tokens;
+	ssgnc::StringBuilder ngram;
+	output->clear();
+	while (is_ok && agent->read(&encoded_freq, &tokens))
+	{
+		if (!database.decode(encoded_freq, tokens, &ngram))
+			is_ok = false;
+		output->append(ngram.str().ptr(), ngram.str().length());
+		*output += '\n';
+	}
+
+	if (agent->bad())
+		is_ok = false;
+
+	pool->release(agent);
+	return is_ok;
+}
+
+// Each thread starts at a different query, so the threads miss, fill and
+// hit the cache entries of the same queries at the same time.
+void *searchDatabase(void *arg)
+{
+	DatabaseTask *task = static_cast<DatabaseTask *>(arg);
+	const std::vector<QuerySpec> &queries = *task->queries;
+
+	std::string output;
+	for (int i = 0; i < NUM_DATABASE_LOOPS; ++i)
+	{
+		for (std::size_t j = 0; j < queries.size(); ++j)
+		{
+			std::size_t id = (j + (task->thread_id * 7)) % queries.size();
+			if (!runQuery(*task->database, task->pool, queries[id], &output) ||
+				output != (*task->outputs)[id])
+				task->is_ok = false;
+		}
+	}
+	return NULL;
+}
+
+}  // namespace
+
+int main()
+{
+	std::ofstream file("5gm-0000.db", std::ios::binary);
+	for (int i = 0; i < NUM_NGRAMS; ++i)
+	{
+		assert(writeValue(NUM_NGRAMS - i, &file));
+		assert(writeValue(1, &file));
+		assert(writeValue(i + 2, &file));
+		for (int j = 3; j <= NUM_TOKENS; ++j)
+			assert(writeValue(j, &file));
+	}
+	assert(writeValue(0, &file));
+	file.close();
+
+	ssgnc::NgramIndex::Entry entry;
+	assert(entry.set_file_id(0));
+	assert(entry.set_offset(0));
+
+	std::vector<ssgnc::Agent::Source> sources;
+	sources.push_back(ssgnc::Agent::Source(NUM_TOKENS, entry));
+
+	// A closed agent is kept only if the free list has room.
+	ssgnc::AgentPool pool;
+	assert(!pool.is_open());
+	assert(pool.acquire() == NULL);
+	assert(pool.open(1));
+	assert(pool.is_open());
+
+	ssgnc::Agent *agent = pool.acquire();
+	ssgnc::Agent *other_agent = pool.acquire();
+	assert(agent != NULL && other_agent != NULL && agent != other_agent);
+	assert(pool.num_acquired_agents() == 2);
+	assert(pool.num_created_agents() == 2);
+	assert(!pool.close());
+
+	pool.release(agent);
+	pool.release(other_agent);
+	assert(pool.num_acquired_agents() == 0);
+	assert(pool.num_free_agents() == 1);
+	assert(pool.acquire() == agent);
+	pool.release(agent);
+	assert(pool.close());
+
+	// Threads share the pool, the error stream and the files.
+	std::ostringstream log;
+	ssgnc::set_error_stream(&log);
+
+	assert(pool.open());
+
+	std::vector<Task> tasks(NUM_THREADS);
+	std::vector<pthread_t> threads(NUM_THREADS);
+	for (int i = 0; i < NUM_THREADS; ++i)
+	{
+		tasks[i].pool = &pool;
+		tasks[i].sources = &sources;
+		tasks[i].thread_id = i;
+		tasks[i].is_ok = true;
+		assert(::pthread_create(&threads[i], NULL, stress, &tasks[i]) == 0);
+	}
+	for (int i = 0; i < NUM_THREADS; ++i)
+	{
+		assert(::pthread_join(threads[i], NULL) == 0);
+		assert(tasks[i].is_ok);
+	}
+
+	assert(pool.num_acquired_agents() == 0);
+	assert(pool.num_created_agents() <= NUM_THREADS);
+	assert(pool.num_free_agents() == pool.num_created_agents());
+	assert(pool.close());
+
+	ssgnc::disable_error_logging();
+
+	// Each message consists of a header line and a body line, which must
+	// not be mixed with lines of other threads.
+	std::istringstream log_lines(log.str());
+	std::string header, body;
+	std::vector<int> num_messages(NUM_THREADS, 0);
+	while (std::getline(log_lines, header))
+	{
+		assert(header.find(": error:") != std::string::npos);
+		assert(std::getline(log_lines, body));
+		assert(body.find("  In stress(): thread ") == 0);
+
+		int thread_id = body[22] - '0';
+		assert(thread_id >= 0 && thread_id < NUM_THREADS);
+		++num_messages[thread_id];
+	}
+	for (int i = 0; i < NUM_THREADS; ++i)
+		assert(num_messages[i] == NUM_LOOPS);
+
+	// Threads share a database with a result cache and an access log, and
+	// their results are the same as those of a single thread without them.
+	ssgnc::set_error_stream(&std::clog);
+	writeDatabase();
+
+	ssgnc::Database database;
+	assert(database.open(INDEX_DIR));
+	assert(pool.open());
+
+	std::vector<QuerySpec> queries;
+	makeQueries(&queries);
+	std::vector<std::string> outputs(queries.size());
+	for (std::size_t i = 0; i < queries.size(); ++i)
+		assert(runQuery(database, &pool, queries[i], &outputs[i]));
+	assert(outputs[0].find("a\t") == 0);
+	assert(outputs[queries.size() - 1].empty());
+
+	ssgnc::ResultCache result_cache;
+	assert(result_cache.open(1 << 20));
+	std::ostringstream access_log_stream;
+	ssgnc::AccessLog access_log;
+	assert(access_log.open(&access_log_stream));
+	database.set_result_cache(&result_cache);
+	database.set_access_log(&access_log);
+
+	std::vector<DatabaseTask> database_tasks(NUM_THREADS);
+	for (int i = 0; i < NUM_THREADS; ++i)
+	{
+		database_tasks[i].database = &database;
+		database_tasks[i].pool = &pool;
+		database_tasks[i].queries = &queries;
+		database_tasks[i].outputs = &outputs;
+		database_tasks[i].thread_id = i;
+		database_tasks[i].is_ok = true;
+		assert(::pthread_create(&threads[i], NULL, searchDatabase,
+			&database_tasks[i]) == 0);
+	}
+	for (int i = 0; i < NUM_THREADS; ++i)
+	{
+		assert(::pthread_join(threads[i], NULL) == 0);
+		assert(database_tasks[i].is_ok);
+	}
+
+	assert(result_cache.num_hits() > 0);
+	assert(result_cache.num_entries() > 0);
+	assert(access_log.num_records() > 0);
+
+	// The records of the threads are not mixed.
+	std::istringstream access_log_lines(access_log_stream.str());
+	std::string line;
+	ssgnc::UInt64 num_records = 0;
+	while (std::getline(access_log_lines, line))
+	{
+		ssgnc::AccessLog::Record record;
+		assert(ssgnc::AccessLog::parse(line.c_str(), &record));
+		++num_records;
+	}
+	assert(num_records == access_log.num_records());
+
+	assert(pool.close());
+	assert(result_cache.close());
+	assert(access_log.close());
+	assert(database.close());
+
+	return 0;
+}
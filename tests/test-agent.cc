@@ -0,0 +1,317 @@
+#include "ssgnc.h"
+
+#include <cassert>
+#include <new>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+enum { NUM_TOKENS = 4, NUM_NGRAMS = 100, NUM_WARMUPS = 3, NUM_LOOPS = 100 };
+enum { NUM_LARGE_NGRAMS = 50000 };
+
+ssgnc::UInt64 num_allocs = 0;
+
+bool writeValue(ssgnc::Int32 value, std::ostream *out)
+{
+	ssgnc::UInt8 temp_buf[8];
+	ssgnc::Int32 num_bytes = 0;
+
+	while (value >= 0x80)
+	{
+		temp_buf[num_bytes++] = static_cast<ssgnc::UInt8>(value & 0x7F);
+		value >>= 7;
+	}
+	temp_buf[num_bytes++] = static_cast<ssgnc::UInt8>(value & 0x7F);
+
+	for (ssgnc::Int32 i = 1; i < num_bytes; ++i)
+		out->put(temp_buf[num_bytes - i] | 0x80);
+	out->put(temp_buf[0]);
+
+	return !!*out;
+}
+
+bool writeNgram(ssgnc::Int32 freq, ssgnc::Int32 first_token,
+	ssgnc::Int32 last_token, std::ostream *out)
+{
+	if (!writeValue(freq, out) || !writeValue(first_token, out))
+		return false;
+	for (ssgnc::Int32 i = 2; i < NUM_TOKENS; ++i)
+	{
+		if (!writeValue(100 + i, out))
+			return false;
+	}
+	return writeValue(last_token, out);
+}
+
+void copyFile(const char *src_path, const char *dest_path)
+{
+	std::ifstream src(src_path, std::ios::binary);
+	std::ofstream dest(dest_path, std::ios::binary);
+	assert(src && dest);
+	dest << src.rdbuf();
+	assert(dest);
+}
+
+}  // namespace
+
+// Allocations are counted to check the steady state of reused agents.
+#if __cplusplus < 201103L
+void *operator new(std::size_t size) throw(std::bad_alloc)
+#else  // __cplusplus < 201103L
+void *operator new(std::size_t size)
+#endif  // __cplusplus < 201103L
+{
+	++num_allocs;
+	void *ptr = std::malloc(size != 0 ? size : 1);
+	if (ptr == NULL)
+		throw std::bad_alloc();
+	return ptr;
+}
+
+void operator delete(void *ptr) throw()
+{
+	std::free(ptr);
+}
+
+// Sized deallocation is used since C++14, and it must match the replaced
+// unsized version.
+#if __cplusplus >= 201402L
+void operator delete(void *ptr, std::size_t) throw()
+{
+	::operator delete(ptr);
+}
+#endif  // __cplusplus >= 201402L
+
+int main()
+{
+	// The first list starts in 4gm-0000.db and continues to 4gm-0001.db.
+	// The second list follows the first one in 4gm-0001.db.
+	std::ofstream file("4gm-0000.db", std::ios::binary);
+	for (int i = 0; i < NUM_NGRAMS / 2; ++i)
+		assert(writeNgram(1000 - i, 1, i, &file));
+	file.close();
+
+	file.open("4gm-0001.db", std::ios::binary);
+	for (int i = NUM_NGRAMS / 2; i < NUM_NGRAMS; ++i)
+		assert(writeNgram(1000 - i, 1, i, &file));
+	assert(writeValue(0, &file));
+
+	ssgnc::Int32 second_offset = static_cast<ssgnc::Int32>(file.tellp());
+	for (int i = 0; i < NUM_NGRAMS; ++i)
+		assert(writeNgram(1000 - (2 * i) - 1, 1, 1000 + i, &file));
+	assert(writeValue(0, &file));
+	file.close();
+
+	ssgnc::NgramIndex::Entry first_entry, second_entry;
+	assert(first_entry.set_file_id(0));
+	assert(first_entry.set_offset(0));
+	assert(second_entry.set_file_id(1));
+	assert(second_entry.set_offset(second_offset));
+
+	std::vector<ssgnc::Agent::Source> sources;
+	sources.push_back(ssgnc::Agent::Source(NUM_TOKENS, first_entry));
+	sources.push_back(ssgnc::Agent::Source(NUM_TOKENS, second_entry));
+
+	ssgnc::Query query;
+	assert(query.appendToken(1));
+
+	ssgnc::Agent agent;
+	ssgnc::Int16 encoded_freq;
+	std::vector<ssgnc::Int32> tokens;
+	for (int i = 0; i < NUM_WARMUPS + NUM_LOOPS; ++i)
+	{
+		if (i == NUM_WARMUPS)
+			num_allocs = 0;
+
+		assert(agent.open(".", query, sources));
+
+		// The lists are merged in descending order of frequency.
+		int num_results = 0;
+		ssgnc::Int16 prev_freq = 0x7FFF;
+		while (agent.read(&encoded_freq, &tokens))
+		{
+			assert(encoded_freq <= prev_freq);
+			assert(tokens.size() == NUM_TOKENS && tokens[0] == 1);
+			prev_freq = encoded_freq;
+			++num_results;
+		}
+		assert(!agent.bad());
+		assert(num_results == NUM_NGRAMS * 2);
+		assert(agent.stop_reason() == ssgnc::Agent::END_OF_LISTS);
+
+		assert(agent.close());
+	}
+
+	// Searches of a reused agent do not allocate memory.
+	assert(num_allocs == 0);
+
+	// A batch has the same results as read().
+	ssgnc::Int16 batch_freqs[NUM_NGRAMS * 2];
+	ssgnc::Int32 batch_last_tokens[NUM_NGRAMS * 2];
+	assert(agent.open(".", query, sources));
+	for (int i = 0; i < NUM_NGRAMS * 2; ++i)
+	{
+		assert(agent.read(&encoded_freq, &tokens));
+		batch_freqs[i] = encoded_freq;
+		batch_last_tokens[i] = tokens[NUM_TOKENS - 1];
+	}
+	assert(agent.close());
+
+	ssgnc::ResultBatch batch;
+	for (int i = 0; i < NUM_WARMUPS + NUM_LOOPS; ++i)
+	{
+		if (i == NUM_WARMUPS)
+			num_allocs = 0;
+
+		assert(agent.open(".", query, sources));
+
+		int num_results = 0;
+		while (agent.readBatch(&batch, 7))
+		{
+			assert(batch.size() <= 7);
+			for (ssgnc::UInt32 j = 0; j < batch.size(); ++j)
+			{
+				assert(batch.num_tokens(j) == NUM_TOKENS);
+				assert(batch.tokens(j)[0] == 1);
+				assert(batch.encoded_freq(j) == batch_freqs[num_results]);
+				assert(batch.tokens(j)[NUM_TOKENS - 1] ==
+					batch_last_tokens[num_results]);
+				++num_results;
+			}
+		}
+		assert(!agent.bad());
+		assert(batch.empty());
+		assert(num_results == NUM_NGRAMS * 2);
+
+		assert(agent.close());
+	}
+	assert(num_allocs == 0);
+
+	// The second file is moved to another shard. The lists of the shard are
+	// opened by a worker thread of the agent, which is started by the first
+	// search and reused by the others.
+	::mkdir("test-agent.d", 0755);
+	::mkdir("test-agent.d/shard", 0755);
+	copyFile("4gm-0000.db", "test-agent.d/4gm-0000.db");
+	copyFile("4gm-0001.db", "test-agent.d/shard/4gm-0001.db");
+	{
+		std::ofstream shards_file("test-agent.d/ngms.shards");
+		shards_file << NUM_TOKENS << " 1 shard\n";
+	}
+
+	ssgnc::ShardMap shard_map;
+	assert(shard_map.open("test-agent.d"));
+	assert(shard_map.num_shards() == 2);
+	for (int i = 0; i < NUM_WARMUPS + NUM_LOOPS; ++i)
+	{
+		if (i == NUM_WARMUPS)
+			num_allocs = 0;
+
+		assert(agent.open(shard_map, query, sources));
+		int num_results = 0;
+		while (agent.read(&encoded_freq, &tokens))
+			++num_results;
+		assert(!agent.bad());
+		assert(num_results == NUM_NGRAMS * 2);
+		assert(agent.close());
+	}
+	assert(num_allocs == 0);
+
+	// A reused agent stops at the limits of its query.
+	assert(query.set_max_num_results(10));
+	assert(agent.open(".", query, sources));
+	int num_results = 0;
+	while (agent.read(&encoded_freq, &tokens))
+		++num_results;
+	assert(num_results == 10);
+	assert(agent.stop_reason() == ssgnc::Agent::MAX_NUM_RESULTS);
+	assert(agent.close());
+
+	// The scan limit counts the n-grams rejected by the filter too.
+	ssgnc::Query budget_query;
+	assert(budget_query.appendToken(1));
+	assert(budget_query.appendToken(999));
+	assert(budget_query.set_scan_limit(50));
+	assert(agent.open(".", budget_query, sources));
+	assert(!agent.read(&encoded_freq, &tokens));
+	assert(!agent.bad());
+	assert(agent.num_scanned() == 50);
+	assert(agent.stop_reason() == ssgnc::Agent::SCAN_LIMIT);
+	assert(agent.close());
+	assert(agent.num_scanned() == 0);
+
+	// A canceled search stops before reading lists, and the request is
+	// cleared by close().
+	assert(agent.open(".", query, sources));
+	agent.cancel();
+	assert(!agent.read(&encoded_freq, &tokens));
+	assert(!agent.bad());
+	assert(agent.stop_reason() == ssgnc::Agent::CANCELED);
+	assert(agent.close());
+
+	assert(agent.open(".", query, sources));
+	assert(agent.read(&encoded_freq, &tokens));
+	assert(agent.stop_reason() == ssgnc::Agent::NOT_STOPPED);
+	assert(agent.close());
+
+	budget_query.clearTokens();
+	assert(budget_query.appendToken(1));
+	assert(budget_query.set_scan_limit(0));
+	assert(budget_query.set_time_limit(1));
+	assert(agent.open(".", budget_query, sources));
+	::usleep(1000);
+	assert(!agent.read(&encoded_freq, &tokens));
+	assert(agent.stop_reason() == ssgnc::Agent::TIME_LIMIT);
+	assert(ssgnc::String(ssgnc::Agent::stopReasonName(
+		agent.stop_reason())) == "time-limit");
+	assert(agent.close());
+
+	// A large list is evicted from the page cache, so that tryRead() stops
+	// when the next n-gram needs disk I/O. The eviction depends on the file
+	// system, so the number of stops is not tested.
+	file.open("4gm-0002.db", std::ios::binary);
+	for (int i = 0; i < NUM_LARGE_NGRAMS; ++i)
+		assert(writeNgram(((NUM_LARGE_NGRAMS - i) >> 6) + 1, 1, i, &file));
+	assert(writeValue(0, &file));
+	file.close();
+
+	ssgnc::NgramIndex::Entry large_entry;
+	assert(large_entry.set_file_id(2));
+	assert(large_entry.set_offset(0));
+	std::vector<ssgnc::Agent::Source> large_sources;
+	large_sources.push_back(ssgnc::Agent::Source(NUM_TOKENS, large_entry));
+
+	assert(budget_query.set_time_limit(0));
+	assert(agent.open(".", budget_query, large_sources));
+
+	// The list is evicted after open(), which has read its head.
+	int fd = ::open("4gm-0002.db", O_RDONLY);
+	assert(fd != -1);
+	assert(::fdatasync(fd) == 0);
+	assert(::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED) == 0);
+	assert(::close(fd) == 0);
+	num_results = 0;
+	for ( ; ; )
+	{
+		if (agent.tryRead(&encoded_freq, &tokens))
+		{
+			assert(tokens[NUM_TOKENS - 1] == num_results);
+			++num_results;
+			continue;
+		}
+		else if (!agent.would_block())
+			break;
+
+		assert(!agent.pending_read().empty());
+		assert(agent.pending_read().length() > 0);
+		assert(agent.pending_read().load());
+	}
+	assert(!agent.bad());
+	assert(num_results == NUM_LARGE_NGRAMS);
+	assert(agent.close());
+
+	return 0;
+}
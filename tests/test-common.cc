@@ -1,6 +1,18 @@
 #include "ssgnc.h"
 
 #include <cassert>
+#include <sstream>
+
+namespace {
+
+int num_evaluations = 0;
+
+int evaluate()
+{
+	return ++num_evaluations;
+}
+
+}  // namespace
 
 int main()
 {
@@ -14,5 +26,41 @@ int main()
 	assert(sizeof(ssgnc::UInt32) == 4);
 	assert(sizeof(ssgnc::UInt64) == 8);
 
+	std::ostringstream log;
+	ssgnc::set_error_stream(&log);
+	assert(ssgnc::log_level() == ssgnc::LOG_ERROR);
+
+	// Messages of disabled levels are not formatted.
+	SSGNC_ERROR << evaluate() << std::endl;
+	SSGNC_WARNING << evaluate() << std::endl;
+	SSGNC_INFO << evaluate() << std::endl;
+	assert(num_evaluations == 1);
+	assert(log.str().find(": error:\n  In main(): 1\n") != std::string::npos);
+	assert(log.str().find(": warning:") == std::string::npos);
+
+	ssgnc::set_log_level(ssgnc::LOG_INFO);
+	if (num_evaluations != 0)
+		SSGNC_WARNING << evaluate() << std::endl;
+	else
+		assert(false);
+	SSGNC_INFO << evaluate() << std::endl;
+	assert(num_evaluations == 3);
+	assert(log.str().find(": warning:\n  In main(): 2\n") != std::string::npos);
+	assert(log.str().find(": info:\n  In main(): 3\n") != std::string::npos);
+
+	// A message is not passed until it is flushed.
+	std::string::size_type length = log.str().length();
+	SSGNC_INFO << "pending";
+	ssgnc::flush_error_stream();
+	assert(log.str().length() == length);
+	SSGNC_INFO << std::flush;
+	assert(log.str().find("pending") != std::string::npos);
+
+	ssgnc::disable_error_logging();
+	SSGNC_ERROR << evaluate() << std::endl;
+	assert(num_evaluations == 3);
+
+	ssgnc::set_log_level(ssgnc::LOG_ERROR);
+
 	return 0;
 }
@@ -0,0 +1,100 @@
+#include "ssgnc.h"
+
+#include <cassert>
+
+int main()
+{
+	ssgnc::Query query;
+	assert(query.appendToken(5));
+	assert(query.appendToken(ssgnc::Query::META_TOKEN));
+
+	ssgnc::Cursor cursor;
+	cursor.set_checksum(ssgnc::Cursor::checksum(query));
+	cursor.set_num_results(100);
+	cursor.set_total(1ULL << 40);
+
+	ssgnc::Cursor::List list;
+	list.set_num_tokens(3);
+	list.set_file_id(12);
+	list.set_offset(123456);
+	list.set_encoded_freq(1000);
+	assert(cursor.appendList(list));
+	list.set_num_tokens(5);
+	list.set_file_id(0);
+	list.set_offset(0);
+	list.set_encoded_freq(1);
+	assert(cursor.appendList(list));
+
+	ssgnc::Cursor::Key key;
+	assert(key.set("0123456789abcdef"));
+
+	ssgnc::StringBuilder str;
+	assert(cursor.encode(key, &str));
+	for (ssgnc::UInt32 i = 0; i < str.length(); ++i)
+	{
+		assert((str[i] >= 'A' && str[i] <= 'Z') ||
+			(str[i] >= 'a' && str[i] <= 'z') ||
+			(str[i] >= '0' && str[i] <= '9') ||
+			str[i] == '-' || str[i] == '_');
+	}
+
+	ssgnc::Cursor decoded;
+	assert(decoded.decode(key, str.str()));
+	assert(decoded.checksum() == cursor.checksum());
+	assert(decoded.num_results() == 100);
+	assert(decoded.total() == (1ULL << 40));
+	assert(decoded.num_lists() == 2);
+	assert(decoded.list(0).num_tokens() == 3);
+	assert(decoded.list(0).file_id() == 12);
+	assert(decoded.list(0).offset() == 123456);
+	assert(decoded.list(0).encoded_freq() == 1000);
+	assert(decoded.list(1).num_tokens() == 5);
+	assert(decoded.list(1).file_id() == 0);
+	assert(decoded.list(1).offset() == 0);
+	assert(decoded.list(1).encoded_freq() == 1);
+
+	// The limits are not a part of the checksum.
+	assert(query.set_max_num_results(20));
+	assert(query.set_io_limit(1 << 20));
+	assert(ssgnc::Cursor::checksum(query) == cursor.checksum());
+
+	assert(query.set_order(ssgnc::Query::PHRASE));
+	assert(ssgnc::Cursor::checksum(query) != cursor.checksum());
+	assert(query.set_order(ssgnc::Query::DEFAULT_ORDER));
+	assert(query.appendToken(7));
+	assert(ssgnc::Cursor::checksum(query) != cursor.checksum());
+
+	// Broken cursors are rejected.
+	ssgnc::disable_error_logging();
+	assert(!decoded.decode(key, str.str().substr(0, str.length() - 2)));
+	assert(decoded.num_lists() == 0);
+	assert(!decoded.decode(key, "invalid+cursor"));
+	assert(!decoded.decode(key, ""));
+
+	// A cursor is rejected if it is modified or signed with another key.
+	ssgnc::StringBuilder forged;
+	assert(forged.append(str.str()));
+	for (ssgnc::UInt32 i = 0; i < forged.length(); ++i)
+	{
+		ssgnc::Int8 c = forged[i];
+		forged[i] = (c == 'A') ? 'B' : 'A';
+		assert(!decoded.decode(key, forged.str()));
+		forged[i] = c;
+	}
+	assert(decoded.decode(key, forged.str()));
+
+	ssgnc::Cursor::Key other_key;
+	assert(other_key.set("0123456789abcdeF"));
+	assert(!decoded.decode(other_key, str.str()));
+	assert(other_key.generate());
+	assert(!decoded.decode(other_key, str.str()));
+	assert(!other_key.set("too short"));
+	ssgnc::set_error_stream(&std::clog);
+
+	ssgnc::Cursor empty_cursor;
+	assert(empty_cursor.encode(key, &str));
+	assert(decoded.decode(key, str.str()));
+	assert(decoded.num_lists() == 0);
+
+	return 0;
+}
@@ -0,0 +1,161 @@
+#include "ssgnc.h"
+
+#include <cassert>
+
+#include <sys/stat.h>
+
+namespace {
+
+enum { NUM_KEYS = 2 };
+
+const char INDEX_DIR[] = "test-database-handle.d";
+
+bool writeValue(ssgnc::Int32 value, std::ostream *out)
+{
+	ssgnc::UInt8 temp_buf[8];
+	ssgnc::Int32 num_bytes = 0;
+
+	while (value >= 0x80)
+	{
+		temp_buf[num_bytes++] = static_cast<ssgnc::UInt8>(value & 0x7F);
+		value >>= 7;
+	}
+	temp_buf[num_bytes++] = static_cast<ssgnc::UInt8>(value & 0x7F);
+
+	for (ssgnc::Int32 i = 1; i < num_bytes; ++i)
+		out->put(temp_buf[num_bytes - i] | 0x80);
+	out->put(temp_buf[0]);
+
+	return !!*out;
+}
+
+// An index of unigrams "a" and "b" is written into INDEX_DIR/name.
+std::string writeIndex(const char *name, const ssgnc::Int32 freqs[])
+{
+	std::string index_dir = std::string(INDEX_DIR) + "/" + name;
+	::mkdir(index_dir.c_str(), 0755);
+
+	std::vector<ssgnc::String> keys;
+	keys.push_back("a");
+	keys.push_back("b");
+	assert(ssgnc::VocabDic::build((index_dir + "/vocab.dic").c_str(), keys));
+
+	std::ofstream db_file((index_dir + "/1gm-0000.db").c_str(),
+		std::ios::binary);
+	std::vector<ssgnc::NgramIndex::FileEntry> entries(NUM_KEYS + 1);
+	for (ssgnc::Int32 i = 0; i <= NUM_KEYS; ++i)
+	{
+		assert(entries[i].set_file_id(0));
+		assert(entries[i].set_offset(
+			static_cast<ssgnc::UInt32>(db_file.tellp())));
+		if (i == NUM_KEYS)
+			break;
+
+		assert(writeValue(freqs[i], &db_file));
+		assert(writeValue(i, &db_file));
+		assert(writeValue(0, &db_file));
+	}
+	db_file.close();
+
+	std::ofstream idx_file((index_dir + "/ngms.idx").c_str(),
+		std::ios::binary);
+	ssgnc::Writer writer;
+	assert(writer.open(&idx_file));
+	assert(writer.write(static_cast<ssgnc::Int32>(1)));
+	assert(writer.write(static_cast<ssgnc::Int32>(NUM_KEYS - 1)));
+	assert(writer.write(&entries[0], entries.size()));
+
+	return index_dir;
+}
+
+// Returns the encoded frequency of "a" in the snapshot.
+ssgnc::Int16 searchFreq(ssgnc::DatabaseHandle::Snapshot *snapshot)
+{
+	const ssgnc::Database &database = snapshot->database();
+
+	ssgnc::Query query;
+	assert(database.parseQuery("a", &query));
+
+	ssgnc::Agent agent;
+	assert(database.search(query, &agent));
+
+	ssgnc::Int16 encoded_freq, next_encoded_freq;
+	std::vector<ssgnc::Int32> tokens;
+	assert(agent.read(&encoded_freq, &tokens));
+	assert(tokens.size() == 1 && tokens[0] == 0);
+	assert(!agent.read(&next_encoded_freq, &tokens));
+	assert(!agent.bad());
+	assert(agent.close());
+	return encoded_freq;
+}
+
+}  // namespace
+
+int main()
+{
+	::mkdir(INDEX_DIR, 0755);
+
+	static const ssgnc::Int32 OLD_FREQS[NUM_KEYS] = { 100, 90 };
+	static const ssgnc::Int32 NEW_FREQS[NUM_KEYS] = { 200, 90 };
+	std::string old_dir = writeIndex("old", OLD_FREQS);
+	std::string new_dir = writeIndex("new", NEW_FREQS);
+
+	// The index of the broken directory is truncated.
+	std::string broken_dir = writeIndex("broken", NEW_FREQS);
+	std::ofstream((broken_dir + "/ngms.idx").c_str(), std::ios::binary);
+
+	ssgnc::DatabaseHandle handle;
+	assert(!handle.is_open());
+	assert(handle.open(old_dir.c_str()));
+	assert(handle.is_open());
+	assert(handle.generation() == 1);
+	assert(handle.num_snapshots() == 1);
+
+	// A reference keeps the old snapshot across a reload, and the new
+	// snapshot is warmed by the queries before it replaces the old one.
+	ssgnc::DatabaseHandle::Ref old_ref;
+	assert(old_ref.acquire(&handle));
+	assert(old_ref->generation() == 1);
+	assert(searchFreq(old_ref.snapshot()) == OLD_FREQS[0]);
+
+	std::vector<std::string> queries;
+	queries.push_back("a");
+	queries.push_back("b");
+	assert(handle.reload(new_dir.c_str(), &queries));
+	assert(handle.generation() == 2);
+	assert(handle.num_reloads() == 1);
+	assert(handle.num_snapshots() == 2);
+
+	assert(old_ref->generation() == 1);
+	assert(searchFreq(old_ref.snapshot()) == OLD_FREQS[0]);
+
+	ssgnc::DatabaseHandle::Ref new_ref;
+	assert(new_ref.acquire(&handle));
+	assert(new_ref->generation() == 2);
+	assert(searchFreq(new_ref.snapshot()) == NEW_FREQS[0]);
+
+	// A failed reload keeps the current snapshot.
+	ssgnc::disable_error_logging();
+	assert(!handle.reload((std::string(INDEX_DIR) + "/missing").c_str()));
+	assert(!handle.reload(broken_dir.c_str(), &queries));
+	ssgnc::set_error_stream(&std::clog);
+	assert(handle.generation() == 2);
+	assert(handle.num_reloads() == 1);
+	assert(handle.num_snapshots() == 2);
+
+	// The old snapshot is deleted when its last reference is released.
+	assert(old_ref.release());
+	assert(!old_ref.is_open());
+	assert(handle.num_snapshots() == 1);
+
+	// The current snapshot is kept by a reference after the handle is
+	// closed.
+	assert(handle.close());
+	assert(!handle.is_open());
+	assert(handle.num_snapshots() == 1);
+	assert(searchFreq(new_ref.snapshot()) == NEW_FREQS[0]);
+	assert(new_ref.release());
+	assert(handle.num_snapshots() == 0);
+
+	return 0;
+}
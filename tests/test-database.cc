@@ -0,0 +1,326 @@
+#include "ssgnc.h"
+
+#include <cassert>
+#include <cstdio>
+
+#include <sys/stat.h>
+
+namespace {
+
+enum { MAX_NUM_TOKENS = 2, NUM_KEYS = 4 };
+
+const char INDEX_DIR[] = "test-database.d";
+
+struct Ngram
+{
+	ssgnc::Int32 freq;
+	ssgnc::Int32 tokens[MAX_NUM_TOKENS];
+};
+
+bool writeValue(ssgnc::Int32 value, std::ostream *out)
+{
+	ssgnc::UInt8 temp_buf[8];
+	ssgnc::Int32 num_bytes = 0;
+
+	while (value >= 0x80)
+	{
+		temp_buf[num_bytes++] = static_cast<ssgnc::UInt8>(value & 0x7F);
+		value >>= 7;
+	}
+	temp_buf[num_bytes++] = static_cast<ssgnc::UInt8>(value & 0x7F);
+
+	for (ssgnc::Int32 i = 1; i < num_bytes; ++i)
+		out->put(temp_buf[num_bytes - i] | 0x80);
+	out->put(temp_buf[0]);
+
+	return !!*out;
+}
+
+std::string indexPath(const char *basename)
+{
+	return std::string(INDEX_DIR) + "/" + basename;
+}
+
+bool contains(const Ngram &ngram, ssgnc::Int32 num_tokens,
+	ssgnc::Int32 token_id)
+{
+	for (ssgnc::Int32 i = 0; i < num_tokens; ++i)
+	{
+		if (ngram.tokens[i] == token_id)
+			return true;
+	}
+	return false;
+}
+
+// The lists of an order are written into a .db file in order of tokens, and
+// their starts and the end of the last list are stored into the entries.
+void writeLists(ssgnc::Int32 num_tokens, const Ngram *ngrams,
+	ssgnc::Int32 num_ngrams,
+	std::vector<ssgnc::NgramIndex::FileEntry> *entries)
+{
+	char basename[16];
+	std::sprintf(basename, "%dgm-0000.db", num_tokens);
+	std::ofstream file(indexPath(basename).c_str(), std::ios::binary);
+	assert(file);
+
+	for (ssgnc::Int32 i = 0; i <= NUM_KEYS; ++i)
+	{
+		ssgnc::NgramIndex::FileEntry &entry =
+			(*entries)[(MAX_NUM_TOKENS * i) + num_tokens - 1];
+		assert(entry.set_file_id(0));
+		assert(entry.set_offset(static_cast<ssgnc::UInt32>(file.tellp())));
+		if (i == NUM_KEYS)
+			break;
+
+		for (ssgnc::Int32 j = 0; j < num_ngrams; ++j)
+		{
+			if (!contains(ngrams[j], num_tokens, i))
+				continue;
+
+			assert(writeValue(ngrams[j].freq, &file));
+			for (ssgnc::Int32 k = 0; k < num_tokens; ++k)
+				assert(writeValue(ngrams[j].tokens[k], &file));
+		}
+		assert(writeValue(0, &file));
+	}
+}
+
+// The statistics count each n-gram in the list of its smallest token.
+void writeStats(const Ngram *ngrams[], const ssgnc::Int32 num_ngrams[],
+	ssgnc::UInt64 index_fingerprint)
+{
+	ssgnc::NgramIndex ngram_index;
+	assert(ngram_index.open(indexPath("ngms.idx").c_str()));
+
+	ssgnc::NgramStats::Builder builder;
+	assert(builder.init(MAX_NUM_TOKENS, NUM_KEYS - 1));
+	builder.set_index(ngram_index.size(), index_fingerprint);
+
+	ssgnc::NgramStats::Sketch sketch;
+	sketch.clear();
+	for (ssgnc::Int32 i = 1; i <= MAX_NUM_TOKENS; ++i)
+	{
+		for (ssgnc::Int32 j = 0; j < NUM_KEYS; ++j)
+		{
+			ssgnc::UInt64 freq_counts[ssgnc::NgramStats::NUM_FREQ_BUCKETS] =
+				{ 0 };
+			ssgnc::UInt64 num_first_ngrams = 0;
+			for (ssgnc::Int32 k = 0; k < num_ngrams[i - 1]; ++k)
+			{
+				const Ngram &ngram = ngrams[i - 1][k];
+				if (!contains(ngram, i, j))
+					continue;
+
+				++freq_counts[0];
+				if (ngram.tokens[0] == j)
+				{
+					assert(builder.appendPairs(ngram.tokens, i));
+					++num_first_ngrams;
+				}
+			}
+			assert(builder.appendList(i, j, freq_counts, sketch,
+				num_first_ngrams));
+		}
+	}
+
+	std::ofstream file(indexPath("ngms.stat").c_str(), std::ios::binary);
+	assert(builder.write(&file));
+}
+
+ssgnc::UInt64 countResults(const ssgnc::Database &database,
+	const ssgnc::Query &query)
+{
+	ssgnc::Agent agent;
+	assert(database.search(query, &agent));
+
+	ssgnc::UInt64 num_results = 0;
+	ssgnc::Int16 encoded_freq;
+	std::vector<ssgnc::Int32> tokens;
+	while (agent.read(&encoded_freq, &tokens))
+		++num_results;
+	assert(!agent.bad());
+	assert(agent.close());
+	return num_results;
+}
+
+}  // namespace
+
+int main()
+{
+	::mkdir(INDEX_DIR, 0755);
+
+	// The token IDs are the indices of the keys.
+	std::vector<ssgnc::String> keys;
+	keys.push_back("a");
+	keys.push_back("b");
+	keys.push_back("c");
+	keys.push_back("d");
+	assert(ssgnc::VocabDic::build(indexPath("vocab.dic").c_str(), keys));
+
+	// The smallest token of an n-gram comes first.
+	static const Ngram UNIGRAMS[] = {
+		{ 100, { 0 } }, { 90, { 1 } }, { 80, { 2 } }, { 70, { 3 } }
+	};
+	static const Ngram BIGRAMS[] = {
+		{ 30, { 0, 1 } }, { 20, { 1, 2 } }
+	};
+	const Ngram *ngrams[MAX_NUM_TOKENS] = { UNIGRAMS, BIGRAMS };
+	const ssgnc::Int32 num_ngrams[MAX_NUM_TOKENS] = { 4, 2 };
+
+	std::vector<ssgnc::NgramIndex::FileEntry> entries(
+		MAX_NUM_TOKENS * (NUM_KEYS + 1));
+	for (ssgnc::Int32 i = 1; i <= MAX_NUM_TOKENS; ++i)
+		writeLists(i, ngrams[i - 1], num_ngrams[i - 1], &entries);
+	{
+		std::ofstream file(indexPath("ngms.idx").c_str(), std::ios::binary);
+		ssgnc::Writer writer;
+		assert(writer.open(&file));
+		assert(writer.write(static_cast<ssgnc::Int32>(MAX_NUM_TOKENS)));
+		assert(writer.write(static_cast<ssgnc::Int32>(NUM_KEYS - 1)));
+		assert(writer.write(&entries[0], entries.size()));
+	}
+
+	ssgnc::UInt64 index_fingerprint;
+	{
+		ssgnc::NgramIndex ngram_index;
+		assert(ngram_index.open(indexPath("ngms.idx").c_str()));
+		index_fingerprint = ngram_index.fingerprint();
+	}
+
+	// Statistics of another build of the index are refused.
+	writeStats(ngrams, num_ngrams, index_fingerprint + 1);
+	ssgnc::Database database;
+	ssgnc::disable_error_logging();
+	assert(!database.open(INDEX_DIR));
+	ssgnc::set_error_stream(&std::clog);
+
+	writeStats(ngrams, num_ngrams, index_fingerprint);
+	assert(database.open(INDEX_DIR));
+	assert(database.ngram_stats().is_open());
+
+	// Without ngms.key, a key is generated when a cursor first needs it and
+	// is kept until the database is closed.
+	const ssgnc::Cursor::Key *cursor_key;
+	assert(database.cursor_key(&cursor_key));
+	ssgnc::UInt64 cursor_k0 = cursor_key->k0();
+	assert(database.cursor_key(&cursor_key));
+	assert(cursor_key->k0() == cursor_k0);
+
+	ssgnc::Query query;
+	assert(database.parseQuery("b", &query));
+	assert(countResults(database, query) == 3);
+
+	// A query whose pairs all co-occur is not pruned.
+	std::vector<ssgnc::Agent::Source> sources;
+	assert(database.parseQuery("a b", &query));
+	assert(database.plan(query, &sources));
+	assert(sources.size() == 1);
+	assert(sources[0].num_tokens() == 2);
+	assert(countResults(database, query) == 1);
+
+	// The pair filter prunes the orders of a query whose tokens never
+	// co-occur, so the search reads no list.
+	assert(database.parseQuery("a c", &query));
+	assert(!database.ngram_stats().mayHavePair(2, 0, 2));
+	assert(database.plan(query, &sources));
+	assert(sources.empty());
+	{
+		ssgnc::Agent agent;
+		assert(database.search(query, &agent));
+		ssgnc::Int16 encoded_freq;
+		std::vector<ssgnc::Int32> tokens;
+		assert(!agent.read(&encoded_freq, &tokens));
+		assert(!agent.bad());
+		assert(agent.stop_reason() == ssgnc::Agent::END_OF_LISTS);
+		assert(agent.tell() == 0);
+		assert(agent.close());
+	}
+
+	// Searches attach to the flight of a query until it has buffered more
+	// than the limit. The range of the number of tokens is normalized, so a
+	// maximum beyond the index does not split the flight.
+	{
+		ssgnc::Coalescer coalescer;
+		assert(coalescer.open(database, 1));
+
+		ssgnc::Query wide_query;
+		assert(database.parseQuery("b", &query));
+		assert(database.parseQuery("b", &wide_query));
+		assert(wide_query.set_max_num_tokens(MAX_NUM_TOKENS + 3));
+
+		ssgnc::Coalescer::Waiter waiters[3];
+		assert(coalescer.search(query, &waiters[0]));
+		assert(coalescer.search(wide_query, &waiters[1]));
+		assert(coalescer.num_flights() == 1);
+		assert(coalescer.num_joins() == 1);
+
+		ssgnc::Int16 encoded_freq;
+		std::vector<ssgnc::Int32> tokens;
+		assert(waiters[0].read(&encoded_freq, &tokens));
+		assert(coalescer.search(query, &waiters[2]));
+		assert(coalescer.num_flights() == 2);
+		assert(coalescer.num_joins() == 1);
+
+		for (int i = 0; i < 3; ++i)
+		{
+			while (waiters[i].read(&encoded_freq, &tokens))
+				continue;
+			assert(!waiters[i].bad());
+			assert(waiters[i].num_results() == 3);
+			assert(waiters[i].close());
+		}
+		assert(coalescer.close());
+	}
+	assert(database.close());
+
+	// A saturated pair filter, which has more than half of its bits set, is
+	// ignored by the planner.
+	{
+		std::fstream file(indexPath("ngms.stat").c_str(),
+			std::ios::in | std::ios::out | std::ios::binary);
+		ssgnc::NgramStats::Header header;
+		assert(file.read(reinterpret_cast<char *>(&header), sizeof(header)));
+		header.pair_filter_num_set_bits =
+			1ULL << header.pair_filter_size_bits;
+		assert(file.seekp(0));
+		assert(file.write(reinterpret_cast<const char *>(&header),
+			sizeof(header)));
+	}
+	assert(database.open(INDEX_DIR, ssgnc::FileMap::DEFAULT_MODE, false));
+	assert(!database.ngram_stats().is_open());
+	assert(database.close());
+	assert(database.open(INDEX_DIR));
+	assert(database.ngram_stats().is_pair_filter_saturated());
+	assert(database.ngram_stats().pair_filter_fill_ratio() == 1.0);
+	assert(database.parseQuery("a c", &query));
+	assert(!database.ngram_stats().mayHavePair(2, 0, 2));
+	assert(database.plan(query, &sources));
+	assert(!sources.empty());
+	assert(countResults(database, query) == 0);
+	assert(database.close());
+
+	// An index without statistics is planned by the sizes of lists.
+	assert(std::remove(indexPath("ngms.stat").c_str()) == 0);
+	assert(database.open(INDEX_DIR));
+	assert(!database.ngram_stats().is_open());
+	assert(database.parseQuery("b", &query));
+	assert(countResults(database, query) == 3);
+	assert(database.parseQuery("a c", &query));
+	assert(database.plan(query, &sources));
+	assert(!sources.empty());
+	assert(countResults(database, query) == 0);
+
+	// A reused agent does not keep the access log of a previous search.
+	{
+		ssgnc::AccessLog access_log;
+		ssgnc::Agent agent;
+		agent.set_access_log(&access_log);
+		assert(database.access_log() == NULL);
+		assert(database.search(query, &agent));
+		assert(agent.access_log() == NULL);
+		assert(agent.close());
+	}
+	assert(database.close());
+
+	return 0;
+}
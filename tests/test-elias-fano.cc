@@ -0,0 +1,151 @@
+#include "ssgnc.h"
+
+#include <cassert>
+#include <cstring>
+#include <ctime>
+#include <sstream>
+
+namespace {
+
+void testSequence(const std::vector<ssgnc::UInt64> &values)
+{
+	std::ostringstream stream;
+	ssgnc::Writer writer;
+	assert(writer.open(&stream));
+	assert(ssgnc::EliasFano::build(values, &writer));
+
+	std::string str = stream.str();
+	assert(str.size() % sizeof(ssgnc::UInt64) == 0);
+
+	std::vector<ssgnc::UInt64> buf(str.size() / sizeof(ssgnc::UInt64));
+	std::memcpy(&buf[0], str.data(), str.size());
+
+	ssgnc::Mapper mapper;
+	assert(mapper.open(&buf[0], str.size()));
+
+	ssgnc::EliasFano sequence;
+	assert(!sequence.is_mapped());
+	assert(sequence.map(&mapper));
+	assert(mapper.eof());
+
+	assert(sequence.is_mapped());
+	assert(sequence.num_values() == values.size());
+
+	for (std::size_t i = 0; i < values.size(); ++i)
+	{
+		ssgnc::UInt64 value;
+		assert(sequence.get(i, &value));
+		assert(value == values[i]);
+		assert(sequence[i] == values[i]);
+	}
+
+	ssgnc::UInt64 value;
+	assert(!sequence.get(values.size(), &value));
+
+	sequence.clear();
+	assert(!sequence.is_mapped());
+	assert(sequence.num_values() == 0);
+}
+
+// A broken header or bit vector is rejected instead of being read past.
+void testBrokenSequence(const std::vector<ssgnc::UInt64> &values)
+{
+	enum { NUM_VALUES, NUM_LOW_BITS, NUM_LOWER_WORDS, NUM_UPPER_WORDS,
+		NUM_SAMPLES, HEADER_SIZE };
+
+	std::ostringstream stream;
+	ssgnc::Writer writer;
+	assert(writer.open(&stream));
+	assert(ssgnc::EliasFano::build(values, &writer));
+
+	std::string str = stream.str();
+	std::vector<ssgnc::UInt64> buf(str.size() / sizeof(ssgnc::UInt64));
+	std::memcpy(&buf[0], str.data(), str.size());
+
+	std::size_t upper_begin = HEADER_SIZE + buf[NUM_LOWER_WORDS];
+	std::size_t samples_begin = upper_begin + buf[NUM_UPPER_WORDS];
+
+	for (int i = 0; i < 6; ++i)
+	{
+		std::vector<ssgnc::UInt64> broken(buf);
+		switch (i)
+		{
+		case 0:
+			--broken[NUM_LOWER_WORDS];
+			break;
+		case 1:
+			++broken[NUM_LOWER_WORDS];
+			break;
+		case 2:
+			broken[NUM_UPPER_WORDS] = (values.size() / 64) - 1;
+			break;
+		case 3:
+			broken[NUM_VALUES] = ~0ULL;
+			break;
+		case 4:
+			broken[upper_begin + broken[NUM_UPPER_WORDS] - 1] = 0;
+			break;
+		case 5:
+			++broken[samples_begin + 1];
+			break;
+		}
+
+		ssgnc::Mapper mapper;
+		assert(mapper.open(&broken[0],
+			broken.size() * sizeof(ssgnc::UInt64)));
+
+		ssgnc::EliasFano sequence;
+		assert(!sequence.map(&mapper));
+		assert(!sequence.is_mapped());
+	}
+}
+
+}  // namespace
+
+int main()
+{
+	enum { NUM_VALUES = 1 << 16 };
+
+	std::srand(static_cast<unsigned>(std::time(NULL)));
+
+	ssgnc::disable_error_logging();
+
+	std::vector<ssgnc::UInt64> values;
+	testSequence(values);
+
+	values.push_back(0);
+	testSequence(values);
+
+	values.push_back(0);
+	values.push_back(1);
+	values.push_back(1ULL << 40);
+	testSequence(values);
+
+	values.clear();
+	ssgnc::UInt64 value = 0;
+	for (int i = 0; i < NUM_VALUES; ++i)
+	{
+		if (std::rand() % 4 != 0)
+		{
+			value += std::rand() % 256;
+			if (std::rand() % 100 == 0)
+				value += static_cast<ssgnc::UInt64>(std::rand()) << 16;
+		}
+		values.push_back(value);
+	}
+	testSequence(values);
+
+	for (int i = 0; i < NUM_VALUES; ++i)
+		values[i] = i;
+	testSequence(values);
+	testBrokenSequence(values);
+
+	std::ostringstream stream;
+	ssgnc::Writer writer;
+	assert(writer.open(&stream));
+
+	values[NUM_VALUES / 2] = 0;
+	assert(!ssgnc::EliasFano::build(values, &writer));
+
+	return 0;
+}
@@ -0,0 +1,290 @@
+#include "../cgi/fast-cgi.h"
+
+#include <cassert>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+
+typedef ssgnc::cgi::FastCgiRequest Request;
+
+// Returns a record whose content is padded to a multiple of 8 bytes.
+std::string makeRecord(int type, int request_id, const std::string &content)
+{
+	int padding_length = (8 - (content.length() & 7)) & 7;
+
+	std::string record;
+	record += static_cast<char>(Request::PROTOCOL_VERSION);
+	record += static_cast<char>(type);
+	record += static_cast<char>(request_id >> 8);
+	record += static_cast<char>(request_id);
+	record += static_cast<char>(content.length() >> 8);
+	record += static_cast<char>(content.length());
+	record += static_cast<char>(padding_length);
+	record += '\0';
+	record += content;
+	record.append(padding_length, '\0');
+	return record;
+}
+
+std::string makeBeginRequest(int request_id, int role, int flags)
+{
+	std::string content(8, '\0');
+	content[0] = static_cast<char>(role >> 8);
+	content[1] = static_cast<char>(role);
+	content[2] = static_cast<char>(flags);
+	return makeRecord(Request::BEGIN_REQUEST, request_id, content);
+}
+
+// A length is encoded in 4 bytes if it is greater than 127 or if
+// is_long is true.
+std::string makeLength(std::size_t length, bool is_long)
+{
+	std::string bytes;
+	if (length < 0x80 && !is_long)
+		bytes += static_cast<char>(length);
+	else
+	{
+		bytes += static_cast<char>((length >> 24) | 0x80);
+		bytes += static_cast<char>(length >> 16);
+		bytes += static_cast<char>(length >> 8);
+		bytes += static_cast<char>(length);
+	}
+	return bytes;
+}
+
+std::string makeParam(const std::string &name, const std::string &value,
+	bool is_long = false)
+{
+	return makeLength(name.length(), is_long)
+		+ makeLength(value.length(), is_long) + name + value;
+}
+
+void writeAll(int fd, const std::string &bytes)
+{
+	std::size_t offset = 0;
+	while (offset < bytes.length())
+	{
+		ssize_t size = ::write(fd, bytes.data() + offset,
+			bytes.length() - offset);
+		assert(size > 0);
+		offset += size;
+	}
+}
+
+void readAll(int fd, char *buf, std::size_t length)
+{
+	std::size_t offset = 0;
+	while (offset < length)
+	{
+		ssize_t size = ::read(fd, buf + offset, length - offset);
+		assert(size > 0);
+		offset += size;
+	}
+}
+
+// Reads a record sent by FastCgiRequest and checks its header.
+std::string readRecord(int fd, int type, int request_id)
+{
+	unsigned char header[Request::HEADER_SIZE];
+	readAll(fd, reinterpret_cast<char *>(header), sizeof(header));
+	assert(header[0] == Request::PROTOCOL_VERSION);
+	assert(header[1] == type);
+	assert(((header[2] << 8) | header[3]) == request_id);
+
+	std::size_t content_length = (header[4] << 8) | header[5];
+	assert(((content_length + header[6]) & 7) == 0);
+
+	std::string content(content_length + header[6], '\0');
+	if (!content.empty())
+		readAll(fd, &content[0], content.length());
+	return content.substr(0, content_length);
+}
+
+Request::ProtocolStatus readEndRequest(int fd, int request_id)
+{
+	std::string content = readRecord(fd, Request::END_REQUEST, request_id);
+	assert(content.length() == 8);
+	return static_cast<Request::ProtocolStatus>(content[4]);
+}
+
+void openPair(Request *request, int *peer)
+{
+	int fds[2];
+	assert(::socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+	assert(request->open(fds[0]));
+	*peer = fds[1];
+}
+
+// Management records, a multiplexed request and a kept connection.
+void testKeepConn()
+{
+	Request request;
+	int peer;
+	openPair(&request, &peer);
+
+	std::string long_name(200, 'n');
+	std::string long_value(300, 'v');
+
+	std::string input;
+	input += makeRecord(Request::GET_VALUES, 0,
+		makeParam("FCGI_MPXS_CONNS", ""));
+	input += makeRecord(20, 0, "");
+	input += makeBeginRequest(1, Request::RESPONDER, Request::KEEP_CONN);
+	input += makeBeginRequest(2, Request::RESPONDER, 0);
+	input += makeRecord(Request::PARAMS, 1, makeParam("QUERY_STRING", "q=a"));
+	input += makeRecord(Request::PARAMS, 2, makeParam("IGNORED", "x"));
+	input += makeRecord(Request::PARAMS, 1, makeParam("SHORT", "s", true)
+		+ makeParam(long_name, long_value) + makeParam("EMPTY", ""));
+	input += makeRecord(Request::PARAMS, 1, "");
+	input += makeRecord(Request::STDIN, 1, "body");
+	input += makeRecord(Request::STDIN, 1, "");
+	writeAll(peer, input);
+
+	assert(request.accept());
+	assert(request.keep_conn());
+	assert(request.param("QUERY_STRING") == "q=a");
+	assert(request.param("SHORT") == "s");
+	assert(request.param(long_name.c_str()) == long_value.c_str());
+	assert(request.param("EMPTY") == "");
+	assert(request.param("IGNORED") == "");
+
+	assert(readRecord(peer, Request::GET_VALUES_RESULT, 0) ==
+		makeParam("FCGI_MPXS_CONNS", "0"));
+	assert(readRecord(peer, Request::UNKNOWN_TYPE, 0) ==
+		std::string(1, '\x14') + std::string(7, '\0'));
+	assert(readEndRequest(peer, 2) == Request::CANT_MPX_CONN);
+
+	std::ostream out(&request);
+	out << "Content-Type: text/plain\r\n\r\n" << std::flush;
+	out << "ok";
+	assert(request.finish());
+
+	assert(readRecord(peer, Request::STDOUT, 1) ==
+		"Content-Type: text/plain\r\n\r\n");
+	assert(readRecord(peer, Request::STDOUT, 1) == "ok");
+	assert(readRecord(peer, Request::STDOUT, 1) == "");
+	assert(readEndRequest(peer, 1) == Request::REQUEST_COMPLETE);
+
+	// The next request on the kept connection has its own parameters, and a
+	// request of another role is rejected.
+	input.clear();
+	input += makeBeginRequest(3, 2, 0);
+	input += makeBeginRequest(4, Request::RESPONDER, 0);
+	input += makeRecord(Request::PARAMS, 4, makeParam("SHORT", "t"));
+	input += makeRecord(Request::PARAMS, 4, "");
+	input += makeRecord(Request::STDIN, 4, "");
+	writeAll(peer, input);
+
+	assert(request.accept());
+	assert(!request.keep_conn());
+	assert(request.param("SHORT") == "t");
+	assert(request.param("QUERY_STRING") == "");
+	assert(readEndRequest(peer, 3) == Request::UNKNOWN_ROLE);
+
+	assert(request.finish());
+	assert(readRecord(peer, Request::STDOUT, 4) == "");
+	assert(readEndRequest(peer, 4) == Request::REQUEST_COMPLETE);
+
+	// The web server closes the connection between records.
+	::close(peer);
+	assert(!request.accept());
+	assert(request.close());
+}
+
+// An aborted request ends the connection unless it is kept.
+void testAbortRequest()
+{
+	Request request;
+	int peer;
+	openPair(&request, &peer);
+
+	std::string input;
+	input += makeBeginRequest(1, Request::RESPONDER, Request::KEEP_CONN);
+	input += makeRecord(Request::PARAMS, 1, makeParam("A", "1"));
+	input += makeRecord(Request::ABORT_REQUEST, 1, "");
+	input += makeBeginRequest(2, Request::RESPONDER, 0);
+	input += makeRecord(Request::PARAMS, 2, makeParam("B", "2"));
+	input += makeRecord(Request::PARAMS, 2, "");
+	input += makeRecord(Request::STDIN, 2, "");
+	input += makeBeginRequest(3, Request::RESPONDER, 0);
+	input += makeRecord(Request::ABORT_REQUEST, 3, "");
+	writeAll(peer, input);
+
+	assert(request.accept());
+	assert(request.param("A") == "");
+	assert(request.param("B") == "2");
+	assert(readEndRequest(peer, 1) == Request::REQUEST_COMPLETE);
+	assert(request.finish());
+	assert(readRecord(peer, Request::STDOUT, 2) == "");
+	assert(readEndRequest(peer, 2) == Request::REQUEST_COMPLETE);
+
+	assert(!request.accept());
+	assert(readEndRequest(peer, 3) == Request::REQUEST_COMPLETE);
+
+	::close(peer);
+	assert(request.close());
+}
+
+// Every broken input makes accept() fail instead of blocking or reading
+// out of bounds.
+void testBrokenInput(const std::string &input)
+{
+	Request request;
+	int peer;
+	openPair(&request, &peer);
+
+	writeAll(peer, input);
+	assert(::shutdown(peer, SHUT_WR) == 0);
+
+	assert(!request.accept());
+	assert(request.close());
+	::close(peer);
+}
+
+void testBrokenInputs()
+{
+	std::string begin = makeBeginRequest(1, Request::RESPONDER, 0);
+	std::string params = makeRecord(Request::PARAMS, 1,
+		makeParam("NAME", "VALUE"));
+
+	// Truncated headers and contents.
+	testBrokenInput(begin.substr(0, 5));
+	testBrokenInput(begin + params.substr(0, Request::HEADER_SIZE + 3));
+	testBrokenInput(begin + params.substr(0, params.length() - 1));
+
+	// A short FCGI_BEGIN_REQUEST and an unsupported version.
+	testBrokenInput(makeRecord(Request::BEGIN_REQUEST, 1,
+		std::string("\0\1", 2)));
+	std::string version = begin;
+	version[0] = 2;
+	testBrokenInput(version);
+
+	// Name-value pairs which run over the end of the parameters.
+	std::string pairs[] = {
+		std::string("\x05\x05NAME", 6),
+		std::string("\x80\x00\x00", 3),
+		makeLength(4, true) + makeLength(0x7FFFFFFF, true) + "NAME",
+		std::string("\x04", 1)
+	};
+	for (std::size_t i = 0; i < sizeof(pairs) / sizeof(pairs[0]); ++i)
+	{
+		testBrokenInput(begin + makeRecord(Request::PARAMS, 1, pairs[i])
+			+ makeRecord(Request::PARAMS, 1, "")
+			+ makeRecord(Request::STDIN, 1, ""));
+	}
+}
+
+}  // namespace
+
+int main()
+{
+	testKeepConn();
+	testAbortRequest();
+
+	ssgnc::disable_error_logging();
+	testBrokenInputs();
+
+	return 0;
+}
@@ -49,5 +49,34 @@ int main()
 	assert(file_map.ptr() == NULL);
 	assert(file_map.size() == 0);
 
+	assert(file_map.open("FILE_MAP", ssgnc::FileMap::MMAP_FILE
+		| ssgnc::FileMap::POPULATE_PAGES | ssgnc::FileMap::HUGE_PAGES
+		| ssgnc::FileMap::RANDOM_ACCESS | ssgnc::FileMap::WILL_NEED));
+
+	assert(ssgnc::String(static_cast<const ssgnc::Int8 *>(file_map.ptr()),
+		file_map.size()) == src);
+
+	assert(file_map.close());
+
+	assert(file_map.open("FILE_MAP",
+		ssgnc::FileMap::MMAP_FILE | ssgnc::FileMap::LOCK_PAGES));
+
+	assert(ssgnc::String(static_cast<const ssgnc::Int8 *>(file_map.ptr()),
+		file_map.size()) == src);
+
+	assert(file_map.close());
+
+	assert(file_map.open("FILE_MAP",
+		ssgnc::FileMap::READ_FILE | ssgnc::FileMap::LOCK_PAGES));
+
+	assert(ssgnc::String(static_cast<const ssgnc::Int8 *>(file_map.ptr()),
+		file_map.size()) == src);
+
+	assert(file_map.close());
+
+	assert(!file_map.open("FILE_MAP", static_cast<ssgnc::FileMap::Mode>(
+		ssgnc::FileMap::READ_FILE + 1)));
+	assert(!file_map.is_open());
+
 	return 0;
 }
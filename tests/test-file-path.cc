@@ -32,6 +32,12 @@ int main()
 	assert(file_path.basename() == "prefix-%04d.ext");
 	assert(file_path.tell() == 2);
 
+	assert(file_path.read("shard", &path));
+	assert(path.str() == "shard/prefix-0002.ext");
+
+	assert(file_path.dirname() == ".");
+	assert(file_path.tell() == 3);
+
 	file_path.close();
 
 	assert(file_path.dirname() == "");
@@ -28,7 +28,20 @@ int main()
 		int value;
 		assert(queue.top(&value));
 		results.push_back(value);
-		assert(queue.pop());
+
+		// The second value is the next top value.
+		int second_value;
+		if (queue.second(&second_value))
+		{
+			assert(queue.pop());
+			assert(queue.top(&value));
+			assert(value == second_value);
+		}
+		else
+		{
+			assert(queue.size() == 1);
+			assert(queue.pop());
+		}
 	}
 
 	assert(results.size() == values.size());
@@ -0,0 +1,140 @@
+#include "ssgnc.h"
+
+#include <cassert>
+
+int main()
+{
+	ssgnc::MaterializedResults::Builder builder;
+
+	std::vector<ssgnc::Int32> tokens;
+	ssgnc::ResultCache::Results results;
+	for (ssgnc::Int32 i = 0; i < 10; ++i)
+	{
+		tokens.assign(1 + (i % 3), i);
+		assert(results.append(static_cast<ssgnc::Int16>(100 - i), tokens));
+	}
+
+	ssgnc::MaterializedResults::Key complete_key(3, 1);
+	ssgnc::MaterializedResults::Key incomplete_key(3, 2);
+	ssgnc::MaterializedResults::Key missing_key(3, 3);
+
+	// Entries are sorted by their keys in the file.
+	assert(builder.append(incomplete_key, results, false, 500, 50));
+	assert(builder.append(complete_key, results, true, 1000, 100));
+	ssgnc::disable_error_logging();
+	assert(!builder.append(complete_key, results, true, 0, 0));
+	ssgnc::set_error_stream(&std::clog);
+	assert(builder.contains(complete_key));
+	assert(!builder.contains(missing_key));
+	assert(builder.num_entries() == 2);
+
+	{
+		std::ofstream file("ngms.mat", std::ios::binary);
+		assert(builder.write(&file));
+	}
+
+	ssgnc::MaterializedResults materialized_results;
+	assert(materialized_results.open("ngms.mat"));
+	assert(materialized_results.num_entries() == 2);
+
+	ssgnc::Query query;
+	assert(query.set_max_num_results(0));
+
+	ssgnc::Agent agent;
+	bool is_found;
+	assert(materialized_results.find(missing_key, query, &agent, &is_found));
+	assert(!is_found);
+	assert(materialized_results.find(incomplete_key, query, &agent,
+		&is_found));
+	assert(!is_found);
+	assert(!agent.is_open());
+	assert(materialized_results.find(complete_key, query, &agent,
+		&is_found));
+	assert(is_found);
+	assert(agent.tell() == 1000);
+	assert(agent.num_scanned() == 100);
+
+	ssgnc::Int16 encoded_freq;
+	ssgnc::UInt64 num_results = 0;
+	while (agent.read(&encoded_freq, &tokens))
+	{
+		assert(encoded_freq == static_cast<ssgnc::Int16>(100 - num_results));
+		assert(tokens.size() == 1 + (num_results % 3));
+		assert(tokens[0] == static_cast<ssgnc::Int32>(num_results));
+		++num_results;
+	}
+	assert(!agent.bad());
+	assert(num_results == 10);
+	assert(agent.close());
+
+	// An incomplete entry answers a query with a small limit.
+	assert(query.set_max_num_results(10));
+	assert(materialized_results.find(incomplete_key, query, &agent,
+		&is_found));
+	assert(is_found);
+	num_results = 0;
+	while (agent.read(&encoded_freq, &tokens))
+		++num_results;
+	assert(num_results == 10);
+	assert(agent.close());
+
+	assert(query.set_max_num_results(11));
+	assert(materialized_results.find(incomplete_key, query, &agent,
+		&is_found));
+	assert(!is_found);
+
+	// An entry is not used if the limits would have stopped the search.
+	assert(query.set_max_num_results(0));
+	assert(query.set_io_limit(1000));
+	assert(materialized_results.find(complete_key, query, &agent,
+		&is_found));
+	assert(!is_found);
+	assert(query.set_io_limit(1001));
+	assert(query.set_scan_limit(100));
+	assert(materialized_results.find(complete_key, query, &agent,
+		&is_found));
+	assert(!is_found);
+	assert(query.set_scan_limit(101));
+	assert(materialized_results.find(complete_key, query, &agent,
+		&is_found));
+	assert(is_found);
+	assert(agent.close());
+	assert(materialized_results.close());
+
+	// A broken pool is an error rather than a missing key. The first value
+	// of the pool is the encoded frequency of the first result of the
+	// incomplete entry, and the second one is its number of tokens.
+	{
+		std::fstream file("ngms.mat",
+			std::ios::in | std::ios::out | std::ios::binary);
+		file.seekp(sizeof(ssgnc::UInt32) * 3
+			+ (sizeof(ssgnc::MaterializedResults::Entry) * 2)
+			+ sizeof(ssgnc::Int32));
+		ssgnc::Int32 num_tokens = 1 << 20;
+		file.write(reinterpret_cast<const char *>(&num_tokens),
+			sizeof(num_tokens));
+	}
+	assert(materialized_results.open("ngms.mat"));
+	assert(query.set_max_num_results(10));
+	assert(query.set_io_limit(0));
+	assert(query.set_scan_limit(0));
+	ssgnc::disable_error_logging();
+	assert(!materialized_results.find(incomplete_key, query, &agent,
+		&is_found));
+	ssgnc::set_error_stream(&std::clog);
+	assert(!is_found);
+
+	// A file of the old format is rejected.
+	{
+		std::ofstream file("ngms.mat", std::ios::binary);
+		ssgnc::UInt32 num_entries = 0;
+		file.write(reinterpret_cast<const char *>(&num_entries),
+			sizeof(num_entries));
+	}
+	assert(materialized_results.close());
+	ssgnc::disable_error_logging();
+	assert(!materialized_results.open("ngms.mat"));
+	ssgnc::set_error_stream(&std::clog);
+
+	return 0;
+}
@@ -0,0 +1,188 @@
+#include "ssgnc.h"
+
+#include <cassert>
+#include <cstdlib>
+
+namespace {
+
+enum { NUM_TOKENS = 5, NUM_NGRAMS = 1000, NUM_QUERIES = 200 };
+enum { MAX_TOKEN = 6 };
+
+bool writeValue(ssgnc::Int32 value, std::ostream *out)
+{
+	ssgnc::UInt8 temp_buf[8];
+	ssgnc::Int32 num_bytes = 0;
+
+	while (value >= 0x80)
+	{
+		temp_buf[num_bytes++] = static_cast<ssgnc::UInt8>(value & 0x7F);
+		value >>= 7;
+	}
+	temp_buf[num_bytes++] = static_cast<ssgnc::UInt8>(value & 0x7F);
+
+	for (ssgnc::Int32 i = 1; i < num_bytes; ++i)
+		out->put(temp_buf[num_bytes - i] | 0x80);
+	out->put(temp_buf[0]);
+
+	return !!*out;
+}
+
+// A straightforward implementation of the filters, which is compared with
+// the filters of NgramBlock.
+bool filter(const ssgnc::Query &query, const ssgnc::Int32 *tokens)
+{
+	ssgnc::Int32 num_query_tokens = query.num_tokens();
+	switch (query.order())
+	{
+	case ssgnc::Query::UNORDERED:
+	{
+		bool is_used[NUM_TOKENS] = { false };
+		for (ssgnc::Int32 i = 0; i < num_query_tokens; ++i)
+		{
+			if (query.token(i) == ssgnc::Query::META_TOKEN)
+				continue;
+
+			ssgnc::Int32 j = 0;
+			while (j < NUM_TOKENS &&
+				(is_used[j] || tokens[j] != query.token(i)))
+				++j;
+			if (j == NUM_TOKENS)
+				return false;
+			is_used[j] = true;
+		}
+		return true;
+	}
+	case ssgnc::Query::ORDERED:
+	{
+		ssgnc::Int32 j = 0;
+		for (ssgnc::Int32 i = 0; i < num_query_tokens; ++i, ++j)
+		{
+			while (j < NUM_TOKENS &&
+				query.token(i) != ssgnc::Query::META_TOKEN &&
+				tokens[j] != query.token(i))
+				++j;
+			if (j >= NUM_TOKENS)
+				return false;
+		}
+		return true;
+	}
+	case ssgnc::Query::PHRASE:
+		for (ssgnc::Int32 start = 0;
+			start + num_query_tokens <= NUM_TOKENS; ++start)
+		{
+			ssgnc::Int32 i = 0;
+			while (i < num_query_tokens &&
+				(query.token(i) == ssgnc::Query::META_TOKEN ||
+				tokens[start + i] == query.token(i)))
+				++i;
+			if (i == num_query_tokens)
+				return true;
+		}
+		return false;
+	case ssgnc::Query::FIXED:
+		if (num_query_tokens != NUM_TOKENS)
+			return false;
+		for (ssgnc::Int32 i = 0; i < num_query_tokens; ++i)
+		{
+			if (query.token(i) != ssgnc::Query::META_TOKEN &&
+				tokens[i] != query.token(i))
+				return false;
+		}
+		return true;
+	default:
+		assert(false);
+		return false;
+	}
+}
+
+}  // namespace
+
+int main()
+{
+	std::srand(1);
+
+	std::vector<ssgnc::Int32> ngrams;
+	std::ofstream file("5gm-0000.db", std::ios::binary);
+	for (int i = 0; i < NUM_NGRAMS; ++i)
+	{
+		assert(writeValue(NUM_NGRAMS - i, &file));
+		for (int j = 0; j < NUM_TOKENS; ++j)
+		{
+			ngrams.push_back(std::rand() % MAX_TOKEN);
+			assert(writeValue(ngrams.back(), &file));
+		}
+	}
+	assert(writeValue(0, &file));
+	file.close();
+
+	ssgnc::NgramIndex::Entry entry;
+	assert(entry.set_file_id(0));
+	assert(entry.set_offset(0));
+
+	ssgnc::NgramReader reader;
+	assert(reader.open(".", NUM_TOKENS, entry));
+
+	// The n-grams are read into blocks with their positions.
+	ssgnc::NgramBlock blocks[(NUM_NGRAMS / ssgnc::NgramBlock::MAX_SIZE) + 1];
+	int num_blocks = 0;
+	int num_ngrams = 0;
+	while (reader.good())
+	{
+		ssgnc::NgramBlock *block = &blocks[num_blocks++];
+		assert(block->reset(&reader));
+		while (!block->full() && reader.good())
+		{
+			ssgnc::UInt64 offset = reader.offset();
+			assert(block->read());
+			assert(block->offset(block->size() - 1) == offset);
+			assert(block->encoded_freq(block->size() - 1) ==
+				NUM_NGRAMS - num_ngrams);
+			++num_ngrams;
+		}
+		assert(block->full() || !reader.good());
+	}
+	assert(!reader.bad());
+	assert(num_ngrams == NUM_NGRAMS);
+	assert(num_blocks == static_cast<int>(sizeof(blocks) / sizeof(blocks[0])));
+
+	ssgnc::Int32 tokens[NUM_TOKENS];
+	blocks[1].copyTokens(2, tokens);
+	for (int j = 0; j < NUM_TOKENS; ++j)
+	{
+		assert(tokens[j] ==
+			ngrams[(ssgnc::NgramBlock::MAX_SIZE + 2) * NUM_TOKENS + j]);
+	}
+
+	static const ssgnc::Query::TokenOrder ORDERS[] = {
+		ssgnc::Query::UNORDERED, ssgnc::Query::ORDERED,
+		ssgnc::Query::PHRASE, ssgnc::Query::FIXED
+	};
+
+	for (int i = 0; i < NUM_QUERIES; ++i)
+	{
+		ssgnc::Query query;
+		assert(query.set_order(ORDERS[i % 4]));
+		int num_query_tokens = 1 + (std::rand() % NUM_TOKENS);
+		for (int j = 0; j < num_query_tokens; ++j)
+		{
+			int token = (std::rand() % (MAX_TOKEN + 2)) - 1;
+			assert(query.appendToken(token < 0 ?
+				ssgnc::Query::META_TOKEN : token % MAX_TOKEN));
+		}
+
+		int id = 0;
+		for (int j = 0; j < num_blocks; ++j)
+		{
+			assert(blocks[j].filter(query));
+			for (ssgnc::UInt32 k = 0; k < blocks[j].size(); ++k, ++id)
+			{
+				assert(blocks[j].match(k) ==
+					filter(query, &ngrams[id * NUM_TOKENS]));
+			}
+		}
+	}
+
+	assert(reader.close());
+
+	return 0;
+}
@@ -115,5 +115,189 @@ int main()
 	assert(ngram_index.max_num_tokens() == 0);
 	assert(ngram_index.max_token_id() == 0);
 
+	std::ofstream wide_file("NGRAM_INDEX_WIDE", std::ios::binary);
+	assert(wide_file.good());
+
+	assert(writer.close());
+	assert(writer.open(&wide_file));
+
+	assert(writer.write(static_cast<ssgnc::Int32>(
+		ssgnc::NgramIndex::FORMAT_MARKER)));
+	assert(writer.write(static_cast<ssgnc::Int32>(
+		ssgnc::NgramIndex::WIDE_FORMAT)));
+	assert(writer.write(MAX_NUM_TOKENS));
+	assert(writer.write(MAX_TOKEN_ID));
+
+	std::vector<ssgnc::NgramIndex::WideFileEntry> wide_entries;
+	for (ssgnc::Int32 i = 1; i <= MAX_NUM_TOKENS; ++i)
+	{
+		ssgnc::NgramIndex::WideFileEntry ngram_offset;
+		assert(ngram_offset.set_file_id(0));
+		assert(ngram_offset.set_offset(0));
+		wide_entries.push_back(ngram_offset);
+
+		assert(writer.write(ngram_offset));
+	}
+	std::vector<ssgnc::Int64> sizes;
+	index = 0;
+	for (ssgnc::Int32 i = 0; i <= MAX_TOKEN_ID; ++i)
+	{
+		for (ssgnc::Int32 j = 1; j <= MAX_NUM_TOKENS; ++j)
+		{
+			ssgnc::Int32 file_id = wide_entries[index].file_id();
+			ssgnc::UInt64 offset = wide_entries[index].offset();
+			ssgnc::Int64 size = 1 + (std::rand() % 65536);
+			if (std::rand() % 10 == 0)
+				size += std::rand() * 64LL;
+
+			// A list never spans files.
+			if (std::rand() % 100 == 0)
+			{
+				++file_id;
+				offset = 0;
+			}
+			offset += size;
+			sizes.push_back(size);
+			++index;
+
+			ssgnc::NgramIndex::WideFileEntry ngram_offset;
+			assert(ngram_offset.set_file_id(file_id));
+			assert(ngram_offset.set_offset(offset));
+			wide_entries.push_back(ngram_offset);
+
+			assert(writer.write(ngram_offset));
+		}
+	}
+
+	wide_file.close();
+
+	assert(ngram_index.open("NGRAM_INDEX_WIDE"));
+
+	assert(ngram_index.is_wide());
+	assert(ngram_index.max_num_tokens() == MAX_NUM_TOKENS);
+	assert(ngram_index.max_token_id() == MAX_TOKEN_ID);
+
+	for (ssgnc::Int32 i = 1; i <= MAX_NUM_TOKENS; ++i)
+	{
+		for (ssgnc::Int32 j = 0; j <= MAX_TOKEN_ID; ++j)
+		{
+			ssgnc::NgramIndex::Entry entry;
+			assert(ngram_index.get(i, j, &entry));
+
+			ssgnc::UInt32 id = (MAX_NUM_TOKENS * j) + (i - 1);
+			assert(entry.file_id() == wide_entries[id].file_id());
+			assert(entry.offset() == wide_entries[id].offset());
+			assert(entry.approx_size() == sizes[id]);
+		}
+	}
+
+	assert(ngram_index.close());
+
+	assert(!ngram_index.is_wide());
+
+	std::ofstream elias_fano_file("NGRAM_INDEX_ELIAS_FANO", std::ios::binary);
+	assert(elias_fano_file.good());
+
+	assert(writer.close());
+	assert(writer.open(&elias_fano_file));
+
+	assert(writer.write(static_cast<ssgnc::Int32>(
+		ssgnc::NgramIndex::FORMAT_MARKER)));
+	assert(writer.write(static_cast<ssgnc::Int32>(
+		ssgnc::NgramIndex::ELIAS_FANO_FORMAT)));
+	assert(writer.write(MAX_NUM_TOKENS));
+	assert(writer.write(MAX_TOKEN_ID));
+
+	for (ssgnc::Int32 i = 1; i <= MAX_NUM_TOKENS; ++i)
+	{
+		std::vector<ssgnc::UInt64> keys;
+		for (ssgnc::Int32 j = 0; j <= MAX_TOKEN_ID + 1; ++j)
+			keys.push_back(entries[(MAX_NUM_TOKENS * j) + (i - 1)].key());
+		assert(ssgnc::EliasFano::build(keys, &writer));
+	}
+
+	elias_fano_file.close();
+
+	assert(ngram_index.open("NGRAM_INDEX_ELIAS_FANO"));
+
+	assert(ngram_index.is_elias_fano());
+	assert(!ngram_index.is_wide());
+	assert(ngram_index.max_num_tokens() == MAX_NUM_TOKENS);
+	assert(ngram_index.max_token_id() == MAX_TOKEN_ID);
+
+	for (ssgnc::Int32 i = 1; i <= MAX_NUM_TOKENS; ++i)
+	{
+		for (ssgnc::Int32 j = 0; j <= MAX_TOKEN_ID; ++j)
+		{
+			ssgnc::NgramIndex::Entry entry;
+			assert(ngram_index.get(i, j, &entry));
+
+			ssgnc::UInt32 id = (MAX_NUM_TOKENS * j) + (i - 1);
+			assert(entry.file_id() == entries[id].file_id());
+			assert(entry.offset() == entries[id].offset());
+			assert(entry.approx_size() == entries[id + MAX_NUM_TOKENS]
+				- entries[id]);
+		}
+	}
+
+	assert(ngram_index.close());
+
+	assert(!ngram_index.is_elias_fano());
+
+	std::ofstream sized_file("NGRAM_INDEX_SIZED", std::ios::binary);
+	assert(sized_file.good());
+
+	assert(writer.close());
+	assert(writer.open(&sized_file));
+
+	assert(writer.write(static_cast<ssgnc::Int32>(
+		ssgnc::NgramIndex::FORMAT_MARKER)));
+	assert(writer.write(static_cast<ssgnc::Int32>(
+		ssgnc::NgramIndex::WIDE_FORMAT | ssgnc::NgramIndex::SIZED_FORMAT)));
+	assert(writer.write(MAX_NUM_TOKENS));
+	assert(writer.write(MAX_TOKEN_ID));
+
+	// Lists of the sized format are not in order of token IDs.
+	std::vector<ssgnc::UInt32> list_sizes;
+	for (std::size_t i = 0; i + MAX_NUM_TOKENS < wide_entries.size(); ++i)
+	{
+		std::size_t j = wide_entries.size() - MAX_NUM_TOKENS - 1 - i;
+		assert(writer.write(wide_entries[j]));
+		list_sizes.push_back(
+			sizes[j] > ssgnc::NgramIndex::MAX_LIST_SIZE
+			? ssgnc::NgramIndex::MAX_LIST_SIZE
+			: static_cast<ssgnc::UInt32>(sizes[j]));
+	}
+	assert(writer.write(&list_sizes[0], list_sizes.size()));
+
+	sized_file.close();
+
+	assert(ngram_index.open("NGRAM_INDEX_SIZED"));
+
+	assert(ngram_index.is_sized());
+	assert(ngram_index.is_wide());
+	assert(ngram_index.max_num_tokens() == MAX_NUM_TOKENS);
+	assert(ngram_index.max_token_id() == MAX_TOKEN_ID);
+
+	for (ssgnc::Int32 i = 1; i <= MAX_NUM_TOKENS; ++i)
+	{
+		for (ssgnc::Int32 j = 0; j <= MAX_TOKEN_ID; ++j)
+		{
+			ssgnc::NgramIndex::Entry entry;
+			assert(ngram_index.get(i, j, &entry));
+
+			ssgnc::UInt32 id = (MAX_NUM_TOKENS * j) + (i - 1);
+			ssgnc::UInt32 reversed_id = static_cast<ssgnc::UInt32>(
+				wide_entries.size() - MAX_NUM_TOKENS - 1 - id);
+			assert(entry.file_id() == wide_entries[reversed_id].file_id());
+			assert(entry.offset() == wide_entries[reversed_id].offset());
+			assert(entry.approx_size() == list_sizes[id]);
+		}
+	}
+
+	assert(ngram_index.close());
+
+	assert(!ngram_index.is_sized());
+
 	return 0;
 }
@@ -75,6 +75,10 @@ int main()
 		assert(writeValue(0, &file));
 		file_ids.push_back(file_path.tell() - 1);
 		offsets.push_back(static_cast<ssgnc::Int32>(file.tellp()));
+
+		// The next list starts at the end of the current file.
+		if (std::rand() % 16 == 0)
+			assert(openNextFile(&file_path, &file));
 	}
 
 	file.close();
@@ -110,5 +114,48 @@ int main()
 	}
 	assert(src_id == src_freqs.size());
 
+	// A reader resumed at the position of another reader returns the rest
+	// of the list.
+	ssgnc::ShardMap shard_map;
+	assert(shard_map.open("."));
+
+	ssgnc::NgramReader resumed_reader;
+
+	src_id = 0;
+	for (int i = 0; i < MAX_TOKEN_ID; ++i)
+	{
+		if (ngram_reader.is_open())
+			ngram_reader.close();
+		if (resumed_reader.is_open())
+			resumed_reader.close();
+
+		ssgnc::NgramIndex::Entry entry;
+		assert(entry.set_file_id(file_ids[i]));
+		assert(entry.set_offset(offsets[i]));
+
+		assert(ngram_reader.open(shard_map, 3, entry));
+		int num_skips = std::rand() % (MAX_NUM_NGRAMS + 1);
+		for (int j = 0; j < num_skips && ngram_reader.good(); ++j)
+		{
+			assert(ngram_reader.read(&freq, &tokens));
+			++src_id;
+		}
+		if (!ngram_reader.good())
+			continue;
+
+		assert(resumed_reader.resume(shard_map, 3, ngram_reader.file_id(),
+			ngram_reader.offset(), ngram_reader.encoded_freq()));
+		while (resumed_reader.read(&freq, &tokens))
+		{
+			assert(freq == src_freqs[src_id]);
+			for (int j = 0; j < NUM_TOKENS; ++j)
+				assert(tokens[j] == src_tokens[(NUM_TOKENS * src_id) + j]);
+			++src_id;
+		}
+		assert(!resumed_reader.bad());
+		assert(resumed_reader.eof());
+	}
+	assert(src_id == src_freqs.size());
+
 	return 0;
 }
@@ -0,0 +1,169 @@
+#include "ssgnc.h"
+
+#include <cassert>
+
+int main()
+{
+	enum { MAX_NUM_TOKENS = 3, MAX_TOKEN_ID = 99 };
+
+	// A sketch never underestimates the counts of pairs, and the counts are
+	// exact without collisions.
+	ssgnc::NgramStats::Sketch sketch;
+	sketch.clear();
+	assert(sketch.count(5, 0) == 0);
+	ssgnc::Int32 tokens[MAX_NUM_TOKENS] = { 5, 7, 5 };
+	for (int i = 0; i < 10; ++i)
+		sketch.add(tokens, MAX_NUM_TOKENS);
+	assert(sketch.count(5, 0) >= 10);
+	assert(sketch.count(7, 1) >= 10);
+	assert(sketch.count(5, 2) >= 10);
+	for (ssgnc::Int32 i = 0; i < ssgnc::NgramStats::SKETCH_DEPTH; ++i)
+	{
+		assert(ssgnc::NgramStats::Sketch::hash(i, 5, 0) <
+			ssgnc::NgramStats::SKETCH_WIDTH);
+	}
+	for (ssgnc::Int32 i = 0; i < 1000; ++i)
+	{
+		ssgnc::Int32 token = i % 50;
+		sketch.add(&token, 1);
+	}
+	assert(sketch.count(5, 0) >= 30);
+	assert(sketch.count(49, 0) >= 20);
+
+	ssgnc::NgramStats::Builder builder;
+	assert(builder.init(MAX_NUM_TOKENS, MAX_TOKEN_ID));
+	builder.set_scan_cost(123);
+
+	// The list of a token has (token * 20) n-grams, which are spread over
+	// the buckets of the order. A token is the smallest one of a half of its
+	// n-grams.
+	for (ssgnc::Int32 i = 1; i <= MAX_NUM_TOKENS; ++i)
+	{
+		for (ssgnc::Int32 j = 0; j <= MAX_TOKEN_ID; ++j)
+		{
+			ssgnc::UInt64 freq_counts[ssgnc::NgramStats::NUM_FREQ_BUCKETS] =
+				{ 0 };
+			freq_counts[0] = j * 10;
+			freq_counts[i] = j * 10;
+			ssgnc::NgramStats::Sketch list_sketch;
+			list_sketch.clear();
+			tokens[0] = j;
+			for (int k = 0; k < j; ++k)
+				list_sketch.add(tokens, 1);
+			assert(builder.appendList(i, j, freq_counts, list_sketch,
+				j * 10));
+		}
+	}
+
+	// The lists must be appended in order.
+	ssgnc::UInt64 freq_counts[ssgnc::NgramStats::NUM_FREQ_BUCKETS] = { 0 };
+	freq_counts[0] = ssgnc::NgramStats::MIN_HISTOGRAM_SIZE;
+	ssgnc::disable_error_logging();
+	assert(!builder.appendList(1, 0, freq_counts, sketch, 0));
+	assert(!builder.appendList(MAX_NUM_TOKENS + 1, 0, freq_counts,
+		sketch, 0));
+	assert(!builder.appendList(1, MAX_TOKEN_ID + 1, freq_counts, sketch, 0));
+	ssgnc::set_error_stream(&std::clog);
+
+	ssgnc::UInt64 num_ngrams = 0;
+	for (ssgnc::Int32 j = 0; j <= MAX_TOKEN_ID; ++j)
+		num_ngrams += j * 10;
+	assert(builder.num_ngrams(1) == num_ngrams);
+
+	// Lists of (MIN_HISTOGRAM_SIZE / 20) or more tokens have histograms.
+	ssgnc::Int32 min_histogram_token =
+		(ssgnc::NgramStats::MIN_HISTOGRAM_SIZE + 19) / 20;
+	assert(builder.num_histograms() == static_cast<ssgnc::UInt32>(
+		MAX_NUM_TOKENS * (MAX_TOKEN_ID - min_histogram_token + 1)));
+
+	// The pair filter has the pairs of adjacent tokens in 2-grams and a pair
+	// in a 3-gram with a repeated token.
+	for (ssgnc::Int32 j = 0; j < MAX_TOKEN_ID; ++j)
+	{
+		tokens[0] = j;
+		tokens[1] = j + 1;
+		assert(builder.appendPairs(tokens, 2));
+	}
+	tokens[0] = 1;
+	tokens[1] = 2;
+	tokens[2] = 1;
+	assert(builder.appendPairs(tokens, 3));
+	ssgnc::disable_error_logging();
+	assert(!builder.appendPairs(tokens, MAX_NUM_TOKENS + 1));
+	assert(!builder.appendPairs(NULL, 2));
+	ssgnc::set_error_stream(&std::clog);
+
+	{
+		std::ofstream file("ngms.stat", std::ios::binary);
+		assert(builder.write(&file));
+	}
+
+	ssgnc::NgramStats stats;
+	assert(stats.open("ngms.stat"));
+	assert(stats.max_num_tokens() == MAX_NUM_TOKENS);
+	assert(stats.max_token_id() == MAX_TOKEN_ID);
+	assert(stats.scan_cost() == 123);
+
+	for (ssgnc::Int32 i = 1; i <= MAX_NUM_TOKENS; ++i)
+	{
+		assert(stats.num_ngrams(i) == num_ngrams);
+		for (ssgnc::Int32 j = 0; j <= MAX_TOKEN_ID; ++j)
+		{
+			ssgnc::NgramStats::Entry entry;
+			assert(stats.get(i, j, &entry));
+			assert(entry.num_ngrams() == static_cast<ssgnc::UInt64>(j * 20));
+			if (j < min_histogram_token)
+			{
+				assert(!entry.has_histogram());
+				assert(!entry.has_sketch());
+				continue;
+			}
+
+			assert(entry.has_histogram());
+			assert(entry.has_sketch());
+			assert(entry.sketch()->count(j, 0) >=
+				static_cast<ssgnc::UInt32>(j));
+			for (ssgnc::Int32 k = 0; k < ssgnc::NgramStats::NUM_FREQ_BUCKETS;
+				++k)
+			{
+				ssgnc::UInt32 expected = (k == 0 || k == i) ? j * 10 : 0;
+				assert(entry.freq_counts()[k] == expected);
+			}
+		}
+	}
+
+	// The pair filter has no false negatives, and a few false positives.
+	// Its size is given by the distinct pairs, so that it is far from
+	// saturated.
+	assert(stats.has_pair_filter());
+	assert(stats.num_pairs() == static_cast<ssgnc::UInt64>(MAX_TOKEN_ID + 1));
+	assert(stats.pair_filter_fill_ratio() > 0.0);
+	assert(stats.pair_filter_fill_ratio() < 0.5);
+	assert(!stats.is_pair_filter_saturated());
+	ssgnc::Int32 num_false_positives = 0;
+	for (ssgnc::Int32 j = 0; j < MAX_TOKEN_ID; ++j)
+	{
+		assert(stats.mayHavePair(2, j, j + 1));
+		assert(stats.mayHavePair(2, j + 1, j));
+		assert(stats.mayHavePair(2, j, j));
+		if (stats.mayHavePair(2, j, (j + 2) % (MAX_TOKEN_ID + 1)))
+			++num_false_positives;
+	}
+	assert(num_false_positives < MAX_TOKEN_ID / 2);
+	assert(stats.mayHavePair(3, 1, 2));
+	assert(stats.mayHavePair(3, 2, 1));
+	assert(!stats.mayHavePair(3, 5, 6) || !stats.mayHavePair(3, 7, 8));
+
+	ssgnc::NgramStats::Entry entry;
+	ssgnc::disable_error_logging();
+	assert(!stats.get(0, 0, &entry));
+	assert(!stats.get(1, MAX_TOKEN_ID + 1, &entry));
+	ssgnc::set_error_stream(&std::clog);
+
+	assert(ssgnc::NgramStats::freqBucket(999) == 0);
+	assert(ssgnc::NgramStats::freqBucket((1 << 10) + 100) == 1);
+
+	assert(stats.close());
+
+	return 0;
+}
@@ -0,0 +1,109 @@
+#include "ssgnc.h"
+
+#include <cassert>
+#include <cmath>
+#include <sstream>
+
+namespace {
+
+bool isNear(double lhs, double rhs)
+{
+	return std::fabs(lhs - rhs) < 1e-6;
+}
+
+ssgnc::Planner::Estimate makeEstimate(ssgnc::Int32 num_tokens,
+	ssgnc::UInt64 num_ngrams, const ssgnc::UInt32 *freq_counts,
+	double density)
+{
+	ssgnc::Planner::Estimate estimate;
+	estimate.num_tokens = num_tokens;
+	estimate.token_id = 0;
+	estimate.approx_size = static_cast<ssgnc::Int64>(num_ngrams * 10);
+	estimate.num_ngrams = num_ngrams;
+	estimate.freq_counts = freq_counts;
+	estimate.sketch = NULL;
+	estimate.density = density;
+	estimate.num_scans = 0.0;
+	estimate.num_bytes = 0.0;
+	estimate.num_matches = 0.0;
+	estimate.num_total_matches = 0.0;
+	return estimate;
+}
+
+}  // namespace
+
+int main()
+{
+	// The first list has 1000 n-grams in bucket 2 and 3000 n-grams in bucket
+	// 0, and the second one has 2000 n-grams in bucket 1.
+	ssgnc::UInt32 first_counts[ssgnc::NgramStats::NUM_FREQ_BUCKETS] = { 0 };
+	first_counts[2] = 1000;
+	first_counts[0] = 3000;
+	ssgnc::UInt32 second_counts[ssgnc::NgramStats::NUM_FREQ_BUCKETS] = { 0 };
+	second_counts[1] = 2000;
+
+	std::vector<ssgnc::Planner::Estimate> estimates;
+	estimates.push_back(makeEstimate(2, 4000, first_counts, 0.1));
+	estimates.push_back(makeEstimate(3, 2000, second_counts, 0.5));
+	estimates.push_back(makeEstimate(4, 10, NULL, 1.0));
+
+	// Without limits, all the lists are read.
+	ssgnc::Query query;
+	assert(query.appendToken(0));
+	ssgnc::Planner::estimate(query, &estimates);
+	assert(isNear(estimates[0].num_scans, 4000.0));
+	assert(isNear(estimates[0].num_bytes, 40000.0));
+	assert(isNear(estimates[0].num_matches, 400.0));
+	assert(isNear(estimates[1].num_matches, 1000.0));
+	assert(isNear(estimates[2].num_scans, 10.0));
+
+	// A limit of 610 results is reached in bucket 1, after the 10 results of
+	// the small list and the 100 results of bucket 2.
+	assert(query.set_max_num_results(610));
+	ssgnc::Planner::estimate(query, &estimates);
+	assert(isNear(estimates[0].num_scans, 1000.0));
+	assert(isNear(estimates[1].num_scans, 1000.0));
+	assert(isNear(estimates[2].num_scans, 10.0));
+	assert(isNear(estimates[0].num_matches + estimates[1].num_matches +
+		estimates[2].num_matches, 610.0));
+	assert(isNear(estimates[0].num_total_matches, 400.0));
+	assert(isNear(estimates[1].num_total_matches, 1000.0));
+
+	// The I/O limit scales the estimates.
+	assert(query.set_max_num_results(0));
+	assert(query.set_io_limit(30050));
+	ssgnc::Planner::estimate(query, &estimates);
+	assert(isNear(estimates[0].num_bytes + estimates[1].num_bytes +
+		estimates[2].num_bytes, 30050.0));
+	assert(isNear(estimates[0].num_scans, 2000.0));
+
+	// The minimum frequency excludes the lower buckets.
+	assert(query.set_io_limit(0));
+	assert(query.set_min_encoded_freq(1 << 10));
+	ssgnc::Planner::estimate(query, &estimates);
+	assert(isNear(estimates[0].num_scans, 1000.0));
+	assert(isNear(estimates[1].num_scans, 2000.0));
+
+	ssgnc::Planner::Explanation explanation;
+	explanation.set_access(ssgnc::Planner::Explanation::LISTS);
+	explanation.set_has_stats(true);
+	explanation.set_scan_cost(2000);
+	*explanation.mutable_estimates() = estimates;
+	assert(isNear(explanation.num_scans(), 3010.0));
+	assert(isNear(explanation.search_time(), 6.02));
+
+	std::ostringstream output;
+	assert(explanation.write(&output));
+	assert(output.str().find("access: lists (stats)\n") == 0);
+	assert(output.str().find("total: 3 lists, scans 3010,") !=
+		std::string::npos);
+
+	explanation.clear();
+	assert(explanation.access() == ssgnc::Planner::Explanation::NO_SOURCES);
+	assert(explanation.estimates().empty());
+	assert(ssgnc::String(ssgnc::Planner::Explanation::accessName(
+		ssgnc::Planner::Explanation::MATERIALIZED_RESULTS)) ==
+		"materialized-results");
+
+	return 0;
+}
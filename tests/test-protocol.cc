@@ -0,0 +1,161 @@
+#include "ssgnc.h"
+
+#include <cassert>
+#include <sstream>
+
+#include <sys/socket.h>
+
+int main()
+{
+	ssgnc::Query query;
+	assert(query.set_order(ssgnc::Query::PHRASE));
+	assert(query.set_min_encoded_freq(3));
+	assert(query.set_min_num_tokens(2));
+	assert(query.set_max_num_tokens(4));
+	assert(query.set_max_num_results(100));
+	assert(query.set_io_limit(1 << 20));
+	assert(query.set_time_limit(3000000));
+	assert(query.set_scan_limit(1 << 16));
+	assert(query.appendToken(5));
+	assert(query.appendToken(ssgnc::Query::META_TOKEN));
+	assert(query.appendToken(7));
+
+	std::vector<ssgnc::Int32> tokens;
+	tokens.push_back(5);
+	tokens.push_back(6);
+	tokens.push_back(7);
+
+	std::stringstream stream;
+
+	ssgnc::Writer writer;
+	assert(writer.open(&stream));
+
+	assert(ssgnc::Protocol::writeQuery(&writer, query));
+	assert(ssgnc::Protocol::writeResult(&writer, 10, tokens, 256));
+	assert(!ssgnc::Protocol::writeResult(&writer,
+		ssgnc::Protocol::END_OF_RESULTS, tokens, 256));
+	assert(ssgnc::Protocol::writeEnd(&writer, true, 512));
+	assert(ssgnc::Protocol::writeEnd(&writer, false, 0));
+
+	ssgnc::Reader reader;
+	assert(reader.open(&stream));
+
+	ssgnc::Query query_copy;
+	assert(ssgnc::Protocol::readQuery(&reader, &query_copy));
+	assert(query_copy.order() == ssgnc::Query::PHRASE);
+	assert(query_copy.min_encoded_freq() == 3);
+	assert(query_copy.min_num_tokens() == 2);
+	assert(query_copy.max_num_tokens() == 4);
+	assert(query_copy.max_num_results() == 100);
+	assert(query_copy.io_limit() == 1 << 20);
+	assert(query_copy.time_limit() == 3000000);
+	assert(query_copy.scan_limit() == 1 << 16);
+	assert(query_copy.num_tokens() == 3);
+	assert(query_copy.token(0) == 5);
+	assert(query_copy.token(1) == ssgnc::Query::META_TOKEN);
+	assert(query_copy.token(2) == 7);
+
+	ssgnc::Int16 encoded_freq;
+	std::vector<ssgnc::Int32> tokens_copy;
+	ssgnc::UInt64 total;
+
+	assert(ssgnc::Protocol::readResult(&reader, &encoded_freq,
+		&tokens_copy, &total));
+	assert(encoded_freq == 10);
+	assert(tokens_copy == tokens);
+	assert(total == 256);
+
+	assert(ssgnc::Protocol::readResult(&reader, &encoded_freq,
+		&tokens_copy, &total));
+	assert(encoded_freq == ssgnc::Protocol::END_OF_RESULTS);
+	assert(tokens_copy.empty());
+	assert(total == 512);
+
+	assert(ssgnc::Protocol::readResult(&reader, &encoded_freq,
+		&tokens_copy, &total));
+	assert(encoded_freq == ssgnc::Protocol::ERROR_OF_RESULTS);
+
+	assert(!ssgnc::Protocol::readResult(&reader, &encoded_freq,
+		&tokens_copy, &total));
+
+	stream.clear();
+	stream.str("");
+
+	ssgnc::StringBuilder query_str;
+	ssgnc::StringBuilder ngram;
+	ssgnc::Int32 length;
+
+	assert(ssgnc::Protocol::writeRequest(&writer, query, "w5 * w7"));
+	assert(ssgnc::Protocol::writeRequest(&writer, query, ""));
+	assert(ssgnc::Protocol::writeNgram(&writer, "w5 w6 w7\t100"));
+	assert(ssgnc::Protocol::writeEndOfNgrams(&writer, true));
+	assert(ssgnc::Protocol::writeEndOfNgrams(&writer, false));
+
+	assert(ssgnc::Protocol::readRequest(&reader, &query_copy, &query_str));
+	assert(query_str.str() == "w5 * w7");
+	assert(query_copy.order() == ssgnc::Query::PHRASE);
+	assert(query_copy.max_num_results() == 100);
+	assert(query_copy.num_tokens() == 0);
+
+	assert(ssgnc::Protocol::readRequest(&reader, &query_copy, &query_str));
+	assert(query_str.empty());
+
+	assert(ssgnc::Protocol::readNgram(&reader, &length, &ngram));
+	assert(length == 12);
+	assert(ngram.str() == "w5 w6 w7\t100");
+
+	assert(ssgnc::Protocol::readNgram(&reader, &length, &ngram));
+	assert(length == ssgnc::Protocol::END_OF_NGRAMS);
+	assert(ngram.empty());
+
+	assert(ssgnc::Protocol::readNgram(&reader, &length, &ngram));
+	assert(length == ssgnc::Protocol::ERROR_OF_NGRAMS);
+
+	assert(!ssgnc::Protocol::readRequest(&reader, &query_copy, &query_str));
+
+	// A request and its response go through a pair of sockets.
+	int fds[2];
+	assert(::socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+
+	ssgnc::FdStreambuf client_buf, server_buf;
+	assert(client_buf.open(fds[0], 16));
+	assert(server_buf.open(fds[1]));
+	assert(client_buf.is_open() && server_buf.is_open());
+
+	std::iostream client_stream(&client_buf), server_stream(&server_buf);
+	ssgnc::Reader client_reader, server_reader;
+	ssgnc::Writer client_writer, server_writer;
+	assert(client_reader.open(&client_stream));
+	assert(client_writer.open(&client_stream));
+	assert(server_reader.open(&server_stream));
+	assert(server_writer.open(&server_stream));
+
+	assert(ssgnc::Protocol::writeQuery(&client_writer, query));
+	assert(client_stream.flush());
+
+	assert(ssgnc::Protocol::readQuery(&server_reader, &query_copy));
+	assert(query_copy.num_tokens() == 3);
+	assert(query_copy.token(2) == 7);
+
+	assert(ssgnc::Protocol::writeResult(&server_writer, 10, tokens, 256));
+	assert(ssgnc::Protocol::writeEnd(&server_writer, true, 512));
+	assert(server_buf.close());
+	assert(!server_buf.is_open());
+
+	assert(ssgnc::Protocol::readResult(&client_reader, &encoded_freq,
+		&tokens_copy, &total));
+	assert(encoded_freq == 10);
+	assert(tokens_copy == tokens);
+	assert(ssgnc::Protocol::readResult(&client_reader, &encoded_freq,
+		&tokens_copy, &total));
+	assert(encoded_freq == ssgnc::Protocol::END_OF_RESULTS);
+	assert(total == 512);
+
+	// The peer has closed its socket.
+	assert(!ssgnc::Protocol::readResult(&client_reader, &encoded_freq,
+		&tokens_copy, &total));
+
+	assert(client_buf.close());
+
+	return 0;
+}
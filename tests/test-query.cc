@@ -13,8 +13,21 @@ int main()
 	assert(query.max_num_tokens() == 0);
 	assert(query.max_num_results() == 0);
 	assert(query.io_limit() == 0);
+	assert(query.time_limit() == 0);
+	assert(query.scan_limit() == 0);
 	assert(query.order() == ssgnc::Query::DEFAULT_ORDER);
 
+	assert(query.set_time_limit(ssgnc::Query::MAX_TIME_LIMIT));
+	assert(query.set_scan_limit(ssgnc::Query::MAX_SCAN_LIMIT));
+	assert(!query.set_time_limit(ssgnc::Query::MAX_TIME_LIMIT + 1));
+	assert(!query.set_scan_limit(-1));
+	assert(query.time_limit() ==
+		static_cast<ssgnc::UInt64>(ssgnc::Query::MAX_TIME_LIMIT));
+	assert(query.scan_limit() ==
+		static_cast<ssgnc::UInt64>(ssgnc::Query::MAX_SCAN_LIMIT));
+	assert(query.set_time_limit(ssgnc::Query::MIN_TIME_LIMIT));
+	assert(query.set_scan_limit(ssgnc::Query::MIN_SCAN_LIMIT));
+
 	assert(query.appendToken(ssgnc::Query::MIN_TOKEN));
 	assert(query.set_min_freq(ssgnc::Query::MIN_FREQ));
 	assert(query.set_min_num_tokens(ssgnc::Query::MIN_NUM_TOKENS));
@@ -150,6 +163,8 @@ int main()
 		"argv[3]",
 		"--ssgnc-max-num-results", "100",
 		"--ssgnc-io-limit=1000000000000",
+		"--ssgnc-time-limit=2500",
+		"--ssgnc-scan-limit", "300",
 		"--ssgnc-order", "unordered" };
 
 	int argc = static_cast<int>(sizeof(args) / sizeof(args[0]));
@@ -170,8 +185,15 @@ int main()
 	assert(query.max_num_tokens() == 5);
 	assert(query.max_num_results() == 100);
 	assert(query.io_limit() == 1000000000000LL);
+	assert(query.time_limit() == 2500);
+	assert(query.scan_limit() == 300);
 	assert(query.order() == ssgnc::Query::UNORDERED);
 
+	ssgnc::Query query_copy;
+	assert(query.clone(&query_copy));
+	assert(query_copy.time_limit() == 2500);
+	assert(query_copy.scan_limit() == 300);
+
 	assert(query.parseQueryString(
 		"q=C%2B%2b+Q%26A%20FAQ"
 		"&f=1%300"
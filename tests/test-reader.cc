@@ -49,7 +49,7 @@ int main()
 		assert(reader.read(&value));
 		assert(value == values[i]);
 	}
-	assert(reader.tell() == stream.tellg());
+	assert(reader.tell() == static_cast<ssgnc::UInt64>(stream.tellg()));
 
 	std::vector<int> values_clone(NUM_OBJS);
 
@@ -68,7 +68,7 @@ int main()
 
 	assert(reader.open(&stream));
 	assert(reader.read(&values_clone[0], NUM_OBJS));
-	assert(reader.tell() == stream.tellg());
+	assert(reader.tell() == static_cast<ssgnc::UInt64>(stream.tellg()));
 
 	for (int i = 0; i < NUM_OBJS; ++i)
 		assert(values_clone[i] == values[i]);
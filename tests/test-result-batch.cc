@@ -0,0 +1,42 @@
+#include "ssgnc.h"
+
+#include <cassert>
+
+int main()
+{
+	ssgnc::ResultBatch batch;
+	assert(batch.empty());
+	assert(batch.size() == 0);
+
+	ssgnc::Int32 tokens[] = { 3, 5, 7 };
+	assert(batch.append(30, tokens, 2));
+	assert(batch.append(20, tokens, 3));
+	assert(batch.append(10, tokens + 2, 1));
+	assert(!batch.empty());
+	assert(batch.size() == 3);
+
+	assert(batch.encoded_freq(0) == 30);
+	assert(batch.num_tokens(0) == 2);
+	assert(batch.tokens(0)[0] == 3 && batch.tokens(0)[1] == 5);
+	assert(batch.encoded_freq(1) == 20);
+	assert(batch.num_tokens(1) == 3);
+	assert(batch.tokens(1)[2] == 7);
+	assert(batch.encoded_freq(2) == 10);
+	assert(batch.num_tokens(2) == 1);
+	assert(batch.tokens(2)[0] == 7);
+
+	// The columns are stored in flat arrays.
+	assert(batch.encoded_freqs().size() == 3);
+	assert(batch.tokens().size() == 6);
+	assert(batch.offsets()[1] == 2 && batch.offsets()[2] == 5);
+
+	assert(!batch.append(0, NULL, 1));
+	assert(!batch.append(0, tokens, -1));
+	assert(batch.size() == 3);
+
+	batch.clear();
+	assert(batch.empty());
+	assert(batch.tokens().empty());
+
+	return 0;
+}
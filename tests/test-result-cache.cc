@@ -0,0 +1,114 @@
+#include "ssgnc.h"
+
+#include <cassert>
+
+int main()
+{
+	std::vector<ssgnc::Int32> tokens;
+	tokens.push_back(3);
+	tokens.push_back(5);
+
+	ssgnc::ResultCache::Results results;
+	assert(results.size() == 0);
+	assert(results.append(30, tokens));
+	tokens.push_back(7);
+	assert(results.append(20, tokens));
+	assert(results.size() == 2);
+
+	ssgnc::Int16 encoded_freq;
+	std::vector<ssgnc::Int32> result_tokens;
+	assert(results.get(0, &encoded_freq, &result_tokens));
+	assert(encoded_freq == 30);
+	assert(result_tokens.size() == 2);
+	assert(results.get(1, &encoded_freq, &result_tokens));
+	assert(encoded_freq == 20);
+	assert(result_tokens == tokens);
+	assert(!results.get(2, &encoded_freq, &result_tokens));
+
+	ssgnc::Query query;
+	assert(query.appendToken(5));
+	assert(query.set_max_num_results(1));
+
+	ssgnc::ResultCache::Key key, other_key;
+	assert(ssgnc::ResultCache::makeKey(query, 1, 5, &key));
+	assert(key.size() == 5);
+	assert(ssgnc::ResultCache::makeKey(query, 2, 5, &other_key));
+	assert(key != other_key);
+
+	ssgnc::ResultCache cache;
+	assert(!cache.is_open());
+	assert(cache.open(1 << 16));
+	assert(cache.is_open());
+
+	ssgnc::Agent agent;
+	assert(!cache.find(key, query, &agent));
+	assert(cache.num_misses() == 1);
+
+	// Complete results are returned for any limit.
+	cache.insert(key, &results, true, 100, 10, NULL);
+	assert(results.size() == 0);
+	assert(cache.num_entries() == 1);
+	assert(cache.num_bytes() > 0);
+
+	assert(cache.find(key, query, &agent));
+	assert(cache.num_hits() == 1);
+	assert(agent.is_open());
+	assert(agent.tell() == 100);
+	assert(agent.num_scanned() == 10);
+	assert(agent.read(&encoded_freq, &result_tokens));
+	assert(encoded_freq == 30);
+	assert(!agent.read(&encoded_freq, &result_tokens));
+	assert(agent.eof() && !agent.bad());
+	assert(agent.close());
+
+	assert(query.set_max_num_results(0));
+	assert(cache.find(key, query, &agent));
+	assert(agent.read(&encoded_freq, &result_tokens));
+	assert(agent.read(&encoded_freq, &result_tokens));
+	assert(encoded_freq == 20);
+	assert(!agent.read(&encoded_freq, &result_tokens));
+	assert(agent.close());
+
+	// The entry is not used if the limits would have stopped the search
+	// which has produced it.
+	assert(query.set_io_limit(100));
+	assert(!cache.find(key, query, &agent));
+	assert(query.set_io_limit(101));
+	assert(query.set_scan_limit(10));
+	assert(!cache.find(key, query, &agent));
+	assert(query.set_scan_limit(11));
+	assert(cache.find(key, query, &agent));
+	assert(agent.close());
+	assert(query.set_io_limit(0));
+	assert(query.set_scan_limit(0));
+
+	// Incomplete results without an agent are enough only for small limits.
+	assert(results.append(10, tokens));
+	cache.insert(other_key, &results, false, 50, 5, NULL);
+	assert(cache.num_entries() == 2);
+	assert(!cache.find(other_key, query, &agent));
+	assert(query.set_max_num_results(1));
+	assert(cache.find(other_key, query, &agent));
+	assert(agent.read(&encoded_freq, &result_tokens));
+	assert(encoded_freq == 10);
+	assert(agent.close());
+
+	// Fewer incomplete results do not replace the entry.
+	cache.insert(other_key, &results, false, 10, 1, NULL);
+	assert(cache.find(other_key, query, &agent));
+	assert(agent.tell() == 50);
+	assert(agent.close());
+
+	assert(cache.hit_rate() > 0.5);
+
+	// An entry larger than the cache is not stored.
+	assert(cache.close());
+	assert(cache.num_entries() == 0);
+	assert(cache.open(1));
+	assert(results.append(10, tokens));
+	cache.insert(key, &results, true, 0, 0, NULL);
+	assert(cache.num_entries() == 0);
+	assert(cache.num_bytes() == 0);
+
+	return 0;
+}
@@ -0,0 +1,73 @@
+#include "ssgnc.h"
+
+#include <cassert>
+#include <cstdio>
+
+int main()
+{
+	ssgnc::disable_error_logging();
+
+	std::remove("ngms.shards");
+
+	ssgnc::ShardMap shard_map;
+
+	assert(!shard_map.is_open());
+
+	assert(shard_map.open("."));
+
+	assert(shard_map.is_open());
+	assert(shard_map.index_dir() == ".");
+	assert(shard_map.num_shards() == 1);
+	assert(shard_map.find(1, 0) == 0);
+	assert(shard_map.dirname(0) == ".");
+
+	assert(!shard_map.open("."));
+	assert(shard_map.close());
+	assert(!shard_map.is_open());
+
+	std::ofstream file("ngms.shards", std::ios::binary);
+	assert(file.good());
+	file << "# NUM_TOKENS FIRST_FILE_ID DIRNAME\n"
+		<< "2 0 /disk1\n"
+		<< "1 0 disk0\n"
+		<< "2 3 /disk2\n"
+		<< "3 2 /disk1\n";
+	file.close();
+
+	assert(shard_map.open("."));
+
+	assert(shard_map.num_shards() == 4);
+	assert(shard_map.find(1, 0) == 2);
+	assert(shard_map.find(1, 100) == 2);
+	assert(shard_map.dirname(2) == "./disk0");
+
+	assert(shard_map.find(2, 0) == 1);
+	assert(shard_map.find(2, 2) == 1);
+	assert(shard_map.find(2, 3) == 3);
+	assert(shard_map.dirname(1) == "/disk1");
+	assert(shard_map.dirname(3) == "/disk2");
+
+	assert(shard_map.find(3, 0) == 0);
+	assert(shard_map.find(3, 1) == 0);
+	assert(shard_map.find(3, 2) == 1);
+	assert(shard_map.find(4, 0) == 0);
+
+	assert(shard_map.close());
+
+	file.open("ngms.shards", std::ios::binary);
+	file << "1 0 disk0\n" << "1 0 disk1\n";
+	file.close();
+
+	assert(!shard_map.open("."));
+	assert(!shard_map.is_open());
+
+	file.open("ngms.shards", std::ios::binary);
+	file << "1 disk0\n";
+	file.close();
+
+	assert(!shard_map.open("."));
+
+	std::remove("ngms.shards");
+
+	return 0;
+}
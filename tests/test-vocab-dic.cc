@@ -43,6 +43,7 @@ int main()
 	assert(vocab_dic.total_size() == 0);
 
 	assert(vocab_dic.open("VOCAB_DIC"));
+	assert(!vocab_dic.is_large());
 
 	assert(vocab_dic.num_keys() == keys.size());
 	assert(vocab_dic.table_size() > keys.size());
@@ -89,5 +90,77 @@ int main()
 	assert(vocab_dic_clone.table_size() == 0);
 	assert(vocab_dic_clone.total_size() == 0);
 
+	// A dictionary in the large format without the padding after the table
+	// is rejected, because its 64-bit offsets are misaligned.
+	std::ifstream small_file("VOCAB_DIC", std::ios::binary);
+	assert(small_file.good());
+
+	ssgnc::Reader reader(&small_file);
+	ssgnc::UInt32 num_keys, table_size, total_size;
+	assert(reader.read(&num_keys));
+	assert(reader.read(&table_size));
+	assert(reader.read(&total_size));
+
+	assert(table_size % 2 == 1);
+	std::vector<ssgnc::Int32> table(table_size);
+	assert(reader.read(&table[0], table_size));
+
+	std::vector<ssgnc::UInt32> offsets(num_keys + 1);
+	assert(reader.read(&offsets[0], num_keys + 1));
+
+	std::vector<ssgnc::Int8> keys_buf(offsets[num_keys]);
+	assert(reader.read(&keys_buf[0], offsets[num_keys]));
+
+	std::ofstream large_file("VOCAB_DIC_LARGE", std::ios::binary);
+	assert(large_file.good());
+
+	ssgnc::Writer writer(&large_file);
+	assert(writer.write(static_cast<ssgnc::UInt32>(
+		ssgnc::VocabDic::LARGE_FORMAT_MARKER)));
+	assert(writer.write(static_cast<ssgnc::UInt32>(
+		ssgnc::VocabDic::LARGE_FORMAT)));
+	assert(writer.write(num_keys));
+	assert(writer.write(table_size));
+	assert(writer.write(static_cast<ssgnc::UInt64>(total_size)
+		+ sizeof(ssgnc::UInt32) * (num_keys + 1)));
+	assert(writer.write(&table[0], table_size));
+	for (ssgnc::UInt32 i = 0; i <= num_keys; ++i)
+		assert(writer.write(static_cast<ssgnc::UInt64>(offsets[i])));
+	assert(writer.write(&keys_buf[0], offsets[num_keys]));
+
+	large_file.close();
+
+	ssgnc::VocabDic large_vocab_dic;
+
+	ssgnc::disable_error_logging();
+	assert(!large_vocab_dic.open("VOCAB_DIC_LARGE"));
+	ssgnc::set_error_stream(&std::clog);
+
+	// The large format is used only for huge dictionaries unless it is
+	// forced.
+	assert(ssgnc::VocabDic::build("VOCAB_DIC_LARGE", keys, true));
+
+	assert(large_vocab_dic.open("VOCAB_DIC_LARGE"));
+	assert(large_vocab_dic.is_large());
+	assert(large_vocab_dic.num_keys() == keys.size());
+	assert(large_vocab_dic.table_size() == table_size);
+	assert(large_vocab_dic.total_size() ==
+		sizeof(ssgnc::Int32) * (table_size + 1)
+		+ sizeof(ssgnc::UInt64) * (num_keys + 1)
+		+ KEY_LENGTH * num_keys);
+
+	for (ssgnc::UInt32 i = 0; i < large_vocab_dic.num_keys(); ++i)
+	{
+		ssgnc::Int32 key_id = static_cast<ssgnc::Int32>(i);
+		assert(large_vocab_dic.find(key_id, &key));
+		assert(key == keys[i]);
+
+		ssgnc::Int32 value;
+		assert(large_vocab_dic.find(key, &value));
+		assert(value == key_id);
+	}
+
+	assert(large_vocab_dic.close());
+
 	return 0;
 }
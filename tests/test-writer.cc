@@ -40,7 +40,7 @@ int main()
 
 	for (int i = 0; i < NUM_OBJS; ++i)
 		assert(writer.write(values[i]));
-	assert(writer.tell() == stream.tellp());
+	assert(writer.tell() == static_cast<ssgnc::UInt64>(stream.tellp()));
 
 	for (int i = 0; i < NUM_OBJS; ++i)
 	{
@@ -65,7 +65,7 @@ int main()
 
 	assert(writer.open(&stream));
 	assert(writer.write(&values[0], NUM_OBJS));
-	assert(writer.tell() == stream.tellp());
+	assert(writer.tell() == static_cast<ssgnc::UInt64>(stream.tellp()));
 
 	for (int i = 0; i < NUM_OBJS; ++i)
 	{